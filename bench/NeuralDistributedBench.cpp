@@ -0,0 +1,156 @@
+/**
+ * @file NeuralDistributedBench.cpp
+ * @brief The NeuralDistributed benchmark.
+ *
+ * This file measures the bandwidth of the all-reduce of both transports with the number of workers,
+ * then the speedup and the scaling efficiency of the distributed training over one worker.
+ *
+ * Usage: neural_distributed_bench [max_workers] [base_port]
+ *
+ * @author Manitas Bahri
+ * @date 2023/11
+ * @license MIT License
+ */
+
+// INCLUDES
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+#include "../include/NeuralCPP.hpp"
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+/**
+ * @brief Get the mean time of an all-reduce of n floats over forked workers, in seconds, or -1 if a worker failed.
+ */
+double allreduce_seconds(const NeuralDistributed::Transport &transport, const int &n_workers, const size_t &n, const int &base_port)
+{
+    const int repeats = n < (1 << 16) ? 1000 : 20;
+    std::unique_ptr<NeuralShmComm> shm(transport == NeuralDistributed::SHARED_MEMORY ? new NeuralShmComm(n_workers, n) : nullptr);
+
+    // The worker 0 sends its time to the parent
+    int fds[2];
+    if (pipe(fds) != 0)
+        return -1;
+
+    std::vector<pid_t> pids;
+    for (int rank = 0; rank < n_workers; rank++)
+    {
+        const pid_t pid = fork();
+        if (pid < 0)
+            break;
+
+        if (pid == 0)
+        {
+            int status = 0;
+            try
+            {
+                std::unique_ptr<NeuralTcpComm> tcp;
+                if (shm)
+                    shm->attach(rank);
+                else
+                    tcp.reset(new NeuralTcpComm(rank, n_workers, "127.0.0.1", base_port));
+                NeuralComm &comm = shm ? (NeuralComm &)*shm : (NeuralComm &)*tcp;
+
+                // The first all-reduce warms up the buffers and the connections
+                std::vector<float> data(n, 1);
+                comm.allreduce(data.data(), n);
+                comm.barrier();
+
+                const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                for (int r = 0; r < repeats; r++)
+                    comm.allreduce(data.data(), n);
+                const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / repeats;
+
+                if (rank == 0 && write(fds[1], &seconds, sizeof(seconds)) != sizeof(seconds))
+                    status = 1;
+            }
+            catch (const std::exception &e)
+            {
+                std::fprintf(stderr, "Worker %d: %s\n", rank, e.what());
+                status = 1;
+            }
+
+            _exit(status);
+        }
+
+        pids.push_back(pid);
+    }
+
+    bool failed = (int)pids.size() != n_workers;
+    for (const pid_t &pid : pids)
+    {
+        int status = 0;
+        failed = failed || waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0;
+    }
+
+    double seconds = -1;
+    if (failed || read(fds[0], &seconds, sizeof(seconds)) != sizeof(seconds))
+        seconds = -1;
+
+    close(fds[0]);
+    close(fds[1]);
+
+    return seconds;
+}
+
+int main(int argc, char **argv)
+{
+    const int max_workers = argc > 1 ? std::atoi(argv[1]) : 4;
+    const int base_port = argc > 2 ? std::atoi(argv[2]) : 29500;
+    const char *names[] = {"shm", "tcp"};
+
+    std::vector<int> workers;
+    for (int n = 1; n < max_workers; n *= 2)
+        workers.push_back(n);
+    workers.push_back(max_workers);
+
+    // TEST 1: ALL-REDUCE SCALING
+    // The bus bandwidth counts the 2 (p - 1) / p bytes of each float moved by a ring all-reduce of p workers
+    std::printf("ALL-REDUCE\n");
+    std::printf("%-9s %8s %10s %12s %12s %12s\n", "transport", "workers", "floats", "time (us)", "algo GB/s", "bus GB/s");
+
+    for (const NeuralDistributed::Transport &transport : {NeuralDistributed::SHARED_MEMORY, NeuralDistributed::TCP})
+        for (const int &n_workers : workers)
+        {
+            if (n_workers < 2)
+                continue;
+
+            for (const size_t &n : {(size_t)1 << 10, (size_t)1 << 16, (size_t)1 << 20})
+            {
+                const double seconds = allreduce_seconds(transport, n_workers, n, base_port);
+                if (seconds < 0)
+                {
+                    std::printf("%-9s %8d %10zu %12s\n", names[transport], n_workers, n, "failed");
+                    continue;
+                }
+
+                const double bytes = n * sizeof(float);
+                std::printf("%-9s %8d %10zu %12.1f %12.3f %12.3f\n", names[transport], n_workers, n, seconds * 1e6, bytes / seconds / 1e9,
+                            2. * (n_workers - 1) / n_workers * bytes / seconds / 1e9);
+            }
+        }
+
+    // TEST 2: TRAINING SCALING OVER ONE WORKER
+    cmatrix<float> X, y;
+    NeuralCPP::create_dataset(X, y, 20000, 32, 2);
+
+    std::printf("\nTRAINING, 20000 samples, layers {64, 64}, 20 epochs\n");
+    std::printf("%-9s %8s %10s %10s %10s %10s %14s\n", "transport", "workers", "time (s)", "speedup", "efficiency", "overlap", "samples/s");
+
+    for (const NeuralDistributed::Transport &transport : {NeuralDistributed::SHARED_MEMORY, NeuralDistributed::TCP})
+        for (const int &n_workers : workers)
+        {
+            NeuralLayers model({64, 64});
+            const NeuralDistributed::Report &report = NeuralDistributed(n_workers, transport, base_port).fit(model, X, y, 20, .1);
+
+            std::printf("%-9s %8d %10.3f %10.2f %10.2f %10.2f %14.0f\n", names[transport], n_workers, report.seconds, report.speedup,
+                        report.efficiency, report.overlap, report.samples_per_second);
+        }
+
+    return 0;
+}
@@ -0,0 +1,141 @@
+/**
+ * @file NeuralExprBench.cpp
+ * @brief The NeuralExpr benchmark.
+ *
+ * This file compares the chains of operators of the matrices with the same chains fused by the expressions,
+ * and reports their allocations, their memory traffic and their bandwidth.
+ *
+ * Usage: neural_expr_bench [rows] [columns]
+ *
+ * @author Manitas Bahri
+ * @date 2023/11
+ * @license MIT License
+ */
+
+// INCLUDES
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <new>
+#include "../include/NeuralCPP.hpp"
+
+/**
+ * @brief The number of allocations and the allocated bytes of the program, counted by the global operator new.
+ */
+static std::atomic<size_t> n_allocations(0);
+static std::atomic<size_t> n_bytes(0);
+
+void *operator new(std::size_t size)
+{
+    n_allocations++;
+    n_bytes += size;
+    if (void *block = std::malloc(size ? size : 1))
+        return block;
+
+    throw std::bad_alloc();
+}
+
+void operator delete(void *block) noexcept
+{
+    std::free(block);
+}
+
+void operator delete(void *block, std::size_t) noexcept
+{
+    std::free(block);
+}
+
+/** @brief The allocations, the allocated bytes and the fastest wall time of 5 runs of a function. */
+struct Measure
+{
+    size_t allocations;
+    size_t bytes;
+    double seconds;
+};
+
+/** @brief Measure a function: the counters come from its first run, the time from the fastest run. */
+Measure measure(const std::function<void()> &function)
+{
+    Measure result = {0, 0, -1};
+    for (int r = 0; r < 5; r++)
+    {
+        const size_t allocations = n_allocations, bytes = n_bytes;
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        function();
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        if (r == 0)
+        {
+            result.allocations = n_allocations - allocations;
+            result.bytes = n_bytes - bytes;
+        }
+        if (result.seconds < 0 || seconds < result.seconds)
+            result.seconds = seconds;
+    }
+
+    return result;
+}
+
+/**
+ * @brief Print one path of a chain. The traffic counts the floats read and written by the loops of the path,
+ * each operator of the matrices reading its operands and writing its result, each expression reading its leaves once.
+ */
+void report(const char *name, const char *path, const Measure &result, const size_t &n_floats)
+{
+    const double traffic = (double)n_floats * sizeof(float);
+    std::printf("%-14s %-6s %8zu %14.1f %14.1f %10.3f %10.2f\n", name, path, result.allocations, result.bytes / 1e6, traffic / 1e6,
+                result.seconds * 1e3, traffic / result.seconds / 1e9);
+}
+
+int main(int argc, char **argv)
+{
+    const size_t rows = argc > 1 ? std::atoi(argv[1]) : 2048;
+    const size_t columns = argc > 2 ? std::atoi(argv[2]) : 2048;
+    const size_t n = rows * columns;
+
+    const cmatrix<float> &A = cmatrix<float>::randfloat(rows, columns, -1, 1, 1);
+    const cmatrix<float> &B = cmatrix<float>::randfloat(rows, columns, -1, 1, 2);
+    cmatrix<float> W = cmatrix<float>::randfloat(rows, columns, -1, 1, 3);
+    cmatrix<float> D(rows, columns);
+    const float lr = .01f;
+    volatile float sink = 0;
+
+    std::printf("%zu x %zu floats\n", rows, columns);
+    std::printf("%-14s %-6s %8s %14s %14s %10s %10s\n", "chain", "path", "allocs", "allocated MB", "traffic MB", "time (ms)", "GB/s");
+
+    // TEST 1: MEAN SQUARED ERROR, A - B, ^ 2 AND THE SUM
+    report("mse", "eager", measure([&]()
+                                   { sink = ((A - B) ^ 2).sum_all() / n; }),
+           6 * n);
+    report("mse", "fused", measure([&]()
+                                   { sink = (NeuralLazy(A) - NeuralLazy(B)).square().sum_all() / n; }),
+           2 * n);
+
+    // TEST 2: MEAN ABSOLUTE ERROR, A - B, ABS AND THE SUM
+    report("mae", "eager", measure([&]()
+                                   { sink = (A - B).abs().sum_all() / n; }),
+           6 * n);
+    report("mae", "fused", measure([&]()
+                                   { sink = (NeuralLazy(A) - NeuralLazy(B)).abs().sum_all() / n; }),
+           2 * n);
+
+    // TEST 3: GRADIENT UPDATE, IN PLACE FOR THE EXPRESSION
+    report("update", "eager", measure([&]()
+                                      { W = W - B * lr; sink = W.cell(0, 0); }),
+           5 * n);
+    report("update", "fused", measure([&]()
+                                      { (NeuralLazy(W) - lr * NeuralLazy(B)).eval_to(W); sink = W.cell(0, 0); }),
+           3 * n);
+
+    // TEST 4: DERIVATIVE OF THE SIGMOID, B * A * (1 - A), IN A PREALLOCATED MATRIX FOR THE EXPRESSION
+    report("sigmoid grad", "eager", measure([&]()
+                                            { D = B * A * (A * -1 + 1); sink = D.cell(0, 0); }),
+           10 * n);
+    report("sigmoid grad", "fused", measure([&]()
+                                            { (NeuralLazy(B) * NeuralLazy(A) * (1 - NeuralLazy(A))).eval_to(D); sink = D.cell(0, 0); }),
+           3 * n);
+
+    return 0;
+}
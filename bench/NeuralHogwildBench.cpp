@@ -0,0 +1,115 @@
+/**
+ * @file NeuralHogwildBench.cpp
+ * @brief The NeuralHogwild benchmark.
+ *
+ * This file measures the throughput of the asynchronous fits with the number of threads,
+ * and compares their convergence with the synchronous fits.
+ *
+ * Usage: neural_hogwild_bench [max_threads]
+ *
+ * @author Manitas Bahri
+ * @date 2023/11
+ * @license MIT License
+ */
+
+// INCLUDES
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <thread>
+#include <vector>
+#include "../include/NeuralCPP.hpp"
+
+/** @brief Get the wall time of a function, in seconds. */
+double seconds(const std::function<void()> &function)
+{
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    function();
+
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/** @brief Computes the accuracy of the predictions of a model. */
+template <class Model, class Input>
+float accuracy(Model &model, const Input &X, const cmatrix<float> &y)
+{
+    const cmatrix<float> &correct = cmatrix<float>(model.predict(X).eq(cmatrix<cbool>(y)));
+    return correct.sum_all() / y.width();
+}
+
+int main(int argc, char **argv)
+{
+    const size_t max_threads = argc > 1 ? std::atoi(argv[1]) : std::max(1u, std::thread::hardware_concurrency());
+
+    // The candidate numbers of threads: the powers of 2, then all the threads
+    std::vector<size_t> threads;
+    for (size_t n = 1; n < max_threads; n *= 2)
+        threads.push_back(n);
+    threads.push_back(max_threads);
+
+    NeuralSparse X_sparse;
+    cmatrix<float> y_sparse, X_dense, y_dense;
+    NeuralCPP::create_dataset(X_sparse, y_sparse, 100000, 10000, .001f, 2, 1);
+    NeuralCPP::create_dataset(X_dense, y_dense, 100000, 16, 2);
+
+    const NeuralSparse &samples = X_sparse.transpose();
+    cmatrix<float> y_signs(100000, 1);
+    for (size_t j = 0; j < 100000; j++)
+        y_signs.cell(j, 0) = y_sparse.cell(0, j) ? 1 : -1;
+
+    // TEST 1: THROUGHPUT SCALING
+    std::printf("THROUGHPUT (samples/s), 5 epochs\n");
+    std::printf("%8s %16s %8s %16s %8s %16s %8s\n", "threads", "perceptron", "speedup", "layers sparse", "speedup", "layers dense", "speedup");
+
+    double base[3] = {0, 0, 0};
+    for (const size_t &n : threads)
+    {
+        NeuralPerceptron perceptron;
+        perceptron.fit_async(samples, y_signs, 5, .01, n);
+
+        NeuralLayers sparse_model({8}), dense_model({8});
+        sparse_model.fit_async(X_sparse, y_sparse, 5, .1, 0, n);
+        dense_model.fit_async(X_dense, y_dense, 5, .1, 0, n);
+
+        const double rates[3] = {perceptron.throughput, sparse_model.throughput, dense_model.throughput};
+        if (n == 1)
+            std::copy(rates, rates + 3, base);
+
+        std::printf("%8zu %16.0f %8.2f %16.0f %8.2f %16.0f %8.2f\n", n, rates[0], rates[0] / base[0], rates[1], rates[1] / base[1], rates[2], rates[2] / base[2]);
+    }
+
+    // TEST 2: CONVERGENCE AGAINST THE SYNCHRONOUS FITS
+    std::printf("\nCONVERGENCE, %zu threads\n", max_threads);
+    std::printf("%-16s %12s %10s %12s %10s\n", "model", "sync (s)", "accuracy", "async (s)", "accuracy");
+
+    NeuralLayers sync_sparse({8}), async_sparse({8});
+    const double sync_sparse_seconds = seconds([&]()
+                                               { sync_sparse.fit(X_sparse, y_sparse, 500, .5, 0); });
+    const double async_sparse_seconds = seconds([&]()
+                                                { async_sparse.fit_async(X_sparse, y_sparse, 10, .1, 0, max_threads); });
+    std::printf("%-16s %12.3f %10.3f %12.3f %10.3f\n", "layers sparse", sync_sparse_seconds, accuracy(sync_sparse, X_sparse, y_sparse),
+                async_sparse_seconds, accuracy(async_sparse, X_sparse, y_sparse));
+
+    NeuralLayers sync_dense({8}), async_dense({8});
+    const double sync_dense_seconds = seconds([&]()
+                                              { sync_dense.fit(X_dense, y_dense, 500, .5, 0); });
+    const double async_dense_seconds = seconds([&]()
+                                               { async_dense.fit_async(X_dense, y_dense, 10, .1, 0, max_threads); });
+    std::printf("%-16s %12.3f %10.3f %12.3f %10.3f\n", "layers dense", sync_dense_seconds, accuracy(sync_dense, X_dense, y_dense),
+                async_dense_seconds, accuracy(async_dense, X_dense, y_dense));
+
+    // The perceptron predicts -1 or 1, one sample per row
+    NeuralPerceptron sync_perceptron, async_perceptron;
+    const double sync_perceptron_seconds = seconds([&]()
+                                                   { sync_perceptron.fit(samples, y_signs, 50, .01); });
+    const double async_perceptron_seconds = seconds([&]()
+                                                    { async_perceptron.fit_async(samples, y_signs, 10, .01, max_threads); });
+    const cmatrix<float> &sync_correct = cmatrix<float>((sync_perceptron.predict(samples) > 0).eq(y_signs > 0));
+    const cmatrix<float> &async_correct = cmatrix<float>((async_perceptron.predict(samples) > 0).eq(y_signs > 0));
+    std::printf("%-16s %12.3f %10.3f %12.3f %10.3f\n", "perceptron", sync_perceptron_seconds, sync_correct.sum_all() / 100000,
+                async_perceptron_seconds, async_correct.sum_all() / 100000);
+
+    return 0;
+}
@@ -0,0 +1,97 @@
+/**
+ * @file NeuralRecurrentBench.cpp
+ * @brief The recurrent layers benchmark.
+ *
+ * This file measures the sequences per second of the LSTM and GRU layers in inference and in training,
+ * with the full backpropagation through time and with a truncated one.
+ *
+ * Usage: neural_recurrent_bench [length] [batch] [truncation]
+ *
+ * @author Manitas Bahri
+ * @date 2023/11
+ * @license MIT License
+ */
+
+// INCLUDES
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <vector>
+#include "../include/NeuralCPP.hpp"
+
+/** @brief Get the sequences per second of the fastest of 5 runs of a function processing n_batches batches. */
+double sequences_per_second(const std::function<void()> &function, const size_t &n_batches, const size_t &batch)
+{
+    function();
+
+    double best = -1;
+    for (int r = 0; r < 5; r++)
+    {
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        function();
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        if (best < 0 || seconds < best)
+            best = seconds;
+    }
+
+    return n_batches * batch / best;
+}
+
+/** @brief Measure a recurrent layer followed by a dense output, and print its rates in inference and in training. */
+void bench(const char *name, const NeuralLayer &cell, const size_t &units, const size_t &truncation, const size_t &n_features,
+           const size_t &length, const size_t &batch)
+{
+    const size_t n_batches = 10;
+
+    NeuralGraph graph(NeuralLayer::Shape(n_features, 1, length));
+    graph.add(cell).add(NeuralDense(1));
+    graph.build(graph.input_shape().size(), 1);
+    graph.plan(batch);
+
+    const cmatrix<float> &R = cmatrix<float>::randfloat(batch, n_features * length + 1, -1, 1, 7);
+    std::vector<float> y(batch);
+    for (size_t s = 0; s < batch; s++)
+    {
+        for (size_t f = 0; f < n_features * length; f++)
+            graph.activation(0)[s * n_features * length + f] = R.cell(s, f);
+
+        y[s] = R.cell(s, n_features * length) > 0;
+    }
+
+    volatile float sink = 0;
+    const double inference = sequences_per_second([&]()
+                                                  { for (size_t b = 0; b < n_batches; b++) sink = graph.forward(false)[0]; },
+                                                  n_batches, batch);
+    const double training = sequences_per_second([&]()
+                                                 { for (size_t b = 0; b < n_batches; b++) { graph.forward(true); graph.backward(y); graph.update(.01f); } },
+                                                 n_batches, batch);
+
+    std::printf("%-5s %6zu %11zu %14.0f %14.0f %10.2f\n", name, units, truncation, inference, training, inference / training);
+}
+
+int main(int argc, char **argv)
+{
+    const size_t n_features = 32;
+    const size_t length = argc > 1 ? std::atoi(argv[1]) : 50;
+    const size_t batch = argc > 2 ? std::atoi(argv[2]) : 64;
+    const size_t truncation = argc > 3 ? std::atoi(argv[3]) : 10;
+
+    std::printf("%zu features, %zu time steps, batches of %zu sequences\n", n_features, length, batch);
+    std::printf("%-5s %6s %11s %14s %14s %10s\n", "cell", "units", "truncation", "inference/s", "training/s", "ratio");
+
+    for (const size_t &units : {(size_t)64, (size_t)128})
+    {
+        // TEST 1: LSTM, THE FULL AND THE TRUNCATED BACKPROPAGATION THROUGH TIME
+        bench("lstm", NeuralLSTM(units), units, 0, n_features, length, batch);
+        bench("lstm", NeuralLSTM(units, false, truncation), units, truncation, n_features, length, batch);
+
+        // TEST 2: GRU, THE FULL AND THE TRUNCATED BACKPROPAGATION THROUGH TIME
+        bench("gru", NeuralGRU(units), units, 0, n_features, length, batch);
+        bench("gru", NeuralGRU(units, false, truncation), units, truncation, n_features, length, batch);
+    }
+
+    return 0;
+}
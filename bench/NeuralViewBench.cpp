@@ -0,0 +1,108 @@
+/**
+ * @file NeuralViewBench.cpp
+ * @brief The NeuralView benchmark.
+ *
+ * This file compares the hot paths reading the samples through views with the same paths copying them,
+ * and reports the copied bytes and the copy bandwidth saved by the views.
+ *
+ * Usage: neural_view_bench [n_samples] [n_features]
+ *
+ * @author Manitas Bahri
+ * @date 2023/11
+ * @license MIT License
+ */
+
+// INCLUDES
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include "../include/NeuralCPP.hpp"
+
+/** @brief Get the fastest wall time of 5 runs of a function, in seconds. */
+double fastest(const std::function<void()> &function)
+{
+    double best = -1;
+    for (int r = 0; r < 5; r++)
+    {
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        function();
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        if (best < 0 || seconds < best)
+            best = seconds;
+    }
+
+    return best;
+}
+
+/** @brief Print a comparison: the bytes copied by the copy path, and the bandwidth of its copies, saved by the view path. */
+void report(const char *name, const double &bytes, const double &copy_seconds, const double &view_seconds)
+{
+    std::printf("%-24s %12.1f %12.3f %12.3f %10.2f %12.3f\n", name, bytes / 1e6, copy_seconds * 1e3, view_seconds * 1e3,
+                copy_seconds / view_seconds, bytes / copy_seconds / 1e9);
+}
+
+int main(int argc, char **argv)
+{
+    const size_t n_samples = argc > 1 ? std::atoi(argv[1]) : 20000;
+    const size_t n_features = argc > 2 ? std::atoi(argv[2]) : 256;
+
+    // The samples are the rows of X, as the perceptron reads them
+    const cmatrix<float> &X = cmatrix<float>::randfloat(n_samples, n_features, -1, 1, 1);
+    cmatrix<float> y(n_samples, 1);
+    for (size_t i = 0; i < n_samples; i++)
+        y.cell(i, 0) = X.cell(i, 0) + X.cell(i, 1) > 0 ? 1 : -1;
+
+    const NeuralView samples(X);
+    const double bytes = n_samples * n_features * sizeof(float);
+    volatile float sink = 0;
+
+    std::printf("%zu samples x %zu features\n", n_samples, n_features);
+    std::printf("%-24s %12s %12s %12s %10s %12s\n", "operation", "copied MB", "copy ms", "view ms", "speedup", "copy GB/s");
+
+    // TEST 1: PREDICT, THE SAMPLES WERE COPIED BEFORE THE PRODUCT
+    NeuralPerceptron model;
+    model.fit(samples, y, 1, .01);
+    const double predict_copy = fastest([&]()
+                                        { sink = model.predict(samples.to_cmatrix()).cell(0, 0); });
+    const double predict_view = fastest([&]()
+                                        { sink = model.predict(samples).cell(0, 0); });
+    report("predict", bytes, predict_copy, predict_view);
+
+    // TEST 2: FIT EPOCH, A HALF OF THE SAMPLES IN A BLOCK OF ROWS OF THE MATRIX
+    const NeuralView &half = samples.rows(0, n_samples / 2);
+    cmatrix<float> y_half(n_samples / 2, 1);
+    for (size_t i = 0; i < n_samples / 2; i++)
+        y_half.cell(i, 0) = y.cell(i, 0);
+    const double fit_copy = fastest([&]()
+                                    { NeuralPerceptron copy_model; copy_model.m_weights = model.m_weights; copy_model.fit(half.to_cmatrix(), y_half, 1, .01); });
+    const double fit_view = fastest([&]()
+                                    { NeuralPerceptron view_model; view_model.m_weights = model.m_weights; view_model.fit(half, y_half, 1, .01); });
+    report("fit epoch, row block", bytes / 2, fit_copy, fit_view);
+
+    // TEST 3: THE ROW OF EACH SAMPLE, TRANSPOSED, AS IN THE GRADIENT OF THE PERCEPTRON
+    const double rows_copy = fastest([&]()
+                                     { for (size_t i = 0; i < n_samples; i++) sink = X.rows(i).transpose().cell(1, 0); });
+    const double rows_view = fastest([&]()
+                                     { for (size_t i = 0; i < n_samples; i++) sink = samples.rows(i).transpose().cell(1, 0); });
+    report("sample rows, transposed", 2 * bytes, rows_copy, rows_view);
+
+    // TEST 4: THE MINI-BATCHES OF 256 SAMPLES, AS COLUMN RANGES OF THE TRANSPOSED SAMPLES
+    const NeuralView &columns = samples.transpose();
+    const double batches_copy = fastest([&]()
+                                        { for (size_t b = 0; b < n_samples; b += 256) sink = columns.columns(b, std::min(b + 256, n_samples)).to_cmatrix().cell(0, 0); });
+    const double batches_view = fastest([&]()
+                                        { for (size_t b = 0; b < n_samples; b += 256) sink = columns.columns(b, std::min(b + 256, n_samples)).cell(0, 0); });
+    report("mini-batches", bytes, batches_copy, batches_view);
+
+    // TEST 5: THE TRANSPOSE OF THE SAMPLES
+    const double transpose_copy = fastest([&]()
+                                          { sink = X.transpose().cell(0, 0); });
+    const double transpose_view = fastest([&]()
+                                          { sink = samples.transpose().cell(0, 0); });
+    report("transpose", bytes, transpose_copy, transpose_view);
+
+    return 0;
+}
@@ -17,6 +17,8 @@
 #define NEURALACTIVATION_HPP
 
 #include "../lib/CMatrix/include/CMatrix.hpp"
+#include "NeuralSparse.hpp"
+#include "NeuralView.hpp"
 
 /**
  * @brief This class is used to define the activation functions used in neural networks.
@@ -49,6 +51,31 @@ public:
      * @return The updated weights matrix.
      */
     static cmatrix<float> dW_relu(const cmatrix<float> &X, const cmatrix<float> &y_true, const cmatrix<float> &weights);
+    /**
+     * @brief The gradient descent update rule for the rectified linear unit (ReLU) activation function with a view of the samples.
+     * The function is dW = dW + [X, 1] * y_true if y_pred != y_true. The samples are not copied.
+     *
+     * @param X The view of the training samples.
+     * @param y_true The target values.
+     * @param weights The weights matrix. Must be of size (X.width() + bias)x1.
+     * @param bias If true, the samples are augmented with a column of ones and the last weight is the bias. Default: false.
+     *
+     * @return The updated weights matrix.
+     *
+     * @throw std::invalid_argument If the weights matrix is not of size (X.width() + bias)x1.
+     */
+    static cmatrix<float> dW_relu(const NeuralView &X, const cmatrix<float> &y_true, const cmatrix<float> &weights, const bool &bias = false);
+    /**
+     * @brief The gradient descent update rule for the rectified linear unit (ReLU) activation function with sparse samples.
+     * The function is dW = dW + [X, 1] * y_true if y_pred != y_true. Only the non-zero features are updated.
+     *
+     * @param X The sparse training samples, not augmented. The last weight is the bias.
+     * @param y_true The target values.
+     * @param weights The weights matrix. Must be of size (X.width() + 1)x1.
+     *
+     * @return The updated weights matrix.
+     */
+    static cmatrix<float> dW_relu(const NeuralSparse &X, const cmatrix<float> &y_true, const cmatrix<float> &weights);
 };
 
 #endif // NEURALACTIVATION_HPP
@@ -0,0 +1,266 @@
+/**
+ * @defgroup NeuralAllocator NeuralAllocator
+ * @file NeuralAllocator.hpp
+ * @see src/NeuralAllocator.cpp for implementation.
+ * @brief The NeuralMemory and NeuralAllocator classes.
+ *
+ * This file defines the memory pools of the buffers of the models: the aligned, huge page backed and first touched allocations.
+ *
+ * @see Visit https://www.kernel.org/doc/html/latest/admin-guide/mm/transhuge.html for more information on the huge pages.
+ *
+ * @author Manitas Bahri <https://github.com/B-Manitas>
+ * @date 2023/11
+ * @license MIT License
+ */
+
+#ifndef NEURALALLOCATOR_HPP
+#define NEURALALLOCATOR_HPP
+
+// INCLUDES
+#include <atomic>
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @brief This class allocates the buffers of a kind (parameters, activations, workspace) and counts them.
+ *
+ * Every block is aligned on 64 bytes, the size of a cache line. The blocks of at least min_mapped_bytes are mapped
+ * directly, so they can be backed by huge pages, which divides the number of TLB misses of the large buffers:
+ * - TRANSPARENT: the block is aligned on a huge page and advised with madvise(MADV_HUGEPAGE).
+ * - EXPLICIT: the block is mapped with MAP_HUGETLB from the reserved huge pages. If none is available, it falls back to TRANSPARENT.
+ *
+ * A mapped block is first touched by the OpenMP threads with the static schedule of the kernels, so each page is placed
+ * on the NUMA node of the thread which computes it, instead of the node of the thread which allocates it.
+ *
+ * Example:
+ * @code
+ * NeuralMemory::activations().set_huge_pages(NeuralMemory::EXPLICIT);
+ * model.fit(X, y);
+ * std::cout << NeuralMemory::activations().stats().peak_bytes << std::endl;
+ * @endcode
+ */
+class NeuralMemory
+{
+public:
+    // STRUCTURES
+    /**
+     * @brief The huge pages policy of the mapped blocks.
+     */
+    enum HugePages
+    {
+        /**
+         * @brief The blocks use the default pages.
+         */
+        NONE,
+        /**
+         * @brief The blocks are advised to be backed by transparent huge pages.
+         */
+        TRANSPARENT,
+        /**
+         * @brief The blocks are backed by the reserved huge pages, or by transparent huge pages if none is available.
+         */
+        EXPLICIT
+    };
+
+    /**
+     * @brief The statistics of a pool.
+     */
+    struct Stats
+    {
+        size_t n_allocations = 0;
+        size_t n_deallocations = 0;
+        size_t bytes_in_use = 0;
+        size_t peak_bytes = 0;
+        /**
+         * @brief The bytes of the blocks in use which are mapped directly.
+         */
+        size_t mapped_bytes = 0;
+        /**
+         * @brief The bytes of the blocks in use which are backed by huge pages (explicit or advised).
+         */
+        size_t huge_page_bytes = 0;
+        /**
+         * @brief The number of explicit huge page mappings which fell back to transparent huge pages.
+         */
+        size_t n_fallbacks = 0;
+    };
+
+    /**
+     * @brief The alignment of every block, in bytes.
+     */
+    static const size_t ALIGNMENT = 64;
+    /**
+     * @brief The size of a huge page, in bytes.
+     */
+    static const size_t HUGE_PAGE_SIZE = 2 << 20;
+
+private:
+    // STRUCTURES
+    /**
+     * @brief A mapped block: the mapped range and the huge pages backing it.
+     */
+    struct Mapping
+    {
+        void *base;
+        size_t bytes;
+        bool huge;
+    };
+
+    // ATTRIBUTES
+    std::string m_name;
+    std::atomic<int> m_huge_pages;
+    std::atomic<bool> m_first_touch;
+    std::atomic<size_t> m_min_mapped_bytes;
+
+    std::atomic<size_t> m_n_allocations;
+    std::atomic<size_t> m_n_deallocations;
+    std::atomic<size_t> m_bytes_in_use;
+    std::atomic<size_t> m_peak_bytes;
+    std::atomic<size_t> m_mapped_bytes;
+    std::atomic<size_t> m_huge_page_bytes;
+    std::atomic<size_t> m_n_fallbacks;
+
+    std::mutex m_mutex;
+    std::map<void *, Mapping> m_mappings;
+
+    // METHODS
+    /**
+     * @brief Map a block, backed by huge pages according to the policy.
+     *
+     * @param bytes The size of the block.
+     * @return void* The block, or nullptr if the mapping failed.
+     */
+    void *__map(const size_t &bytes);
+    /**
+     * @brief Write the first value of each page of a block from the OpenMP threads.
+     */
+    static void __first_touch(void *block, const size_t &bytes);
+
+public:
+    // CONSTRUCTORS
+    /**
+     * @brief Construct a new Neural Memory object.
+     *
+     * @param name The name of the pool.
+     * @param huge_pages The huge pages policy of the mapped blocks. Default: TRANSPARENT.
+     * @param first_touch If true, the pages of the mapped blocks are first touched by the OpenMP threads. Default: true.
+     * @param min_mapped_bytes The minimum size of a mapped block. The smaller blocks come from the heap. Default: 1 MiB.
+     */
+    explicit NeuralMemory(const std::string &name, const HugePages &huge_pages = TRANSPARENT, const bool &first_touch = true, const size_t &min_mapped_bytes = 1 << 20);
+    NeuralMemory(const NeuralMemory &) = delete;
+    NeuralMemory &operator=(const NeuralMemory &) = delete;
+
+    // STATIC METHODS
+    /**
+     * @brief The pool of the parameters and of the gradients of the layers.
+     */
+    static NeuralMemory &parameters();
+    /**
+     * @brief The pool of the activations and of the deltas of the graphs.
+     */
+    static NeuralMemory &activations();
+    /**
+     * @brief The pool of the temporary buffers of the layers, such as the im2col columns. It is the default pool.
+     */
+    static NeuralMemory &workspace();
+
+    // GETTERS
+    const std::string &name() const;
+    HugePages huge_pages() const;
+    bool first_touch() const;
+    size_t min_mapped_bytes() const;
+    /**
+     * @brief Get a snapshot of the statistics of the pool.
+     */
+    Stats stats() const;
+
+    // SETTERS
+    /**
+     * @brief Set the huge pages policy of the next mapped blocks.
+     */
+    void set_huge_pages(const HugePages &huge_pages);
+    /**
+     * @brief Set if the pages of the next mapped blocks are first touched by the OpenMP threads.
+     */
+    void set_first_touch(const bool &first_touch);
+    /**
+     * @brief Set the minimum size of the next mapped blocks.
+     */
+    void set_min_mapped_bytes(const size_t &min_mapped_bytes);
+
+    // METHODS
+    /**
+     * @brief Allocate a block aligned on 64 bytes.
+     *
+     * @param bytes The size of the block.
+     * @param first_touch If false, the pages are not first touched, so the caller places them. Default: true.
+     * @return void* The block. Its values are not initialized.
+     *
+     * @throw std::bad_alloc If the block cannot be allocated.
+     */
+    void *allocate(const size_t &bytes, const bool &first_touch = true);
+    /**
+     * @brief Release a block of the pool.
+     *
+     * @param block The block.
+     * @param bytes The size of the block, as given to allocate.
+     */
+    void deallocate(void *block, const size_t &bytes);
+    /**
+     * @brief Reset the peak of the bytes in use to the current bytes in use.
+     */
+    void reset_peak();
+};
+
+/**
+ * @brief This class is a standard allocator which allocates its values in a NeuralMemory.
+ *
+ * @tparam T The type of the values.
+ */
+template <class T>
+class NeuralAllocator
+{
+private:
+    // ATTRIBUTES
+    NeuralMemory *m_pool;
+
+public:
+    // TYPES
+    typedef T value_type;
+    typedef std::true_type propagate_on_container_copy_assignment;
+    typedef std::true_type propagate_on_container_move_assignment;
+    typedef std::true_type propagate_on_container_swap;
+
+    // CONSTRUCTORS
+    /**
+     * @brief Construct an allocator of the workspace pool.
+     */
+    NeuralAllocator() : m_pool(&NeuralMemory::workspace()) {}
+    /**
+     * @brief Construct an allocator of a pool.
+     */
+    explicit NeuralAllocator(NeuralMemory &pool) : m_pool(&pool) {}
+    template <class U>
+    NeuralAllocator(const NeuralAllocator<U> &allocator) : m_pool(&allocator.pool()) {}
+
+    // METHODS
+    NeuralMemory &pool() const { return *m_pool; }
+    T *allocate(const size_t &n) { return static_cast<T *>(m_pool->allocate(n * sizeof(T))); }
+    void deallocate(T *block, const size_t &n) { m_pool->deallocate(block, n * sizeof(T)); }
+};
+
+template <class T, class U>
+bool operator==(const NeuralAllocator<T> &a, const NeuralAllocator<U> &b) { return &a.pool() == &b.pool(); }
+template <class T, class U>
+bool operator!=(const NeuralAllocator<T> &a, const NeuralAllocator<U> &b) { return &a.pool() != &b.pool(); }
+
+/**
+ * @brief A buffer of floats allocated in a NeuralMemory.
+ */
+typedef std::vector<float, NeuralAllocator<float>> NeuralBuffer;
+
+#endif // NEURALALLOCATOR_HPP
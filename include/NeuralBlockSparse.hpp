@@ -0,0 +1,138 @@
+/**
+ * @defgroup NeuralBlockSparse NeuralBlockSparse
+ * @file NeuralBlockSparse.hpp
+ * @see src/NeuralBlockSparse.cpp for implementation.
+ * @brief The NeuralBlockSparse class.
+ *
+ * This file defines the block compressed sparse row (BSR) matrix used to store the pruned weights of a layer.
+ *
+ * @see Visit https://docs.scipy.org/doc/scipy/reference/generated/scipy.sparse.bsr_matrix.html for more information.
+ *
+ * @author Manitas Bahri <https://github.com/B-Manitas>
+ * @date 2023/11
+ * @license MIT License
+ */
+
+#ifndef NEURALBLOCKSPARSE_HPP
+#define NEURALBLOCKSPARSE_HPP
+
+// INCLUDES
+#include <istream>
+#include <ostream>
+#include <vector>
+
+#include "NeuralAllocator.hpp"
+
+/**
+ * @brief This class stores a sparse matrix of floats in the block compressed sparse row (BSR) format.
+ *
+ * The matrix is split in blocks of block_height x block_width values and only the blocks containing a non-zero
+ * value are stored, as dense blocks. Each block is multiplied with contiguous values of the dense operand,
+ * so the products are vectorized, unlike the products of a CSR matrix which gather one value per non-zero.
+ *
+ * The blocks of the last block row and of the last block column may exceed the matrix: their extra values are 0.
+ */
+class NeuralBlockSparse
+{
+private:
+    // ATTRIBUTES
+    size_t m_height = 0;
+    size_t m_width = 0;
+    size_t m_block_height = 1;
+    size_t m_block_width = 1;
+
+    /**
+     * @brief The blocks of the block row i are the blocks m_block_ptr[i] to m_block_ptr[i + 1] - 1.
+     */
+    std::vector<size_t> m_block_ptr = {0};
+    /**
+     * @brief The block column of each block.
+     */
+    std::vector<size_t> m_block_col = {};
+    /**
+     * @brief The values of each block, stored row by row, one block after the other.
+     */
+    NeuralBuffer m_values = NeuralBuffer(NeuralAllocator<float>(NeuralMemory::parameters()));
+
+    // CHECKS
+    /**
+     * @brief Check if the size of the blocks is valid.
+     *
+     * @throw std::invalid_argument If a size of the blocks is not in [1, 16].
+     */
+    static void __check_valid_block(const size_t &block_height, const size_t &block_width);
+
+public:
+    // CONSTRUCTORS
+    /**
+     * @brief Construct an empty block sparse matrix.
+     */
+    NeuralBlockSparse();
+    /**
+     * @brief Create a block sparse matrix from a dense matrix, stored row by row. The blocks containing only zeros are not stored.
+     *
+     * @param M The dense matrix.
+     * @param height The number of rows.
+     * @param width The number of columns.
+     * @param ld The distance between two rows of M.
+     * @param block_height The number of rows of a block, in [1, 16].
+     * @param block_width The number of columns of a block, in [1, 16].
+     * @return NeuralBlockSparse The block sparse matrix.
+     *
+     * @throw std::invalid_argument If a size of the blocks is not valid.
+     */
+    static NeuralBlockSparse from_dense(const float *M, const size_t &height, const size_t &width, const size_t &ld, const size_t &block_height, const size_t &block_width);
+
+    // GETTERS
+    size_t height() const;
+    size_t width() const;
+    size_t block_height() const;
+    size_t block_width() const;
+    /**
+     * @brief Get the number of stored blocks.
+     */
+    size_t n_blocks() const;
+    /**
+     * @brief Get the ratio of stored blocks. It is n_blocks / the number of blocks of the matrix.
+     */
+    float density() const;
+    /**
+     * @brief Check if the matrix is empty (0 x 0).
+     */
+    bool is_empty() const;
+
+    // METHODS
+    /**
+     * @brief Write the matrix in a dense matrix, stored row by row. The values outside of the stored blocks are set to 0.
+     *
+     * @param M The dense matrix, of size height() x ld.
+     * @param ld The distance between two rows of M.
+     */
+    void to_dense(float *M, const size_t &ld) const;
+    /**
+     * @brief Compute the product X * S^T, where S is the current matrix.
+     *
+     * @param X The dense matrix of size batch x width(), stored row by row.
+     * @param batch The number of rows of X.
+     * @param out The dense matrix of size batch x height(), stored row by row. It is overwritten.
+     * @param parallel If true, the rows of X are computed in parallel. Default: true.
+     */
+    void matmul_transpose(const float *X, const size_t &batch, float *out, const bool &parallel = true) const;
+
+    /**
+     * @brief Write the matrix in a stream.
+     *
+     * @param stream The output stream.
+     */
+    void save(std::ostream &stream) const;
+    /**
+     * @brief Read a matrix written by save.
+     *
+     * @param stream The input stream.
+     *
+     * @throw std::runtime_error If the stream does not contain a valid matrix.
+     */
+    void load(std::istream &stream);
+};
+
+#endif // NEURALBLOCKSPARSE_HPP
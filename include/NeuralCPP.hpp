@@ -13,10 +13,23 @@
 #define NEURALCPP_HPP
 
 // INCLUDES
+#include "NeuralAllocator.hpp"
 #include "NeuralActivation.hpp"
+#include "NeuralExpr.hpp"
 #include "NeuralLoss.hpp"
 #include "NeuralPerceptron.hpp"
+#include "NeuralLayer.hpp"
+#include "NeuralGraph.hpp"
+#include "NeuralBlockSparse.hpp"
+#include "NeuralPruner.hpp"
 #include "NeuralLayers.hpp"
+#include "NeuralScaler.hpp"
+#include "NeuralSparse.hpp"
+#include "NeuralView.hpp"
+#include "NeuralSearch.hpp"
+#include "NeuralScorer.hpp"
+#include "NeuralDistributed.hpp"
+#include "NeuralTuner.hpp"
 
 #include <random>
 
@@ -39,6 +52,18 @@ public:
      * @return std::tuple<cmatrix<float>, cmatrix<float>> The dataset.
      */
     static void create_dataset(cmatrix<float> &X, cmatrix<float> &y, const int &n_samples, const int &n_features, const int &n_classes = 2, const int &random_state = 0);
+    /**
+     * @brief Create a random sparse dataset. Only the non-zero values are generated, so the memory scales with the number of non-zero values.
+     *
+     * @param X The sparse input matrix. (n_features, n_samples)
+     * @param y The output matrix. (1, n_samples)
+     * @param n_samples The number of samples.
+     * @param n_features The number of features.
+     * @param density The expected ratio of non-zero features of each sample. Must be in ]0, 1].
+     * @param n_classes The number of classes. Default is 2.
+     * @param random_state The random state. Default is 0.
+     */
+    static void create_dataset(NeuralSparse &X, cmatrix<float> &y, const int &n_samples, const int &n_features, const float &density, const int &n_classes = 2, const int &random_state = 0);
 };
 
 #endif // NEURALCPP_HPP
@@ -0,0 +1,179 @@
+/**
+ * @defgroup NeuralComm NeuralComm
+ * @file NeuralComm.hpp
+ * @see src/NeuralComm.cpp for implementation.
+ * @brief The NeuralComm classes.
+ *
+ * This file defines the collective communications between the worker processes of a data-parallel training:
+ * an all-reduce over POSIX shared memory and a ring all-reduce over loopback TCP.
+ *
+ * @see Visit https://en.wikipedia.org/wiki/Collective_operation#All-Reduce for more information.
+ *
+ * @author Manitas Bahri <https://github.com/B-Manitas>
+ * @date 2023/11
+ * @license MIT License
+ */
+
+#ifndef NEURALCOMM_HPP
+#define NEURALCOMM_HPP
+
+// INCLUDES
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * @brief This class is the interface of the collective communications between the workers.
+ *
+ * Every worker must call the collective methods in the same order.
+ */
+class NeuralComm
+{
+protected:
+    // ATTRIBUTES
+    int m_rank = 0;
+    int m_size = 1;
+
+public:
+    // CONSTRUCTORS
+    NeuralComm(const int &size);
+    virtual ~NeuralComm();
+
+    // METHODS
+    /**
+     * @brief Get the index of the current worker.
+     */
+    int rank() const;
+    /**
+     * @brief Get the number of workers.
+     */
+    int size() const;
+    /**
+     * @brief Sum the data of every worker. Each worker gets the sum in data.
+     *
+     * @param data The data to reduce. Must be of the same size on every worker.
+     */
+    void allreduce(std::vector<float> &data);
+    /**
+     * @brief Sum the data of every worker, in place. It reduces any buffer, such as the gradients of a layer.
+     *
+     * @param data The data to reduce.
+     * @param n The number of values. Must be the same on every worker.
+     */
+    virtual void allreduce(float *data, const size_t &n) = 0;
+    /**
+     * @brief Block until every worker reaches the barrier.
+     */
+    virtual void barrier() = 0;
+};
+
+/**
+ * @brief This class reduces the data over a POSIX shared memory segment.
+ *
+ * Each worker writes its data in its own slot, then reduces its own chunk over all the slots
+ * (reduce-scatter) and finally reads the whole result (all-gather).
+ *
+ * @note The segment must be created by the parent process before forking the workers. Each worker then calls attach().
+ */
+class NeuralShmComm : public NeuralComm
+{
+private:
+    // ATTRIBUTES
+    struct Header;
+
+    size_t m_capacity = 0;
+    size_t m_bytes = 0;
+    Header *m_header = nullptr;
+    float *m_slots = nullptr;
+    float *m_result = nullptr;
+    bool m_owner = true;
+
+public:
+    // CONSTRUCTORS
+    /**
+     * @brief Create the shared memory segment.
+     *
+     * @param size The number of workers.
+     * @param capacity The maximum number of floats reduced at once.
+     *
+     * @throw std::runtime_error If the segment cannot be created.
+     */
+    NeuralShmComm(const int &size, const size_t &capacity);
+    /**
+     * @brief Unmap the segment. The parent process also destroys the barrier.
+     */
+    ~NeuralShmComm();
+
+    NeuralShmComm(const NeuralShmComm &) = delete;
+    NeuralShmComm &operator=(const NeuralShmComm &) = delete;
+
+    // METHODS
+    /**
+     * @brief Set the rank of the current worker. It must be called by each forked worker.
+     *
+     * @param rank The index of the worker.
+     *
+     * @throw std::invalid_argument If the rank is out of range.
+     */
+    void attach(const int &rank);
+    /**
+     * @throw std::invalid_argument If the data is larger than the capacity.
+     */
+    void allreduce(float *data, const size_t &n) override;
+    using NeuralComm::allreduce;
+    void barrier() override;
+};
+
+/**
+ * @brief This class reduces the data with a ring all-reduce over TCP sockets.
+ *
+ * Each worker listens on base_port + rank, sends to the next worker of the ring and receives from the previous one.
+ * On a single machine it uses the loopback interface, as a stand-in for the network between nodes.
+ */
+class NeuralTcpComm : public NeuralComm
+{
+private:
+    // ATTRIBUTES
+    int m_send_fd = -1;
+    int m_recv_fd = -1;
+
+    // METHODS
+    /**
+     * @brief Send the floats to the next worker while receiving the same number of floats from the previous one.
+     *
+     * @param send The floats to send.
+     * @param recv The buffer of the received floats.
+     * @param count The number of floats.
+     */
+    void __exchange(const float *send, float *recv, const size_t &count);
+
+public:
+    // CONSTRUCTORS
+    /**
+     * @brief Connect the worker to its neighbours of the ring.
+     *
+     * @param rank The index of the worker.
+     * @param size The number of workers.
+     * @param host The IPv4 address of the workers. Default: loopback.
+     * @param base_port The port of the worker 0. Default: 29500.
+     * @param timeout The maximum number of seconds to wait for the other workers. Default: 30.
+     *
+     * @throw std::invalid_argument If the rank is out of range, or if the host is not an IPv4 address.
+     * @throw std::runtime_error If the connection fails. The sockets opened so far are closed.
+     */
+    NeuralTcpComm(const int &rank, const int &size, const std::string &host = "127.0.0.1", const int &base_port = 29500, const int &timeout = 30);
+    /**
+     * @brief Close the sockets.
+     */
+    ~NeuralTcpComm();
+
+    NeuralTcpComm(const NeuralTcpComm &) = delete;
+    NeuralTcpComm &operator=(const NeuralTcpComm &) = delete;
+
+    // METHODS
+    void allreduce(float *data, const size_t &n) override;
+    using NeuralComm::allreduce;
+    void barrier() override;
+};
+
+#endif // NEURALCOMM_HPP
@@ -0,0 +1,163 @@
+/**
+ * @defgroup NeuralDistributed NeuralDistributed
+ * @file NeuralDistributed.hpp
+ * @see src/NeuralDistributed.cpp for implementation.
+ * @brief The NeuralDistributed class.
+ *
+ * This file defines the multi-process data-parallel training of the NeuralLayers model.
+ *
+ * @see Visit https://en.wikipedia.org/wiki/Data_parallelism for more information.
+ *
+ * @author Manitas Bahri <https://github.com/B-Manitas>
+ * @date 2023/11
+ * @license MIT License
+ */
+
+#ifndef NEURALDISTRIBUTED_HPP
+#define NEURALDISTRIBUTED_HPP
+
+// INCLUDES
+#include "NeuralComm.hpp"
+#include "NeuralLayers.hpp"
+
+/**
+ * @brief This class trains a NeuralLayers model with several worker processes (data parallelism).
+ *
+ * Each worker is a forked process training on its own shard of the samples: the shard r contains the samples r, r + n, r + 2n...
+ * At each epoch, the gradient of each layer is summed over the workers with an all-reduce as soon as the back propagation
+ * computed it, so the communication of a layer overlaps the back propagation of the previous layers.
+ *
+ * Each worker runs with one OpenMP thread: the threads of the parent are not copied by fork(), and the OpenMP runtime
+ * of a forked process cannot start new ones. Use as many workers as cores.
+ *
+ * @warning The workers are created with fork(). It requires a POSIX system (Linux).
+ */
+class NeuralDistributed
+{
+public:
+    // STRUCTURES
+    /**
+     * @brief The transport of the all-reduce.
+     */
+    enum Transport
+    {
+        /**
+         * @brief The workers reduce the gradients in a POSIX shared memory segment.
+         */
+        SHARED_MEMORY,
+        /**
+         * @brief The workers reduce the gradients with a ring all-reduce over loopback TCP, as between several nodes.
+         */
+        TCP
+    };
+
+    /**
+     * @brief The report of a training.
+     */
+    struct Report
+    {
+        int n_workers;
+        /**
+         * @brief The wall time of the training, in seconds.
+         */
+        float seconds;
+        /**
+         * @brief The longest computation time of a worker, in seconds.
+         */
+        float compute_seconds;
+        /**
+         * @brief The longest time a worker waited for the all-reduce after its back propagation, in seconds.
+         */
+        float wait_seconds;
+        /**
+         * @brief The mean ratio compute / (compute + wait) of the workers: the part of the communication hidden behind
+         * the back propagation. 1 means the communication is fully hidden.
+         */
+        float overlap;
+        /**
+         * @brief The time of the same training on one worker, in seconds: a full-batch epoch of one worker on all the
+         * samples is timed after the training, without communication.
+         */
+        float serial_seconds;
+        /**
+         * @brief The speedup over one worker: serial_seconds / the longest training time of a worker.
+         */
+        float speedup;
+        /**
+         * @brief The scaling efficiency: speedup / n_workers. 1 means a linear scaling.
+         */
+        float efficiency;
+        /**
+         * @brief The number of samples processed per second by all the workers.
+         */
+        float samples_per_second;
+    };
+
+private:
+    // ATTRIBUTES
+    int m_n_workers = 1;
+    Transport m_transport = SHARED_MEMORY;
+    int m_base_port = 29500;
+
+    struct WorkerStats;
+
+    // METHODS
+    /**
+     * @brief Train the shard of a worker.
+     *
+     * @param model The model, with its weights initialized identically on every worker.
+     * @param X The input matrix.
+     * @param y The output matrix.
+     * @param epochs The number of epochs.
+     * @param learning_rate The learning rate.
+     * @param comm The communication between the workers.
+     * @param stats The statistics of the worker.
+     */
+    void __train_worker(NeuralLayers &model, const cmatrix<float> &X, const cmatrix<float> &y, const int &epochs, const float &learning_rate, NeuralComm &comm, WorkerStats &stats) const;
+    /**
+     * @brief Get the time of a full-batch epoch of one worker on all the samples, the baseline of the speedup.
+     * The weights of the model are updated.
+     *
+     * @return double The fastest of 3 epochs, in seconds.
+     */
+    double __time_serial_epoch(NeuralLayers &model, const cmatrix<float> &X, const cmatrix<float> &y, const float &learning_rate) const;
+
+public:
+    // ATTRIBUTES
+    /**
+     * @brief The report of the last training.
+     */
+    Report report = {};
+
+    // CONSTRUCTORS
+    /**
+     * @brief Construct a new Neural Distributed object.
+     *
+     * @param n_workers The number of worker processes.
+     * @param transport The transport of the all-reduce. Default: SHARED_MEMORY.
+     * @param base_port The port of the worker 0 with the TCP transport. The worker r uses base_port + r. Default: 29500.
+     *
+     * @throw std::invalid_argument If the number of workers is not greater than 0.
+     */
+    NeuralDistributed(const int &n_workers, const Transport &transport = SHARED_MEMORY, const int &base_port = 29500);
+
+    // METHODS
+    /**
+     * @brief Fits the model to the data X and y with the worker processes.
+     * The result is the same as a full-batch training of the model on one process, up to the floating point rounding.
+     *
+     * @param model The model to train. Its weights are replaced by the trained weights.
+     * @param X The input matrix. Each column represents a sample and each row represents a feature.
+     * @param y The output matrix. Must be a row matrix with the same number of columns as X. Must contain only 0 and 1.
+     * @param epochs The number of epochs. Default: 1000.
+     * @param learning_rate The learning rate. Default: .01.
+     * @return const Report& The report of the training, with the speedup and the scaling efficiency over one worker.
+     *
+     * @throw std::invalid_argument If there are less samples than workers, if y does not have a column per sample,
+     * or if a layer has sparse gradients (NeuralEmbedding).
+     * @throw std::runtime_error If a worker fails or cannot be forked. The other workers are killed.
+     */
+    const Report &fit(NeuralLayers &model, const cmatrix<float> &X, const cmatrix<float> &y, const int &epochs = 1000, const float &learning_rate = .01);
+};
+
+#endif // NEURALDISTRIBUTED_HPP
@@ -0,0 +1,350 @@
+/**
+ * @defgroup NeuralExpr NeuralExpr
+ * @file NeuralExpr.hpp
+ * @brief The NeuralExpr expression templates.
+ *
+ * This file defines the lazy elementwise expressions of matrices of floats, evaluated in one fused loop.
+ *
+ * @see Visit https://en.wikipedia.org/wiki/Expression_templates for more information.
+ *
+ * @author Manitas Bahri <https://github.com/B-Manitas>
+ * @date 2023/11
+ * @license MIT License
+ */
+
+#ifndef NEURALEXPR_HPP
+#define NEURALEXPR_HPP
+
+// INCLUDES
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+
+#include "../lib/CMatrix/include/CMatrix.hpp"
+
+template <class E, class Op>
+class NeuralExprUnary;
+
+/**
+ * @brief The elementwise operations of the expressions.
+ */
+struct NeuralOp
+{
+    struct Add
+    {
+        static float apply(const float &a, const float &b) { return a + b; }
+    };
+    struct Sub
+    {
+        static float apply(const float &a, const float &b) { return a - b; }
+    };
+    struct Mul
+    {
+        static float apply(const float &a, const float &b) { return a * b; }
+    };
+    struct Div
+    {
+        static float apply(const float &a, const float &b) { return a / b; }
+    };
+    struct Neg
+    {
+        static float apply(const float &a) { return -a; }
+    };
+    struct Abs
+    {
+        static float apply(const float &a) { return std::fabs(a); }
+    };
+    struct Square
+    {
+        static float apply(const float &a) { return a * a; }
+    };
+    struct Sign
+    {
+        static float apply(const float &a) { return (float)(a > 0) - (float)(a < 0); }
+    };
+    struct Exp
+    {
+        static float apply(const float &a) { return std::exp(a); }
+    };
+};
+
+/**
+ * @brief This class is the base of a lazy elementwise expression of matrices of floats.
+ *
+ * Combining expressions with the operators +, -, * and / and the methods abs, square, sign and exp only builds
+ * a small tree of references: nothing is computed. The expression is computed when it is evaluated in a matrix,
+ * or reduced by sum_all, in a single loop over its values split in blocks, vectorized and parallel for the large
+ * matrices. The blocks span the rows, so a row matrix, such as the targets of a loss, is parallel too.
+ * A chain of n operations thus reads each operand once, writes the output once and allocates at most the output,
+ * instead of n temporaries.
+ *
+ * Example:
+ * @code
+ * // MSE, without any temporary
+ * const float mse = (NeuralLazy(y_pred) - NeuralLazy(y_true)).square().sum_all() / n;
+ * // W -= learning_rate * dW, in place
+ * (NeuralLazy(W) - learning_rate * NeuralLazy(dW)).eval_to(W);
+ * @endcode
+ *
+ * @warning An expression references its matrices: they must outlive it. Evaluate it in the statement where it is built.
+ *
+ * @tparam E The type of the expression.
+ */
+template <class E>
+class NeuralExpr
+{
+public:
+    // GETTERS
+    /**
+     * @brief Get the expression as its derived type.
+     */
+    const E &self() const { return static_cast<const E &>(*this); }
+    size_t height() const { return self().rows(); }
+    size_t width() const { return self().columns(); }
+
+    // METHODS
+    NeuralExprUnary<E, NeuralOp::Neg> operator-() const;
+    NeuralExprUnary<E, NeuralOp::Abs> abs() const;
+    NeuralExprUnary<E, NeuralOp::Square> square() const;
+    NeuralExprUnary<E, NeuralOp::Sign> sign() const;
+    NeuralExprUnary<E, NeuralOp::Exp> exp() const;
+
+    /**
+     * @brief Computes the expression in a matrix, in one pass. The matrix may be an operand of the expression.
+     *
+     * @param out The output matrix. It is resized only if its size does not match.
+     */
+    void eval_to(cmatrix<float> &out) const
+    {
+        const size_t h = height(), w = width(), n = h * w, block = 4096;
+        if (out.height() != h || out.width() != w)
+            out = cmatrix<float>(h, w);
+
+        // Each value of the output only depends on the same value of the operands, so the output may alias them.
+        // Each thread computes blocks of the values, each block being split in the pieces of the rows it spans.
+#pragma omp parallel for schedule(static) if (n > 65536)
+        for (size_t b = 0; b < n; b += block)
+        {
+            const size_t end = std::min(b + block, n);
+
+            for (size_t k = b; k < end;)
+            {
+                const size_t i = k / w, first = k % w, last = std::min(w, first + end - k);
+                const typename E::Row row = self().row(i);
+                float *o = &out.cell(i, 0);
+
+#pragma omp simd
+                for (size_t j = first; j < last; j++)
+                    o[j] = row[j];
+
+                k += last - first;
+            }
+        }
+    }
+    /**
+     * @brief Computes the expression in a new matrix.
+     */
+    cmatrix<float> eval() const
+    {
+        cmatrix<float> out(height(), width());
+        eval_to(out);
+
+        return out;
+    }
+    /**
+     * @brief Computes the sum of the values of the expression, without storing them.
+     */
+    float sum_all() const
+    {
+        const size_t h = height(), w = width(), n = h * w, block = 256;
+        double sum = 0;
+
+        // The values are split in blocks spanning the rows, so a row matrix is parallel too.
+        // A block is summed in float, vectorized, and the blocks are accumulated in double.
+#pragma omp parallel for schedule(static) reduction(+ : sum) if (n > 65536)
+        for (size_t b = 0; b < n; b += block)
+        {
+            const size_t end = std::min(b + block, n);
+            float s = 0;
+
+            for (size_t k = b; k < end;)
+            {
+                const size_t i = k / w, first = k % w, last = std::min(w, first + end - k);
+                const typename E::Row row = self().row(i);
+
+#pragma omp simd reduction(+ : s)
+                for (size_t j = first; j < last; j++)
+                    s += row[j];
+
+                k += last - first;
+            }
+
+            sum += s;
+        }
+
+        return sum;
+    }
+};
+
+/**
+ * @brief This class is the leaf of an expression: a reference to a matrix.
+ */
+class NeuralLazy : public NeuralExpr<NeuralLazy>
+{
+private:
+    // ATTRIBUTES
+    const cmatrix<float> *m_X;
+
+public:
+    // STRUCTURES
+    struct Row
+    {
+        const float *values;
+        float operator[](const size_t &j) const { return values[j]; }
+    };
+    static const bool IS_SCALAR = false;
+
+    // CONSTRUCTORS
+    /**
+     * @brief Construct the expression of a matrix. The matrix is not copied.
+     */
+    explicit NeuralLazy(const cmatrix<float> &X) : m_X(&X) {}
+
+    // METHODS
+    size_t rows() const { return m_X->height(); }
+    size_t columns() const { return m_X->width(); }
+    Row row(const size_t &i) const { return Row{m_X->width() ? &m_X->cell(i, 0) : nullptr}; }
+};
+
+/**
+ * @brief This class is a scalar operand of an expression. It matches the size of the other operand.
+ */
+class NeuralExprScalar : public NeuralExpr<NeuralExprScalar>
+{
+private:
+    // ATTRIBUTES
+    float m_value;
+
+public:
+    // STRUCTURES
+    struct Row
+    {
+        float value;
+        float operator[](const size_t &) const { return value; }
+    };
+    static const bool IS_SCALAR = true;
+
+    // CONSTRUCTORS
+    explicit NeuralExprScalar(const float &value) : m_value(value) {}
+
+    // METHODS
+    size_t rows() const { return 0; }
+    size_t columns() const { return 0; }
+    Row row(const size_t &) const { return Row{m_value}; }
+};
+
+/**
+ * @brief This class is an elementwise operation of two expressions of the same size, or of an expression and a scalar.
+ */
+template <class L, class R, class Op>
+class NeuralExprBinary : public NeuralExpr<NeuralExprBinary<L, R, Op>>
+{
+private:
+    // ATTRIBUTES
+    const L m_left;
+    const R m_right;
+
+public:
+    // STRUCTURES
+    struct Row
+    {
+        typename L::Row left;
+        typename R::Row right;
+        float operator[](const size_t &j) const { return Op::apply(left[j], right[j]); }
+    };
+    static const bool IS_SCALAR = false;
+
+    // CONSTRUCTORS
+    /**
+     * @throw std::invalid_argument If the sizes of the expressions do not match.
+     */
+    NeuralExprBinary(const L &left, const R &right) : m_left(left), m_right(right)
+    {
+        if (!L::IS_SCALAR && !R::IS_SCALAR && (left.rows() != right.rows() || left.columns() != right.columns()))
+            throw std::invalid_argument("The sizes of the operands must match: " + std::to_string(left.rows()) + "x" + std::to_string(left.columns()) + " and " + std::to_string(right.rows()) + "x" + std::to_string(right.columns()));
+    }
+
+    // METHODS
+    size_t rows() const { return L::IS_SCALAR ? m_right.rows() : m_left.rows(); }
+    size_t columns() const { return L::IS_SCALAR ? m_right.columns() : m_left.columns(); }
+    Row row(const size_t &i) const { return Row{m_left.row(i), m_right.row(i)}; }
+};
+
+/**
+ * @brief This class is an elementwise function of an expression.
+ */
+template <class E, class Op>
+class NeuralExprUnary : public NeuralExpr<NeuralExprUnary<E, Op>>
+{
+private:
+    // ATTRIBUTES
+    const E m_operand;
+
+public:
+    // STRUCTURES
+    struct Row
+    {
+        typename E::Row operand;
+        float operator[](const size_t &j) const { return Op::apply(operand[j]); }
+    };
+    static const bool IS_SCALAR = false;
+
+    // CONSTRUCTORS
+    explicit NeuralExprUnary(const E &operand) : m_operand(operand) {}
+
+    // METHODS
+    size_t rows() const { return m_operand.rows(); }
+    size_t columns() const { return m_operand.columns(); }
+    Row row(const size_t &i) const { return Row{m_operand.row(i)}; }
+};
+
+template <class E>
+NeuralExprUnary<E, NeuralOp::Neg> NeuralExpr<E>::operator-() const { return NeuralExprUnary<E, NeuralOp::Neg>(self()); }
+template <class E>
+NeuralExprUnary<E, NeuralOp::Abs> NeuralExpr<E>::abs() const { return NeuralExprUnary<E, NeuralOp::Abs>(self()); }
+template <class E>
+NeuralExprUnary<E, NeuralOp::Square> NeuralExpr<E>::square() const { return NeuralExprUnary<E, NeuralOp::Square>(self()); }
+template <class E>
+NeuralExprUnary<E, NeuralOp::Sign> NeuralExpr<E>::sign() const { return NeuralExprUnary<E, NeuralOp::Sign>(self()); }
+template <class E>
+NeuralExprUnary<E, NeuralOp::Exp> NeuralExpr<E>::exp() const { return NeuralExprUnary<E, NeuralOp::Exp>(self()); }
+
+// OPERATORS
+// Each operator combines two expressions, an expression and a scalar, or a scalar and an expression.
+#define NEURALEXPR_OPERATOR(symbol, Op)                                                                                  \
+    template <class L, class R>                                                                                          \
+    NeuralExprBinary<L, R, NeuralOp::Op> operator symbol(const NeuralExpr<L> &left, const NeuralExpr<R> &right)         \
+    {                                                                                                                    \
+        return NeuralExprBinary<L, R, NeuralOp::Op>(left.self(), right.self());                                         \
+    }                                                                                                                    \
+    template <class L>                                                                                                   \
+    NeuralExprBinary<L, NeuralExprScalar, NeuralOp::Op> operator symbol(const NeuralExpr<L> &left, const float &right)   \
+    {                                                                                                                    \
+        return NeuralExprBinary<L, NeuralExprScalar, NeuralOp::Op>(left.self(), NeuralExprScalar(right));               \
+    }                                                                                                                    \
+    template <class R>                                                                                                   \
+    NeuralExprBinary<NeuralExprScalar, R, NeuralOp::Op> operator symbol(const float &left, const NeuralExpr<R> &right)   \
+    {                                                                                                                    \
+        return NeuralExprBinary<NeuralExprScalar, R, NeuralOp::Op>(NeuralExprScalar(left), right.self());               \
+    }
+
+NEURALEXPR_OPERATOR(+, Add)
+NEURALEXPR_OPERATOR(-, Sub)
+NEURALEXPR_OPERATOR(*, Mul)
+NEURALEXPR_OPERATOR(/, Div)
+
+#undef NEURALEXPR_OPERATOR
+
+#endif // NEURALEXPR_HPP
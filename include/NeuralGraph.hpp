@@ -0,0 +1,202 @@
+/**
+ * @defgroup NeuralGraph NeuralGraph
+ * @file NeuralGraph.hpp
+ * @see src/NeuralGraph.cpp for implementation.
+ * @brief The NeuralGraph class.
+ *
+ * This file defines the graph of layers executed by the NeuralLayers model.
+ *
+ * @author Manitas Bahri <https://github.com/B-Manitas>
+ * @date 2023/11
+ * @license MIT License
+ */
+
+#ifndef NEURALGRAPH_HPP
+#define NEURALGRAPH_HPP
+
+// INCLUDES
+#include <functional>
+#include <istream>
+#include <ostream>
+#include <vector>
+
+#include "NeuralLayer.hpp"
+
+/**
+ * @brief This class chains layers, from the input to the output.
+ *
+ * The graph is built for a shape of input, which computes the shape of each layer and initializes their parameters.
+ * Then it is planned for a number of samples: the buffers of the activations and of the gradients are allocated once
+ * and reused by every forward and backward of this size.
+ *
+ * The output is trained with the cross-entropy: for a sigmoid output, the gradient of its input is y_pred - y_true.
+ *
+ * Example:
+ * @code
+ * NeuralGraph graph(NeuralLayer::Shape(1, 28, 28));
+ * graph.add(NeuralConv2D(8, 3, 3)).add(NeuralPool(2, 2)).add(NeuralDense(32)).add(NeuralDense(1));
+ * NeuralLayers model(graph);
+ * @endcode
+ */
+class NeuralGraph
+{
+private:
+    // ATTRIBUTES
+    NeuralLayer::Shape m_input_shape = NeuralLayer::Shape();
+    std::vector<NeuralLayer *> m_layers = {};
+    bool m_built = false;
+
+    size_t m_batch = 0;
+    size_t m_first_layer = 0;
+    /**
+     * @brief The activations: the buffer i is the input of the layer i, the last buffer is the output.
+     */
+    std::vector<NeuralBuffer> m_activations = {};
+    /**
+     * @brief Two buffers of gradients, swapped after each layer of the backward.
+     */
+    NeuralBuffer m_deltas[2] = {NeuralBuffer(NeuralAllocator<float>(NeuralMemory::activations())), NeuralBuffer(NeuralAllocator<float>(NeuralMemory::activations()))};
+
+    // METHODS
+    /**
+     * @brief Checks if the graph is built.
+     *
+     * @throw std::runtime_error If the graph is not built.
+     */
+    void __check_built() const;
+
+public:
+    // ATTRIBUTES
+    /**
+     * @brief If set, it is called by backward as soon as the gradients of a layer with parameters are computed.
+     */
+    std::function<void(const size_t &layer, NeuralBuffer &gradients)> on_gradient = nullptr;
+
+    // CONSTRUCTORS
+    /**
+     * @brief Construct a new empty Neural Graph object.
+     *
+     * @param input_shape The shape of an input sample. Set the channels to 0 to use a vector of features,
+     * with the number of features of the data. Default: vector of features.
+     */
+    explicit NeuralGraph(const NeuralLayer::Shape &input_shape = NeuralLayer::Shape());
+    NeuralGraph(const NeuralGraph &other);
+    NeuralGraph &operator=(const NeuralGraph &other);
+    ~NeuralGraph();
+
+    // METHODS
+    /**
+     * @brief Adds a copy of a layer at the end of the graph.
+     *
+     * @param layer The layer.
+     * @return NeuralGraph& The graph, to chain the calls.
+     */
+    NeuralGraph &add(const NeuralLayer &layer);
+    /**
+     * @brief Adds a layer at the end of the graph. The graph takes the ownership of the layer.
+     *
+     * @param layer The layer, allocated with new.
+     * @return NeuralGraph& The graph, to chain the calls.
+     */
+    NeuralGraph &add(NeuralLayer *layer);
+    /**
+     * @brief Get the number of layers.
+     */
+    size_t size() const;
+    /**
+     * @brief Get a layer.
+     *
+     * @param i The index of the layer.
+     */
+    NeuralLayer &layer(const size_t &i);
+    const NeuralLayer &layer(const size_t &i) const;
+    /**
+     * @brief Check if the graph is built.
+     */
+    bool is_built() const;
+    /**
+     * @brief Get the shape of an input sample.
+     */
+    const NeuralLayer::Shape &input_shape() const;
+    /**
+     * @brief Get the number of values of an output sample.
+     */
+    size_t output_size() const;
+
+    /**
+     * @brief Builds every layer and initializes their parameters. The layer i is initialized with the seed random_state + i + 1.
+     *
+     * @param n_features The number of features of an input sample.
+     * @param random_state The random state. Default: 0.
+     *
+     * @throw std::invalid_argument If the graph is empty, if the input shape does not match the number of features, or if a layer does not fit.
+     */
+    void build(const size_t &n_features, const int &random_state = 0);
+    /**
+     * @brief Allocates the buffers for a number of samples. It does nothing if the graph is already planned for this number.
+     *
+     * @param batch The number of samples.
+     * @param first_layer The first layer executed. The activations before it are not allocated. Default: 0.
+     *
+     * @throw std::runtime_error If the graph is not built.
+     */
+    void plan(const size_t &batch, const size_t &first_layer = 0);
+    /**
+     * @brief Get the number of samples of the planned buffers.
+     */
+    size_t batch() const;
+    /**
+     * @brief Get the buffer of the activation i, of size batch x size of a sample. The buffer 0 is the input.
+     */
+    float *activation(const size_t &i);
+    /**
+     * @brief Computes the activations of the layers from first_layer to the last one.
+     * The buffer of the activation first_layer must be filled.
+     *
+     * @param training If true, the layers are in training mode (dropout).
+     * @param first_layer The first layer to compute. Default: 0.
+     * @return const float* The output, of size batch x output_size().
+     */
+    const float *forward(const bool &training, const size_t &first_layer = 0);
+    /**
+     * @brief Computes the gradients of the layers from the last one down to first_layer.
+     *
+     * @param y The expected output, of size batch x output_size().
+     * @param first_layer The last layer for which the gradients are computed. Default: 0.
+     * @return float* The gradient of the activation first_layer, or nullptr if first_layer is 0.
+     */
+    float *backward(const std::vector<float> &y, const size_t &first_layer = 0);
+    /**
+     * @brief Updates the parameters of the layers from first_layer to the last one.
+     *
+     * @param learning_rate The learning rate.
+     * @param first_layer The first layer to update. Default: 0.
+     */
+    void update(const float &learning_rate, const size_t &first_layer = 0);
+
+    /**
+     * @brief Get the parameters of every layer, concatenated.
+     */
+    std::vector<float> parameters() const;
+    /**
+     * @brief Set the parameters of every layer from their concatenation.
+     *
+     * @throw std::invalid_argument If the number of parameters does not match.
+     */
+    void set_parameters(const std::vector<float> &parameters);
+
+    /**
+     * @brief Writes the layers and their parameters.
+     *
+     * @throw std::runtime_error If the graph is not built.
+     */
+    void save(std::ostream &stream) const;
+    /**
+     * @brief Reads a graph written by save.
+     *
+     * @throw std::runtime_error If the stream does not contain a valid graph.
+     */
+    void load(std::istream &stream);
+};
+
+#endif // NEURALGRAPH_HPP
@@ -0,0 +1,148 @@
+/**
+ * @defgroup NeuralHogwild NeuralHogwild
+ * @file NeuralHogwild.hpp
+ * @see src/NeuralHogwild.cpp for implementation.
+ * @brief The NeuralHogwild class.
+ *
+ * This file defines the lock-free asynchronous stochastic gradient descent engine (Hogwild!).
+ *
+ * @see Visit https://arxiv.org/abs/1106.5730 for more information.
+ *
+ * @author Manitas Bahri <https://github.com/B-Manitas>
+ * @date 2023/11
+ * @license MIT License
+ */
+
+#ifndef NEURALHOGWILD_HPP
+#define NEURALHOGWILD_HPP
+
+// INCLUDES
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+#include "NeuralAllocator.hpp"
+
+/**
+ * @brief This class runs a lock-free asynchronous stochastic gradient descent (Hogwild!).
+ *
+ * The worker threads pull the samples and apply their updates directly to shared weights with relaxed atomic
+ * loads and stores. Concurrent updates of the same weight may overwrite each other, which Hogwild! tolerates.
+ *
+ * The weights can be replicated: each replica is shared by a group of workers and the replicas are averaged at
+ * the end of each epoch. On Linux, the workers of each replica are pinned to one NUMA node and the replica is
+ * allocated and first touched by one of them, so it lives in the memory of its node.
+ */
+class NeuralHogwild
+{
+public:
+    // STRUCTURES
+    /**
+     * @brief The weights of one replica, shared by its workers.
+     */
+    class Weights
+    {
+    private:
+        std::atomic<float> *m_data = nullptr;
+        size_t m_size = 0;
+
+    public:
+        Weights(std::atomic<float> *data, const size_t &size) : m_data(data), m_size(size) {}
+
+        /**
+         * @brief Get the number of weights.
+         */
+        size_t size() const { return m_size; }
+        /**
+         * @brief Read a weight with a relaxed atomic load.
+         */
+        float get(const size_t &i) const { return m_data[i].load(std::memory_order_relaxed); }
+        /**
+         * @brief Add delta to a weight without lock. A concurrent update of the same weight may be lost.
+         */
+        void add(const size_t &i, const float &delta) { m_data[i].store(get(i) + delta, std::memory_order_relaxed); }
+    };
+
+    /**
+     * @brief The function applying the update of one sample.
+     *
+     * @param sample The index of the sample.
+     * @param weights The weights of the replica of the worker.
+     * @param worker The index of the worker, to select its own buffers.
+     */
+    typedef std::function<void(const size_t &sample, Weights &weights, const size_t &worker)> Step;
+    /**
+     * @brief The function called at the end of each epoch with the averaged weights.
+     *
+     * @return true to stop the training.
+     */
+    typedef std::function<bool(const int &epoch, const std::vector<float> &weights)> Callback;
+
+private:
+    // ATTRIBUTES
+    size_t m_n_threads = 1;
+    size_t m_n_replicas = 1;
+    std::vector<std::vector<int>> m_node_cpus = {};
+
+    // METHODS
+    /**
+     * @brief Read the CPUs of each NUMA node. It is empty if the topology is not available.
+     */
+    static std::vector<std::vector<int>> __read_numa_nodes();
+    /**
+     * @brief Pin the calling thread to the CPUs of the NUMA node of a replica. Do nothing without NUMA topology.
+     *
+     * @param replica The index of the replica.
+     */
+    void __pin_thread(const size_t &replica) const;
+    /**
+     * @brief Average the replicas and store the mean in each of them.
+     *
+     * @param replicas The replicas.
+     * @param size The number of weights.
+     * @return std::vector<float> The averaged weights.
+     */
+    std::vector<float> __average(const std::vector<std::atomic<float> *> &replicas, const size_t &size) const;
+
+public:
+    // ATTRIBUTES
+    /**
+     * @brief The number of samples processed per second during the last run.
+     */
+    float throughput = 0;
+
+    // CONSTRUCTORS
+    /**
+     * @brief Construct a new Hogwild engine.
+     *
+     * @param n_threads The number of worker threads. Set to 0 to use the number of hardware threads. Default: 0.
+     * @param n_replicas The number of weights replicas, typically the number of sockets. Default: 1.
+     *
+     * @throw std::invalid_argument If the number of replicas is 0 or greater than the number of threads.
+     */
+    NeuralHogwild(const size_t &n_threads = 0, const size_t &n_replicas = 1);
+
+    // METHODS
+    /**
+     * @brief Get the number of worker threads.
+     */
+    size_t n_threads() const;
+    /**
+     * @brief Train the weights asynchronously.
+     * At each epoch, the samples are shuffled and split between the workers, which call step for each of their samples.
+     *
+     * @param weights The initial weights.
+     * @param n_samples The number of samples.
+     * @param epochs The number of epochs.
+     * @param step The function applying the update of one sample.
+     * @param callback The function called at the end of each epoch. Default: none.
+     * @param random_state The random state used to shuffle the samples. Default: 0.
+     * @return std::vector<float> The trained weights, averaged over the replicas.
+     *
+     * @throw std::invalid_argument If the number of epochs is not greater than 0.
+     */
+    std::vector<float> run(const std::vector<float> &weights, const size_t &n_samples, const int &epochs, const Step &step, const Callback &callback = nullptr, const int &random_state = 0);
+};
+
+#endif // NEURALHOGWILD_HPP
@@ -0,0 +1,824 @@
+/**
+ * @defgroup NeuralLayer NeuralLayer
+ * @file NeuralLayer.hpp
+ * @see src/NeuralLayer.cpp for implementation.
+ * @brief The NeuralLayer classes.
+ *
+ * This file defines the layers of a NeuralGraph: dense, 1D and 2D convolution, max and average pooling, dropout, embedding, LSTM and GRU.
+ *
+ * @see Visit https://en.wikipedia.org/wiki/Convolutional_neural_network for more information.
+ *
+ * @author Manitas Bahri <https://github.com/B-Manitas>
+ * @date 2023/11
+ * @license MIT License
+ */
+
+#ifndef NEURALLAYER_HPP
+#define NEURALLAYER_HPP
+
+// INCLUDES
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "NeuralAllocator.hpp"
+#include "NeuralBlockSparse.hpp"
+#include "NeuralSparse.hpp"
+#include "NeuralTuner.hpp"
+
+/**
+ * @brief This class is the interface of a layer of a NeuralGraph.
+ *
+ * The values are stored in flat buffers, one sample after the other. A sample of shape (channels, height, width)
+ * is stored channel by channel, then row by row. The buffers are planned by the graph before the execution.
+ *
+ * The weights of a layer with parameters are stored row by row: one row per output unit (or filter),
+ * with the bias in the last column.
+ */
+class NeuralLayer
+{
+public:
+    // STRUCTURES
+    /**
+     * @brief The activation function applied at the end of the layer, fused with its computation.
+     */
+    enum Activation
+    {
+        LINEAR,
+        SIGMOID,
+        RELU
+    };
+
+    /**
+     * @brief The shape of a sample: (channels, height, width).
+     */
+    struct Shape
+    {
+        size_t channels;
+        size_t height;
+        size_t width;
+
+        explicit Shape(const size_t &channels = 0, const size_t &height = 1, const size_t &width = 1) : channels(channels), height(height), width(width) {}
+
+        /**
+         * @brief Get the number of values of a sample.
+         */
+        size_t size() const { return channels * height * width; }
+    };
+
+protected:
+    // ATTRIBUTES
+    Activation m_activation = LINEAR;
+    Shape m_input = Shape();
+    Shape m_output = Shape();
+
+    /**
+     * @brief If true, the gradient received by backward is already the gradient of the input of the activation.
+     * It is set by the graph for a sigmoid output layer trained with the cross-entropy.
+     */
+    bool m_loss_output = false;
+
+    NeuralBuffer m_parameters = NeuralBuffer(NeuralAllocator<float>(NeuralMemory::parameters()));
+    NeuralBuffer m_gradients = NeuralBuffer(NeuralAllocator<float>(NeuralMemory::parameters()));
+    /**
+     * @brief The pruning mask of the parameters: 0 for a pruned parameter. It is empty if the layer is not pruned.
+     */
+    std::vector<uint8_t> m_mask = {};
+
+    // METHODS
+    /**
+     * @brief Applies the activation function in place.
+     *
+     * @param values The values.
+     * @param size The number of values.
+     */
+    void __activate(float *values, const size_t &size) const;
+    /**
+     * @brief Multiplies in place the gradient of the output by the derivative of the activation function.
+     *
+     * @param out The output of the layer.
+     * @param d_out The gradient of the output.
+     * @param size The number of values.
+     */
+    void __activate_backward(const float *out, float *d_out, const size_t &size) const;
+
+    /**
+     * @brief Blocked product C = A * B, or C += A * B. A is M x K and B is K x N, both stored row by row.
+     * The block size and the number of threads of each product are given by NeuralTuner::config for its shape.
+     *
+     * @param accumulate If true, the product is added to C.
+     * @param parallel If true, the rows of C are computed in parallel.
+     */
+    static void __gemm_nn(const size_t &M, const size_t &N, const size_t &K, const float *A, const size_t &lda, const float *B, const size_t &ldb, float *C, const size_t &ldc, const bool &accumulate, const bool &parallel);
+    /**
+     * @brief Blocked product C = A * B^T, or C += A * B^T. A is M x K and B is N x K, both stored row by row.
+     */
+    static void __gemm_nt(const size_t &M, const size_t &N, const size_t &K, const float *A, const size_t &lda, const float *B, const size_t &ldb, float *C, const size_t &ldc, const bool &accumulate, const bool &parallel);
+    /**
+     * @brief Blocked product C = A^T * B, or C += A^T * B. A is K x M and B is K x N, both stored row by row.
+     */
+    static void __gemm_tn(const size_t &M, const size_t &N, const size_t &K, const float *A, const size_t &lda, const float *B, const size_t &ldb, float *C, const size_t &ldc, const bool &accumulate, const bool &parallel);
+    /**
+     * @brief Sets the pruned parameters to 0.
+     */
+    void __apply_mask();
+    /**
+     * @brief Called after the parameters are modified by the layer: update, set_parameters or set_mask.
+     */
+    virtual void __parameters_changed();
+
+    /**
+     * @brief Get the index of the calling thread in the current parallel region.
+     */
+    static size_t __thread_index();
+    /**
+     * @brief Get the maximum number of threads of a parallel region.
+     */
+    static size_t __max_threads();
+    /**
+     * @brief Get the number of threads of a product: the tuned number, at most the maximum number of threads.
+     *
+     * @param config The configuration of the product given by NeuralTuner::config.
+     */
+    static int __gemm_threads(const NeuralTuner::Config &config);
+
+    friend class NeuralTuner;
+
+public:
+    // CONSTRUCTORS
+    NeuralLayer(const Activation &activation = LINEAR);
+    virtual ~NeuralLayer();
+
+    /**
+     * @brief Copy the layer, with its configuration and its parameters.
+     */
+    virtual NeuralLayer *clone() const = 0;
+
+    // METHODS
+    /**
+     * @brief Get the shape of an input sample.
+     */
+    const Shape &input_shape() const;
+    /**
+     * @brief Get the shape of an output sample.
+     */
+    const Shape &output_shape() const;
+    /**
+     * @brief Get the activation function.
+     */
+    Activation activation() const;
+    /**
+     * @brief Get the parameters of the layer. It is empty for a layer without parameters.
+     */
+    NeuralBuffer &parameters();
+    const NeuralBuffer &parameters() const;
+    /**
+     * @brief Get the gradients of the parameters computed by the last backward.
+     */
+    NeuralBuffer &gradients();
+    /**
+     * @brief Set if the layer is the output of a graph trained with the cross-entropy. See m_loss_output.
+     */
+    void set_loss_output(const bool &loss_output);
+
+    /**
+     * @brief Computes the output shape and initializes the parameters.
+     *
+     * @param input The shape of an input sample.
+     * @param seed The seed of the initialization of the parameters.
+     * @return Shape The shape of an output sample.
+     *
+     * @throw std::invalid_argument If the input shape is not valid for the layer.
+     */
+    virtual Shape build(const Shape &input, const int &seed) = 0;
+    /**
+     * @brief Allocates the buffers of the layer for a batch. Called by the graph before the execution.
+     *
+     * @param batch The number of samples.
+     */
+    virtual void plan(const size_t &batch);
+    /**
+     * @brief Computes the output of the layer.
+     *
+     * @param in The input, of size batch x input_shape().size().
+     * @param out The output, of size batch x output_shape().size().
+     * @param batch The number of samples.
+     * @param training If true, the layer is in training mode (dropout).
+     */
+    virtual void forward(const float *in, float *out, const size_t &batch, const bool &training) = 0;
+    /**
+     * @brief Computes the gradients of the parameters and the gradient of the input.
+     *
+     * @param in The input of the last forward.
+     * @param out The output of the last forward.
+     * @param d_out The gradient of the output. It may be modified.
+     * @param d_in The gradient of the input, or nullptr if it is not needed.
+     * @param batch The number of samples.
+     */
+    virtual void backward(const float *in, const float *out, float *d_out, float *d_in, const size_t &batch) = 0;
+    /**
+     * @brief Updates the parameters with their gradients. The pruned parameters stay 0.
+     *
+     * @param learning_rate The learning rate.
+     */
+    virtual void update(const float &learning_rate);
+    /**
+     * @brief Set the parameters. The pruned parameters stay 0.
+     *
+     * @param parameters The parameters, of the size of parameters().
+     *
+     * @throw std::invalid_argument If the number of parameters does not match.
+     */
+    void set_parameters(const std::vector<float> &parameters);
+
+    /**
+     * @brief Get the shape of the weights which can be pruned: the parameter r * (parameters().size() / rows) + c, for r < rows and c < columns.
+     * The other parameters (the bias) are never pruned. Both are 0 for a layer without weights.
+     *
+     * @param rows The number of rows (units or filters).
+     * @param columns The number of weights of a row.
+     */
+    virtual void weights_shape(size_t &rows, size_t &columns) const;
+    /**
+     * @brief Get the pruning mask of the parameters: 0 for a pruned parameter. It is empty if the layer is not pruned.
+     */
+    const std::vector<uint8_t> &mask() const;
+    /**
+     * @brief Set the pruning mask and sets the pruned parameters to 0.
+     *
+     * @param mask The mask, of the size of parameters(), or empty to stop pruning.
+     *
+     * @throw std::invalid_argument If the size of the mask does not match.
+     */
+    void set_mask(const std::vector<uint8_t> &mask);
+    /**
+     * @brief Get the ratio of the weights equal to 0. It is 0 for a layer without weights.
+     */
+    float sparsity() const;
+
+    /**
+     * @brief Writes the configuration of the layer, without its parameters.
+     *
+     * @param stream The output stream.
+     */
+    virtual void save(std::ostream &stream) const = 0;
+    /**
+     * @brief Writes the parameters: their number, then their values.
+     *
+     * @param stream The output stream.
+     */
+    virtual void save_parameters(std::ostream &stream) const;
+    /**
+     * @brief Reads the parameters written by save_parameters. The layer must be built.
+     *
+     * @param stream The input stream.
+     *
+     * @throw std::runtime_error If the stream does not contain the parameters of the layer.
+     */
+    virtual void load_parameters(std::istream &stream);
+    /**
+     * @brief Creates a layer from a configuration written by save.
+     *
+     * @param stream The input stream.
+     * @return NeuralLayer* The new layer, owned by the caller.
+     *
+     * @throw std::runtime_error If the stream does not contain a valid layer.
+     */
+    static NeuralLayer *load(std::istream &stream);
+};
+
+/**
+ * @brief This class is a fully connected layer: out = activation(W * in + b).
+ */
+class NeuralDense : public NeuralLayer
+{
+private:
+    // ATTRIBUTES
+    size_t m_units = 1;
+    bool m_bias = true;
+
+    /**
+     * @brief The weights without the bias, compressed by compress. It is empty if the layer is not compressed.
+     */
+    NeuralBlockSparse m_compressed = NeuralBlockSparse();
+
+    // METHODS
+    /**
+     * @brief Drops the compressed weights, which are no longer up to date.
+     */
+    void __parameters_changed() override;
+
+public:
+    // CONSTRUCTORS
+    /**
+     * @brief Construct a new Neural Dense object.
+     *
+     * @param units The number of neurons.
+     * @param activation The activation function. Default: SIGMOID.
+     * @param bias If true, the layer has a bias. Default: true.
+     *
+     * @throw std::invalid_argument If the number of neurons is 0.
+     */
+    NeuralDense(const size_t &units, const Activation &activation = SIGMOID, const bool &bias = true);
+    NeuralLayer *clone() const override;
+
+    // METHODS
+    /**
+     * @brief Check if the layer has a bias.
+     */
+    bool bias() const;
+
+    Shape build(const Shape &input, const int &seed) override;
+    void forward(const float *in, float *out, const size_t &batch, const bool &training) override;
+    void backward(const float *in, const float *out, float *d_out, float *d_in, const size_t &batch) override;
+    /**
+     * @brief Computes the output of the layer for a sparse input.
+     *
+     * @param X The sparse input. Each row represents a sample and each column represents a feature.
+     * @param out The output, of size X.height() x units.
+     */
+    void forward(const NeuralSparse &X, float *out);
+    /**
+     * @brief Computes the output of the layer for a sparse input stored by features, without transposing it.
+     *
+     * @param X The sparse input. Each row represents a feature and each column represents a sample.
+     * @param out The output, of size X.width() x units.
+     */
+    void forward_columns(const NeuralSparse &X, float *out);
+    /**
+     * @brief Updates the parameters for a sparse input. Only the weights of the non-zero features are updated.
+     *
+     * @param X The sparse input. Each row represents a feature and each column represents a sample.
+     * @param out The output of the last forward.
+     * @param d_out The gradient of the output. It is modified.
+     * @param learning_rate The learning rate.
+     */
+    void update(const NeuralSparse &X, const float *out, float *d_out, const float &learning_rate);
+    using NeuralLayer::update;
+
+    void weights_shape(size_t &rows, size_t &columns) const override;
+    /**
+     * @brief Compresses the weights in the block sparse format. The forward then skips the blocks of zeros.
+     * The compressed weights are dropped as soon as the parameters are modified.
+     *
+     * @param block_height The number of units of a block, in [1, 16].
+     * @param block_width The number of features of a block, in [1, 16].
+     *
+     * @throw std::invalid_argument If the layer is not built or if a size of the blocks is not valid.
+     */
+    void compress(const size_t &block_height, const size_t &block_width);
+    /**
+     * @brief Check if the weights are compressed.
+     */
+    bool is_compressed() const;
+    /**
+     * @brief Get the compressed weights, without the bias.
+     */
+    const NeuralBlockSparse &compressed() const;
+
+    void save(std::ostream &stream) const override;
+    /**
+     * @brief Writes the parameters. If the layer is compressed, only the blocks of weights and the bias are written.
+     */
+    void save_parameters(std::ostream &stream) const override;
+    void load_parameters(std::istream &stream) override;
+};
+
+/**
+ * @brief This class is a 2D convolution layer, with several filters.
+ *
+ * The convolution is lowered onto a blocked matrix product (im2col) or, for the small kernels, computed directly.
+ * The choice is made when the layer is built.
+ */
+class NeuralConv2D : public NeuralLayer
+{
+protected:
+    // ATTRIBUTES
+    size_t m_filters = 1;
+    size_t m_kernel_height = 1;
+    size_t m_kernel_width = 1;
+    size_t m_stride = 1;
+    size_t m_padding_height = 0;
+    size_t m_padding_width = 0;
+
+    bool m_direct = false;
+    size_t m_n_threads = 1;
+    /**
+     * @brief The buffers of each thread, allocated and first touched by their thread.
+     */
+    std::vector<NeuralBuffer> m_columns = {};
+    std::vector<NeuralBuffer> m_thread_gradients = {};
+
+    // METHODS
+    /**
+     * @brief Get the number of weights of a filter, without the bias.
+     */
+    size_t __kernel_size() const;
+    /**
+     * @brief Unfolds the patches of a sample: the column p contains the input values of the output position p.
+     *
+     * @param in The input sample.
+     * @param columns The patches, of size kernel_size x (output height x output width).
+     */
+    void __im2col(const float *in, float *columns) const;
+    /**
+     * @brief Sums the patches back to the input positions. It is the transpose of __im2col.
+     *
+     * @param columns The gradients of the patches.
+     * @param d_in The gradient of the input sample.
+     */
+    void __col2im(const float *columns, float *d_in) const;
+
+public:
+    // CONSTRUCTORS
+    /**
+     * @brief Construct a new Neural Conv 2D object.
+     *
+     * @param filters The number of filters, i.e. of output channels.
+     * @param kernel_height The height of the kernel.
+     * @param kernel_width The width of the kernel.
+     * @param stride The step between two positions of the kernel. Default: 1.
+     * @param padding The number of zeros added on each side of the input. Default: 0.
+     * @param activation The activation function. Default: RELU.
+     *
+     * @throw std::invalid_argument If a size is 0.
+     */
+    NeuralConv2D(const size_t &filters, const size_t &kernel_height, const size_t &kernel_width, const size_t &stride = 1, const size_t &padding = 0, const Activation &activation = RELU);
+    NeuralLayer *clone() const override;
+
+    // METHODS
+    Shape build(const Shape &input, const int &seed) override;
+    void plan(const size_t &batch) override;
+    void forward(const float *in, float *out, const size_t &batch, const bool &training) override;
+    void backward(const float *in, const float *out, float *d_out, float *d_in, const size_t &batch) override;
+    void weights_shape(size_t &rows, size_t &columns) const override;
+    void save(std::ostream &stream) const override;
+};
+
+/**
+ * @brief This class is a 1D convolution layer. The input is a signal of shape (channels, 1, length).
+ */
+class NeuralConv1D : public NeuralConv2D
+{
+public:
+    // CONSTRUCTORS
+    /**
+     * @brief Construct a new Neural Conv 1D object.
+     *
+     * @param filters The number of filters, i.e. of output channels.
+     * @param kernel The length of the kernel.
+     * @param stride The step between two positions of the kernel. Default: 1.
+     * @param padding The number of zeros added on each side of the input. Default: 0.
+     * @param activation The activation function. Default: RELU.
+     *
+     * @throw std::invalid_argument If a size is 0.
+     */
+    NeuralConv1D(const size_t &filters, const size_t &kernel, const size_t &stride = 1, const size_t &padding = 0, const Activation &activation = RELU);
+    NeuralLayer *clone() const override;
+
+    // METHODS
+    Shape build(const Shape &input, const int &seed) override;
+    void save(std::ostream &stream) const override;
+};
+
+/**
+ * @brief This class is a max or average pooling layer, applied on each channel.
+ */
+class NeuralPool : public NeuralLayer
+{
+public:
+    // STRUCTURES
+    enum Mode
+    {
+        MAX,
+        AVERAGE
+    };
+
+private:
+    // ATTRIBUTES
+    Mode m_mode = MAX;
+    size_t m_pool_height = 1;
+    size_t m_pool_width = 1;
+    size_t m_stride = 1;
+
+    /**
+     * @brief The position in the input sample of the maximum of each output, used by the backward of the max pooling.
+     */
+    std::vector<uint32_t, NeuralAllocator<uint32_t>> m_argmax = {};
+
+public:
+    // CONSTRUCTORS
+    /**
+     * @brief Construct a new Neural Pool object.
+     *
+     * @param pool_height The height of the pooling window. Set to 1 for a signal.
+     * @param pool_width The width of the pooling window.
+     * @param mode The pooling: MAX or AVERAGE. Default: MAX.
+     * @param stride The step between two windows. Set to 0 to use the width of the window. Default: 0.
+     *
+     * @throw std::invalid_argument If a size of the window is 0.
+     */
+    NeuralPool(const size_t &pool_height, const size_t &pool_width, const Mode &mode = MAX, const size_t &stride = 0);
+    NeuralLayer *clone() const override;
+
+    // METHODS
+    Shape build(const Shape &input, const int &seed) override;
+    void plan(const size_t &batch) override;
+    void forward(const float *in, float *out, const size_t &batch, const bool &training) override;
+    void backward(const float *in, const float *out, float *d_out, float *d_in, const size_t &batch) override;
+    void save(std::ostream &stream) const override;
+};
+
+/**
+ * @brief This class is a dropout layer. In training mode, each value is set to 0 with the probability rate
+ * and the others are scaled by 1 / (1 - rate). In inference mode, the values are copied.
+ *
+ * The mask is drawn with a xorshift generator seeded per sample, so it does not depend on the number of threads.
+ */
+class NeuralDropout : public NeuralLayer
+{
+private:
+    // ATTRIBUTES
+    float m_rate = .5;
+    uint64_t m_seed = 0;
+    uint64_t m_step = 0;
+
+    std::vector<uint8_t, NeuralAllocator<uint8_t>> m_mask = {};
+
+public:
+    // CONSTRUCTORS
+    /**
+     * @brief Construct a new Neural Dropout object.
+     *
+     * @param rate The probability to drop a value. Default: .5.
+     * @param seed The seed of the masks. Default: 0.
+     *
+     * @throw std::invalid_argument If the rate is not in [0, 1[.
+     */
+    NeuralDropout(const float &rate = .5, const int &seed = 0);
+    NeuralLayer *clone() const override;
+
+    // METHODS
+    Shape build(const Shape &input, const int &seed) override;
+    void plan(const size_t &batch) override;
+    void forward(const float *in, float *out, const size_t &batch, const bool &training) override;
+    void backward(const float *in, const float *out, float *d_out, float *d_in, const size_t &batch) override;
+    void save(std::ostream &stream) const override;
+};
+
+/**
+ * @brief This class is an embedding layer for the categorical features: each input value is the ID of a row of a table,
+ * and the output is the rows of the IDs of a sample, concatenated, summed or averaged.
+ *
+ * The IDs are stored as floats in the input, so they are exact below 2^24. A negative ID is a missing value: it pads
+ * the multi-valued fields and is ignored by the pooling. The input is never scaled: use it with the default NeuralScaler.
+ *
+ * The backward is a sparse scatter-add: only the rows of the IDs of the batch get a gradient, and the update only
+ * touches these rows. The IDs of the batch are grouped by row, so each row is accumulated by one thread without lock. The memory traffic of a step scales with the IDs
+ * of the batch, not with the size of the table. For the same reason, gradients() is empty.
+ */
+class NeuralEmbedding : public NeuralLayer
+{
+public:
+    // STRUCTURES
+    /**
+     * @brief The pooling of the rows of a sample.
+     */
+    enum Pooling
+    {
+        CONCAT,
+        SUM,
+        MEAN
+    };
+
+    /**
+     * @brief The optimizer of the rows. The state of ADAGRAD is one accumulator per row, only updated for the touched rows.
+     */
+    enum Optimizer
+    {
+        SGD,
+        ADAGRAD
+    };
+
+private:
+    // ATTRIBUTES
+    size_t m_n_rows = 1;
+    size_t m_dim = 1;
+    Pooling m_pooling = CONCAT;
+    Optimizer m_optimizer = SGD;
+
+    /**
+     * @brief The slot of each row in the gradients of the last backward, or -1 if the row is not touched.
+     */
+    std::vector<int32_t> m_slots = {};
+    /**
+     * @brief The rows touched by the last backward, in the order of their slot.
+     */
+    std::vector<uint32_t> m_touched = {};
+    /**
+     * @brief The gradients of the touched rows, one row of size dim per slot.
+     */
+    NeuralBuffer m_row_gradients = NeuralBuffer();
+    /**
+     * @brief The IDs of the last backward grouped by slot: the positions in the input of the IDs of the slot i
+     * are m_occurrences[m_offsets[i]] to m_occurrences[m_offsets[i + 1] - 1].
+     */
+    std::vector<size_t> m_offsets = {};
+    std::vector<size_t> m_occurrences = {};
+    /**
+     * @brief The scale of the gradient of each sample of the last backward.
+     */
+    std::vector<float> m_scales = {};
+    /**
+     * @brief The sum of the mean squared gradient of each row, for ADAGRAD.
+     */
+    NeuralBuffer m_accumulators = NeuralBuffer(NeuralAllocator<float>(NeuralMemory::parameters()));
+
+    // METHODS
+    /**
+     * @brief Get the row of an ID of the input, or -1 if the ID is missing.
+     */
+    long __row(const float &id) const;
+
+public:
+    // CONSTRUCTORS
+    /**
+     * @brief Construct a new Neural Embedding object.
+     *
+     * @param n_rows The number of rows of the table, i.e. the number of IDs.
+     * @param dim The size of a row.
+     * @param pooling The pooling of the rows of a sample. Default: CONCAT.
+     * @param optimizer The optimizer of the rows. Default: SGD.
+     *
+     * @throw std::invalid_argument If a size is 0 or if the number of rows is above 2^24.
+     */
+    NeuralEmbedding(const size_t &n_rows, const size_t &dim, const Pooling &pooling = CONCAT, const Optimizer &optimizer = SGD);
+    NeuralLayer *clone() const override;
+
+    // METHODS
+    /**
+     * @brief Get the rows touched by the last backward.
+     */
+    const std::vector<uint32_t> &touched() const;
+
+    Shape build(const Shape &input, const int &seed) override;
+    /**
+     * @copydoc NeuralLayer::forward
+     * @throw std::invalid_argument If an ID is not an integer of [0, n_rows[ or a negative value.
+     */
+    void forward(const float *in, float *out, const size_t &batch, const bool &training) override;
+    void backward(const float *in, const float *out, float *d_out, float *d_in, const size_t &batch) override;
+    /**
+     * @brief Updates the rows touched by the last backward.
+     *
+     * @param learning_rate The learning rate.
+     */
+    void update(const float &learning_rate) override;
+    void save(std::ostream &stream) const override;
+};
+
+/**
+ * @brief This class is a recurrent layer, LSTM or GRU. The input is a sequence of shape (features, 1, length),
+ * stored like the signal of a NeuralConv1D: feature by feature.
+ *
+ * The input projections of all the gates are computed for a whole window of time steps by one large product.
+ * Then each time step computes the recurrent projections of all the gates by one product, and applies the
+ * nonlinearities of the gates and the update of the state in one fused kernel. The GRU resets the recurrent
+ * projection of its candidate after the product (n = tanh(W_n x + b_n + r * (U_n h + c_n))), so its step has
+ * a single product too.
+ *
+ * The backward propagates through time from the buffers of each time step, allocated once by plan.
+ * With a truncation of k steps, the gradient only flows through the last k steps of the sequence,
+ * and the buffers of the time steps are rings of k steps, so the memory does not grow with the length.
+ * The truncation is only available with the last state as output: the outputs of the steps before the last k
+ * would have no gradient.
+ *
+ * The weights of a gate unit are stored row by row: its input weights, its recurrent weights, its bias,
+ * then for a GRU its recurrent bias. The gates are ordered (input, forget, cell, output) for a LSTM and
+ * (update, reset, candidate) for a GRU.
+ */
+class NeuralRecurrent : public NeuralLayer
+{
+public:
+    // STRUCTURES
+    enum Cell
+    {
+        LSTM,
+        GRU
+    };
+
+protected:
+    // ATTRIBUTES
+    Cell m_cell = LSTM;
+    size_t m_units = 1;
+    bool m_sequences = false;
+    size_t m_truncation = 0;
+
+    size_t m_features = 0;
+    size_t m_length = 0;
+    /**
+     * @brief The number of time steps kept for the backward: the truncation, or the whole length.
+     */
+    size_t m_window = 0;
+    size_t m_batch = 0;
+
+    /**
+     * @brief The biases of the gates, gathered from the parameters at each forward.
+     */
+    NeuralBuffer m_biases = NeuralBuffer();
+    /**
+     * @brief The buffers of the time steps of the window: the step t is in the slot t % window, one sample after the other.
+     * The states are in a ring of window + 1 slots: the state after the step t is in the slot (t + 1) % (window + 1).
+     */
+    NeuralBuffer m_inputs = NeuralBuffer(NeuralAllocator<float>(NeuralMemory::activations()));
+    NeuralBuffer m_gates = NeuralBuffer(NeuralAllocator<float>(NeuralMemory::activations()));
+    NeuralBuffer m_recurrent = NeuralBuffer(NeuralAllocator<float>(NeuralMemory::activations()));
+    NeuralBuffer m_states = NeuralBuffer(NeuralAllocator<float>(NeuralMemory::activations()));
+    NeuralBuffer m_cells = NeuralBuffer(NeuralAllocator<float>(NeuralMemory::activations()));
+    /**
+     * @brief The gradients of the time steps of the window: of the input projections, of the recurrent projections
+     * (the same as the input projections for a LSTM), and the previous state of each step.
+     */
+    NeuralBuffer m_deltas = NeuralBuffer();
+    NeuralBuffer m_recurrent_deltas = NeuralBuffer();
+    NeuralBuffer m_previous = NeuralBuffer();
+    NeuralBuffer m_d_state = NeuralBuffer();
+    NeuralBuffer m_d_cell = NeuralBuffer();
+    NeuralBuffer m_d_inputs = NeuralBuffer();
+
+    // METHODS
+    /**
+     * @brief Get the number of gates of the cell.
+     */
+    size_t __n_gates() const;
+    /**
+     * @brief Computes the time step t: the recurrent product and the fused kernel of the gates.
+     *
+     * @param t The time step.
+     * @param out The output of the layer, written at each step if the sequence is returned.
+     */
+    void __step(const size_t &t, float *out);
+    /**
+     * @brief Computes the gradients of the projections of the time step t, and the gradient of its previous state.
+     *
+     * @param t The time step.
+     * @param d_out The gradient of the output of the layer.
+     */
+    void __step_backward(const size_t &t, const float *d_out);
+
+public:
+    // CONSTRUCTORS
+    /**
+     * @brief Construct a new Neural Recurrent object.
+     *
+     * @param cell The cell: LSTM or GRU.
+     * @param units The size of the state.
+     * @param sequences If true, the output is the state after each time step, of shape (units, 1, length). Otherwise, it is the last state. Default: false.
+     * @param truncation The number of time steps of the backpropagation through time. Set to 0 to use the whole sequence. Default: 0.
+     *
+     * @throw std::invalid_argument If the number of units is 0, or if the truncation is not 0 while the sequence is returned.
+     */
+    NeuralRecurrent(const Cell &cell, const size_t &units, const bool &sequences = false, const size_t &truncation = 0);
+    NeuralLayer *clone() const override;
+
+    // METHODS
+    Shape build(const Shape &input, const int &seed) override;
+    void plan(const size_t &batch) override;
+    void forward(const float *in, float *out, const size_t &batch, const bool &training) override;
+    void backward(const float *in, const float *out, float *d_out, float *d_in, const size_t &batch) override;
+    void weights_shape(size_t &rows, size_t &columns) const override;
+    void save(std::ostream &stream) const override;
+};
+
+/**
+ * @brief This class is a LSTM layer.
+ */
+class NeuralLSTM : public NeuralRecurrent
+{
+public:
+    // CONSTRUCTORS
+    /**
+     * @brief Construct a new Neural LSTM object. See NeuralRecurrent for the parameters.
+     */
+    NeuralLSTM(const size_t &units, const bool &sequences = false, const size_t &truncation = 0);
+    NeuralLayer *clone() const override;
+};
+
+/**
+ * @brief This class is a GRU layer.
+ */
+class NeuralGRU : public NeuralRecurrent
+{
+public:
+    // CONSTRUCTORS
+    /**
+     * @brief Construct a new Neural GRU object. See NeuralRecurrent for the parameters.
+     */
+    NeuralGRU(const size_t &units, const bool &sequences = false, const size_t &truncation = 0);
+    NeuralLayer *clone() const override;
+};
+
+#endif // NEURALLAYER_HPP
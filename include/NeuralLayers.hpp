@@ -13,29 +13,54 @@
 #define NEURAL_LAYERS_HPP
 
 // INCLUDES
-#include <map>
+#include <functional>
 
 #include "../lib/CMatrix/include/CMatrix.hpp"
+#include "NeuralGraph.hpp"
+#include "NeuralHogwild.hpp"
+#include "NeuralPruner.hpp"
+#include "NeuralScaler.hpp"
+#include "NeuralSparse.hpp"
 
 class NeuralLayers
 {
 private:
     // ATTRIBUTES
-    std::map<std::string, cmatrix<float>> m_weights = {};
-    std::map<std::string, cmatrix<float>> m_activations = {};
-    std::map<std::string, cmatrix<float>> m_gradients = {};
-
+    /**
+     * @brief The layers of the model. With the dimensions of the layers, it is rebuilt at each fit:
+     * sigmoid dense layers, a bias on the first one, and a sigmoid dense output layer.
+     */
+    NeuralGraph m_graph = NeuralGraph();
     std::vector<int> m_layers_dims = {1};
+    /**
+     * @brief If true, the graph is given by the user (or loaded) and only the last layer is checked against the output.
+     */
+    bool m_custom_graph = false;
+
+    /**
+     * @brief The preprocessing of the input, fitted with the model and applied while the input of the first layer is built.
+     */
+    NeuralScaler m_scaler = NeuralScaler();
+    /**
+     * @brief The pruning of the weights, applied by the schedule of the pruner at the end of each epoch of fit.
+     */
+    NeuralPruner m_pruner = NeuralPruner();
+
+    friend class NeuralDistributed;
+    friend class NeuralScorer;
+    friend class NeuralSearch;
+    friend class NeuralTuner;
 
     // GENERAL METHODS
     /**
-     * @brief Initializes the weights for each layer.
+     * @brief Builds the graph and initializes the weights for each layer.
      *
-     * @param n_features The number of features
-     * @param layers_dims The dimensions of each layer
-     * @param n_output The number of outputs
+     * @param n_features The number of features of the input of the first layer, without the bias.
+     * @param n_output The number of outputs.
+     *
+     * @throw std::invalid_argument If the output of the graph does not match the number of outputs.
      */
-    void __init_weights(const int &n_features, std::vector<int> &layers_dims, const int &n_output);
+    void __init_weights(const size_t &n_features, const size_t &n_output);
     /**
      * @brief Checks if the dimensions of the layers are valid
      *
@@ -45,32 +70,58 @@ private:
      */
     bool __valid_layers_dims(const std::vector<int> &layers_dims) const;
     /**
-     * @brief The sigmoid function. It is used as the activation function for the hidden layers.
+     * @brief Get the first layer used with a sparse input. A sparse input is never scaled and its first layer is dense.
      *
-     * @param Z The matrix to apply the sigmoid function.
-     * @return cmatrix<float> The matrix with the sigmoid function applied.
+     * @throw std::invalid_argument If the scaler is not the identity or if the first layer is not dense.
+     */
+    NeuralDense &__sparse_input_layer();
+    /**
+     * @brief Gathers the expected output of the selected samples, one sample after the other, as the graph expects it.
      *
-     * @see https://en.wikipedia.org/wiki/Sigmoid_function
+     * @param y The output matrix.
+     * @param indices The indices of the samples, or nullptr to use all the samples.
+     *
+     * @throw std::invalid_argument If an index is out of range.
      */
-    cmatrix<float> __sigmoid(const cmatrix<float> &Z) const;
+    std::vector<float> __gather_targets(const cmatrix<float> &y, const std::vector<size_t> *indices) const;
 
     // TRAINING METHODS
     /**
      * @brief The forward propagation algorithm. It computes the activation for each layer.
+     * The input is scaled in one pass, directly in the input buffer of the graph.
      *
      * @param X The input matrix.
+     * @param training If true, the layers are in training mode (dropout). Default: false.
      *
      * @see https://en.wikipedia.org/wiki/Backpropagation#Forward_propagation
      */
-    void __forward_propagation(const cmatrix<float> &X);
+    void __forward_propagation(const cmatrix<float> &X, const bool &training = false);
+    /**
+     * @brief The forward propagation algorithm for a sparse input. The first layer is computed with a sparse-dense product.
+     *
+     * @param X The transposed sparse input matrix. Each row represents a sample and each column represents a feature.
+     * @param training If true, the layers are in training mode (dropout). Default: false.
+     */
+    void __forward_propagation(const NeuralSparse &X, const bool &training = false);
+    /**
+     * @brief The forward propagation algorithm for a subset of the samples.
+     * The selected columns are gathered directly in the input buffer of the graph, so the subset is never copied on its own.
+     *
+     * @param X The input matrix.
+     * @param indices The indices of the columns (samples) of X to use.
+     * @param training If true, the layers are in training mode (dropout). Default: false.
+     *
+     * @throw std::invalid_argument If an index is out of range.
+     */
+    void __forward_propagation(const cmatrix<float> &X, const std::vector<size_t> &indices, const bool &training = false);
     /**
      * @brief The back propagation algorithm. It computes the gradients for each layer.
      *
-     * @param y The output matrix.
+     * @param y The expected output, gathered by __gather_targets.
      *
      * @see https://en.wikipedia.org/wiki/Backpropagation#Backpropagation_algorithm
      */
-    void __back_propagation(const cmatrix<float> &y);
+    void __back_propagation(const std::vector<float> &y);
     /**
      * @brief The gradient descent algorithm. It updates the weights for each layer.
      *
@@ -79,6 +130,55 @@ private:
      * @see https://en.wikipedia.org/wiki/Gradient_descent
      */
     void __gradient_descent(const float &learning_rate);
+    /**
+     * @brief Get the probabilities of the last forward propagation.
+     *
+     * @return cmatrix<float> The output matrix of the last layer. Each column represents a sample.
+     */
+    cmatrix<float> __probabilities();
+    /**
+     * @brief Get the prediction of the last forward propagation.
+     *
+     * @return cmatrix<cbool> The predicted output matrix. Each column represents a sample.
+     */
+    cmatrix<cbool> __output();
+    /**
+     * @brief Computes the accuracy of the predictions, prints it and stores the error.
+     *
+     * @param epoch The current epoch.
+     * @param y_pred The predicted output matrix.
+     * @param y_true The expected output matrix.
+     * @return true if the accuracy is 100%.
+     */
+    bool __log_accuracy(const int &epoch, const cmatrix<cbool> &y_pred, const cmatrix<cbool> &y_true);
+    /**
+     * @brief Trains the fitted model on the columns (samples) of X and y selected by indices, from first_epoch to epochs.
+     * The scaler and the weights are kept, so a training of first_epoch epochs is resumed.
+     *
+     * @param X The input matrix.
+     * @param y The output matrix.
+     * @param indices The indices of the samples to train on.
+     * @param first_epoch The number of epochs already trained.
+     * @param epochs The number of epochs at the end of the training.
+     * @param learning_rate The learning rate.
+     * @param verbose The number of epochs between each print of the error. Set to 0 to disable.
+     *
+     * @throw std::invalid_argument If an index is out of range.
+     */
+    void __train(const cmatrix<float> &X, const cmatrix<float> &y, const std::vector<size_t> &indices, const int &first_epoch, const int &epochs, const float &learning_rate, const int &verbose);
+    /**
+     * @brief Trains the weights asynchronously with one stochastic gradient step per sample.
+     *
+     * @param n_samples The number of samples.
+     * @param sample The function returning the non-zero (feature, value) pairs of a sample, without the bias.
+     * @param y The output matrix.
+     * @param epochs The number of epochs.
+     * @param learning_rate The learning rate.
+     * @param verbose The number of epochs between each print of the error. Set to 0 to disable.
+     * @param hogwild The asynchronous engine.
+     * @param predict The function predicting the output of all the samples with the current weights.
+     */
+    void __fit_async(const size_t &n_samples, const std::function<void(const size_t &, std::vector<std::pair<size_t, float>> &)> &sample, const cmatrix<float> &y, const int &epochs, const float &learning_rate, const int &verbose, NeuralHogwild &hogwild, const std::function<cmatrix<cbool>()> &predict);
 
 public:
     // ATTRIBUTES
@@ -86,6 +186,10 @@ public:
      * @brief The errors for each epoch during the training.
      */
     std::vector<float> errors = {};
+    /**
+     * @brief The number of samples processed per second by the last asynchronous fit.
+     */
+    float throughput = 0;
 
     // CONSTRUCTORS
     /**
@@ -102,6 +206,24 @@ public:
      * @note The activation function for the hidden layer is the sigmoid function.
      */
     NeuralLayers(const std::vector<int> &layers_dims);
+    /**
+     * @brief Construct a new Neural Layers object for binary classification, with a preprocessing of the input.
+     * The scaler is fitted at each fit of the model, and it is applied to every input of the model.
+     *
+     * @param layers_dims The dimensions of each layer.
+     * @param scaler The preprocessing of the input. Ex: NeuralScaler(NeuralScaler::STANDARD).
+     */
+    NeuralLayers(const std::vector<int> &layers_dims, const NeuralScaler &scaler);
+    /**
+     * @brief Construct a new Neural Layers object from a graph of layers, with a preprocessing of the input.
+     * The graph is built at each fit, for the number of outputs of the scaler. Its output must have one value per output of y.
+     *
+     * @param graph The layers of the model. Ex: a graph of NeuralConv2D, NeuralPool and NeuralDense layers.
+     * @param scaler The preprocessing of the input. Default: NeuralScaler().
+     *
+     * @throw std::invalid_argument If the graph is empty.
+     */
+    NeuralLayers(const NeuralGraph &graph, const NeuralScaler &scaler = NeuralScaler());
     /**
      * @brief Destroy the Neural Layers object
      */
@@ -118,8 +240,88 @@ public:
      * @param verbose The number of epochs between each print of the error. Set to 0 to disable. Default: 100.
      *
      * @note To get the errors for each epoch, use the attribute errors. Ensure that the model is trained before accessing this attribute.
+     * @note If NeuralTuner::automatic() is true, the shapes of the model which are not in the tuning cache are tuned first.
      */
     void fit(const cmatrix<float> &X, const cmatrix<float> &y, const int &epochs = 1000, const float &learning_rate = .01, const int &verbose = 100);
+    /**
+     * @brief Fits the model to the sparse data X and y.
+     * The first layer uses a sparse-dense product and its weights are only updated for the non-zero features,
+     * so the cost of the first layer scales with the number of non-zero values of X.
+     *
+     * @param X The sparse input matrix. Each column represents a sample and each row represents a feature.
+     * @param y The output matrix. Must be a row matrix with the same number of columns as X. Must contain only 0 and 1.
+     * @param epochs The number of epochs. Default: 1000.
+     * @param learning_rate The learning rate. Default: .01.
+     * @param verbose The number of epochs between each print of the error. Set to 0 to disable. Default: 100.
+     */
+    void fit(const NeuralSparse &X, const cmatrix<float> &y, const int &epochs = 1000, const float &learning_rate = .01, const int &verbose = 100);
+    /**
+     * @brief Fits the model to the columns (samples) of X and y selected by indices.
+     * This is used to train on a fold of a shared dataset without copying the fold.
+     *
+     * @param X The input matrix. Each column represents a sample and each row represents a feature.
+     * @param y The output matrix. Must be a row matrix with the same number of columns as X. Must contain only 0 and 1.
+     * @param indices The indices of the samples to train on.
+     * @param epochs The number of epochs. Default: 1000.
+     * @param learning_rate The learning rate. Default: .01.
+     * @param verbose The number of epochs between each print of the error. Set to 0 to disable. Default: 100.
+     *
+     * @throw std::invalid_argument If an index is out of range.
+     */
+    void fit(const cmatrix<float> &X, const cmatrix<float> &y, const std::vector<size_t> &indices, const int &epochs = 1000, const float &learning_rate = .01, const int &verbose = 100);
+    /**
+     * @brief Fits the model asynchronously with lock-free stochastic updates (Hogwild!).
+     * The worker threads pull the samples one by one, compute their gradient and update the shared weights without lock.
+     * It is intended for shallow networks, where the updates of two samples rarely touch the same weights.
+     *
+     * @param X The input matrix. Each column represents a sample and each row represents a feature.
+     * @param y The output matrix. Must be a row matrix with the same number of columns as X. Must contain only 0 and 1.
+     * @param epochs The number of epochs. Default: 10.
+     * @param learning_rate The learning rate of each stochastic step. Default: .1.
+     * @param verbose The number of epochs between each print of the error. Set to 0 to disable. Default: 1.
+     * @param n_threads The number of worker threads. Set to 0 to use all the hardware threads. Default: 0.
+     * @param n_replicas The number of weights replicas averaged after each epoch, typically the number of sockets. Default: 1.
+     *
+     * @note Use the attribute throughput to get the number of samples processed per second.
+     * @throw std::invalid_argument If the model is built from a graph: only the dimensions of the layers are supported.
+     * @see NeuralHogwild
+     */
+    void fit_async(const cmatrix<float> &X, const cmatrix<float> &y, const int &epochs = 10, const float &learning_rate = .1, const int &verbose = 1, const size_t &n_threads = 0, const size_t &n_replicas = 1);
+    /**
+     * @brief Fits the model asynchronously on sparse data. The updates of the first layer only touch the non-zero features of their sample.
+     *
+     * @param X The sparse input matrix. Each column represents a sample and each row represents a feature.
+     * @param y The output matrix. Must be a row matrix with the same number of columns as X. Must contain only 0 and 1.
+     * @param epochs The number of epochs. Default: 10.
+     * @param learning_rate The learning rate of each stochastic step. Default: .1.
+     * @param verbose The number of epochs between each print of the error. Set to 0 to disable. Default: 1.
+     * @param n_threads The number of worker threads. Set to 0 to use all the hardware threads. Default: 0.
+     * @param n_replicas The number of weights replicas averaged after each epoch, typically the number of sockets. Default: 1.
+     */
+    void fit_async(const NeuralSparse &X, const cmatrix<float> &y, const int &epochs = 10, const float &learning_rate = .1, const int &verbose = 1, const size_t &n_threads = 0, const size_t &n_replicas = 1);
+
+    // PRUNING METHODS
+    /**
+     * @brief Set the pruning of the weights during the next fits (except the asynchronous fits).
+     *
+     * @param pruner The pruner. Ex: NeuralPruner(.9, NeuralPruner::GLOBAL, 200, 600).
+     */
+    void set_pruner(const NeuralPruner &pruner);
+    /**
+     * @brief Compresses the pruned dense layers in the block sparse format of the pruner. Their forward skips the blocks of zeros
+     * and the model file only stores the remaining blocks. A layer is compressed if at least min_sparsity of its blocks are zeros.
+     *
+     * @param min_sparsity The minimum ratio of blocks of zeros of a compressed layer. If negative, it is the sparsity from which
+     * the block sparse product is faster than the dense one, measured for the shape of each layer by NeuralTuner::crossover. Default: -1.
+     * @return size_t The number of compressed layers.
+     *
+     * @throw std::invalid_argument If the model is not trained.
+     */
+    size_t compress(const float &min_sparsity = -1);
+    /**
+     * @brief Get the layers of the model.
+     */
+    const NeuralGraph &graph() const;
 
     // PREDICTION METHODS
     /**
@@ -129,6 +331,48 @@ public:
      * @return cmatrix<cbool> The predicted output matrix.
      */
     cmatrix<cbool> predict(const cmatrix<float> &X);
+    /**
+     * @brief Predicts the output for the sparse input matrix X. The first layer reads the columns of X directly.
+     *
+     * @param X The sparse input matrix. Each column represents a sample and each row represents a feature.
+     * @return cmatrix<cbool> The predicted output matrix.
+     */
+    cmatrix<cbool> predict(const NeuralSparse &X);
+    /**
+     * @brief Predicts the output for the columns (samples) of X selected by indices.
+     *
+     * @param X The input matrix.
+     * @param indices The indices of the samples to predict.
+     * @return cmatrix<cbool> The predicted output matrix. Its column i is the prediction of the sample indices[i].
+     *
+     * @throw std::invalid_argument If an index is out of range.
+     */
+    cmatrix<cbool> predict(const cmatrix<float> &X, const std::vector<size_t> &indices);
+    /**
+     * @brief Predicts the probability of each output for the input matrix X.
+     *
+     * @param X The input matrix.
+     * @return cmatrix<float> The probabilities. Each column represents a sample.
+     */
+    cmatrix<float> predict_proba(const cmatrix<float> &X);
+
+    // SERIALIZATION METHODS
+    /**
+     * @brief Saves the weights and the fitted scaler of the model in a file.
+     *
+     * @param path The path of the file.
+     *
+     * @throw std::runtime_error If the file cannot be written.
+     */
+    void save(const std::string &path) const;
+    /**
+     * @brief Loads the weights and the scaler of a model saved with save.
+     *
+     * @param path The path of the file.
+     *
+     * @throw std::runtime_error If the file cannot be read or is not valid.
+     */
+    void load(const std::string &path);
 };
 
 #endif // NEURAL_LAYERS_HPP
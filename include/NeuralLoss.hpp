@@ -18,6 +18,8 @@
 
 // INCLUDES
 #include "../lib/CMatrix/include/CMatrix.hpp"
+#include "NeuralExpr.hpp"
+#include "NeuralView.hpp"
 
 /**
  * @brief This class is used to compute the loss and associated gradients.
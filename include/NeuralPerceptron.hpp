@@ -18,6 +18,8 @@
 
 // INCLUDES
 #include "NeuralActivation.hpp"
+#include "NeuralExpr.hpp"
+#include "NeuralHogwild.hpp"
 
 /**
  * @brief This class is used to fit a model to a dataset.
@@ -28,7 +30,30 @@ class NeuralPerceptron
 {
 private:
     // STATIC METHODS
-    cmatrix<float> __augment_X(const cmatrix<float> &X) const;
+    /**
+     * @brief Get the weights as a contiguous vector. The last weight is the bias.
+     */
+    std::vector<float> __weights() const;
+    /**
+     * @brief Check if the number of epochs is valid and if all the labels are either 1 or -1.
+     *
+     * @throw std::invalid_argument If the number of epochs is not greater than 0.
+     * @throw std::invalid_argument If the labels are not either 1 or -1.
+     */
+    void __check_valid_fit(const cmatrix<float> &y_true, const int &epochs) const;
+    /**
+     * @brief Train the weights asynchronously with the perceptron rule: w += learning_rate * y * [x, 1] if y * [x, 1].w <= 0.
+     *
+     * @param n_samples The number of samples.
+     * @param n_features The number of features, without the bias.
+     * @param sample The function returning the non-zero (feature, value) pairs of a sample.
+     * @param y_true The target values.
+     * @param epochs The number of epochs.
+     * @param learning_rate The learning rate.
+     * @param hogwild The asynchronous engine.
+     * @param error The function computing the error with the given weights, called after each epoch if verbose is true.
+     */
+    void __fit_async(const size_t &n_samples, const size_t &n_features, const std::function<void(const size_t &, std::vector<std::pair<size_t, float>> &)> &sample, const cmatrix<float> &y_true, const int &epochs, const float &learning_rate, NeuralHogwild &hogwild, const std::function<float()> &error);
 
 public:
     // ATTRIBUTES
@@ -44,6 +69,10 @@ public:
      * @brief If true, print the error at each iteration. Default: false.
      */
     bool verbose = false;
+    /**
+     * @brief The number of samples processed per second by the last asynchronous fit.
+     */
+    float throughput = 0;
 
     // METHODS
     /**
@@ -69,6 +98,72 @@ public:
      */
 
     cmatrix<float> fit(const cmatrix<float> &X, const cmatrix<float> &y_true, const int &epochs = 1000, const float &learning_rate = .01);
+    /**
+     * @brief Fit the model on a view of the training samples, such as a block of rows of a larger matrix.
+     * The samples are not augmented nor copied: the bias is applied implicitly.
+     *
+     * @param X The view of the training samples.
+     * @param y_true The target values.
+     * @param epochs The number of epochs. Default is 1000.
+     * @param learning_rate The learning rate. Default is 0.01.
+     * @return cmatrix<float> The weights after fitting the model. The last weight is the bias.
+     *
+     * @throw std::invalid_argument If the number of epochs is not greater than 0.
+     * @throw std::invalid_argument If the weights matrix is not of size (X.width() + 1)x1.
+     * @throw std::invalid_argument If the labels are not either 1 or -1.
+     */
+    cmatrix<float> fit(const NeuralView &X, const cmatrix<float> &y_true, const int &epochs = 1000, const float &learning_rate = .01);
+    /**
+     * @brief Fit the model according to the given sparse training data.
+     * The samples are not augmented: the bias is applied implicitly, so the cost of each epoch scales with the number of non-zero values.
+     *
+     * @param X The sparse training samples. Each row is a sample.
+     * @param y_true The target values.
+     * @param epochs The number of epochs. Default is 1000.
+     * @param learning_rate The learning rate. Default is 0.01.
+     * @return cmatrix<float> The weights after fitting the model. The last weight is the bias.
+     *
+     * @throw std::invalid_argument If the number of epochs is not greater than 0.
+     * @throw std::invalid_argument If the labels are not either 1 or -1.
+     *
+     * @warning The problem must be a binary classification problem (labels must be either 1 or -1).
+     */
+    cmatrix<float> fit(const NeuralSparse &X, const cmatrix<float> &y_true, const int &epochs = 1000, const float &learning_rate = .01);
+    /**
+     * @brief Fit the model asynchronously with lock-free stochastic updates (Hogwild!).
+     * The worker threads pull the samples one by one and update the shared weights without lock
+     * with the perceptron rule: w += learning_rate * y * [x, 1] if y * [x, 1].w <= 0.
+     *
+     * @param X The training samples. Each row is a sample.
+     * @param y_true The target values.
+     * @param epochs The number of epochs. Default is 10.
+     * @param learning_rate The learning rate. Default is 0.01.
+     * @param n_threads The number of worker threads. Set to 0 to use all the hardware threads. Default is 0.
+     * @param n_replicas The number of weights replicas averaged after each epoch, typically the number of sockets. Default is 1.
+     * @return cmatrix<float> The weights after fitting the model. The last weight is the bias.
+     *
+     * @throw std::invalid_argument If the number of epochs is not greater than 0.
+     * @throw std::invalid_argument If the labels are not either 1 or -1.
+     *
+     * @note Use the throughput attribute to get the number of samples processed per second.
+     * @see NeuralHogwild
+     */
+    cmatrix<float> fit_async(const cmatrix<float> &X, const cmatrix<float> &y_true, const int &epochs = 10, const float &learning_rate = .01, const size_t &n_threads = 0, const size_t &n_replicas = 1);
+    /**
+     * @brief Fit the model asynchronously on sparse samples. Each update only touches the non-zero features of its sample.
+     *
+     * @param X The sparse training samples. Each row is a sample.
+     * @param y_true The target values.
+     * @param epochs The number of epochs. Default is 10.
+     * @param learning_rate The learning rate. Default is 0.01.
+     * @param n_threads The number of worker threads. Set to 0 to use all the hardware threads. Default is 0.
+     * @param n_replicas The number of weights replicas averaged after each epoch, typically the number of sockets. Default is 1.
+     * @return cmatrix<float> The weights after fitting the model. The last weight is the bias.
+     *
+     * @throw std::invalid_argument If the number of epochs is not greater than 0.
+     * @throw std::invalid_argument If the labels are not either 1 or -1.
+     */
+    cmatrix<float> fit_async(const NeuralSparse &X, const cmatrix<float> &y_true, const int &epochs = 10, const float &learning_rate = .01, const size_t &n_threads = 0, const size_t &n_replicas = 1);
     /**
      * @brief Predict using the linear model.
      *
@@ -81,6 +176,26 @@ public:
      * @note Use the m_weights attribute to get the weights after fitting the model.
      */
     cmatrix<float> predict(const cmatrix<float> &X) const;
+    /**
+     * @brief Predict a view of the samples using the linear model. The samples are not copied.
+     *
+     * @param X The view of the samples, either augmented with a column of ones or not.
+     * @return cmatrix<float> The predicted values.
+     *
+     * @throw std::runtime_error If the model is not fitted.
+     * @throw std::invalid_argument If the width of the view is neither m_weights.height() nor m_weights.height() - 1.
+     */
+    cmatrix<float> predict(const NeuralView &X) const;
+    /**
+     * @brief Predict the sparse samples using the linear model.
+     *
+     * @param X The sparse samples matrix, not augmented.
+     * @return cmatrix<float> The predicted values.
+     *
+     * @throw std::invalid_argument If the model is not fitted.
+     * @throw std::invalid_argument If the samples matrix is not of size X.height() x (m_weights.height() - 1).
+     */
+    cmatrix<float> predict(const NeuralSparse &X) const;
 };
 
 #endif // NEURALPERCEPTRON_HPP
@@ -0,0 +1,165 @@
+/**
+ * @defgroup NeuralPruner NeuralPruner
+ * @file NeuralPruner.hpp
+ * @see src/NeuralPruner.cpp for implementation.
+ * @brief The NeuralPruner class.
+ *
+ * This file defines the magnitude pruning of the weights of a NeuralGraph.
+ *
+ * @see Visit https://arxiv.org/abs/1710.01878 for more information on the gradual pruning schedule.
+ *
+ * @author Manitas Bahri <https://github.com/B-Manitas>
+ * @date 2023/11
+ * @license MIT License
+ */
+
+#ifndef NEURALPRUNER_HPP
+#define NEURALPRUNER_HPP
+
+// INCLUDES
+#include <cstddef>
+#include <vector>
+
+#include "NeuralGraph.hpp"
+
+/**
+ * @brief This class prunes the weights of the smallest magnitude of a graph, while it is trained.
+ *
+ * The weights are pruned by blocks of block_height x block_width weights, scored by their mean magnitude
+ * (one weight per block by default). The target sparsity grows from 0 to its final value between two epochs
+ * with a cubic schedule, so the remaining weights are fine-tuned while the pruning progresses, and after it.
+ * The bias is never pruned.
+ *
+ * Once trained, the pruned dense layers can be compressed in the block sparse format: their forward then skips
+ * the blocks of zeros, and the model file only stores the remaining blocks.
+ *
+ * Example:
+ * @code
+ * NeuralLayers model({256, 256});
+ * model.set_pruner(NeuralPruner(.9, NeuralPruner::GLOBAL, 200, 600, 50, 1, 4));
+ * model.fit(X, y, 1000);
+ * model.compress();
+ * @endcode
+ */
+class NeuralPruner
+{
+public:
+    // STRUCTURES
+    /**
+     * @brief The set of weights in which the sparsity is reached.
+     */
+    enum Scope
+    {
+        /**
+         * @brief The weights of all the layers are compared together.
+         */
+        GLOBAL,
+        /**
+         * @brief Each layer reaches the sparsity.
+         */
+        LAYER
+    };
+
+private:
+    // ATTRIBUTES
+    float m_sparsity = 0;
+    Scope m_scope = GLOBAL;
+    int m_begin_epoch = 0;
+    int m_end_epoch = 0;
+    int m_frequency = 1;
+    size_t m_block_height = 1;
+    size_t m_block_width = 1;
+
+    // The structured N:M pruning keeps n weights in each group of m consecutive weights. It is disabled if m is 0.
+    size_t m_n = 0;
+    size_t m_m = 0;
+
+    // METHODS
+    /**
+     * @brief Prunes the blocks of the smallest mean magnitude.
+     *
+     * @param graph The graph.
+     * @param sparsity The ratio of pruned blocks.
+     */
+    void __prune_magnitude(NeuralGraph &graph, const float &sparsity) const;
+
+    friend class NeuralTuner;
+    /**
+     * @brief Keeps the n weights of the largest magnitude in each group of m consecutive weights of a row.
+     *
+     * @param graph The graph.
+     */
+    void __prune_structured(NeuralGraph &graph) const;
+
+public:
+    // CONSTRUCTORS
+    /**
+     * @brief Construct a new Neural Pruner object for magnitude pruning.
+     *
+     * @param sparsity The final ratio of pruned weights, in [0, 1[. Set to 0 to disable the pruning. Default: 0.
+     * @param scope The set of weights in which the sparsity is reached. Default: GLOBAL.
+     * @param begin_epoch The epoch of the first pruning. Default: 0.
+     * @param end_epoch The epoch at which the final sparsity is reached. If it is not after begin_epoch, the weights are pruned once at begin_epoch. Default: 0.
+     * @param frequency The number of epochs between two prunings. Default: 1.
+     * @param block_height The number of rows (units or filters) of a pruned block, in [1, 16]. Default: 1.
+     * @param block_width The number of weights of a row of a pruned block, in [1, 16]. Default: 1.
+     *
+     * @throw std::invalid_argument If a parameter is out of range.
+     */
+    NeuralPruner(const float &sparsity = 0, const Scope &scope = GLOBAL, const int &begin_epoch = 0, const int &end_epoch = 0, const int &frequency = 1, const size_t &block_height = 1, const size_t &block_width = 1);
+    /**
+     * @brief Create a pruner keeping n weights in each group of m consecutive weights of a row (N:M structured sparsity).
+     *
+     * @param n The number of kept weights of a group.
+     * @param m The number of weights of a group.
+     * @param begin_epoch The epoch of the first pruning. Default: 0.
+     * @param end_epoch The epoch of the last pruning. Default: 0.
+     * @param frequency The number of epochs between two prunings. Default: 1.
+     * @return NeuralPruner The pruner.
+     *
+     * @throw std::invalid_argument If n is not lower than m or if m is 0.
+     */
+    static NeuralPruner structured(const size_t &n, const size_t &m, const int &begin_epoch = 0, const int &end_epoch = 0, const int &frequency = 1);
+
+    // METHODS
+    /**
+     * @brief Check if the pruner prunes the weights.
+     */
+    bool is_enabled() const;
+    /**
+     * @brief Get the target sparsity of an epoch: 0 before begin_epoch, then s * (1 - (1 - t)^3),
+     * where t is the progress from begin_epoch to end_epoch, then the final sparsity s.
+     *
+     * @param epoch The epoch.
+     */
+    float sparsity(const int &epoch) const;
+    /**
+     * @brief Prunes the graph if the schedule prunes at this epoch.
+     *
+     * @param graph The built graph.
+     * @param epoch The epoch.
+     * @return true if the graph was pruned.
+     */
+    bool step(NeuralGraph &graph, const int &epoch) const;
+    /**
+     * @brief Prunes the graph: sets the masks of the layers with weights. The pruned weights stay 0 during the training.
+     *
+     * @param graph The built graph.
+     * @param sparsity The ratio of pruned weights. It is ignored by the N:M pruning.
+     *
+     * @throw std::invalid_argument If the graph is not built.
+     */
+    void prune(NeuralGraph &graph, const float &sparsity) const;
+    /**
+     * @brief Compresses the dense layers with the blocks of the pruner, if the ratio of their blocks of zeros is at least min_sparsity.
+     * Below this ratio, the block sparse product is slower than the dense one.
+     *
+     * @param graph The built graph.
+     * @param min_sparsity The minimum ratio of blocks of zeros of a compressed layer. If negative, it is the crossover
+     * measured for the shape of each layer, see NeuralTuner::crossover. Default: -1.
+     * @return size_t The number of compressed layers.
+     */
+    size_t compress(NeuralGraph &graph, const float &min_sparsity = -1) const;
+};
+
+#endif // NEURALPRUNER_HPP
@@ -0,0 +1,237 @@
+/**
+ * @defgroup NeuralScaler NeuralScaler
+ * @file NeuralScaler.hpp
+ * @see src/NeuralScaler.cpp for implementation.
+ * @brief The NeuralScaler class.
+ *
+ * This file defines the preprocessing of the input features: standardization, min-max scaling and one-hot encoding.
+ *
+ * @see Visit https://en.wikipedia.org/wiki/Algorithms_for_calculating_variance#Welford's_online_algorithm for more information.
+ *
+ * @author Manitas Bahri <https://github.com/B-Manitas>
+ * @date 2023/11
+ * @license MIT License
+ */
+
+#ifndef NEURALSCALER_HPP
+#define NEURALSCALER_HPP
+
+// INCLUDES
+#include <istream>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+#include "../lib/CMatrix/include/CMatrix.hpp"
+
+/**
+ * @brief This class scales the input features of a model.
+ *
+ * The statistics of the features are computed in one parallel pass over the samples (Welford).
+ * The transform is applied while the input of the first layer is built, so the scaled data is never stored on its own.
+ *
+ * The categorical features are one-hot encoded: a feature with k categories becomes k rows of the output.
+ * A category unseen during the fit is encoded with zeros only.
+ */
+class NeuralScaler
+{
+public:
+    // STRUCTURES
+    /**
+     * @brief The scaling of the numerical features.
+     */
+    enum Method
+    {
+        /**
+         * @brief The features are not scaled.
+         */
+        NONE,
+        /**
+         * @brief The features are centered and divided by their standard deviation.
+         */
+        STANDARD,
+        /**
+         * @brief The features are scaled to [0, 1] with their minimum and maximum.
+         */
+        MINMAX
+    };
+
+private:
+    // ATTRIBUTES
+    Method m_method = NONE;
+    std::vector<size_t> m_categorical = {};
+
+    size_t m_n_features = 0;
+    size_t m_n_outputs = 0;
+    bool m_fitted = false;
+
+    // The output of the numerical feature f is (x - m_shift[f]) * m_scale[f], stored in the row m_offsets[f]
+    std::vector<float> m_shift = {};
+    std::vector<float> m_scale = {};
+    std::vector<size_t> m_offsets = {};
+    // The sorted categories of each categorical feature, empty for the numerical features
+    std::vector<std::vector<float>> m_categories = {};
+
+    // METHODS
+    /**
+     * @brief Computes the statistics of the features over the selected samples.
+     *
+     * @param X The input matrix.
+     * @param indices The indices of the samples, or nullptr to use all the samples.
+     */
+    void __fit(const cmatrix<float> &X, const std::vector<size_t> *indices);
+    /**
+     * @brief Transforms the selected samples.
+     *
+     * @param X The input matrix.
+     * @param indices The indices of the samples, or nullptr to use all the samples.
+     * @param bias If true, a last row of ones is added for the bias.
+     */
+    cmatrix<float> __transform(const cmatrix<float> &X, const std::vector<size_t> *indices, const bool &bias) const;
+    /**
+     * @brief Transforms the selected samples into a buffer, one sample after the other.
+     *
+     * @param X The input matrix.
+     * @param indices The indices of the samples, or nullptr to use all the samples.
+     * @param out The output buffer, of size number of samples x n_outputs.
+     */
+    void __transform(const cmatrix<float> &X, const std::vector<size_t> *indices, float *out) const;
+    /**
+     * @brief Checks if the indices of the samples are in range.
+     *
+     * @throw std::invalid_argument If an index is out of range.
+     */
+    void __check_valid_indices(const cmatrix<float> &X, const std::vector<size_t> &indices) const;
+    /**
+     * @brief Checks if the scaler is fitted to the features of X.
+     *
+     * @throw std::invalid_argument If the scaler is not fitted or if X has not the number of features of the fit.
+     */
+    void __check_valid_X(const cmatrix<float> &X) const;
+    /**
+     * @brief Get the position of a category of a categorical feature.
+     *
+     * @return size_t The position of the category, or the number of categories if it is unknown.
+     */
+    size_t __category(const size_t &feature, const float &value) const;
+    /**
+     * @brief Computes the output row of each feature and the number of outputs.
+     */
+    void __compute_offsets();
+
+public:
+    // CONSTRUCTORS
+    /**
+     * @brief Construct a new Neural Scaler object.
+     *
+     * @param method The scaling of the numerical features. Default: NONE.
+     * @param categorical The indices of the categorical features, which are one-hot encoded. Default: none.
+     */
+    NeuralScaler(const Method &method = NONE, const std::vector<size_t> &categorical = {});
+
+    // METHODS
+    /**
+     * @brief Get the scaling of the numerical features.
+     */
+    Method method() const;
+    /**
+     * @brief Check if the scaler leaves the features unchanged.
+     */
+    bool is_identity() const;
+    /**
+     * @brief Check if the scaler is fitted.
+     */
+    bool is_fitted() const;
+    /**
+     * @brief Get the number of input features of the fitted scaler.
+     */
+    size_t n_features() const;
+    /**
+     * @brief Get the number of output rows of the transform, without the bias.
+     */
+    size_t n_outputs() const;
+
+    /**
+     * @brief Computes the statistics of the features.
+     *
+     * @param X The input matrix. Each column represents a sample and each row represents a feature.
+     *
+     * @throw std::invalid_argument If X is empty or if a categorical feature is out of range.
+     */
+    void fit(const cmatrix<float> &X);
+    /**
+     * @brief Computes the statistics of the features over the samples selected by indices.
+     *
+     * @param X The input matrix. Each column represents a sample and each row represents a feature.
+     * @param indices The indices of the samples.
+     *
+     * @throw std::invalid_argument If there is no sample, if an index is out of range or if a categorical feature is out of range.
+     */
+    void fit(const cmatrix<float> &X, const std::vector<size_t> &indices);
+
+    /**
+     * @brief Transforms the samples of X.
+     *
+     * @param X The input matrix.
+     * @param bias If true, a last row of ones is added for the bias. Default: false.
+     * @return cmatrix<float> The transformed matrix of size (n_outputs + bias) x X.width().
+     *
+     * @throw std::invalid_argument If the scaler is not fitted to the features of X.
+     */
+    cmatrix<float> transform(const cmatrix<float> &X, const bool &bias = false) const;
+    /**
+     * @brief Transforms the samples of X selected by indices.
+     *
+     * @param X The input matrix.
+     * @param indices The indices of the samples.
+     * @param bias If true, a last row of ones is added for the bias. Default: false.
+     * @return cmatrix<float> The transformed matrix. Its column i is the sample indices[i].
+     *
+     * @throw std::invalid_argument If the scaler is not fitted to the features of X or if an index is out of range.
+     */
+    cmatrix<float> transform(const cmatrix<float> &X, const std::vector<size_t> &indices, const bool &bias = false) const;
+    /**
+     * @brief Transforms one sample of X into its non-zero (row, value) pairs, without the bias.
+     *
+     * @param X The input matrix.
+     * @param j The index of the sample.
+     * @param x The output pairs.
+     */
+    void transform(const cmatrix<float> &X, const size_t &j, std::vector<std::pair<size_t, float>> &x) const;
+    /**
+     * @brief Transforms the samples of X into a buffer, one sample after the other, without the bias.
+     *
+     * @param X The input matrix.
+     * @param out The output buffer, of size X.width() x n_outputs. The value k * n_outputs + i is the output i of the sample k.
+     *
+     * @throw std::invalid_argument If the scaler is not fitted to the features of X.
+     */
+    void transform(const cmatrix<float> &X, float *out) const;
+    /**
+     * @brief Transforms the samples of X selected by indices into a buffer, one sample after the other, without the bias.
+     *
+     * @param X The input matrix.
+     * @param indices The indices of the samples.
+     * @param out The output buffer, of size indices.size() x n_outputs.
+     *
+     * @throw std::invalid_argument If the scaler is not fitted to the features of X or if an index is out of range.
+     */
+    void transform(const cmatrix<float> &X, const std::vector<size_t> &indices, float *out) const;
+
+    /**
+     * @brief Writes the fitted scaler in a stream.
+     *
+     * @param stream The output stream.
+     */
+    void save(std::ostream &stream) const;
+    /**
+     * @brief Reads a scaler written by save. The scaler is unchanged if the stream is not valid.
+     *
+     * @param stream The input stream.
+     *
+     * @throw std::runtime_error If the stream does not contain a valid scaler.
+     */
+    void load(std::istream &stream);
+};
+
+#endif // NEURALSCALER_HPP
@@ -0,0 +1,255 @@
+/**
+ * @defgroup NeuralScorer NeuralScorer
+ * @file NeuralScorer.hpp
+ * @see src/NeuralScorer.cpp for implementation.
+ * @brief The NeuralScorer class.
+ *
+ * This file defines the offline batch scoring of a file of samples with a trained NeuralLayers model.
+ *
+ * @author Manitas Bahri <https://github.com/B-Manitas>
+ * @date 2023/11
+ * @license MIT License
+ */
+
+#ifndef NEURALSCORER_HPP
+#define NEURALSCORER_HPP
+
+// INCLUDES
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <string>
+
+#include "NeuralLayers.hpp"
+
+/**
+ * @brief This class scores a file of samples with a trained model and writes the probabilities and the labels in a file.
+ *
+ * The file is memory-mapped and streamed through a pipeline of stages, connected by bounded queues:
+ * - read: one thread splits the file in chunks of batch_size rows.
+ * - parse: n_parsers threads convert the chunks in matrices of samples.
+ * - compute: n_workers threads run the batched forward passes, each with its own copy of the model, and format the results.
+ * - write: one thread writes the results in the order of the input.
+ *
+ * At most (3 * queue_size + n_parsers + n_workers) chunks are in flight, so the memory is bounded and the fastest stages
+ * wait for the slowest one (backpressure). The report gives the busy time of each stage and the bottleneck of the run.
+ *
+ * The input formats are:
+ * - CSV: one sample per line, its features separated by commas. The first line is skipped if header is true.
+ * - BINARY: the columnar format written by save_binary: the magic "NCPPCOL1", the number of rows and of features
+ *   (uint64), then the values of each feature (float32), one feature after the other.
+ *
+ * The output formats are:
+ * - CSV: one line per sample: the probability of each output, then the label of each output (1 if its probability > .5).
+ * - BINARY: the magic "NCPPSCR1" and the number of outputs (uint64), then for each sample the probabilities (float32)
+ *   and the labels (uint8).
+ *
+ * Example:
+ * @code
+ * NeuralScorer scorer(8192, 4, 2);
+ * const NeuralScorer::Report &report = scorer.score(model, "samples.csv", "scores.csv");
+ * std::cout << report.rows_per_second << " rows/s" << std::endl;
+ * @endcode
+ */
+class NeuralScorer
+{
+public:
+    // STRUCTURES
+    /**
+     * @brief The format of a file.
+     */
+    enum Format
+    {
+        CSV,
+        BINARY
+    };
+
+    /**
+     * @brief A stage of the pipeline.
+     */
+    enum Stage
+    {
+        READ,
+        PARSE,
+        COMPUTE,
+        WRITE
+    };
+
+    /**
+     * @brief The report of a scoring.
+     */
+    struct Report
+    {
+        size_t n_rows = 0;
+        size_t n_chunks = 0;
+        size_t bytes_read = 0;
+        size_t bytes_written = 0;
+        double seconds = 0;
+        double rows_per_second = 0;
+        /**
+         * @brief The time spent working by each stage, summed over its threads. The waits on the queues are excluded.
+         */
+        double busy_seconds[4] = {0, 0, 0, 0};
+        /**
+         * @brief The stage with the highest ratio of busy time per thread: adding threads to it, or a faster disk for READ and WRITE, speeds up the scoring.
+         */
+        Stage bottleneck = READ;
+    };
+
+private:
+    // STRUCTURES
+    /**
+     * @brief A queue of bounded size. push waits while it is full, pop waits while it is empty.
+     * Once closed, push fails and pop fails when the queue is empty.
+     */
+    template <class T>
+    class Queue
+    {
+    private:
+        std::mutex m_mutex;
+        std::condition_variable m_cv_push;
+        std::condition_variable m_cv_pop;
+        std::deque<T> m_items;
+        size_t m_capacity;
+        bool m_closed = false;
+
+    public:
+        explicit Queue(const size_t &capacity) : m_capacity(capacity) {}
+
+        bool push(T item)
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cv_push.wait(lock, [&]
+                           { return m_closed || m_items.size() < m_capacity; });
+
+            if (m_closed)
+                return false;
+
+            m_items.push_back(std::move(item));
+            m_cv_pop.notify_one();
+            return true;
+        }
+
+        bool pop(T &item)
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cv_pop.wait(lock, [&]
+                          { return m_closed || !m_items.empty(); });
+
+            if (m_items.empty())
+                return false;
+
+            item = std::move(m_items.front());
+            m_items.pop_front();
+            m_cv_push.notify_one();
+            return true;
+        }
+
+        void close()
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_closed = true;
+            m_cv_push.notify_all();
+            m_cv_pop.notify_all();
+        }
+    };
+
+    /**
+     * @brief A chunk of rows, from its range in the file to its formatted results.
+     */
+    struct Chunk
+    {
+        size_t index = 0;
+        size_t first_row = 0;
+        size_t n_rows = 0;
+        const char *begin = nullptr;
+        const char *end = nullptr;
+        cmatrix<float> X = cmatrix<float>();
+        std::string result = std::string();
+    };
+
+    // ATTRIBUTES
+    size_t m_batch_size = 4096;
+    size_t m_n_parsers = 1;
+    size_t m_n_workers = 1;
+    size_t m_queue_size = 4;
+    Report m_report = Report();
+
+    // METHODS
+    /**
+     * @brief Parse the CSV rows of a chunk.
+     *
+     * @param chunk The chunk. Its matrix is filled with its samples.
+     * @param n_features The number of features of a row.
+     *
+     * @throw std::runtime_error If a row does not have n_features numeric values.
+     */
+    static void __parse_csv(Chunk &chunk, const size_t &n_features);
+    /**
+     * @brief Gather the rows of a chunk of a binary columnar file.
+     *
+     * @param chunk The chunk. Its matrix is filled with its samples.
+     * @param columns The first value of the first column.
+     * @param n_rows The number of rows of the file.
+     */
+    static void __parse_binary(Chunk &chunk, const float *columns, const size_t &n_rows);
+    /**
+     * @brief Format the output of the model for the samples of a chunk.
+     *
+     * @param chunk The chunk. Its result is overwritten.
+     * @param output The output of the model, of size n_rows x n_outputs.
+     * @param n_outputs The number of outputs.
+     * @param format The output format.
+     */
+    static void __format(Chunk &chunk, const float *output, const size_t &n_outputs, const Format &format);
+
+public:
+    // CONSTRUCTORS
+    /**
+     * @brief Construct a new Neural Scorer object.
+     *
+     * @param batch_size The number of rows of a chunk, scored by one forward pass.
+     * If 0, it is the batch size tuned for the model by NeuralTuner, else 4096. Default: 4096.
+     * @param n_parsers The number of parsing threads. If 0, it is the number of cores. Default: 0.
+     * @param n_workers The number of compute threads. The cores are shared between their forward passes. Default: 1.
+     * @param queue_size The number of chunks of each queue between two stages. Default: 4.
+     *
+     * @throw std::invalid_argument If n_workers or queue_size is 0.
+     */
+    NeuralScorer(const size_t &batch_size = 4096, const size_t &n_parsers = 0, const size_t &n_workers = 1, const size_t &queue_size = 4);
+
+    // METHODS
+    /**
+     * @brief Score a file of samples.
+     *
+     * @param model The trained model. It is copied by each compute thread.
+     * @param input The path of the samples.
+     * @param output The path of the results.
+     * @param input_format The format of the samples. Default: CSV.
+     * @param output_format The format of the results. Default: CSV.
+     * @param header If true, the first line of a CSV input is skipped. Default: false.
+     * @return const Report& The report of the scoring.
+     *
+     * @throw std::invalid_argument If the model is not trained.
+     * @throw std::runtime_error If a file cannot be opened, or if the samples are not valid.
+     */
+    const Report &score(const NeuralLayers &model, const std::string &input, const std::string &output, const Format &input_format = CSV, const Format &output_format = CSV, const bool &header = false);
+    /**
+     * @brief Get the report of the last scoring.
+     */
+    const Report &report() const;
+
+    // STATIC METHODS
+    /**
+     * @brief Write samples in the binary columnar input format.
+     *
+     * @param path The path of the file.
+     * @param X The samples. Each column represents a sample and each row represents a feature.
+     *
+     * @throw std::runtime_error If the file cannot be written.
+     */
+    static void save_binary(const std::string &path, const cmatrix<float> &X);
+};
+
+#endif // NEURALSCORER_HPP
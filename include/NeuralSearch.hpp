@@ -0,0 +1,207 @@
+/**
+ * @defgroup NeuralSearch NeuralSearch
+ * @file NeuralSearch.hpp
+ * @see src/NeuralSearch.cpp for implementation.
+ * @brief The NeuralSearch class.
+ *
+ * This file defines the hyperparameter search of the NeuralLayers model with k-fold cross-validation.
+ *
+ * @see Visit https://en.wikipedia.org/wiki/Hyperparameter_optimization for more information.
+ *
+ * @author Manitas Bahri <https://github.com/B-Manitas>
+ * @date 2023/11
+ * @license MIT License
+ */
+
+#ifndef NEURALSEARCH_HPP
+#define NEURALSEARCH_HPP
+
+// INCLUDES
+#include <vector>
+
+#include "NeuralLayers.hpp"
+#include "NeuralThreadPool.hpp"
+
+/**
+ * @brief This class searches the best hyperparameters of the NeuralLayers model with k-fold cross-validation.
+ *
+ * The trainings of all the (candidate, fold) pairs run concurrently on a work-stealing thread pool.
+ * They all read the same X and y: the folds are vectors of sample indices, never copies of the dataset.
+ * With successive halving, the models of the remaining candidates are kept between the rounds and resume their training.
+ */
+class NeuralSearch
+{
+public:
+    // STRUCTURES
+    /**
+     * @brief The hyperparameters of a candidate model.
+     */
+    struct Params
+    {
+        std::vector<int> layers_dims;
+        int epochs;
+        float learning_rate;
+    };
+    /**
+     * @brief The cross-validation result of a candidate model.
+     */
+    struct Result
+    {
+        Params params;
+        /**
+         * @brief The number of epochs the candidate was trained for. It is lower than params.epochs if it was eliminated early.
+         */
+        int epochs_trained;
+        /**
+         * @brief The mean validation accuracy over the folds.
+         */
+        float score;
+        /**
+         * @brief The validation accuracy of each fold.
+         */
+        std::vector<float> fold_scores;
+    };
+
+private:
+    // ATTRIBUTES
+    int m_n_folds = 5;
+    int m_random_state = 0;
+    NeuralThreadPool m_pool;
+
+    // METHODS
+    /**
+     * @brief Split the indices of the samples in shuffled folds.
+     *
+     * @param n_samples The number of samples.
+     * @return std::vector<std::vector<size_t>> The indices of the samples of each fold.
+     *
+     * @throw std::invalid_argument If the number of samples is lower than the number of folds.
+     */
+    std::vector<std::vector<size_t>> __split_folds(const size_t &n_samples) const;
+    /**
+     * @brief Cross-validate the candidates concurrently. Each (candidate, fold) pair is a task of the pool.
+     *
+     * @param X The input matrix, shared by all the tasks.
+     * @param y The output matrix, shared by all the tasks.
+     * @param candidates The candidates to evaluate.
+     * @param first_epochs The number of epochs already trained by the models of each candidate.
+     * @param epochs The number of epochs of each candidate at the end of the training.
+     * @param models The model of each candidate and fold, trained for first_epochs, or nullptr to train new models
+     * which are not kept. Default: nullptr.
+     * @return std::vector<Result> The result of each candidate, in the same order.
+     */
+    std::vector<Result> __cross_validate(const cmatrix<float> &X, const cmatrix<float> &y, const std::vector<Params> &candidates, const std::vector<int> &first_epochs, const std::vector<int> &epochs, std::vector<std::vector<NeuralLayers>> *models = nullptr);
+    /**
+     * @brief Train a candidate on the training samples of a fold and compute its accuracy on the validation samples.
+     *
+     * @param X The input matrix.
+     * @param y The output matrix.
+     * @param params The hyperparameters of the candidate.
+     * @param model The model of the candidate on the fold. If first_epoch is 0, it is replaced by a new model.
+     * @param first_epoch The number of epochs already trained by the model. Its training resumes from this epoch.
+     * @param epochs The number of epochs at the end of the training.
+     * @param train The indices of the training samples.
+     * @param valid The indices of the validation samples.
+     * @return float The validation accuracy.
+     */
+    static float __score_fold(const cmatrix<float> &X, const cmatrix<float> &y, const Params &params, NeuralLayers &model, const int &first_epoch, const int &epochs, const std::vector<size_t> &train, const std::vector<size_t> &valid);
+    /**
+     * @brief Sort the results by decreasing score.
+     */
+    static void __sort_results(std::vector<Result> &results);
+
+public:
+    // ATTRIBUTES
+    /**
+     * @brief The results of the last search, sorted by decreasing score.
+     */
+    std::vector<Result> results = {};
+
+    // CONSTRUCTORS
+    /**
+     * @brief Construct a new Neural Search object.
+     *
+     * @param n_folds The number of folds. Must be greater than 1. Default: 5.
+     * @param n_threads The number of threads training the candidates. Set to 0 to use all the hardware threads. Default: 0.
+     * @param random_state The random state used to shuffle the folds. Default: 0.
+     *
+     * @throw std::invalid_argument If the number of folds is lower than 2.
+     */
+    NeuralSearch(const int &n_folds = 5, const size_t &n_threads = 0, const int &random_state = 0);
+
+    // STATIC METHODS
+    /**
+     * @brief Create the candidates of a grid search: every combination of the given values.
+     *
+     * @param layers_dims The values of the layers dimensions.
+     * @param epochs The values of the number of epochs.
+     * @param learning_rates The values of the learning rate.
+     * @return std::vector<Params> The candidates.
+     */
+    static std::vector<Params> grid(const std::vector<std::vector<int>> &layers_dims, const std::vector<int> &epochs, const std::vector<float> &learning_rates);
+    /**
+     * @brief Create the candidates of a random search.
+     * The layers dimensions are drawn from the given values, the number of epochs uniformly
+     * in [min_epochs, max_epochs] and the learning rate log-uniformly in [min_learning_rate, max_learning_rate].
+     *
+     * @param layers_dims The values of the layers dimensions.
+     * @param min_epochs The minimum number of epochs.
+     * @param max_epochs The maximum number of epochs.
+     * @param min_learning_rate The minimum learning rate. Must be greater than 0.
+     * @param max_learning_rate The maximum learning rate.
+     * @param n_candidates The number of candidates.
+     * @param random_state The random state. Default: 0.
+     * @return std::vector<Params> The candidates.
+     *
+     * @throw std::invalid_argument If a range is not valid.
+     */
+    static std::vector<Params> random(const std::vector<std::vector<int>> &layers_dims, const int &min_epochs, const int &max_epochs, const float &min_learning_rate, const float &max_learning_rate, const int &n_candidates, const int &random_state = 0);
+
+    // METHODS
+    /**
+     * @brief Cross-validate every candidate with its own number of epochs.
+     *
+     * @param X The input matrix. Each column represents a sample and each row represents a feature.
+     * @param y The output matrix. Must be a row matrix with the same number of columns as X. Must contain only 0 and 1.
+     * @param candidates The candidates to evaluate.
+     * @return const std::vector<Result>& The results, sorted by decreasing score.
+     *
+     * @throw std::invalid_argument If there is no candidate.
+     */
+    const std::vector<Result> &fit(const cmatrix<float> &X, const cmatrix<float> &y, const std::vector<Params> &candidates);
+    /**
+     * @brief Cross-validate the candidates with successive halving.
+     * All the candidates are first trained for min_epochs. Only the best 1/eta are kept for the next round,
+     * which trains them for eta times more epochs (bounded by their own number of epochs). The models of a kept
+     * candidate resume their training, so a round only trains the extra epochs.
+     *
+     * @param X The input matrix. Each column represents a sample and each row represents a feature.
+     * @param y The output matrix. Must be a row matrix with the same number of columns as X. Must contain only 0 and 1.
+     * @param candidates The candidates to evaluate.
+     * @param min_epochs The number of epochs of the first round. Default: 10.
+     * @param eta The elimination factor. Must be greater than 1. Default: 3.
+     * @return const std::vector<Result>& The results, sorted by the last round reached, then by decreasing score.
+     *
+     * @throw std::invalid_argument If there is no candidate, or if min_epochs or eta are not valid.
+     *
+     * @see https://arxiv.org/abs/1502.07943
+     */
+    const std::vector<Result> &fit_halving(const cmatrix<float> &X, const cmatrix<float> &y, const std::vector<Params> &candidates, const int &min_epochs = 10, const int &eta = 3);
+    /**
+     * @brief Get the validation samples of each fold. The training samples of a fold are the samples of the other folds.
+     *
+     * @param n_samples The number of samples.
+     * @return std::vector<std::vector<size_t>> The indices of the validation samples of each fold.
+     *
+     * @throw std::invalid_argument If the number of samples is lower than the number of folds.
+     */
+    std::vector<std::vector<size_t>> folds(const size_t &n_samples) const;
+    /**
+     * @brief Get the best result of the last search.
+     *
+     * @throw std::runtime_error If no search was done.
+     */
+    const Result &best() const;
+};
+
+#endif // NEURALSEARCH_HPP
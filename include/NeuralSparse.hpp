@@ -0,0 +1,188 @@
+/**
+ * @defgroup NeuralSparse NeuralSparse
+ * @file NeuralSparse.hpp
+ * @see src/NeuralSparse.cpp for implementation.
+ * @brief The NeuralSparse class.
+ *
+ * This file defines the compressed sparse row (CSR) matrix used as a sparse input for the models.
+ *
+ * @see Visit https://en.wikipedia.org/wiki/Sparse_matrix#Compressed_sparse_row_(CSR,_CRS_or_Yale_format) for more information.
+ *
+ * @author Manitas Bahri <https://github.com/B-Manitas>
+ * @date 2023/11
+ * @license MIT License
+ */
+
+#ifndef NEURALSPARSE_HPP
+#define NEURALSPARSE_HPP
+
+// INCLUDES
+#include <vector>
+
+#include "../lib/CMatrix/include/CMatrix.hpp"
+
+/**
+ * @brief This class stores a sparse matrix of floats in the compressed sparse row (CSR) format.
+ *
+ * Only the non-zero values are stored, so the memory and the cost of the products scale with
+ * the number of non-zero values (nnz) instead of height x width.
+ *
+ * @note The compressed sparse column (CSC) form of a matrix is the CSR form of its transpose. Use transpose() to get it.
+ */
+class NeuralSparse
+{
+private:
+    // ATTRIBUTES
+    size_t m_height = 0;
+    size_t m_width = 0;
+
+    std::vector<size_t> m_row_ptr = {0};
+    std::vector<size_t> m_col_idx = {};
+    std::vector<float> m_values = {};
+
+    // CHECKS
+    /**
+     * @brief Check if the CSR arrays describe a valid matrix of size height x width.
+     *
+     * @throw std::invalid_argument If the row pointers are not of size height + 1 or are not increasing.
+     * @throw std::invalid_argument If the column indices and the values are not of size nnz.
+     * @throw std::invalid_argument If a column index is out of range.
+     */
+    void __check_valid_csr() const;
+
+public:
+    // CONSTRUCTORS
+    /**
+     * @brief Construct an empty sparse matrix.
+     */
+    NeuralSparse();
+    /**
+     * @brief Construct a sparse matrix of size height x width containing only zeros.
+     *
+     * @param height The number of rows.
+     * @param width The number of columns.
+     */
+    NeuralSparse(const size_t &height, const size_t &width);
+    /**
+     * @brief Construct a sparse matrix from its CSR arrays.
+     *
+     * @param height The number of rows.
+     * @param width The number of columns.
+     * @param row_ptr The row pointers. The values of the row i are stored in [row_ptr[i], row_ptr[i + 1]).
+     * @param col_idx The column index of each value.
+     * @param values The non-zero values.
+     *
+     * @throw std::invalid_argument If the CSR arrays are not valid.
+     */
+    NeuralSparse(const size_t &height, const size_t &width, const std::vector<size_t> &row_ptr, const std::vector<size_t> &col_idx, const std::vector<float> &values);
+
+    // STATIC METHODS
+    /**
+     * @brief Create a sparse matrix from a dense matrix.
+     *
+     * @param M The dense matrix.
+     * @param epsilon The values whose absolute value is lower or equal to epsilon are dropped. Default: 0.
+     * @return NeuralSparse The sparse matrix.
+     */
+    static NeuralSparse from_dense(const cmatrix<float> &M, const float &epsilon = 0);
+    /**
+     * @brief Create a sparse matrix from a list of (row, column, value) triplets.
+     *
+     * @param height The number of rows.
+     * @param width The number of columns.
+     * @param rows The row index of each value.
+     * @param cols The column index of each value.
+     * @param values The values. Duplicated (row, column) entries are summed.
+     * @return NeuralSparse The sparse matrix.
+     *
+     * @throw std::invalid_argument If the three vectors are not of the same size.
+     * @throw std::invalid_argument If an index is out of range.
+     */
+    static NeuralSparse from_triplets(const size_t &height, const size_t &width, const std::vector<size_t> &rows, const std::vector<size_t> &cols, const std::vector<float> &values);
+
+    // GETTERS
+    /**
+     * @brief Get the number of rows.
+     */
+    size_t height() const;
+    /**
+     * @brief Get the number of columns.
+     */
+    size_t width() const;
+    /**
+     * @brief Get the number of non-zero values.
+     */
+    size_t nnz() const;
+    /**
+     * @brief Get the ratio of non-zero values. It is nnz / (height x width).
+     */
+    float density() const;
+    /**
+     * @brief Check if the matrix has no rows or no columns.
+     */
+    bool is_empty() const;
+    /**
+     * @brief Get the row pointers.
+     */
+    const std::vector<size_t> &row_ptr() const;
+    /**
+     * @brief Get the column index of each non-zero value.
+     */
+    const std::vector<size_t> &col_idx() const;
+    /**
+     * @brief Get the non-zero values.
+     */
+    const std::vector<float> &values() const;
+
+    // METHODS
+    /**
+     * @brief Convert the sparse matrix to a dense matrix.
+     *
+     * @return cmatrix<float> The dense matrix.
+     */
+    cmatrix<float> to_dense() const;
+    /**
+     * @brief Transpose the matrix. The result is the CSC form of the current matrix.
+     *
+     * @return NeuralSparse The transposed matrix.
+     */
+    NeuralSparse transpose() const;
+
+    // PRODUCTS
+    /**
+     * @brief Compute the product S * B, where S is the current matrix (SpMM).
+     * The rows of the result are computed in parallel.
+     *
+     * @param B The dense matrix. Must be of size width() x p, or (width() + 1) x p if bias is true.
+     * @param bias If true, S is considered augmented with a trailing column of ones. Default: false.
+     * @return cmatrix<float> The product of size height() x p.
+     *
+     * @throw std::invalid_argument If the height of B is not valid.
+     */
+    cmatrix<float> matmul(const cmatrix<float> &B, const bool &bias = false) const;
+    /**
+     * @brief Compute the product A * S, where S is the current matrix.
+     * The rows of the result are computed in parallel.
+     *
+     * @param A The dense matrix. Must be of size p x height(), or p x (height() + 1) if bias is true.
+     * @param bias If true, S is considered augmented with a trailing row of ones. Default: false.
+     * @return cmatrix<float> The product of size p x width().
+     *
+     * @throw std::invalid_argument If the width of A is not valid.
+     */
+    cmatrix<float> rmatmul(const cmatrix<float> &A, const bool &bias = false) const;
+    /**
+     * @brief Compute out += alpha * A * S^T, where S is the current matrix.
+     * Only the columns of out matching a non-empty row of S are updated. The rows of S are processed in parallel.
+     *
+     * @param A The dense matrix of size p x width().
+     * @param out The dense matrix to update. Must be of size p x height(), or p x (height() + 1) if bias is true.
+     * @param alpha The scaling factor. Default: 1.
+     * @param bias If true, S is considered augmented with a trailing row of ones. Default: false.
+     *
+     * @throw std::invalid_argument If the sizes of A or out are not valid.
+     */
+    void rmatmul_transpose_add(const cmatrix<float> &A, cmatrix<float> &out, const float &alpha = 1, const bool &bias = false) const;
+};
+
+#endif // NEURALSPARSE_HPP
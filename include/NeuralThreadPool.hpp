@@ -0,0 +1,109 @@
+/**
+ * @defgroup NeuralThreadPool NeuralThreadPool
+ * @file NeuralThreadPool.hpp
+ * @see src/NeuralThreadPool.cpp for implementation.
+ * @brief The NeuralThreadPool class.
+ *
+ * This file defines the work-stealing thread pool used to run independent trainings concurrently.
+ *
+ * @see Visit https://en.wikipedia.org/wiki/Work_stealing for more information.
+ *
+ * @author Manitas Bahri <https://github.com/B-Manitas>
+ * @date 2023/11
+ * @license MIT License
+ */
+
+#ifndef NEURALTHREADPOOL_HPP
+#define NEURALTHREADPOOL_HPP
+
+// INCLUDES
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief This class is a work-stealing thread pool.
+ *
+ * Each worker owns a queue. A worker takes its tasks from the back of its own queue and,
+ * when it is empty, steals the oldest task from the front of another queue.
+ */
+class NeuralThreadPool
+{
+private:
+    // ATTRIBUTES
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::thread> m_workers = {};
+    std::vector<Queue *> m_queues = {};
+
+    std::mutex m_mutex;
+    std::condition_variable m_cv_task;
+    std::condition_variable m_cv_done;
+
+    std::atomic<size_t> m_next_queue;
+    size_t m_queued = 0;
+    size_t m_pending = 0;
+    bool m_stop = false;
+    std::exception_ptr m_error = nullptr;
+
+    // METHODS
+    /**
+     * @brief The loop executed by each worker.
+     *
+     * @param id The index of the worker.
+     */
+    void __worker_loop(const size_t &id);
+    /**
+     * @brief Pop a task from the queue of the worker, or steal one from another queue.
+     *
+     * @param id The index of the worker.
+     * @param task The task found.
+     * @return true if a task was found.
+     */
+    bool __pop_task(const size_t &id, std::function<void()> &task);
+
+public:
+    // CONSTRUCTORS
+    /**
+     * @brief Construct a new thread pool.
+     *
+     * @param n_threads The number of workers. Set to 0 to use the number of hardware threads. Default: 0.
+     */
+    NeuralThreadPool(const size_t &n_threads = 0);
+    /**
+     * @brief Wait for the pending tasks, then stop the workers.
+     */
+    ~NeuralThreadPool();
+
+    NeuralThreadPool(const NeuralThreadPool &) = delete;
+    NeuralThreadPool &operator=(const NeuralThreadPool &) = delete;
+
+    // METHODS
+    /**
+     * @brief Get the number of workers.
+     */
+    size_t size() const;
+    /**
+     * @brief Submit a task. The tasks are distributed over the queues of the workers in a round-robin way.
+     *
+     * @param task The task to execute.
+     */
+    void submit(const std::function<void()> &task);
+    /**
+     * @brief Wait until all the submitted tasks are done.
+     *
+     * @throw The first exception thrown by a task, if any.
+     */
+    void wait();
+};
+
+#endif // NEURALTHREADPOOL_HPP
@@ -0,0 +1,240 @@
+/**
+ * @defgroup NeuralTuner NeuralTuner
+ * @file NeuralTuner.hpp
+ * @see src/NeuralTuner.cpp for implementation.
+ * @brief The NeuralTuner class.
+ *
+ * This file defines the autotuning of the kernels of the layers, with a tuning cache persisted per machine.
+ *
+ * @author Manitas Bahri <https://github.com/B-Manitas>
+ * @date 2023/11
+ * @license MIT License
+ */
+
+#ifndef NEURALTUNER_HPP
+#define NEURALTUNER_HPP
+
+// INCLUDES
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "../lib/CMatrix/include/CMatrix.hpp"
+
+class NeuralLayers;
+
+/**
+ * @brief This class benchmarks the configurations of the kernels for the shapes of a model, and keeps the fastest ones.
+ *
+ * The tuned parameters are:
+ * - the block size and the number of threads of each matrix product of the layers (GEMM), for its exact shape.
+ *   A product with one thread runs serially: the number of threads is the parallel threshold of the shape.
+ * - the batch size of the inference of a model, used by NeuralScorer when its batch size is 0.
+ * - the crossover of the block sparse format of each dense layer: the ratio of blocks of zeros from which its block
+ *   sparse product is faster than its dense product. It is used by NeuralLayers::compress.
+ *
+ * The winners are stored in a text cache, one entry per line, keyed by the machine (the CPU model and the number
+ * of threads) and by the shape. Several machines may share the same cache. The cache of the default path is loaded
+ * at the first product, so the later runs use the tuned configurations without any tuning cost. The shapes which
+ * are not in the cache use the default configuration of the kernels.
+ *
+ * The format of an entry is:
+ * - GEMM kernel parallel M N K block threads machine
+ * - BATCH n_features signature batch_size machine
+ * - SPARSE units n_features block_height block_width sparsity machine
+ *
+ * Example:
+ * @code
+ * NeuralLayers model({32, 32});
+ * model.fit(X, y, 1, .1, 0);
+ * // Benchmark the products of a training epoch on X, then save the cache
+ * NeuralTuner().tune(model, X);
+ * model.fit(X, y, 1000, .1);
+ * @endcode
+ *
+ * @note The tuning must not run at the same time as a training, since it changes the configurations of the products.
+ */
+class NeuralTuner
+{
+public:
+    // STRUCTURES
+    /**
+     * @brief The matrix products of the layers. See NeuralLayer::__gemm_nn, __gemm_nt and __gemm_tn.
+     */
+    enum Kernel
+    {
+        NN,
+        NT,
+        TN
+    };
+
+    /**
+     * @brief The configuration of a product.
+     */
+    struct Config
+    {
+        /**
+         * @brief The block size. If 0, it is the default block size of the kernel.
+         */
+        size_t block = 0;
+        /**
+         * @brief The number of threads of a parallel product. If 0, it is the maximum number of threads.
+         */
+        size_t threads = 0;
+    };
+
+    /**
+     * @brief The report of a tuning.
+     */
+    struct Report
+    {
+        size_t n_shapes = 0;
+        size_t n_tuned = 0;
+        size_t batch_size = 0;
+        double seconds = 0;
+    };
+
+private:
+    // ATTRIBUTES
+    std::string m_path = "";
+    size_t m_repeats = 3;
+    std::vector<size_t> m_blocks = {16, 32, 64, 128, 256};
+    std::vector<size_t> m_batch_sizes = {64, 256, 1024, 4096, 16384};
+
+    // METHODS
+    /**
+     * @brief Get the fastest configuration of a product. The product runs with each candidate on random matrices.
+     *
+     * @param kernel The product.
+     * @param parallel If false, only the block size is tuned.
+     * @return Config The fastest configuration.
+     */
+    Config __tune_gemm(const Kernel &kernel, const bool &parallel, const size_t &M, const size_t &N, const size_t &K) const;
+    /**
+     * @brief Get the batch size with the most samples per second for the inference of a model.
+     *
+     * @param model The trained model. Its graph is planned for each candidate.
+     * @param X The samples, repeated to fill the largest batches. Each column is a sample.
+     */
+    size_t __tune_batch_size(NeuralLayers &model, const cmatrix<float> &X) const;
+    /**
+     * @brief Get the crossover of the block sparse format of a dense layer. The dense product and the block sparse
+     * product of random weights are timed, and the sparsity is bisected until the block sparse product is the fastest.
+     *
+     * @param units The number of units of the layer.
+     * @param K The number of features of the layer.
+     * @return float The smallest ratio of blocks of zeros for which the block sparse product is the fastest, to 1/64.
+     */
+    float __tune_crossover(const size_t &units, const size_t &K, const size_t &block_height, const size_t &block_width) const;
+
+    /**
+     * @brief Get the signature of the layers of a model: the hash of its input shape and of the configuration of its layers.
+     */
+    static uint64_t __signature(const NeuralLayers &model);
+    /**
+     * @brief Load the default cache, once. A missing or invalid cache is ignored.
+     */
+    static void __load_default();
+
+public:
+    // CONSTRUCTORS
+    /**
+     * @brief Construct a new Neural Tuner object.
+     *
+     * @param path The path of the cache. Default: default_path().
+     * @param repeats The number of runs of each candidate. The fastest run is kept. Default: 3.
+     *
+     * @throw std::invalid_argument If repeats is 0.
+     */
+    NeuralTuner(const std::string &path = default_path(), const size_t &repeats = 3);
+
+    // METHODS
+    /**
+     * @brief Tune the products of a training epoch of a model on X, the batch size of its inference and the crossover of the
+     * block sparse format of its dense layers, with the blocks of its pruner, then save the cache.
+     * The products are recorded during one forward and backward propagation of X, so they have the shapes of the training.
+     *
+     * @param model The trained model. Its gradients are overwritten.
+     * @param X The input matrix. Each column is a sample.
+     * @param force If false, only the shapes which are not in the cache are tuned. Default: false.
+     * @return Report The report of the tuning.
+     *
+     * @throw std::invalid_argument If the model is not trained, or if X does not have its number of features.
+     * @throw std::runtime_error If the cache cannot be written.
+     */
+    Report tune(NeuralLayers &model, const cmatrix<float> &X, const bool &force = false);
+
+    // STATIC METHODS
+    /**
+     * @brief Get the name of the machine: the CPU model and its number of threads, $OMP_NUM_THREADS or the number of
+     * processors. It does not depend on the number of threads of the calling thread.
+     */
+    static std::string machine();
+    /**
+     * @brief Get the default path of the cache: $NEURALCPP_TUNING_CACHE, else $HOME/.neuralcpp_tuning.
+     */
+    static std::string default_path();
+    /**
+     * @brief Get the configuration of a product. This is called by each product, so it never locks while no tuning runs.
+     *
+     * @param kernel The product.
+     * @param parallel If true, the product may use several threads.
+     * @return Config The tuned configuration, or the default configuration if the shape is not tuned.
+     */
+    static Config config(const Kernel &kernel, const bool &parallel, const size_t &M, const size_t &N, const size_t &K);
+    /**
+     * @brief Get the tuned batch size of the inference of a model.
+     *
+     * @param model The model.
+     * @param fallback The batch size if the model is not tuned.
+     */
+    static size_t batch_size(const NeuralLayers &model, const size_t &fallback);
+    /**
+     * @brief Get the crossover of the block sparse format of a dense layer: the ratio of blocks of zeros from which
+     * its block sparse product is faster than its dense product. A shape which is not in the cache is measured once,
+     * then kept with the tuned configurations, so it is written by the next save.
+     *
+     * @param units The number of units of the layer.
+     * @param K The number of features of the layer.
+     * @param block_height The number of units of a block, in [1, 16].
+     * @param block_width The number of features of a block, in [1, 16].
+     * @return float The crossover, in ]0, 1].
+     *
+     * @throw std::invalid_argument If a size of the blocks is not valid.
+     */
+    static float crossover(const size_t &units, const size_t &K, const size_t &block_height, const size_t &block_width);
+    /**
+     * @brief Add the entries of this machine of a cache to the tuned configurations.
+     *
+     * @param path The path of the cache.
+     * @return true if the cache exists.
+     *
+     * @throw std::runtime_error If an entry is not valid.
+     */
+    static bool load(const std::string &path);
+    /**
+     * @brief Write the tuned configurations of this machine in a cache. The entries of the other machines are kept.
+     *
+     * @param path The path of the cache.
+     *
+     * @throw std::runtime_error If the cache cannot be written.
+     */
+    static void save(const std::string &path);
+    /**
+     * @brief Forget the tuned configurations. The products use their default configuration.
+     */
+    static void clear();
+
+    /**
+     * @brief Get if NeuralLayers::fit tunes the shapes of the model which are not in the cache, before the training.
+     * It is true if the environment variable NEURALCPP_AUTOTUNE is set to 1, unless it is set by set_automatic.
+     */
+    static bool automatic();
+    /**
+     * @brief Set if NeuralLayers::fit tunes the shapes of the model which are not in the cache.
+     */
+    static void set_automatic(const bool &automatic);
+};
+
+#endif // NEURALTUNER_HPP
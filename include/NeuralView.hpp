@@ -0,0 +1,182 @@
+/**
+ * @defgroup NeuralView NeuralView
+ * @file NeuralView.hpp
+ * @see src/NeuralView.cpp for implementation.
+ * @brief The NeuralView class.
+ *
+ * This file defines the non-owning strided view of a matrix of floats used by the kernels of NeuralCPP.
+ *
+ * @author Manitas Bahri <https://github.com/B-Manitas>
+ * @date 2023/11
+ * @license MIT License
+ */
+
+#ifndef NEURALVIEW_HPP
+#define NEURALVIEW_HPP
+
+// INCLUDES
+#include <cstddef>
+
+#include "../lib/CMatrix/include/CMatrix.hpp"
+
+/**
+ * @brief This class is a non-owning view of a block of a matrix of floats, possibly transposed.
+ *
+ * The view reads either a buffer stored row by row, with a distance of ld values between two rows, or the rows of a cmatrix.
+ * Taking rows, columns or the transpose of a view only changes its offsets, its shape and its transposed flag: no value is copied.
+ *
+ * @warning The view does not own the values: the viewed matrix must outlive the view and must not be resized.
+ *
+ * Example:
+ * @code
+ * const NeuralView &batch = NeuralView(X).rows(0, 32);
+ * const cmatrix<float> &G = batch.transpose().matmul(NeuralView(R));
+ * @endcode
+ */
+class NeuralView
+{
+private:
+    // ATTRIBUTES
+    const float *m_data = nullptr;
+    const cmatrix<float> *m_matrix = nullptr;
+    size_t m_ld = 0;
+
+    // The block of the storage read by the view, before the transposition
+    size_t m_row = 0;
+    size_t m_column = 0;
+    size_t m_height = 0;
+    size_t m_width = 0;
+    bool m_transposed = false;
+
+    // METHODS
+    /**
+     * @brief Get the first value of a row of the block, in the storage order.
+     *
+     * @param r The row of the block, before the transposition.
+     */
+    const float *__row(const size_t &r) const { return (m_matrix ? &m_matrix->cell(m_row + r, 0) : m_data + (m_row + r) * m_ld) + m_column; }
+    /**
+     * @brief Get the view of a sub-block of the storage block.
+     *
+     * @param row The first row of the sub-block, before the transposition.
+     * @param column The first column of the sub-block, before the transposition.
+     * @param height The number of rows of the sub-block, before the transposition.
+     * @param width The number of columns of the sub-block, before the transposition.
+     */
+    NeuralView __block(const size_t &row, const size_t &column, const size_t &height, const size_t &width) const;
+
+    // CHECKS
+    /**
+     * @brief Check if the range [begin, end[ is in [0, size].
+     *
+     * @throw std::invalid_argument If the range is empty or out of range.
+     */
+    static void __check_valid_range(const size_t &begin, const size_t &end, const size_t &size);
+
+public:
+    // CONSTRUCTORS
+    /**
+     * @brief Construct an empty view.
+     */
+    NeuralView();
+    /**
+     * @brief Construct a view of a whole matrix.
+     *
+     * @param X The viewed matrix.
+     */
+    explicit NeuralView(const cmatrix<float> &X);
+    /**
+     * @brief Construct a view of a buffer stored row by row.
+     *
+     * @param data The first value of the buffer.
+     * @param height The number of rows.
+     * @param width The number of columns.
+     * @param ld The distance between two rows. If 0, the rows are contiguous (ld = width). Default: 0.
+     *
+     * @throw std::invalid_argument If ld is lower than the width.
+     */
+    NeuralView(const float *data, const size_t &height, const size_t &width, const size_t &ld = 0);
+
+    // GETTERS
+    size_t height() const { return m_transposed ? m_width : m_height; }
+    size_t width() const { return m_transposed ? m_height : m_width; }
+    /**
+     * @brief Check if the view reads its storage transposed.
+     */
+    bool is_transposed() const { return m_transposed; }
+    /**
+     * @brief Check if the view is empty.
+     */
+    bool is_empty() const { return m_height == 0 || m_width == 0; }
+    /**
+     * @brief Get a value of the view.
+     *
+     * @param i The row.
+     * @param j The column.
+     */
+    float cell(const size_t &i, const size_t &j) const { return m_transposed ? __row(j)[i] : __row(i)[j]; }
+    /**
+     * @brief Get the contiguous values of a row. The view must not be transposed.
+     *
+     * @param i The row.
+     */
+    const float *row_data(const size_t &i) const { return __row(i); }
+
+    // METHODS
+    /**
+     * @brief Get the view of a row.
+     *
+     * @param i The row.
+     *
+     * @throw std::invalid_argument If the row is out of range.
+     */
+    NeuralView rows(const size_t &i) const;
+    /**
+     * @brief Get the view of the rows [begin, end[.
+     *
+     * @throw std::invalid_argument If the range is empty or out of range.
+     */
+    NeuralView rows(const size_t &begin, const size_t &end) const;
+    /**
+     * @brief Get the view of a column.
+     *
+     * @param j The column.
+     *
+     * @throw std::invalid_argument If the column is out of range.
+     */
+    NeuralView columns(const size_t &j) const;
+    /**
+     * @brief Get the view of the columns [begin, end[, such as a mini-batch of samples stored in columns.
+     *
+     * @throw std::invalid_argument If the range is empty or out of range.
+     */
+    NeuralView columns(const size_t &begin, const size_t &end) const;
+    /**
+     * @brief Get the transposed view. The values are not moved.
+     */
+    NeuralView transpose() const;
+
+    /**
+     * @brief Copy the values of the view in a new matrix.
+     */
+    cmatrix<float> to_cmatrix() const;
+    /**
+     * @brief Compute the product of the view with another view. The loops follow the storage order of both views.
+     *
+     * @param B The right operand, of height width().
+     * @return cmatrix<float> The product, of size height() x B.width().
+     *
+     * @throw std::invalid_argument If the sizes of the views do not match.
+     */
+    cmatrix<float> matmul(const NeuralView &B) const;
+    /**
+     * @brief Compute the product of the view with a vector: out = V * x + bias.
+     *
+     * @param x The vector, of size width().
+     * @param out The result, of size height(). It is overwritten.
+     * @param bias The value added to each row. Default: 0.
+     */
+    void matvec(const float *x, float *out, const float &bias = 0) const;
+};
+
+#endif // NEURALVIEW_HPP
@@ -28,17 +28,77 @@ cmatrix<float> NeuralActivation::relu(const cmatrix<float> &Z)
 
 cmatrix<float> NeuralActivation::dW_relu(const cmatrix<float> &X, const cmatrix<float> &y_true, const cmatrix<float> &weights)
 {
+    return dW_relu(NeuralView(X), y_true, weights);
+}
+
+cmatrix<float> NeuralActivation::dW_relu(const NeuralView &X, const cmatrix<float> &y_true, const cmatrix<float> &weights, const bool &bias)
+{
+    // Check if the weights match the samples
+    if (weights.height() != X.width() + bias || weights.width() != 1)
+        throw std::invalid_argument("The weights matrix must be of size " + std::to_string(X.width() + bias) + "x1");
+
     // Compute the predictions
-    const cmatrix<float> &y_pred = X.matmul(weights) > 0;
-    
+    const size_t n_features = X.width();
+    std::vector<float> w(weights.height()), scores(X.height());
+    for (size_t k = 0; k < w.size(); k++)
+        w[k] = weights.cell(k, 0);
+
+    X.matvec(w.data(), scores.data(), bias ? w.back() : 0);
+
+    // Update the weights of the wrong predictions, reading the samples in place
+    for (size_t i = 0; i < X.height(); i++)
+    {
+        const float y = y_true.cell(i, 0);
+        if ((scores[i] > 0) * y > 0)
+            continue;
+
+        if (X.is_transposed())
+            for (size_t k = 0; k < n_features; k++)
+                w[k] += y * X.cell(i, k);
+        else
+        {
+            const float *x = X.row_data(i);
+            for (size_t k = 0; k < n_features; k++)
+                w[k] += y * x[k];
+        }
+
+        if (bias)
+            w.back() += y;
+    }
+
+    cmatrix<float> dW(w.size(), 1);
+    for (size_t k = 0; k < w.size(); k++)
+        dW.cell(k, 0) = w[k];
+
+    return dW;
+}
+
+cmatrix<float> NeuralActivation::dW_relu(const NeuralSparse &X, const cmatrix<float> &y_true, const cmatrix<float> &weights)
+{
+    // Compute the predictions (SpMV with the bias)
+    const cmatrix<float> &y_pred = X.matmul(weights, true) > 0;
+
     // Get the wrong predictions
     const cmatrix<float> &filter_wrong = (y_pred * y_true) <= 0;
-    
-    // Update the weights
+
+    // Update the weights of the non-zero features of each wrong prediction
+    const std::vector<size_t> &row_ptr = X.row_ptr();
+    const std::vector<size_t> &col_idx = X.col_idx();
+    const std::vector<float> &values = X.values();
+
     cmatrix<float> w = weights;
     for (size_t i = 0; i < X.height(); i++)
+    {
         if (filter_wrong.cell(i, 0) == 1)
-            w += (y_true.cell(i, 0) * X.rows(i)).transpose();
+        {
+            const float y = y_true.cell(i, 0);
+
+            for (size_t k = row_ptr[i]; k < row_ptr[i + 1]; k++)
+                w.cell(col_idx[k], 0) += y * values[k];
+
+            w.cell(X.width(), 0) += y;
+        }
+    }
 
     return w;
-}
\ No newline at end of file
+}
@@ -0,0 +1,246 @@
+/**
+ * @file NeuralAllocator.cpp
+ * @see include/NeuralAllocator.hpp for definition.
+ * @brief The NeuralMemory class.
+ *
+ * This file contains the implementation of the NeuralMemory class.
+ *
+ * @author Manitas Bahri <https://github.com/B-Manitas>
+ * @date 2023/11
+ * @license MIT License
+ */
+
+// INCLUDES
+#include "../include/NeuralAllocator.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+const size_t NeuralMemory::ALIGNMENT;
+const size_t NeuralMemory::HUGE_PAGE_SIZE;
+
+// ==================================================
+// PRIVATE METHODS
+
+void *NeuralMemory::__map(const size_t &bytes)
+{
+    const int huge_pages = m_huge_pages.load();
+    const size_t page = sysconf(_SC_PAGESIZE);
+    Mapping mapping = {nullptr, 0, false};
+
+#ifdef MAP_HUGETLB
+    // Map the reserved huge pages
+    if (huge_pages == EXPLICIT)
+    {
+        const size_t size = (bytes + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+        void *base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+
+        if (base != MAP_FAILED)
+            mapping = {base, size, true};
+        else
+            m_n_fallbacks++;
+    }
+#endif
+
+    if (!mapping.base)
+    {
+        // Over-allocate to align the block on a huge page, then unmap the unused head and tail
+        const size_t size = (bytes + page - 1) / page * page;
+        const size_t padding = huge_pages == NONE ? 0 : HUGE_PAGE_SIZE;
+        char *base = static_cast<char *>(mmap(nullptr, size + padding, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+
+        if ((void *)base == MAP_FAILED)
+            return nullptr;
+
+        char *block = base;
+        if (padding)
+        {
+            block = reinterpret_cast<char *>((reinterpret_cast<uintptr_t>(base) + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE);
+
+            if (block > base)
+                munmap(base, block - base);
+            if (base + padding > block)
+                munmap(block + size, base + padding - block);
+        }
+
+        mapping = {block, size, false};
+
+#ifdef MADV_HUGEPAGE
+        // The kernel backs the block with huge pages if they are enabled, the advice is ignored otherwise
+        if (huge_pages != NONE)
+            mapping.huge = madvise(block, size, MADV_HUGEPAGE) == 0;
+#endif
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_mappings[mapping.base] = mapping;
+    m_mapped_bytes += mapping.bytes;
+    if (mapping.huge)
+        m_huge_page_bytes += mapping.bytes;
+
+    return mapping.base;
+}
+
+void NeuralMemory::__first_touch(void *block, const size_t &bytes)
+{
+    const size_t page = sysconf(_SC_PAGESIZE);
+    const size_t n_pages = (bytes + page - 1) / page;
+    char *values = static_cast<char *>(block);
+
+    // The same static schedule as the kernels, which split the samples of a buffer in contiguous ranges
+#pragma omp parallel for schedule(static)
+    for (size_t p = 0; p < n_pages; p++)
+        values[p * page] = 0;
+}
+
+// ==================================================
+// CONSTRUCTORS
+
+NeuralMemory::NeuralMemory(const std::string &name, const HugePages &huge_pages, const bool &first_touch, const size_t &min_mapped_bytes)
+    : m_name(name), m_huge_pages(huge_pages), m_first_touch(first_touch), m_min_mapped_bytes(min_mapped_bytes),
+      m_n_allocations(0), m_n_deallocations(0), m_bytes_in_use(0), m_peak_bytes(0), m_mapped_bytes(0), m_huge_page_bytes(0), m_n_fallbacks(0) {}
+
+// ==================================================
+// STATIC METHODS
+
+NeuralMemory &NeuralMemory::parameters()
+{
+    static NeuralMemory pool("parameters");
+    return pool;
+}
+
+NeuralMemory &NeuralMemory::activations()
+{
+    static NeuralMemory pool("activations");
+    return pool;
+}
+
+NeuralMemory &NeuralMemory::workspace()
+{
+    static NeuralMemory pool("workspace");
+    return pool;
+}
+
+// ==================================================
+// GETTERS
+
+const std::string &NeuralMemory::name() const
+{
+    return m_name;
+}
+
+NeuralMemory::HugePages NeuralMemory::huge_pages() const
+{
+    return (HugePages)m_huge_pages.load();
+}
+
+bool NeuralMemory::first_touch() const
+{
+    return m_first_touch;
+}
+
+size_t NeuralMemory::min_mapped_bytes() const
+{
+    return m_min_mapped_bytes;
+}
+
+NeuralMemory::Stats NeuralMemory::stats() const
+{
+    Stats stats;
+    stats.n_allocations = m_n_allocations;
+    stats.n_deallocations = m_n_deallocations;
+    stats.bytes_in_use = m_bytes_in_use;
+    stats.peak_bytes = m_peak_bytes;
+    stats.mapped_bytes = m_mapped_bytes;
+    stats.huge_page_bytes = m_huge_page_bytes;
+    stats.n_fallbacks = m_n_fallbacks;
+
+    return stats;
+}
+
+// ==================================================
+// SETTERS
+
+void NeuralMemory::set_huge_pages(const HugePages &huge_pages)
+{
+    m_huge_pages = huge_pages;
+}
+
+void NeuralMemory::set_first_touch(const bool &first_touch)
+{
+    m_first_touch = first_touch;
+}
+
+void NeuralMemory::set_min_mapped_bytes(const size_t &min_mapped_bytes)
+{
+    m_min_mapped_bytes = min_mapped_bytes;
+}
+
+// ==================================================
+// METHODS
+
+void *NeuralMemory::allocate(const size_t &bytes, const bool &first_touch)
+{
+    void *block = nullptr;
+
+    if (bytes >= m_min_mapped_bytes)
+    {
+        block = __map(bytes);
+
+        if (block && first_touch && m_first_touch)
+            __first_touch(block, bytes);
+    }
+
+    // The small blocks, and the blocks which cannot be mapped, come from the heap
+    if (!block && posix_memalign(&block, ALIGNMENT, bytes ? bytes : ALIGNMENT) != 0)
+        throw std::bad_alloc();
+
+    m_n_allocations++;
+    const size_t in_use = m_bytes_in_use += bytes;
+
+    size_t peak = m_peak_bytes;
+    while (in_use > peak && !m_peak_bytes.compare_exchange_weak(peak, in_use))
+        ;
+
+    return block;
+}
+
+void NeuralMemory::deallocate(void *block, const size_t &bytes)
+{
+    if (!block)
+        return;
+
+    m_n_deallocations++;
+    m_bytes_in_use -= bytes;
+
+    // The minimum size of the mapped blocks may have changed since the allocation: look for the block in the mappings
+    if (m_mapped_bytes.load() > 0)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        const std::map<void *, Mapping>::iterator &it = m_mappings.find(block);
+
+        if (it != m_mappings.end())
+        {
+            const Mapping mapping = it->second;
+            m_mappings.erase(it);
+            m_mapped_bytes -= mapping.bytes;
+            if (mapping.huge)
+                m_huge_page_bytes -= mapping.bytes;
+
+            lock.unlock();
+            munmap(mapping.base, mapping.bytes);
+            return;
+        }
+    }
+
+    free(block);
+}
+
+void NeuralMemory::reset_peak()
+{
+    m_peak_bytes = m_bytes_in_use.load();
+}
@@ -0,0 +1,250 @@
+/**
+ * @file NeuralBlockSparse.cpp
+ * @see include/NeuralBlockSparse.hpp for definition.
+ * @brief The NeuralBlockSparse class.
+ *
+ * This file contains the implementation of the NeuralBlockSparse class.
+ *
+ * @author Manitas Bahri <https://github.com/B-Manitas>
+ * @date 2023/11
+ * @license MIT License
+ */
+
+// INCLUDES
+#include "../include/NeuralBlockSparse.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+// ==================================================
+// CHECKS
+
+void NeuralBlockSparse::__check_valid_block(const size_t &block_height, const size_t &block_width)
+{
+    // The accumulators of a block row are kept in registers
+    if (block_height == 0 || block_width == 0 || block_height > 16 || block_width > 16)
+        throw std::invalid_argument("The size of the blocks must be in [1, 16]");
+}
+
+// ==================================================
+// CONSTRUCTORS
+
+NeuralBlockSparse::NeuralBlockSparse() {}
+
+NeuralBlockSparse NeuralBlockSparse::from_dense(const float *M, const size_t &height, const size_t &width, const size_t &ld, const size_t &block_height, const size_t &block_width)
+{
+    __check_valid_block(block_height, block_width);
+
+    NeuralBlockSparse S;
+    S.m_height = height;
+    S.m_width = width;
+    S.m_block_height = block_height;
+    S.m_block_width = block_width;
+
+    const size_t n_block_rows = (height + block_height - 1) / block_height;
+    const size_t n_block_cols = (width + block_width - 1) / block_width;
+    S.m_block_ptr.assign(n_block_rows + 1, 0);
+
+    for (size_t i = 0; i < n_block_rows; i++)
+    {
+        const size_t rows = std::min(block_height, height - i * block_height);
+
+        for (size_t j = 0; j < n_block_cols; j++)
+        {
+            const size_t cols = std::min(block_width, width - j * block_width);
+            const float *block = M + i * block_height * ld + j * block_width;
+
+            // Keep the block if it contains a non-zero value
+            bool is_zero = true;
+            for (size_t r = 0; r < rows && is_zero; r++)
+                for (size_t c = 0; c < cols && is_zero; c++)
+                    is_zero = block[r * ld + c] == 0;
+
+            if (is_zero)
+                continue;
+
+            S.m_block_col.push_back(j);
+            for (size_t r = 0; r < block_height; r++)
+                for (size_t c = 0; c < block_width; c++)
+                    S.m_values.push_back(r < rows && c < cols ? block[r * ld + c] : 0);
+        }
+
+        S.m_block_ptr[i + 1] = S.m_block_col.size();
+    }
+
+    return S;
+}
+
+// ==================================================
+// GETTERS
+
+size_t NeuralBlockSparse::height() const
+{
+    return m_height;
+}
+
+size_t NeuralBlockSparse::width() const
+{
+    return m_width;
+}
+
+size_t NeuralBlockSparse::block_height() const
+{
+    return m_block_height;
+}
+
+size_t NeuralBlockSparse::block_width() const
+{
+    return m_block_width;
+}
+
+size_t NeuralBlockSparse::n_blocks() const
+{
+    return m_block_col.size();
+}
+
+float NeuralBlockSparse::density() const
+{
+    const size_t n_block_rows = (m_height + m_block_height - 1) / m_block_height;
+    const size_t n_block_cols = (m_width + m_block_width - 1) / m_block_width;
+
+    return is_empty() ? 0 : (float)n_blocks() / (n_block_rows * n_block_cols);
+}
+
+bool NeuralBlockSparse::is_empty() const
+{
+    return m_height == 0 || m_width == 0;
+}
+
+// ==================================================
+// METHODS
+
+void NeuralBlockSparse::to_dense(float *M, const size_t &ld) const
+{
+    const size_t block_size = m_block_height * m_block_width;
+
+    for (size_t r = 0; r < m_height; r++)
+        std::fill(M + r * ld, M + r * ld + m_width, 0.f);
+
+    for (size_t i = 0; i + 1 < m_block_ptr.size(); i++)
+    {
+        const size_t rows = std::min(m_block_height, m_height - i * m_block_height);
+
+        for (size_t k = m_block_ptr[i]; k < m_block_ptr[i + 1]; k++)
+        {
+            const size_t col = m_block_col[k] * m_block_width;
+            const size_t cols = std::min(m_block_width, m_width - col);
+            const float *block = m_values.data() + k * block_size;
+
+            for (size_t r = 0; r < rows; r++)
+                for (size_t c = 0; c < cols; c++)
+                    M[(i * m_block_height + r) * ld + col + c] = block[r * m_block_width + c];
+        }
+    }
+}
+
+void NeuralBlockSparse::matmul_transpose(const float *X, const size_t &batch, float *out, const bool &parallel) const
+{
+    const size_t n_block_rows = m_block_ptr.size() - 1;
+    const size_t block_size = m_block_height * m_block_width;
+
+    // Each row of X is multiplied by every block row: the row of X stays in the cache
+#pragma omp parallel for schedule(static) if (parallel)
+    for (size_t s = 0; s < batch; s++)
+    {
+        const float *x = X + s * m_width;
+        float *y = out + s * m_height;
+
+        for (size_t i = 0; i < n_block_rows; i++)
+        {
+            float acc[16] = {0};
+
+            for (size_t k = m_block_ptr[i]; k < m_block_ptr[i + 1]; k++)
+            {
+                const size_t col = m_block_col[k] * m_block_width;
+                const size_t cols = std::min(m_block_width, m_width - col);
+                const float *block = m_values.data() + k * block_size;
+                const float *xk = x + col;
+
+                for (size_t r = 0; r < m_block_height; r++)
+                {
+                    const float *b = block + r * m_block_width;
+                    float sum = 0;
+
+#pragma omp simd reduction(+ : sum)
+                    for (size_t c = 0; c < cols; c++)
+                        sum += b[c] * xk[c];
+
+                    acc[r] += sum;
+                }
+            }
+
+            const size_t rows = std::min(m_block_height, m_height - i * m_block_height);
+            std::copy(acc, acc + rows, y + i * m_block_height);
+        }
+    }
+}
+
+void NeuralBlockSparse::save(std::ostream &stream) const
+{
+    stream << "NeuralBlockSparse " << m_height << " " << m_width << " " << m_block_height << " " << m_block_width << " " << n_blocks() << "\n";
+
+    // The block pointers, the block columns, then the values
+    for (size_t i = 0; i < m_block_ptr.size(); i++)
+        stream << (i ? " " : "") << m_block_ptr[i];
+    stream << "\n";
+
+    for (size_t k = 0; k < m_block_col.size(); k++)
+        stream << (k ? " " : "") << m_block_col[k];
+    stream << "\n";
+
+    for (size_t k = 0; k < m_values.size(); k++)
+        stream << (k ? " " : "") << m_values[k];
+    stream << "\n";
+}
+
+void NeuralBlockSparse::load(std::istream &stream)
+{
+    std::string name;
+    NeuralBlockSparse S;
+    size_t n_blocks = 0;
+
+    if (!(stream >> name >> S.m_height >> S.m_width >> S.m_block_height >> S.m_block_width >> n_blocks) || name != "NeuralBlockSparse")
+        throw std::runtime_error("The stream does not contain a valid block sparse matrix");
+
+    try
+    {
+        __check_valid_block(S.m_block_height, S.m_block_width);
+    }
+    catch (const std::invalid_argument &e)
+    {
+        throw std::runtime_error("The stream does not contain a valid block sparse matrix: " + std::string(e.what()));
+    }
+
+    const size_t n_block_rows = (S.m_height + S.m_block_height - 1) / S.m_block_height;
+    const size_t n_block_cols = (S.m_width + S.m_block_width - 1) / S.m_block_width;
+
+    S.m_block_ptr.assign(n_block_rows + 1, 0);
+    S.m_block_col.assign(n_blocks, 0);
+    S.m_values.assign(n_blocks * S.m_block_height * S.m_block_width, 0);
+
+    for (size_t &ptr : S.m_block_ptr)
+        stream >> ptr;
+    for (size_t &col : S.m_block_col)
+        stream >> col;
+    for (float &value : S.m_values)
+        stream >> value;
+
+    // Check if the pointers are increasing and the columns in range
+    bool valid = (bool)stream && S.m_block_ptr.front() == 0 && S.m_block_ptr.back() == n_blocks;
+    for (size_t i = 0; i < n_block_rows && valid; i++)
+        valid = S.m_block_ptr[i] <= S.m_block_ptr[i + 1];
+    for (size_t k = 0; k < n_blocks && valid; k++)
+        valid = S.m_block_col[k] < n_block_cols;
+
+    if (!valid)
+        throw std::runtime_error("The stream does not contain a valid block sparse matrix");
+
+    *this = S;
+}
@@ -64,4 +64,71 @@ void NeuralCPP::create_dataset(cmatrix<float> &X, cmatrix<float> &y, const int &
             y.cell(0, c) = current_class;
         }
     }
-}
\ No newline at end of file
+}
+
+void NeuralCPP::create_dataset(NeuralSparse &X, cmatrix<float> &y, const int &n_samples, const int &n_features, const float &density, const int &n_classes, const int &random_state)
+{
+    // Check if the number of samples is valid
+    if (n_samples <= 0)
+        throw std::invalid_argument("The number of samples must be greater than 0");
+
+    // Check if the number of features is valid
+    if (n_features <= 0)
+        throw std::invalid_argument("The number of features must be greater than 0");
+
+    // Check if the number of classes is valid
+    if (n_classes <= 0)
+        throw std::invalid_argument("The number of classes must be greater than 0");
+
+    // Check if the density is valid
+    if (density <= 0 || density > 1)
+        throw std::invalid_argument("The density must be in ]0, 1]");
+
+    // Declare the dataset, built sample by sample before being transposed
+    std::vector<size_t> row_ptr = {0};
+    std::vector<size_t> col_idx;
+    std::vector<float> values;
+    y = cmatrix<float>(1, n_samples, -1);
+
+    // Initialize the random generator
+    srand(random_state);
+    std::uniform_real_distribution<float> dist(-1.0f, 0.0f);
+    std::geometric_distribution<int> skip(density);
+    std::mt19937 generator(random_state);
+
+    // Iterate over each sample and its non-zero features to randomly generate the dataset
+    for (int c = 0; c < n_samples; c++)
+    {
+        // Choose a random class
+        const float current_class = (float)(rand() % n_classes);
+        y.cell(0, c) = current_class;
+
+        // Add some noise
+        const float rand_lower_bound = (float)(rand() % 100) / 100.0f;
+        const float rand_upper_bound = (float)(rand() % 100) / 100.0f;
+        const float sign_x = (rand() % 2) ? 1 : -1;
+        const float sign_y = (rand() % 2) ? 1 : -1;
+
+        // Update the distribution
+        dist = std::uniform_real_distribution<float>(current_class + rand_lower_bound * sign_x,
+                                                     current_class + rand_upper_bound * sign_y);
+
+        // Jump from one non-zero feature to the next one
+        for (long r = skip(generator); r < n_features; r += skip(generator) + 1)
+        {
+            const float sign = (r % 2) ? 1 : -1;
+            const float value = dist(generator) * sign;
+
+            if (value != 0)
+            {
+                col_idx.push_back(r);
+                values.push_back(value);
+            }
+        }
+
+        row_ptr.push_back(values.size());
+    }
+
+    // Store the features as rows
+    X = NeuralSparse(n_samples, n_features, row_ptr, col_idx, values).transpose();
+}
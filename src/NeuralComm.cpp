@@ -0,0 +1,358 @@
+/**
+ * @file NeuralComm.cpp
+ * @see include/NeuralComm.hpp for definition.
+ * @brief The NeuralComm classes.
+ *
+ * This file contains the implementation of the NeuralComm, NeuralShmComm and NeuralTcpComm classes.
+ *
+ * @author Manitas Bahri <https://github.com/B-Manitas>
+ * @date 2023/11
+ * @license MIT License
+ */
+
+// INCLUDES
+#include "../include/NeuralComm.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// ==================================================
+// NEURALCOMM
+
+NeuralComm::NeuralComm(const int &size) : m_size(size)
+{
+    // Check if the number of workers is valid
+    if (size <= 0)
+        throw std::invalid_argument("The number of workers must be greater than 0");
+}
+
+NeuralComm::~NeuralComm() {}
+
+int NeuralComm::rank() const
+{
+    return m_rank;
+}
+
+int NeuralComm::size() const
+{
+    return m_size;
+}
+
+void NeuralComm::allreduce(std::vector<float> &data)
+{
+    allreduce(data.data(), data.size());
+}
+
+// ==================================================
+// NEURALSHMCOMM
+
+struct NeuralShmComm::Header
+{
+    pthread_barrier_t barrier;
+};
+
+NeuralShmComm::NeuralShmComm(const int &size, const size_t &capacity) : NeuralComm(size), m_capacity(capacity)
+{
+    // The segment holds the header, one slot per worker and the result, each aligned on a cache line
+    const size_t header_bytes = (sizeof(Header) + 63) / 64 * 64;
+    const size_t buffer_bytes = (m_capacity * sizeof(float) + 63) / 64 * 64;
+    m_bytes = header_bytes + (size + 1) * buffer_bytes;
+
+    // Create the segment. It is unlinked at once: the forked workers inherit the mapping.
+    const std::string &name = "/neuralcpp_" + std::to_string(getpid()) + "_" + std::to_string((size_t)this);
+    const int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+
+    if (fd < 0)
+        throw std::runtime_error("Unable to create the shared memory segment: " + std::string(strerror(errno)));
+
+    shm_unlink(name.c_str());
+
+    if (ftruncate(fd, m_bytes) != 0)
+    {
+        close(fd);
+        throw std::runtime_error("Unable to resize the shared memory segment: " + std::string(strerror(errno)));
+    }
+
+    void *segment = mmap(nullptr, m_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (segment == MAP_FAILED)
+        throw std::runtime_error("Unable to map the shared memory segment: " + std::string(strerror(errno)));
+
+    m_header = (Header *)segment;
+    m_slots = (float *)((char *)segment + header_bytes);
+    m_result = (float *)((char *)m_slots + size * buffer_bytes);
+
+    // The slots are spaced by buffer_bytes
+    m_capacity = buffer_bytes / sizeof(float);
+
+    // Initialize the barrier shared between the processes
+    pthread_barrierattr_t attr;
+    pthread_barrierattr_init(&attr);
+    pthread_barrierattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+    pthread_barrier_init(&m_header->barrier, &attr, size);
+    pthread_barrierattr_destroy(&attr);
+}
+
+NeuralShmComm::~NeuralShmComm()
+{
+    if (m_owner)
+        pthread_barrier_destroy(&m_header->barrier);
+
+    munmap(m_header, m_bytes);
+}
+
+void NeuralShmComm::attach(const int &rank)
+{
+    // Check if the rank is valid
+    if (rank < 0 || rank >= m_size)
+        throw std::invalid_argument("The rank must be in [0, " + std::to_string(m_size) + "[");
+
+    m_rank = rank;
+    m_owner = false;
+}
+
+void NeuralShmComm::allreduce(float *data, const size_t &n)
+{
+    // Check if the data fits in the slots
+    if (n > m_capacity)
+        throw std::invalid_argument("The data must contain at most " + std::to_string(m_capacity) + " floats");
+
+    if (m_size == 1)
+        return;
+
+    // Publish the data of the worker
+    std::copy(data, data + n, m_slots + m_rank * m_capacity);
+    barrier();
+
+    // Reduce-scatter: each worker sums its own chunk over all the slots
+    const size_t chunk = (n + m_size - 1) / m_size;
+    const size_t begin = std::min(n, m_rank * chunk);
+    const size_t end = std::min(n, begin + chunk);
+
+    for (size_t i = begin; i < end; i++)
+    {
+        float sum = 0;
+        for (int w = 0; w < m_size; w++)
+            sum += m_slots[w * m_capacity + i];
+
+        m_result[i] = sum;
+    }
+
+    barrier();
+
+    // All-gather: read the whole result. The next call writes the result only after its first barrier.
+    std::copy(m_result, m_result + n, data);
+}
+
+void NeuralShmComm::barrier()
+{
+    pthread_barrier_wait(&m_header->barrier);
+}
+
+// ==================================================
+// NEURALTCPCOMM
+
+/**
+ * @brief Closes a socket on every exit of the constructor, unless it is released to the communicator.
+ */
+struct SocketGuard
+{
+    int fd;
+
+    SocketGuard(const int &fd) : fd(fd) {}
+    ~SocketGuard()
+    {
+        if (fd >= 0)
+            close(fd);
+    }
+
+    SocketGuard(const SocketGuard &) = delete;
+    SocketGuard &operator=(const SocketGuard &) = delete;
+
+    int release()
+    {
+        const int released = fd;
+        fd = -1;
+        return released;
+    }
+};
+
+NeuralTcpComm::NeuralTcpComm(const int &rank, const int &size, const std::string &host, const int &base_port, const int &timeout) : NeuralComm(size)
+{
+    // Check if the rank is valid
+    if (rank < 0 || rank >= size)
+        throw std::invalid_argument("The rank must be in [0, " + std::to_string(size) + "[");
+
+    m_rank = rank;
+
+    if (size == 1)
+        return;
+
+    sockaddr_in address;
+    std::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(base_port + rank);
+
+    // Check if the host is an IPv4 address
+    if (inet_pton(AF_INET, host.c_str(), &address.sin_addr) != 1)
+        throw std::invalid_argument("The host must be an IPv4 address: " + host);
+
+    // Listen for the previous worker of the ring
+    SocketGuard listener(socket(AF_INET, SOCK_STREAM, 0));
+    const int one = 1;
+
+    if (listener.fd < 0 || setsockopt(listener.fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) != 0 || bind(listener.fd, (sockaddr *)&address, sizeof(address)) != 0 || listen(listener.fd, 1) != 0)
+        throw std::runtime_error("Unable to listen on port " + std::to_string(base_port + rank) + ": " + std::string(strerror(errno)));
+
+    // Connect to the next worker of the ring, which may not listen yet
+    address.sin_port = htons(base_port + (rank + 1) % size);
+    const std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::seconds(timeout);
+    SocketGuard sender(-1);
+
+    while (true)
+    {
+        SocketGuard attempt(socket(AF_INET, SOCK_STREAM, 0));
+        if (attempt.fd < 0)
+            throw std::runtime_error("Unable to create a socket: " + std::string(strerror(errno)));
+
+        if (connect(attempt.fd, (sockaddr *)&address, sizeof(address)) == 0)
+        {
+            sender.fd = attempt.release();
+            break;
+        }
+
+        if (std::chrono::steady_clock::now() > deadline)
+            throw std::runtime_error("Unable to connect to the worker " + std::to_string((rank + 1) % size));
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+
+    // Accept the previous worker of the ring before the deadline
+    pollfd pending = {listener.fd, POLLIN, 0};
+    const int remaining = std::max<long>(0, std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count());
+    SocketGuard receiver(poll(&pending, 1, remaining) == 1 ? accept(listener.fd, nullptr, nullptr) : -1);
+
+    if (receiver.fd < 0)
+        throw std::runtime_error("Unable to accept the worker " + std::to_string((rank + size - 1) % size));
+
+    // Send the chunks as soon as they are written
+    setsockopt(sender.fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    m_send_fd = sender.release();
+    m_recv_fd = receiver.release();
+}
+
+NeuralTcpComm::~NeuralTcpComm()
+{
+    if (m_send_fd >= 0)
+        close(m_send_fd);
+
+    if (m_recv_fd >= 0)
+        close(m_recv_fd);
+}
+
+void NeuralTcpComm::__exchange(const float *send, float *recv, const size_t &count)
+{
+    // Send and receive at the same time: the ring would deadlock if every worker blocked on a full send buffer.
+    // The sockets are polled, and each call only moves the bytes which fit in the buffers of the kernel.
+    const char *send_bytes = (const char *)send;
+    char *recv_bytes = (char *)recv;
+    size_t to_send = count * sizeof(float), to_recv = count * sizeof(float);
+
+    while (to_send > 0 || to_recv > 0)
+    {
+        pollfd fds[2] = {{m_send_fd, (short)(to_send > 0 ? POLLOUT : 0), 0}, {m_recv_fd, (short)(to_recv > 0 ? POLLIN : 0), 0}};
+
+        if (poll(fds, 2, -1) < 0)
+        {
+            if (errno == EINTR)
+                continue;
+
+            throw std::runtime_error("Unable to poll the connections with the neighbour workers: " + std::string(strerror(errno)));
+        }
+
+        if (to_send > 0 && fds[0].revents)
+        {
+            const ssize_t n = ::send(m_send_fd, send_bytes, to_send, MSG_NOSIGNAL | MSG_DONTWAIT);
+            if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+                throw std::runtime_error("The connection with a neighbour worker was lost");
+
+            if (n > 0)
+            {
+                send_bytes += n;
+                to_send -= n;
+            }
+        }
+
+        if (to_recv > 0 && fds[1].revents)
+        {
+            const ssize_t n = ::recv(m_recv_fd, recv_bytes, to_recv, MSG_DONTWAIT);
+            if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR))
+                throw std::runtime_error("The connection with a neighbour worker was lost");
+
+            if (n > 0)
+            {
+                recv_bytes += n;
+                to_recv -= n;
+            }
+        }
+    }
+}
+
+void NeuralTcpComm::allreduce(float *data, const size_t &n)
+{
+    if (m_size == 1 || n == 0)
+        return;
+
+    // Split the data in one chunk per worker, padded so that all the chunks have the same size
+    const size_t chunk = (n + m_size - 1) / m_size;
+    std::vector<float> buffer(chunk);
+
+    std::vector<float> padded(data, data + n);
+    padded.resize(chunk * m_size, 0);
+
+    // Reduce-scatter: after size - 1 steps, the worker owns the sum of the chunk rank + 1
+    for (int s = 0; s < m_size - 1; s++)
+    {
+        const int send_chunk = ((m_rank - s) % m_size + m_size) % m_size;
+        const int recv_chunk = ((m_rank - s - 1) % m_size + m_size) % m_size;
+
+        __exchange(&padded[send_chunk * chunk], buffer.data(), chunk);
+
+        for (size_t i = 0; i < chunk; i++)
+            padded[recv_chunk * chunk + i] += buffer[i];
+    }
+
+    // All-gather: the reduced chunks travel around the ring
+    for (int s = 0; s < m_size - 1; s++)
+    {
+        const int send_chunk = ((m_rank - s + 1) % m_size + m_size) % m_size;
+        const int recv_chunk = ((m_rank - s) % m_size + m_size) % m_size;
+
+        __exchange(&padded[send_chunk * chunk], &padded[recv_chunk * chunk], chunk);
+    }
+
+    std::copy(padded.begin(), padded.begin() + n, data);
+}
+
+void NeuralTcpComm::barrier()
+{
+    std::vector<float> token(1, 0);
+    allreduce(token);
+}
@@ -0,0 +1,366 @@
+/**
+ * @file NeuralDistributed.cpp
+ * @see include/NeuralDistributed.hpp for definition.
+ * @brief The NeuralDistributed class.
+ *
+ * This file contains the implementation of the NeuralDistributed class.
+ *
+ * @author Manitas Bahri <https://github.com/B-Manitas>
+ * @date 2023/11
+ * @license MIT License
+ */
+
+// INCLUDES
+#include "../include/NeuralDistributed.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// ==================================================
+// PRIVATE METHODS
+
+struct NeuralDistributed::WorkerStats
+{
+    double compute_seconds;
+    double wait_seconds;
+    double train_seconds;
+    double serial_seconds;
+};
+
+double NeuralDistributed::__time_serial_epoch(NeuralLayers &model, const cmatrix<float> &X, const cmatrix<float> &y, const float &learning_rate) const
+{
+    // The epoch of one worker on all the samples, without communication. The fastest of a few epochs is kept.
+    const std::vector<float> &targets = model.__gather_targets(y, nullptr);
+    double best = 0;
+
+    for (int i = 0; i < 3; i++)
+    {
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        model.__forward_propagation(X, true);
+        model.__back_propagation(targets);
+        model.__gradient_descent(learning_rate);
+
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        best = i == 0 ? seconds : std::min(best, seconds);
+    }
+
+    return best;
+}
+
+void NeuralDistributed::__train_worker(NeuralLayers &model, const cmatrix<float> &X, const cmatrix<float> &y, const int &epochs, const float &learning_rate, NeuralComm &comm, WorkerStats &stats) const
+{
+    // Only the layers with parameters send a gradient
+    int n_layers = 0;
+    for (size_t i = 0; i < model.m_graph.size(); i++)
+        n_layers += !model.m_graph.layer(i).parameters().empty();
+
+    // The shard of the worker, used through indices
+    std::vector<size_t> shard;
+    for (size_t j = comm.rank(); j < X.width(); j += comm.size())
+        shard.push_back(j);
+
+    const std::vector<float> &y_shard = model.__gather_targets(y, &shard);
+
+    // The local gradient is the mean over the shard: weight it by the size of the shard to sum the global mean
+    const float scale = shard.size() / X.width_t<float>();
+
+    // The communication thread reduces the gradients in the order they are computed
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<NeuralBuffer *> queue;
+    std::exception_ptr error = nullptr;
+    int n_reduced = 0;
+    bool stop = false;
+
+    std::thread comm_thread([&]
+                            {
+        try
+        {
+            while (true)
+            {
+                NeuralBuffer *dW = nullptr;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    cv.wait(lock, [&]
+                            { return stop || !queue.empty(); });
+
+                    if (queue.empty())
+                        return;
+
+                    dW = queue.front();
+                    queue.pop_front();
+                }
+
+                // Sum the gradient of the layer over the workers, in place
+                for (float &value : *dW)
+                    value *= scale;
+
+                comm.allreduce(dW->data(), dW->size());
+
+                std::lock_guard<std::mutex> lock(mutex);
+                n_reduced++;
+                cv.notify_all();
+            }
+        }
+        catch (...)
+        {
+            // Forward the error of the communication to the training loop
+            std::lock_guard<std::mutex> lock(mutex);
+            error = std::current_exception();
+            cv.notify_all();
+        } });
+
+    // Stop the communication thread on every exit
+    const std::function<void()> &join = [&]
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+            cv.notify_all();
+        }
+
+        comm_thread.join();
+        model.m_graph.on_gradient = nullptr;
+    };
+
+    // Send each gradient to the communication thread as soon as it is computed
+    model.m_graph.on_gradient = [&](const size_t &, NeuralBuffer &dW)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.push_back(&dW);
+        cv.notify_all();
+    };
+
+    typedef std::chrono::steady_clock clock;
+    stats.compute_seconds = 0;
+    stats.wait_seconds = 0;
+    const clock::time_point train_start = clock::now();
+
+    for (int i = 0; i < epochs; i++)
+    {
+        const clock::time_point start = clock::now();
+
+        try
+        {
+            model.__forward_propagation(X, shard, true);
+            model.__back_propagation(y_shard);
+        }
+        catch (...)
+        {
+            join();
+            throw;
+        }
+
+        // Wait for the gradients that are not reduced yet
+        const clock::time_point backward_end = clock::now();
+        bool failed = false;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [&]
+                    { return error || n_reduced == n_layers * (i + 1); });
+            failed = (bool)error;
+        }
+
+        if (failed)
+        {
+            join();
+            std::rethrow_exception(error);
+        }
+
+        const clock::time_point wait_end = clock::now();
+        model.__gradient_descent(learning_rate);
+
+        stats.compute_seconds += std::chrono::duration<double>(backward_end - start).count() + std::chrono::duration<double>(clock::now() - wait_end).count();
+        stats.wait_seconds += std::chrono::duration<double>(wait_end - backward_end).count();
+    }
+
+    stats.train_seconds = std::chrono::duration<double>(clock::now() - train_start).count();
+    join();
+}
+
+// ==================================================
+// CONSTRUCTORS
+
+NeuralDistributed::NeuralDistributed(const int &n_workers, const Transport &transport, const int &base_port)
+    : m_n_workers(n_workers), m_transport(transport), m_base_port(base_port)
+{
+    // Check if the number of workers is valid
+    if (n_workers <= 0)
+        throw std::invalid_argument("The number of workers must be greater than 0");
+}
+
+// ==================================================
+// METHODS
+
+const NeuralDistributed::Report &NeuralDistributed::fit(NeuralLayers &model, const cmatrix<float> &X, const cmatrix<float> &y, const int &epochs, const float &learning_rate)
+{
+    // Check if there are enough samples
+    if (X.width() < (size_t)m_n_workers)
+        throw std::invalid_argument("The number of samples must be greater or equal to the number of workers: " + std::to_string(m_n_workers));
+
+    // Check if every sample has a target: a worker would fail on its shard
+    if (y.width() != X.width())
+        throw std::invalid_argument("The output matrix must have " + std::to_string(X.width()) + " columns");
+
+    // Fit the scaler and initialize the weights before forking, so that every worker starts from the same model
+    model.m_scaler.fit(X);
+    model.__init_weights(model.m_scaler.n_outputs(), y.height());
+
+    // Check if every gradient is dense: the sparse gradients of an embedding are never reduced
+    for (size_t i = 0; i < model.m_graph.size(); i++)
+        if (model.m_graph.layer(i).gradients().empty() && !model.m_graph.layer(i).parameters().empty())
+            throw std::invalid_argument("The distributed training does not support the layers with sparse gradients, such as NeuralEmbedding");
+
+    const size_t n_weights = model.m_graph.parameters().size();
+    size_t max_layer = 0;
+    for (size_t i = 0; i < model.m_graph.size(); i++)
+        max_layer = std::max(max_layer, model.m_graph.layer(i).parameters().size());
+
+    // The shared memory segment must exist before forking
+    std::unique_ptr<NeuralShmComm> shm(m_transport == SHARED_MEMORY ? new NeuralShmComm(m_n_workers, max_layer) : nullptr);
+
+    // The results are written by the workers in a shared mapping: the stats of each worker and the weights of the worker 0
+    const size_t bytes = m_n_workers * sizeof(WorkerStats) + n_weights * sizeof(float);
+    void *results = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+
+    if (results == MAP_FAILED)
+        throw std::runtime_error("Unable to map the results of the workers");
+
+    WorkerStats *stats = (WorkerStats *)results;
+    float *weights = (float *)(stats + m_n_workers);
+
+    // Fork the workers
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::vector<pid_t> pids;
+
+    for (int rank = 0; rank < m_n_workers; rank++)
+    {
+        const pid_t pid = fork();
+
+        if (pid < 0)
+            break;
+
+        if (pid == 0)
+        {
+            int status = 0;
+
+#ifdef _OPENMP
+            // The OpenMP threads of the parent do not exist in the child: a parallel region of more than one thread
+            // would wait for them forever (libgomp). Each worker runs on one core, the workers are the parallelism.
+            omp_set_num_threads(1);
+#endif
+
+            try
+            {
+                std::unique_ptr<NeuralTcpComm> tcp;
+                if (shm)
+                    shm->attach(rank);
+                else
+                    tcp.reset(new NeuralTcpComm(rank, m_n_workers, "127.0.0.1", m_base_port));
+
+                __train_worker(model, X, y, epochs, learning_rate, shm ? (NeuralComm &)*shm : (NeuralComm &)*tcp, stats[rank]);
+
+                // The weights are identical on every worker
+                if (rank == 0)
+                {
+                    const std::vector<float> &trained = model.m_graph.parameters();
+                    std::copy(trained.begin(), trained.end(), weights);
+
+                    // The baseline of the speedup, once the weights are saved: the training on one worker
+                    stats[rank].serial_seconds = __time_serial_epoch(model, X, y, learning_rate) * epochs;
+                }
+            }
+            catch (const std::exception &e)
+            {
+                std::cerr << "Worker " << rank << ": " << e.what() << std::endl;
+                status = 1;
+            }
+
+            // Leave without running the destructors of the parent objects
+            _exit(status);
+        }
+
+        pids.push_back(pid);
+    }
+
+    // Wait for the workers. The first failure kills the others: they would wait for the failed worker forever
+    // in the all-reduce. A failed fork is a failure too, since the forked workers wait for the missing ones.
+    bool failed = (int)pids.size() != m_n_workers;
+    std::vector<pid_t> running = pids;
+
+    while (!running.empty())
+    {
+        if (failed)
+            for (const pid_t &pid : running)
+                kill(pid, SIGKILL);
+
+        const size_t n_running = running.size();
+        for (size_t r = 0; r < running.size();)
+        {
+            int status = 0;
+            const pid_t pid = waitpid(running[r], &status, WNOHANG);
+
+            if (pid == 0 || (pid < 0 && errno == EINTR))
+            {
+                r++;
+                continue;
+            }
+
+            // The status of a worker which cannot be waited for is unknown
+            failed = failed || pid < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0;
+            running.erase(running.begin() + r);
+        }
+
+        if (running.size() == n_running)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    const float seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+    shm.reset();
+
+    if (failed)
+    {
+        munmap(results, bytes);
+        throw std::runtime_error("A worker of the distributed training failed");
+    }
+
+    // Read the trained weights
+    model.m_graph.set_parameters(std::vector<float>(weights, weights + n_weights));
+
+    // Report the speedup over one worker, and the overlap of the communication and the back propagation
+    report = {m_n_workers, seconds, 0, 0, 0, 0, 0, 0, X.width_t<float>() * epochs / seconds};
+    double train_seconds = 0;
+    for (int rank = 0; rank < m_n_workers; rank++)
+    {
+        report.compute_seconds = std::max(report.compute_seconds, (float)stats[rank].compute_seconds);
+        report.wait_seconds = std::max(report.wait_seconds, (float)stats[rank].wait_seconds);
+        report.overlap += stats[rank].compute_seconds / (stats[rank].compute_seconds + stats[rank].wait_seconds) / m_n_workers;
+        train_seconds = std::max(train_seconds, stats[rank].train_seconds);
+    }
+
+    report.serial_seconds = stats[0].serial_seconds;
+    report.speedup = train_seconds > 0 ? stats[0].serial_seconds / train_seconds : 0;
+    report.efficiency = report.speedup / m_n_workers;
+
+    munmap(results, bytes);
+
+    return report;
+}
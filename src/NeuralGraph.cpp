@@ -0,0 +1,312 @@
+/**
+ * @file NeuralGraph.cpp
+ * @see include/NeuralGraph.hpp for definition.
+ * @brief The NeuralGraph class.
+ *
+ * This file contains the implementation of the NeuralGraph class.
+ *
+ * @author Manitas Bahri <https://github.com/B-Manitas>
+ * @date 2023/11
+ * @license MIT License
+ */
+
+// INCLUDES
+#include "../include/NeuralGraph.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+// ==================================================
+// PRIVATE METHODS
+
+void NeuralGraph::__check_built() const
+{
+    if (!m_built)
+        throw std::runtime_error("The graph must be built before its execution");
+}
+
+// ==================================================
+// CONSTRUCTORS
+
+NeuralGraph::NeuralGraph(const NeuralLayer::Shape &input_shape) : m_input_shape(input_shape) {}
+
+NeuralGraph::NeuralGraph(const NeuralGraph &other) : m_input_shape(other.m_input_shape), m_built(other.m_built)
+{
+    // The buffers and the gradient hook are not copied
+    for (const NeuralLayer *layer : other.m_layers)
+        m_layers.push_back(layer->clone());
+}
+
+NeuralGraph &NeuralGraph::operator=(const NeuralGraph &other)
+{
+    if (this == &other)
+        return *this;
+
+    NeuralGraph copy(other);
+    std::swap(m_input_shape, copy.m_input_shape);
+    std::swap(m_layers, copy.m_layers);
+    m_built = copy.m_built;
+
+    // Release the buffers planned for the previous layers
+    m_batch = 0;
+    m_activations.clear();
+    m_deltas[0].clear();
+    m_deltas[1].clear();
+
+    return *this;
+}
+
+NeuralGraph::~NeuralGraph()
+{
+    for (NeuralLayer *layer : m_layers)
+        delete layer;
+}
+
+// ==================================================
+// METHODS
+
+NeuralGraph &NeuralGraph::add(const NeuralLayer &layer)
+{
+    return add(layer.clone());
+}
+
+NeuralGraph &NeuralGraph::add(NeuralLayer *layer)
+{
+    m_layers.push_back(layer);
+    m_built = false;
+    m_batch = 0;
+
+    return *this;
+}
+
+size_t NeuralGraph::size() const
+{
+    return m_layers.size();
+}
+
+NeuralLayer &NeuralGraph::layer(const size_t &i)
+{
+    return *m_layers.at(i);
+}
+
+const NeuralLayer &NeuralGraph::layer(const size_t &i) const
+{
+    return *m_layers.at(i);
+}
+
+bool NeuralGraph::is_built() const
+{
+    return m_built;
+}
+
+const NeuralLayer::Shape &NeuralGraph::input_shape() const
+{
+    return m_built ? m_layers.front()->input_shape() : m_input_shape;
+}
+
+size_t NeuralGraph::output_size() const
+{
+    __check_built();
+
+    return m_layers.back()->output_shape().size();
+}
+
+void NeuralGraph::build(const size_t &n_features, const int &random_state)
+{
+    // Check if the graph is valid
+    if (m_layers.empty())
+        throw std::invalid_argument("The graph must contain at least one layer");
+
+    NeuralLayer::Shape shape = m_input_shape.channels == 0 ? NeuralLayer::Shape(n_features) : m_input_shape;
+
+    if (shape.size() != n_features)
+        throw std::invalid_argument("The input shape of the graph must contain " + std::to_string(n_features) + " features");
+
+    // Compute the shape of each layer and initialize its parameters
+    for (size_t i = 0; i < m_layers.size(); i++)
+    {
+        shape = m_layers[i]->build(shape, random_state + i + 1);
+        m_layers[i]->set_loss_output(i + 1 == m_layers.size());
+    }
+
+    m_built = true;
+    m_batch = 0;
+}
+
+void NeuralGraph::plan(const size_t &batch, const size_t &first_layer)
+{
+    __check_built();
+
+    if (batch == m_batch && first_layer == m_first_layer)
+        return;
+
+    // The activations before the first layer are never written
+    m_activations.resize(m_layers.size() + 1, NeuralBuffer(NeuralAllocator<float>(NeuralMemory::activations())));
+    size_t max_delta = 0;
+
+    for (size_t i = 0; i <= m_layers.size(); i++)
+    {
+        const size_t size = i < m_layers.size() ? m_layers[i]->input_shape().size() : m_layers.back()->output_shape().size();
+
+        if (i < first_layer)
+            NeuralBuffer(m_activations[i].get_allocator()).swap(m_activations[i]);
+        else
+            m_activations[i].resize(batch * size);
+
+        // The gradient of the input is not needed
+        if (i > 0 && i >= first_layer)
+            max_delta = std::max(max_delta, batch * size);
+    }
+
+    m_deltas[0].resize(max_delta);
+    m_deltas[1].resize(max_delta);
+
+    for (NeuralLayer *layer : m_layers)
+        layer->plan(batch);
+
+    m_batch = batch;
+    m_first_layer = first_layer;
+}
+
+size_t NeuralGraph::batch() const
+{
+    return m_batch;
+}
+
+float *NeuralGraph::activation(const size_t &i)
+{
+    return m_activations.at(i).data();
+}
+
+const float *NeuralGraph::forward(const bool &training, const size_t &first_layer)
+{
+    __check_built();
+
+    for (size_t i = first_layer; i < m_layers.size(); i++)
+        m_layers[i]->forward(m_activations[i].data(), m_activations[i + 1].data(), m_batch, training);
+
+    return m_activations.back().data();
+}
+
+float *NeuralGraph::backward(const std::vector<float> &y, const size_t &first_layer)
+{
+    __check_built();
+
+    // Check if y matches the output
+    const NeuralBuffer &y_pred = m_activations.back();
+    if (y.size() != y_pred.size())
+        throw std::invalid_argument("The expected output must contain " + std::to_string(y_pred.size()) + " values");
+
+    // The gradient of the mean cross-entropy with respect to the input of the sigmoid output
+    float *d_out = m_deltas[0].data();
+    float *d_in = m_deltas[1].data();
+    const float m = m_batch;
+
+    for (size_t i = 0; i < y.size(); i++)
+        d_out[i] = (y_pred[i] - y[i]) / m;
+
+    for (size_t i = m_layers.size(); i-- > first_layer;)
+    {
+        m_layers[i]->backward(m_activations[i].data(), m_activations[i + 1].data(), d_out, i > 0 ? d_in : nullptr, m_batch);
+
+        if (on_gradient && !m_layers[i]->gradients().empty())
+            on_gradient(i, m_layers[i]->gradients());
+
+        std::swap(d_out, d_in);
+    }
+
+    return first_layer > 0 ? d_out : nullptr;
+}
+
+void NeuralGraph::update(const float &learning_rate, const size_t &first_layer)
+{
+    for (size_t i = first_layer; i < m_layers.size(); i++)
+        m_layers[i]->update(learning_rate);
+}
+
+std::vector<float> NeuralGraph::parameters() const
+{
+    std::vector<float> parameters;
+
+    for (const NeuralLayer *layer : m_layers)
+        parameters.insert(parameters.end(), layer->parameters().begin(), layer->parameters().end());
+
+    return parameters;
+}
+
+void NeuralGraph::set_parameters(const std::vector<float> &parameters)
+{
+    size_t n_parameters = 0;
+    for (const NeuralLayer *layer : m_layers)
+        n_parameters += layer->parameters().size();
+
+    // Check if the number of parameters matches
+    if (parameters.size() != n_parameters)
+        throw std::invalid_argument("The graph has " + std::to_string(n_parameters) + " parameters");
+
+    std::vector<float>::const_iterator it = parameters.begin();
+    for (NeuralLayer *layer : m_layers)
+    {
+        layer->set_parameters(std::vector<float>(it, it + layer->parameters().size()));
+        it += layer->parameters().size();
+    }
+}
+
+void NeuralGraph::save(std::ostream &stream) const
+{
+    __check_built();
+
+    const NeuralLayer::Shape &shape = input_shape();
+    stream << std::setprecision(std::numeric_limits<float>::max_digits10);
+    stream << "NeuralGraph " << m_layers.size() << " " << shape.channels << " " << shape.height << " " << shape.width << "\n";
+
+    // The configuration of each layer, then its parameters
+    for (const NeuralLayer *layer : m_layers)
+    {
+        layer->save(stream);
+        stream << "\n";
+        layer->save_parameters(stream);
+        stream << "\n";
+    }
+}
+
+void NeuralGraph::load(std::istream &stream)
+{
+    std::string name;
+    size_t n_layers = 0;
+    NeuralLayer::Shape shape;
+
+    if (!(stream >> name >> n_layers >> shape.channels >> shape.height >> shape.width) || name != "NeuralGraph" || n_layers == 0)
+        throw std::runtime_error("The stream does not contain a valid graph");
+
+    // Build the layers in a new graph, which releases them on error
+    NeuralGraph graph(shape);
+    NeuralLayer::Shape layer_shape = shape;
+
+    for (size_t i = 0; i < n_layers; i++)
+    {
+        NeuralLayer *layer = NeuralLayer::load(stream);
+        graph.add(layer);
+
+        try
+        {
+            layer_shape = layer->build(layer_shape, 0);
+        }
+        catch (const std::invalid_argument &e)
+        {
+            throw std::runtime_error("The stream does not contain a valid graph: " + std::string(e.what()));
+        }
+
+        // The parameters replace the initialization of the build
+        layer->load_parameters(stream);
+        layer->set_loss_output(i + 1 == n_layers);
+    }
+
+    std::swap(m_layers, graph.m_layers);
+    m_input_shape = shape;
+    m_built = true;
+    m_batch = 0;
+}
@@ -0,0 +1,247 @@
+/**
+ * @file NeuralHogwild.cpp
+ * @see include/NeuralHogwild.hpp for definition.
+ * @brief The NeuralHogwild class.
+ *
+ * This file contains the implementation of the NeuralHogwild class.
+ *
+ * @author Manitas Bahri <https://github.com/B-Manitas>
+ * @date 2023/11
+ * @license MIT License
+ */
+
+// INCLUDES
+#include "../include/NeuralHogwild.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <fstream>
+#include <memory>
+#include <new>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+/**
+ * @brief Releases a replica of the weights in the parameters pool.
+ */
+struct ReplicaDeleter
+{
+    size_t size;
+
+    void operator()(std::atomic<float> *replica) const
+    {
+        NeuralMemory::parameters().deallocate(replica, size * sizeof(std::atomic<float>));
+    }
+};
+
+// ==================================================
+// PRIVATE METHODS
+
+std::vector<std::vector<int>> NeuralHogwild::__read_numa_nodes()
+{
+    std::vector<std::vector<int>> nodes;
+
+    // Each node lists its CPUs as ranges, ex: 0-3,8-11
+    for (int node = 0; true; node++)
+    {
+        std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+        std::string cpulist;
+
+        if (!file || !std::getline(file, cpulist))
+            break;
+
+        std::vector<int> cpus;
+        std::stringstream ranges(cpulist);
+        std::string range;
+
+        while (std::getline(ranges, range, ','))
+        {
+            const size_t dash = range.find('-');
+            const int first = std::stoi(range.substr(0, dash));
+            const int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+
+            for (int cpu = first; cpu <= last; cpu++)
+                cpus.push_back(cpu);
+        }
+
+        if (!cpus.empty())
+            nodes.push_back(cpus);
+    }
+
+    return nodes;
+}
+
+void NeuralHogwild::__pin_thread(const size_t &replica) const
+{
+#ifdef __linux__
+    // A single replica is shared by every node: let the scheduler place the threads
+    if (m_n_replicas == 1 || m_node_cpus.size() < 2)
+        return;
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+
+    for (const int &cpu : m_node_cpus[replica % m_node_cpus.size()])
+        CPU_SET(cpu, &set);
+
+    pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &set);
+#endif
+}
+
+std::vector<float> NeuralHogwild::__average(const std::vector<std::atomic<float> *> &replicas, const size_t &size) const
+{
+    std::vector<float> mean(size, 0);
+
+    for (std::atomic<float> *replica : replicas)
+        for (size_t i = 0; i < size; i++)
+            mean[i] += replica[i].load(std::memory_order_relaxed);
+
+    for (size_t i = 0; i < size; i++)
+        mean[i] /= replicas.size();
+
+    // Store the mean in each replica
+    if (replicas.size() > 1)
+        for (std::atomic<float> *replica : replicas)
+            for (size_t i = 0; i < size; i++)
+                replica[i].store(mean[i], std::memory_order_relaxed);
+
+    return mean;
+}
+
+// ==================================================
+// CONSTRUCTORS
+
+NeuralHogwild::NeuralHogwild(const size_t &n_threads, const size_t &n_replicas)
+    : m_n_threads(n_threads), m_n_replicas(n_replicas)
+{
+    if (m_n_threads == 0)
+        m_n_threads = std::max(1u, std::thread::hardware_concurrency());
+
+    // Check if the number of replicas is valid
+    if (m_n_replicas == 0 || m_n_replicas > m_n_threads)
+        throw std::invalid_argument("The number of replicas must be in [1, " + std::to_string(m_n_threads) + "]");
+
+    if (m_n_replicas > 1)
+        m_node_cpus = __read_numa_nodes();
+}
+
+// ==================================================
+// METHODS
+
+size_t NeuralHogwild::n_threads() const
+{
+    return m_n_threads;
+}
+
+std::vector<float> NeuralHogwild::run(const std::vector<float> &weights, const size_t &n_samples, const int &epochs, const Step &step, const Callback &callback, const int &random_state)
+{
+    // Check if the number of epochs is valid
+    if (epochs <= 0)
+        throw std::invalid_argument("The number of epochs must be greater than 0");
+
+    const size_t size = weights.size();
+    std::vector<std::atomic<float> *> replicas(m_n_replicas, nullptr);
+    std::vector<std::thread> threads;
+    std::vector<std::exception_ptr> errors(m_n_threads, nullptr);
+
+    // The replicas are released by their owners on every exit, including the errors of the workers and of the callback
+    std::vector<std::unique_ptr<std::atomic<float>, ReplicaDeleter>> owners;
+    for (size_t r = 0; r < m_n_replicas; r++)
+        owners.emplace_back(nullptr, ReplicaDeleter{size});
+
+    // Allocate and first touch each replica from a thread of its node
+    for (size_t r = 0; r < m_n_replicas; r++)
+    {
+        threads.push_back(std::thread([&, r]
+                                      {
+            try
+            {
+                __pin_thread(r);
+                // The pages are placed by the pinned thread, so the pool does not touch them
+                owners[r].reset(static_cast<std::atomic<float> *>(NeuralMemory::parameters().allocate(size * sizeof(std::atomic<float>), false)));
+                replicas[r] = owners[r].get();
+
+                for (size_t i = 0; i < size; i++)
+                    new (&replicas[r][i]) std::atomic<float>(weights[i]);
+            }
+            catch (...)
+            {
+                errors[r] = std::current_exception();
+            } }));
+    }
+
+    for (std::thread &thread : threads)
+        thread.join();
+
+    for (const std::exception_ptr &error : errors)
+        if (error)
+            std::rethrow_exception(error);
+
+    // Train the weights
+    std::vector<size_t> order(n_samples);
+    std::iota(order.begin(), order.end(), 0);
+    std::mt19937 generator(random_state);
+    std::vector<float> result = weights;
+
+    size_t n_processed = 0;
+    float seconds = 0;
+
+    for (int epoch = 0; epoch < epochs; epoch++)
+    {
+        std::shuffle(order.begin(), order.end(), generator);
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+        // Each worker processes its own slice of the shuffled samples
+        threads.clear();
+        for (size_t t = 0; t < m_n_threads; t++)
+        {
+            threads.push_back(std::thread([&, t]
+                                          {
+                try
+                {
+                    const size_t replica = t % m_n_replicas;
+                    __pin_thread(replica);
+                    Weights w(replicas[replica], size);
+
+                    for (size_t k = t; k < n_samples; k += m_n_threads)
+                        step(order[k], w, t);
+                }
+                catch (...)
+                {
+                    errors[t] = std::current_exception();
+                } }));
+        }
+
+        for (std::thread &thread : threads)
+            thread.join();
+
+        n_processed += n_samples;
+        seconds += std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+
+        // Forward the first error thrown by a worker
+        for (const std::exception_ptr &error : errors)
+            if (error)
+                std::rethrow_exception(error);
+
+        // Average the replicas
+        result = __average(replicas, size);
+
+        if (callback && callback(epoch, result))
+            break;
+    }
+
+    // The averaging and the callback are not part of the throughput
+    throughput = seconds > 0 ? n_processed / seconds : 0;
+
+    return result;
+}
@@ -0,0 +1,1804 @@
+/**
+ * @file NeuralLayer.cpp
+ * @see include/NeuralLayer.hpp for definition.
+ * @brief The NeuralLayer classes.
+ *
+ * This file contains the implementation of the NeuralLayer, NeuralDense, NeuralConv2D, NeuralConv1D, NeuralPool, NeuralDropout, NeuralEmbedding and NeuralRecurrent classes.
+ *
+ * @author Manitas Bahri <https://github.com/B-Manitas>
+ * @date 2023/11
+ * @license MIT License
+ */
+
+// INCLUDES
+#include "../include/NeuralLayer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <stdexcept>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// ==================================================
+// NEURALLAYER
+
+void NeuralLayer::__activate(float *values, const size_t &size) const
+{
+    if (m_activation == SIGMOID)
+        for (size_t i = 0; i < size; i++)
+            values[i] = 1 / (1 + std::exp(-values[i]));
+
+    else if (m_activation == RELU)
+        for (size_t i = 0; i < size; i++)
+            values[i] = std::max(values[i], 0.f);
+}
+
+void NeuralLayer::__activate_backward(const float *out, float *d_out, const size_t &size) const
+{
+    // The gradient of the cross-entropy after a sigmoid is already the gradient of its input
+    if (m_loss_output && m_activation == SIGMOID)
+        return;
+
+    if (m_activation == SIGMOID)
+    {
+#pragma omp parallel for schedule(static)
+        for (size_t i = 0; i < size; i++)
+            d_out[i] *= out[i] * (1 - out[i]);
+    }
+
+    else if (m_activation == RELU)
+    {
+#pragma omp parallel for schedule(static)
+        for (size_t i = 0; i < size; i++)
+            d_out[i] = out[i] > 0 ? d_out[i] : 0;
+    }
+}
+
+void NeuralLayer::__gemm_nn(const size_t &M, const size_t &N, const size_t &K, const float *A, const size_t &lda, const float *B, const size_t &ldb, float *C, const size_t &ldc, const bool &accumulate, const bool &parallel)
+{
+    // Each block of rows of C accumulates the blocks of rows of B, which stay in the cache
+    const NeuralTuner::Config config = NeuralTuner::config(NeuralTuner::NN, parallel, M, N, K);
+    const size_t block = config.block ? config.block : 64;
+    const int threads = __gemm_threads(config);
+
+#pragma omp parallel for schedule(static) if (parallel && threads > 1) num_threads(threads)
+    for (size_t i0 = 0; i0 < M; i0 += block)
+    {
+        const size_t i1 = std::min(M, i0 + block);
+
+        if (!accumulate)
+            for (size_t i = i0; i < i1; i++)
+                std::fill(C + i * ldc, C + i * ldc + N, 0.f);
+
+        for (size_t k0 = 0; k0 < K; k0 += block)
+        {
+            const size_t k1 = std::min(K, k0 + block);
+
+            for (size_t i = i0; i < i1; i++)
+            {
+                float *c = C + i * ldc;
+
+                for (size_t k = k0; k < k1; k++)
+                {
+                    const float a = A[i * lda + k];
+                    const float *b = B + k * ldb;
+
+                    if (a != 0)
+                        for (size_t j = 0; j < N; j++)
+                            c[j] += a * b[j];
+                }
+            }
+        }
+    }
+}
+
+void NeuralLayer::__gemm_nt(const size_t &M, const size_t &N, const size_t &K, const float *A, const size_t &lda, const float *B, const size_t &ldb, float *C, const size_t &ldc, const bool &accumulate, const bool &parallel)
+{
+    // Each tile of C is a set of dot products between rows of A and rows of B
+    const NeuralTuner::Config config = NeuralTuner::config(NeuralTuner::NT, parallel, M, N, K);
+    const size_t block = config.block ? config.block : 32;
+    const int threads = __gemm_threads(config);
+
+#pragma omp parallel for schedule(static) if (parallel && threads > 1) num_threads(threads)
+    for (size_t i0 = 0; i0 < M; i0 += block)
+    {
+        const size_t i1 = std::min(M, i0 + block);
+
+        for (size_t j0 = 0; j0 < N; j0 += block)
+        {
+            const size_t j1 = std::min(N, j0 + block);
+
+            for (size_t i = i0; i < i1; i++)
+            {
+                const float *a = A + i * lda;
+
+                for (size_t j = j0; j < j1; j++)
+                {
+                    const float *b = B + j * ldb;
+                    float dot = 0;
+
+                    for (size_t k = 0; k < K; k++)
+                        dot += a[k] * b[k];
+
+                    C[i * ldc + j] = accumulate ? C[i * ldc + j] + dot : dot;
+                }
+            }
+        }
+    }
+}
+
+void NeuralLayer::__gemm_tn(const size_t &M, const size_t &N, const size_t &K, const float *A, const size_t &lda, const float *B, const size_t &ldb, float *C, const size_t &ldc, const bool &accumulate, const bool &parallel)
+{
+    // Each block of rows of C is updated with the rows of B, one rank-1 update per k
+    const NeuralTuner::Config config = NeuralTuner::config(NeuralTuner::TN, parallel, M, N, K);
+    const size_t block = config.block ? config.block : 64;
+    const int threads = __gemm_threads(config);
+
+#pragma omp parallel for schedule(static) if (parallel && threads > 1) num_threads(threads)
+    for (size_t i0 = 0; i0 < M; i0 += block)
+    {
+        const size_t i1 = std::min(M, i0 + block);
+
+        if (!accumulate)
+            for (size_t i = i0; i < i1; i++)
+                std::fill(C + i * ldc, C + i * ldc + N, 0.f);
+
+        for (size_t k = 0; k < K; k++)
+        {
+            const float *b = B + k * ldb;
+
+            for (size_t i = i0; i < i1; i++)
+            {
+                const float a = A[k * lda + i];
+                float *c = C + i * ldc;
+
+                if (a != 0)
+                    for (size_t j = 0; j < N; j++)
+                        c[j] += a * b[j];
+            }
+        }
+    }
+}
+
+size_t NeuralLayer::__thread_index()
+{
+#ifdef _OPENMP
+    return omp_get_thread_num();
+#else
+    return 0;
+#endif
+}
+
+size_t NeuralLayer::__max_threads()
+{
+#ifdef _OPENMP
+    return omp_get_max_threads();
+#else
+    return 1;
+#endif
+}
+
+int NeuralLayer::__gemm_threads(const NeuralTuner::Config &config)
+{
+    // The tuned number is an upper bound: the caller may have capped the threads (omp_set_num_threads)
+    return config.threads ? std::min<size_t>(config.threads, __max_threads()) : __max_threads();
+}
+
+NeuralLayer::NeuralLayer(const Activation &activation) : m_activation(activation) {}
+
+NeuralLayer::~NeuralLayer() {}
+
+const NeuralLayer::Shape &NeuralLayer::input_shape() const
+{
+    return m_input;
+}
+
+const NeuralLayer::Shape &NeuralLayer::output_shape() const
+{
+    return m_output;
+}
+
+NeuralLayer::Activation NeuralLayer::activation() const
+{
+    return m_activation;
+}
+
+NeuralBuffer &NeuralLayer::parameters()
+{
+    return m_parameters;
+}
+
+const NeuralBuffer &NeuralLayer::parameters() const
+{
+    return m_parameters;
+}
+
+NeuralBuffer &NeuralLayer::gradients()
+{
+    return m_gradients;
+}
+
+void NeuralLayer::set_loss_output(const bool &loss_output)
+{
+    m_loss_output = loss_output;
+}
+
+void NeuralLayer::plan(const size_t &) {}
+
+void NeuralLayer::__apply_mask()
+{
+    if (m_mask.empty())
+        return;
+
+#pragma omp parallel for schedule(static) if (m_parameters.size() > 4096)
+    for (size_t i = 0; i < m_parameters.size(); i++)
+        if (!m_mask[i])
+            m_parameters[i] = 0;
+}
+
+void NeuralLayer::__parameters_changed() {}
+
+void NeuralLayer::update(const float &learning_rate)
+{
+    // The pruned parameters are skipped, so they stay 0
+    if (m_mask.empty())
+    {
+#pragma omp parallel for schedule(static) if (m_parameters.size() > 4096)
+        for (size_t i = 0; i < m_parameters.size(); i++)
+            m_parameters[i] -= learning_rate * m_gradients[i];
+    }
+
+    else
+    {
+#pragma omp parallel for schedule(static) if (m_parameters.size() > 4096)
+        for (size_t i = 0; i < m_parameters.size(); i++)
+            m_parameters[i] -= m_mask[i] ? learning_rate * m_gradients[i] : 0;
+    }
+
+    __parameters_changed();
+}
+
+void NeuralLayer::set_parameters(const std::vector<float> &parameters)
+{
+    // Check if the number of parameters matches
+    if (parameters.size() != m_parameters.size())
+        throw std::invalid_argument("The layer has " + std::to_string(m_parameters.size()) + " parameters");
+
+    m_parameters.assign(parameters.begin(), parameters.end());
+    __apply_mask();
+    __parameters_changed();
+}
+
+void NeuralLayer::weights_shape(size_t &rows, size_t &columns) const
+{
+    rows = 0;
+    columns = 0;
+}
+
+const std::vector<uint8_t> &NeuralLayer::mask() const
+{
+    return m_mask;
+}
+
+void NeuralLayer::set_mask(const std::vector<uint8_t> &mask)
+{
+    // Check if the mask matches the parameters
+    if (!mask.empty() && mask.size() != m_parameters.size())
+        throw std::invalid_argument("The mask must have " + std::to_string(m_parameters.size()) + " values");
+
+    m_mask = mask;
+    __apply_mask();
+    __parameters_changed();
+}
+
+float NeuralLayer::sparsity() const
+{
+    size_t rows = 0, columns = 0;
+    weights_shape(rows, columns);
+
+    if (rows * columns == 0)
+        return 0;
+
+    // The bias is not counted
+    const size_t ld = m_parameters.size() / rows;
+    size_t n_zeros = 0;
+
+    for (size_t r = 0; r < rows; r++)
+        for (size_t c = 0; c < columns; c++)
+            n_zeros += m_parameters[r * ld + c] == 0;
+
+    return (float)n_zeros / (rows * columns);
+}
+
+void NeuralLayer::save_parameters(std::ostream &stream) const
+{
+    stream << m_parameters.size();
+
+    for (const float &parameter : m_parameters)
+        stream << " " << parameter;
+}
+
+void NeuralLayer::load_parameters(std::istream &stream)
+{
+    size_t n_parameters = 0;
+    std::vector<float> parameters;
+
+    if (stream >> n_parameters && n_parameters == m_parameters.size())
+    {
+        parameters.resize(n_parameters);
+        for (float &parameter : parameters)
+            stream >> parameter;
+    }
+
+    if (!stream || parameters.size() != m_parameters.size())
+        throw std::runtime_error("The stream does not contain the " + std::to_string(m_parameters.size()) + " parameters of the layer");
+
+    set_parameters(parameters);
+}
+
+NeuralLayer *NeuralLayer::load(std::istream &stream)
+{
+    std::string type;
+    int activation = 0;
+    NeuralLayer *layer = nullptr;
+
+    if (!(stream >> type))
+        throw std::runtime_error("The stream does not contain a valid layer");
+
+    if (type == "Dense")
+    {
+        size_t units = 0;
+        bool bias = true;
+        if (stream >> units >> activation >> bias && units > 0)
+            layer = new NeuralDense(units, (Activation)activation, bias);
+    }
+
+    else if (type == "Conv2D")
+    {
+        size_t filters = 0, kernel_height = 0, kernel_width = 0, stride = 0, padding = 0;
+        if (stream >> filters >> kernel_height >> kernel_width >> stride >> padding >> activation && filters > 0 && kernel_height > 0 && kernel_width > 0 && stride > 0)
+            layer = new NeuralConv2D(filters, kernel_height, kernel_width, stride, padding, (Activation)activation);
+    }
+
+    else if (type == "Conv1D")
+    {
+        size_t filters = 0, kernel = 0, stride = 0, padding = 0;
+        if (stream >> filters >> kernel >> stride >> padding >> activation && filters > 0 && kernel > 0 && stride > 0)
+            layer = new NeuralConv1D(filters, kernel, stride, padding, (Activation)activation);
+    }
+
+    else if (type == "Pool")
+    {
+        size_t pool_height = 0, pool_width = 0, stride = 0;
+        int mode = 0;
+        if (stream >> pool_height >> pool_width >> mode >> stride && pool_height > 0 && pool_width > 0)
+            layer = new NeuralPool(pool_height, pool_width, (NeuralPool::Mode)mode, stride);
+    }
+
+    else if (type == "Dropout")
+    {
+        float rate = 0;
+        int seed = 0;
+        if (stream >> rate >> seed && rate >= 0 && rate < 1)
+            layer = new NeuralDropout(rate, seed);
+    }
+
+    else if (type == "Embedding")
+    {
+        size_t n_rows = 0, dim = 0;
+        int pooling = 0, optimizer = 0;
+        if (stream >> n_rows >> dim >> pooling >> optimizer && n_rows > 0 && dim > 0 && pooling >= NeuralEmbedding::CONCAT && pooling <= NeuralEmbedding::MEAN && optimizer >= NeuralEmbedding::SGD && optimizer <= NeuralEmbedding::ADAGRAD)
+            layer = new NeuralEmbedding(n_rows, dim, (NeuralEmbedding::Pooling)pooling, (NeuralEmbedding::Optimizer)optimizer);
+    }
+
+    else if (type == "LSTM" || type == "GRU")
+    {
+        size_t units = 0, truncation = 0;
+        bool sequences = false;
+        if (stream >> units >> sequences >> truncation && units > 0)
+            layer = type == "LSTM" ? (NeuralLayer *)new NeuralLSTM(units, sequences, truncation) : new NeuralGRU(units, sequences, truncation);
+    }
+
+    if (!layer || activation < LINEAR || activation > RELU)
+    {
+        delete layer;
+        throw std::runtime_error("The stream does not contain a valid layer: " + type);
+    }
+
+    return layer;
+}
+
+// ==================================================
+// NEURALDENSE
+
+NeuralDense::NeuralDense(const size_t &units, const Activation &activation, const bool &bias)
+    : NeuralLayer(activation), m_units(units), m_bias(bias)
+{
+    // Check if the number of neurons is valid
+    if (units == 0)
+        throw std::invalid_argument("The number of neurons must be greater than 0");
+}
+
+NeuralLayer *NeuralDense::clone() const
+{
+    return new NeuralDense(*this);
+}
+
+bool NeuralDense::bias() const
+{
+    return m_bias;
+}
+
+NeuralLayer::Shape NeuralDense::build(const Shape &input, const int &seed)
+{
+    // Check if the input is valid
+    if (input.size() == 0)
+        throw std::invalid_argument("The input of a dense layer must not be empty");
+
+    m_input = input;
+    m_output = Shape(m_units);
+
+    // Initialize the weights, with the bias in the last column
+    const size_t width = input.size() + m_bias;
+    const cmatrix<float> &W = cmatrix<float>::randfloat(m_units, width, -1, 1, seed);
+
+    m_parameters.resize(m_units * width);
+    m_gradients.assign(m_units * width, 0);
+    m_mask.clear();
+    m_compressed = NeuralBlockSparse();
+
+    for (size_t r = 0; r < m_units; r++)
+        for (size_t c = 0; c < width; c++)
+            m_parameters[r * width + c] = W.cell(r, c);
+
+    return m_output;
+}
+
+void NeuralDense::forward(const float *in, float *out, const size_t &batch, const bool &)
+{
+    const size_t K = m_input.size();
+    const size_t ld = K + m_bias;
+
+    // out = in * W^T, skipping the blocks of zeros of the compressed weights
+    if (is_compressed())
+        m_compressed.matmul_transpose(in, batch, out);
+    else
+        __gemm_nt(batch, m_units, K, in, K, m_parameters.data(), ld, out, m_units, false, true);
+
+    // Add the bias and apply the activation while the rows are in the cache
+#pragma omp parallel for schedule(static)
+    for (size_t s = 0; s < batch; s++)
+    {
+        float *z = out + s * m_units;
+
+        if (m_bias)
+            for (size_t u = 0; u < m_units; u++)
+                z[u] += m_parameters[u * ld + K];
+
+        __activate(z, m_units);
+    }
+}
+
+void NeuralDense::backward(const float *in, const float *out, float *d_out, float *d_in, const size_t &batch)
+{
+    const size_t K = m_input.size();
+    const size_t ld = K + m_bias;
+
+    __activate_backward(out, d_out, batch * m_units);
+
+    // dW = d_out^T * in
+    __gemm_tn(m_units, K, batch, d_out, m_units, in, K, m_gradients.data(), ld, false, true);
+
+    // db = sum of d_out over the samples
+    if (m_bias)
+    {
+#pragma omp parallel for schedule(static)
+        for (size_t u = 0; u < m_units; u++)
+        {
+            float sum = 0;
+            for (size_t s = 0; s < batch; s++)
+                sum += d_out[s * m_units + u];
+
+            m_gradients[u * ld + K] = sum;
+        }
+    }
+
+    // d_in = d_out * W
+    if (d_in)
+        __gemm_nn(batch, K, m_units, d_out, m_units, m_parameters.data(), ld, d_in, K, false, true);
+}
+
+void NeuralDense::forward(const NeuralSparse &X, float *out)
+{
+    const size_t K = m_input.size();
+    const size_t ld = K + m_bias;
+
+    // Check if the sparse input has the features of the layer
+    if (X.width() != K)
+        throw std::invalid_argument("The sparse input must have " + std::to_string(K) + " features");
+
+    const std::vector<size_t> &row_ptr = X.row_ptr();
+    const std::vector<size_t> &col_idx = X.col_idx();
+    const std::vector<float> &values = X.values();
+
+    // Each sample only reads the weights of its non-zero features
+#pragma omp parallel for schedule(dynamic, 64)
+    for (size_t s = 0; s < X.height(); s++)
+    {
+        float *z = out + s * m_units;
+
+        for (size_t u = 0; u < m_units; u++)
+        {
+            const float *w = m_parameters.data() + u * ld;
+            float sum = m_bias ? w[K] : 0;
+
+            for (size_t k = row_ptr[s]; k < row_ptr[s + 1]; k++)
+                sum += w[col_idx[k]] * values[k];
+
+            z[u] = sum;
+        }
+
+        __activate(z, m_units);
+    }
+}
+
+void NeuralDense::forward_columns(const NeuralSparse &X, float *out)
+{
+    const size_t K = m_input.size();
+    const size_t ld = K + m_bias;
+    const size_t batch = X.width();
+
+    // Check if the sparse input has the features of the layer
+    if (X.height() != K)
+        throw std::invalid_argument("The sparse input must have " + std::to_string(K) + " features");
+
+    const std::vector<size_t> &row_ptr = X.row_ptr();
+    const std::vector<size_t> &col_idx = X.col_idx();
+    const std::vector<float> &values = X.values();
+
+    // Each thread owns a block of units: the features scatter into the outputs of their samples without race.
+    // The features are summed in increasing order, as in the forward of the samples stored by rows.
+#pragma omp parallel for schedule(static)
+    for (size_t u0 = 0; u0 < m_units; u0 += 16)
+    {
+        const size_t u1 = std::min(u0 + 16, m_units);
+
+        for (size_t s = 0; s < batch; s++)
+            for (size_t u = u0; u < u1; u++)
+                out[s * m_units + u] = m_bias ? m_parameters[u * ld + K] : 0;
+
+        for (size_t k = 0; k < K; k++)
+            for (size_t i = row_ptr[k]; i < row_ptr[k + 1]; i++)
+            {
+                float *z = out + col_idx[i] * m_units;
+                for (size_t u = u0; u < u1; u++)
+                    z[u] += m_parameters[u * ld + k] * values[i];
+            }
+    }
+
+#pragma omp parallel for schedule(static)
+    for (size_t s = 0; s < batch; s++)
+        __activate(out + s * m_units, m_units);
+}
+
+void NeuralDense::update(const NeuralSparse &X, const float *out, float *d_out, const float &learning_rate)
+{
+    const size_t K = m_input.size();
+    const size_t ld = K + m_bias;
+
+    // Check if the sparse input has the features of the layer
+    if (X.height() != K)
+        throw std::invalid_argument("The sparse input must have " + std::to_string(K) + " features");
+
+    const size_t batch = X.width();
+    __activate_backward(out, d_out, batch * m_units);
+
+    const std::vector<size_t> &row_ptr = X.row_ptr();
+    const std::vector<size_t> &col_idx = X.col_idx();
+    const std::vector<float> &values = X.values();
+
+    // W -= learning_rate * d_out^T * X^T: each feature updates its own column, for its non-zero samples only
+#pragma omp parallel for schedule(dynamic, 64)
+    for (size_t k = 0; k < K; k++)
+    {
+        for (size_t i = row_ptr[k]; i < row_ptr[k + 1]; i++)
+        {
+            const float *d = d_out + col_idx[i] * m_units;
+            const float step = learning_rate * values[i];
+
+            for (size_t u = 0; u < m_units; u++)
+                m_parameters[u * ld + k] -= step * d[u];
+        }
+    }
+
+    if (m_bias)
+    {
+#pragma omp parallel for schedule(static)
+        for (size_t u = 0; u < m_units; u++)
+        {
+            float sum = 0;
+            for (size_t s = 0; s < batch; s++)
+                sum += d_out[s * m_units + u];
+
+            m_parameters[u * ld + K] -= learning_rate * sum;
+        }
+    }
+
+    __apply_mask();
+    __parameters_changed();
+}
+
+void NeuralDense::weights_shape(size_t &rows, size_t &columns) const
+{
+    rows = m_units;
+    columns = m_input.size();
+}
+
+void NeuralDense::compress(const size_t &block_height, const size_t &block_width)
+{
+    // Check if the layer is built
+    if (m_parameters.empty())
+        throw std::invalid_argument("The layer must be built before its compression");
+
+    const size_t K = m_input.size();
+    m_compressed = NeuralBlockSparse::from_dense(m_parameters.data(), m_units, K, K + m_bias, block_height, block_width);
+}
+
+bool NeuralDense::is_compressed() const
+{
+    return !m_compressed.is_empty();
+}
+
+const NeuralBlockSparse &NeuralDense::compressed() const
+{
+    return m_compressed;
+}
+
+void NeuralDense::save(std::ostream &stream) const
+{
+    stream << "Dense " << m_units << " " << m_activation << " " << m_bias;
+}
+
+void NeuralDense::save_parameters(std::ostream &stream) const
+{
+    if (!is_compressed())
+        return NeuralLayer::save_parameters(stream);
+
+    // The blocks of weights, then the bias
+    const size_t K = m_input.size();
+    stream << "Compressed\n";
+    m_compressed.save(stream);
+
+    for (size_t u = 0; u < m_units && m_bias; u++)
+        stream << (u ? " " : "") << m_parameters[u * (K + 1) + K];
+}
+
+void NeuralDense::load_parameters(std::istream &stream)
+{
+    const std::istream::pos_type position = stream.tellg();
+    std::string type;
+
+    if (!(stream >> type) || type != "Compressed")
+    {
+        stream.clear();
+        stream.seekg(position);
+        return NeuralLayer::load_parameters(stream);
+    }
+
+    const size_t K = m_input.size();
+    const size_t ld = K + m_bias;
+    NeuralBlockSparse compressed;
+    compressed.load(stream);
+
+    // Check if the blocks match the weights
+    if (compressed.height() != m_units || compressed.width() != K)
+        throw std::runtime_error("The stream does not contain the compressed weights of the layer");
+
+    std::vector<float> parameters(m_parameters.size());
+    compressed.to_dense(parameters.data(), ld);
+
+    for (size_t u = 0; u < m_units && m_bias; u++)
+        stream >> parameters[u * ld + K];
+
+    if (!stream)
+        throw std::runtime_error("The stream does not contain the bias of the layer");
+
+    set_parameters(parameters);
+    m_compressed = compressed;
+}
+
+void NeuralDense::__parameters_changed()
+{
+    m_compressed = NeuralBlockSparse();
+}
+
+// ==================================================
+// NEURALCONV2D
+
+size_t NeuralConv2D::__kernel_size() const
+{
+    return m_input.channels * m_kernel_height * m_kernel_width;
+}
+
+void NeuralConv2D::__im2col(const float *in, float *columns) const
+{
+    const size_t P = m_output.height * m_output.width;
+
+    for (size_t c = 0; c < m_input.channels; c++)
+        for (size_t ky = 0; ky < m_kernel_height; ky++)
+            for (size_t kx = 0; kx < m_kernel_width; kx++)
+            {
+                float *column = columns + ((c * m_kernel_height + ky) * m_kernel_width + kx) * P;
+
+                for (size_t oy = 0; oy < m_output.height; oy++)
+                {
+                    // The padded positions are out of range once shifted, as size_t
+                    const size_t iy = oy * m_stride + ky - m_padding_height;
+
+                    for (size_t ox = 0; ox < m_output.width; ox++)
+                    {
+                        const size_t ix = ox * m_stride + kx - m_padding_width;
+                        const bool inside = iy < m_input.height && ix < m_input.width;
+
+                        column[oy * m_output.width + ox] = inside ? in[(c * m_input.height + iy) * m_input.width + ix] : 0;
+                    }
+                }
+            }
+}
+
+void NeuralConv2D::__col2im(const float *columns, float *d_in) const
+{
+    const size_t P = m_output.height * m_output.width;
+    std::fill(d_in, d_in + m_input.size(), 0.f);
+
+    for (size_t c = 0; c < m_input.channels; c++)
+        for (size_t ky = 0; ky < m_kernel_height; ky++)
+            for (size_t kx = 0; kx < m_kernel_width; kx++)
+            {
+                const float *column = columns + ((c * m_kernel_height + ky) * m_kernel_width + kx) * P;
+
+                for (size_t oy = 0; oy < m_output.height; oy++)
+                {
+                    const size_t iy = oy * m_stride + ky - m_padding_height;
+
+                    for (size_t ox = 0; ox < m_output.width; ox++)
+                    {
+                        const size_t ix = ox * m_stride + kx - m_padding_width;
+
+                        if (iy < m_input.height && ix < m_input.width)
+                            d_in[(c * m_input.height + iy) * m_input.width + ix] += column[oy * m_output.width + ox];
+                    }
+                }
+            }
+}
+
+NeuralConv2D::NeuralConv2D(const size_t &filters, const size_t &kernel_height, const size_t &kernel_width, const size_t &stride, const size_t &padding, const Activation &activation)
+    : NeuralLayer(activation), m_filters(filters), m_kernel_height(kernel_height), m_kernel_width(kernel_width), m_stride(stride), m_padding_height(padding), m_padding_width(padding)
+{
+    // Check if the sizes are valid
+    if (filters == 0 || kernel_height == 0 || kernel_width == 0 || stride == 0)
+        throw std::invalid_argument("The number of filters, the kernel size and the stride must be greater than 0");
+}
+
+NeuralLayer *NeuralConv2D::clone() const
+{
+    return new NeuralConv2D(*this);
+}
+
+NeuralLayer::Shape NeuralConv2D::build(const Shape &input, const int &seed)
+{
+    // Check if the kernel fits in the padded input
+    if (input.size() == 0 || m_kernel_height > input.height + 2 * m_padding_height || m_kernel_width > input.width + 2 * m_padding_width)
+        throw std::invalid_argument("The kernel must fit in the padded input of the convolution");
+
+    m_input = input;
+    m_output = Shape(m_filters, (input.height + 2 * m_padding_height - m_kernel_height) / m_stride + 1, (input.width + 2 * m_padding_width - m_kernel_width) / m_stride + 1);
+
+    // The small kernels are computed directly: the unfolded patches would cost more than the product
+    m_direct = __kernel_size() <= 16;
+
+    // Initialize the weights (Glorot uniform), with the bias in the last column
+    const size_t width = __kernel_size() + 1;
+    const float limit = std::sqrt(6.f / (__kernel_size() + m_filters * m_kernel_height * m_kernel_width));
+    const cmatrix<float> &W = cmatrix<float>::randfloat(m_filters, width, -limit, limit, seed);
+
+    m_parameters.resize(m_filters * width);
+    m_gradients.assign(m_filters * width, 0);
+    m_mask.clear();
+
+    for (size_t r = 0; r < m_filters; r++)
+        for (size_t c = 0; c < width; c++)
+            m_parameters[r * width + c] = c + 1 < width ? W.cell(r, c) : 0;
+
+    return m_output;
+}
+
+void NeuralConv2D::plan(const size_t &batch)
+{
+    m_n_threads = std::max((size_t)1, std::min(batch, __max_threads()));
+
+    // Each thread unfolds its samples in its own buffer and accumulates its own gradients
+    m_columns.assign(m_direct ? 0 : m_n_threads, NeuralBuffer());
+    m_thread_gradients.assign(m_n_threads, NeuralBuffer());
+
+    // The buffers are allocated by their thread, so their pages are placed on its node
+#pragma omp parallel num_threads(m_n_threads)
+    {
+        const size_t t = __thread_index();
+
+        if (t < m_columns.size())
+            m_columns[t].resize(__kernel_size() * m_output.height * m_output.width);
+        if (t < m_thread_gradients.size())
+            m_thread_gradients[t].resize(m_parameters.size());
+    }
+}
+
+void NeuralConv2D::forward(const float *in, float *out, const size_t &batch, const bool &)
+{
+    const size_t K = __kernel_size();
+    const size_t ld = K + 1;
+    const size_t P = m_output.height * m_output.width;
+    const float *W = m_parameters.data();
+
+    if (m_columns.size() < m_n_threads && !m_direct)
+        plan(batch);
+
+#pragma omp parallel for schedule(static) num_threads(m_n_threads)
+    for (size_t s = 0; s < batch; s++)
+    {
+        const float *x = in + s * m_input.size();
+        float *y = out + s * m_output.size();
+
+        if (m_direct)
+        {
+            for (size_t f = 0; f < m_filters; f++)
+                for (size_t oy = 0; oy < m_output.height; oy++)
+                    for (size_t ox = 0; ox < m_output.width; ox++)
+                    {
+                        float z = W[f * ld + K];
+
+                        for (size_t c = 0; c < m_input.channels; c++)
+                            for (size_t ky = 0; ky < m_kernel_height; ky++)
+                            {
+                                const size_t iy = oy * m_stride + ky - m_padding_height;
+                                if (iy >= m_input.height)
+                                    continue;
+
+                                for (size_t kx = 0; kx < m_kernel_width; kx++)
+                                {
+                                    const size_t ix = ox * m_stride + kx - m_padding_width;
+                                    if (ix < m_input.width)
+                                        z += W[f * ld + (c * m_kernel_height + ky) * m_kernel_width + kx] * x[(c * m_input.height + iy) * m_input.width + ix];
+                                }
+                            }
+
+                        y[f * P + oy * m_output.width + ox] = z;
+                    }
+        }
+
+        else
+        {
+            // y = W * im2col(x) + b
+            float *columns = m_columns[__thread_index()].data();
+            __im2col(x, columns);
+            __gemm_nn(m_filters, P, K, W, ld, columns, P, y, P, false, false);
+
+            for (size_t f = 0; f < m_filters; f++)
+                for (size_t p = 0; p < P; p++)
+                    y[f * P + p] += W[f * ld + K];
+        }
+
+        __activate(y, m_output.size());
+    }
+}
+
+void NeuralConv2D::backward(const float *in, const float *out, float *d_out, float *d_in, const size_t &batch)
+{
+    const size_t K = __kernel_size();
+    const size_t ld = K + 1;
+    const size_t P = m_output.height * m_output.width;
+    const float *W = m_parameters.data();
+
+    if (m_thread_gradients.size() < m_n_threads)
+        plan(batch);
+
+    __activate_backward(out, d_out, batch * m_output.size());
+
+    for (NeuralBuffer &gradients : m_thread_gradients)
+        std::fill(gradients.begin(), gradients.end(), 0.f);
+
+#pragma omp parallel for schedule(static) num_threads(m_n_threads)
+    for (size_t s = 0; s < batch; s++)
+    {
+        const float *x = in + s * m_input.size();
+        const float *dz = d_out + s * m_output.size();
+        float *dx = d_in ? d_in + s * m_input.size() : nullptr;
+        float *dW = m_thread_gradients[__thread_index()].data();
+
+        // db = sum of dz over the positions
+        for (size_t f = 0; f < m_filters; f++)
+            for (size_t p = 0; p < P; p++)
+                dW[f * ld + K] += dz[f * P + p];
+
+        if (m_direct)
+        {
+            if (dx)
+                std::fill(dx, dx + m_input.size(), 0.f);
+
+            for (size_t f = 0; f < m_filters; f++)
+                for (size_t oy = 0; oy < m_output.height; oy++)
+                    for (size_t ox = 0; ox < m_output.width; ox++)
+                    {
+                        const float d = dz[f * P + oy * m_output.width + ox];
+                        if (d == 0)
+                            continue;
+
+                        for (size_t c = 0; c < m_input.channels; c++)
+                            for (size_t ky = 0; ky < m_kernel_height; ky++)
+                            {
+                                const size_t iy = oy * m_stride + ky - m_padding_height;
+                                if (iy >= m_input.height)
+                                    continue;
+
+                                for (size_t kx = 0; kx < m_kernel_width; kx++)
+                                {
+                                    const size_t ix = ox * m_stride + kx - m_padding_width;
+                                    if (ix >= m_input.width)
+                                        continue;
+
+                                    const size_t w = f * ld + (c * m_kernel_height + ky) * m_kernel_width + kx;
+                                    const size_t i = (c * m_input.height + iy) * m_input.width + ix;
+
+                                    dW[w] += d * x[i];
+                                    if (dx)
+                                        dx[i] += d * W[w];
+                                }
+                            }
+                    }
+        }
+
+        else
+        {
+            // dW += dz * im2col(x)^T
+            float *columns = m_columns[__thread_index()].data();
+            __im2col(x, columns);
+            __gemm_nt(m_filters, K, P, dz, P, columns, P, dW, ld, true, false);
+
+            // dx = col2im(W^T * dz)
+            if (dx)
+            {
+                __gemm_tn(K, P, m_filters, W, ld, dz, P, columns, P, false, false);
+                __col2im(columns, dx);
+            }
+        }
+    }
+
+    // Sum the gradients of the threads
+#pragma omp parallel for schedule(static)
+    for (size_t i = 0; i < m_gradients.size(); i++)
+    {
+        float sum = 0;
+        for (const NeuralBuffer &gradients : m_thread_gradients)
+            sum += gradients[i];
+
+        m_gradients[i] = sum;
+    }
+}
+
+void NeuralConv2D::weights_shape(size_t &rows, size_t &columns) const
+{
+    rows = m_filters;
+    columns = __kernel_size();
+}
+
+void NeuralConv2D::save(std::ostream &stream) const
+{
+    stream << "Conv2D " << m_filters << " " << m_kernel_height << " " << m_kernel_width << " " << m_stride << " " << m_padding_width << " " << m_activation;
+}
+
+// ==================================================
+// NEURALCONV1D
+
+NeuralConv1D::NeuralConv1D(const size_t &filters, const size_t &kernel, const size_t &stride, const size_t &padding, const Activation &activation)
+    : NeuralConv2D(filters, 1, kernel, stride, padding, activation)
+{
+    // A signal is only padded along its length
+    m_padding_height = 0;
+}
+
+NeuralLayer *NeuralConv1D::clone() const
+{
+    return new NeuralConv1D(*this);
+}
+
+NeuralLayer::Shape NeuralConv1D::build(const Shape &input, const int &seed)
+{
+    // Check if the input is a signal
+    if (input.height != 1)
+        throw std::invalid_argument("The input of a 1D convolution must be of shape (channels, 1, length)");
+
+    return NeuralConv2D::build(input, seed);
+}
+
+void NeuralConv1D::save(std::ostream &stream) const
+{
+    stream << "Conv1D " << m_filters << " " << m_kernel_width << " " << m_stride << " " << m_padding_width << " " << m_activation;
+}
+
+// ==================================================
+// NEURALPOOL
+
+NeuralPool::NeuralPool(const size_t &pool_height, const size_t &pool_width, const Mode &mode, const size_t &stride)
+    : m_mode(mode), m_pool_height(pool_height), m_pool_width(pool_width), m_stride(stride == 0 ? pool_width : stride)
+{
+    // Check if the window is valid
+    if (pool_height == 0 || pool_width == 0)
+        throw std::invalid_argument("The size of the pooling window must be greater than 0");
+}
+
+NeuralLayer *NeuralPool::clone() const
+{
+    return new NeuralPool(*this);
+}
+
+NeuralLayer::Shape NeuralPool::build(const Shape &input, const int &)
+{
+    // Check if the window fits in the input
+    if (input.size() == 0 || m_pool_height > input.height || m_pool_width > input.width)
+        throw std::invalid_argument("The pooling window must fit in the input");
+
+    m_input = input;
+    m_output = Shape(input.channels, (input.height - m_pool_height) / m_stride + 1, (input.width - m_pool_width) / m_stride + 1);
+
+    return m_output;
+}
+
+void NeuralPool::plan(const size_t &batch)
+{
+    m_argmax.assign(m_mode == MAX ? batch * m_output.size() : 0, 0);
+}
+
+void NeuralPool::forward(const float *in, float *out, const size_t &batch, const bool &)
+{
+    if (m_mode == MAX && m_argmax.size() < batch * m_output.size())
+        plan(batch);
+
+    const float area = m_pool_height * m_pool_width;
+
+#pragma omp parallel for schedule(static)
+    for (size_t s = 0; s < batch; s++)
+    {
+        const float *x = in + s * m_input.size();
+
+        for (size_t c = 0; c < m_output.channels; c++)
+            for (size_t oy = 0; oy < m_output.height; oy++)
+                for (size_t ox = 0; ox < m_output.width; ox++)
+                {
+                    const size_t o = (c * m_output.height + oy) * m_output.width + ox;
+                    float best = -std::numeric_limits<float>::infinity();
+                    float sum = 0;
+                    size_t argmax = 0;
+
+                    for (size_t ky = 0; ky < m_pool_height; ky++)
+                        for (size_t kx = 0; kx < m_pool_width; kx++)
+                        {
+                            const size_t i = (c * m_input.height + oy * m_stride + ky) * m_input.width + ox * m_stride + kx;
+                            sum += x[i];
+
+                            if (x[i] > best)
+                            {
+                                best = x[i];
+                                argmax = i;
+                            }
+                        }
+
+                    if (m_mode == MAX)
+                    {
+                        out[s * m_output.size() + o] = best;
+                        m_argmax[s * m_output.size() + o] = argmax;
+                    }
+
+                    else
+                        out[s * m_output.size() + o] = sum / area;
+                }
+    }
+}
+
+void NeuralPool::backward(const float *, const float *, float *d_out, float *d_in, const size_t &batch)
+{
+    if (!d_in)
+        return;
+
+    const float area = m_pool_height * m_pool_width;
+
+#pragma omp parallel for schedule(static)
+    for (size_t s = 0; s < batch; s++)
+    {
+        float *dx = d_in + s * m_input.size();
+        const float *dz = d_out + s * m_output.size();
+        std::fill(dx, dx + m_input.size(), 0.f);
+
+        // The maximum receives the whole gradient, the average spreads it over the window
+        if (m_mode == MAX)
+            for (size_t o = 0; o < m_output.size(); o++)
+                dx[m_argmax[s * m_output.size() + o]] += dz[o];
+
+        else
+            for (size_t c = 0; c < m_output.channels; c++)
+                for (size_t oy = 0; oy < m_output.height; oy++)
+                    for (size_t ox = 0; ox < m_output.width; ox++)
+                    {
+                        const float d = dz[(c * m_output.height + oy) * m_output.width + ox] / area;
+
+                        for (size_t ky = 0; ky < m_pool_height; ky++)
+                            for (size_t kx = 0; kx < m_pool_width; kx++)
+                                dx[(c * m_input.height + oy * m_stride + ky) * m_input.width + ox * m_stride + kx] += d;
+                    }
+    }
+}
+
+void NeuralPool::save(std::ostream &stream) const
+{
+    stream << "Pool " << m_pool_height << " " << m_pool_width << " " << m_mode << " " << m_stride;
+}
+
+// ==================================================
+// NEURALDROPOUT
+
+NeuralDropout::NeuralDropout(const float &rate, const int &seed) : m_rate(rate), m_seed(seed)
+{
+    // Check if the rate is valid
+    if (rate < 0 || rate >= 1)
+        throw std::invalid_argument("The dropout rate must be in [0, 1[");
+}
+
+NeuralLayer *NeuralDropout::clone() const
+{
+    return new NeuralDropout(*this);
+}
+
+NeuralLayer::Shape NeuralDropout::build(const Shape &input, const int &)
+{
+    m_input = input;
+    m_output = input;
+
+    return m_output;
+}
+
+void NeuralDropout::plan(const size_t &batch)
+{
+    m_mask.assign(batch * m_input.size(), 0);
+}
+
+void NeuralDropout::forward(const float *in, float *out, const size_t &batch, const bool &training)
+{
+    const size_t size = m_input.size();
+
+    if (!training || m_rate == 0)
+    {
+        std::copy(in, in + batch * size, out);
+        return;
+    }
+
+    if (m_mask.size() < batch * size)
+        plan(batch);
+
+    // A value is kept if its 16 bits random lane is above the threshold
+    const uint32_t threshold = (uint32_t)(m_rate * 65536);
+    const float scale = 1 / (1 - m_rate);
+    const uint64_t step = ++m_step;
+
+#pragma omp parallel for schedule(static)
+    for (size_t s = 0; s < batch; s++)
+    {
+        // Seed the generator of the sample (splitmix64), then draw 4 lanes per 64 bits (xorshift64*)
+        uint64_t state = m_seed + 0x9E3779B97F4A7C15ULL * (step * 0x100000001B3ULL + s + 1);
+        state = (state ^ (state >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        state = (state ^ (state >> 27)) * 0x94D049BB133111EBULL;
+        state ^= state >> 31;
+        state |= 1;
+
+        const float *x = in + s * size;
+        float *y = out + s * size;
+        uint8_t *mask = m_mask.data() + s * size;
+        uint64_t random = 0;
+
+        for (size_t i = 0; i < size; i++)
+        {
+            if (i % 4 == 0)
+            {
+                state ^= state >> 12;
+                state ^= state << 25;
+                state ^= state >> 27;
+                random = state * 0x2545F4914F6CDD1DULL;
+            }
+
+            mask[i] = ((random >> (16 * (i % 4))) & 0xFFFF) >= threshold;
+            y[i] = mask[i] ? x[i] * scale : 0;
+        }
+    }
+}
+
+void NeuralDropout::backward(const float *, const float *, float *d_out, float *d_in, const size_t &batch)
+{
+    if (!d_in)
+        return;
+
+    const size_t n = batch * m_input.size();
+    const float scale = 1 / (1 - m_rate);
+
+    if (m_rate == 0)
+    {
+        std::copy(d_out, d_out + n, d_in);
+        return;
+    }
+
+    // The values dropped in the last forward have no gradient
+#pragma omp parallel for schedule(static)
+    for (size_t i = 0; i < n; i++)
+        d_in[i] = m_mask[i] ? d_out[i] * scale : 0;
+}
+
+void NeuralDropout::save(std::ostream &stream) const
+{
+    stream << "Dropout " << m_rate << " " << m_seed;
+}
+
+// ==================================================
+// NEURALEMBEDDING
+
+long NeuralEmbedding::__row(const float &id) const
+{
+    return id < 0 ? -1 : (long)id;
+}
+
+NeuralEmbedding::NeuralEmbedding(const size_t &n_rows, const size_t &dim, const Pooling &pooling, const Optimizer &optimizer)
+    : NeuralLayer(LINEAR), m_n_rows(n_rows), m_dim(dim), m_pooling(pooling), m_optimizer(optimizer)
+{
+    if (n_rows == 0 || dim == 0)
+        throw std::invalid_argument("The number of rows and the size of a row of an embedding must be positive");
+
+    // The IDs are floats: the integers above 2^24 are not exact
+    if (n_rows > (1 << 24))
+        throw std::invalid_argument("The number of rows of an embedding must be at most 2^24");
+}
+
+NeuralLayer *NeuralEmbedding::clone() const
+{
+    return new NeuralEmbedding(*this);
+}
+
+const std::vector<uint32_t> &NeuralEmbedding::touched() const
+{
+    return m_touched;
+}
+
+NeuralLayer::Shape NeuralEmbedding::build(const Shape &input, const int &seed)
+{
+    // Check if the input is valid
+    if (input.size() == 0)
+        throw std::invalid_argument("The input of an embedding layer must not be empty");
+
+    m_input = input;
+    m_output = Shape(m_pooling == CONCAT ? input.size() * m_dim : m_dim);
+
+    // Initialize the rows directly in the table, which may be too large to be copied
+    std::mt19937 generator(seed);
+    std::uniform_real_distribution<float> distribution(-1, 1);
+
+    m_parameters.resize(m_n_rows * m_dim);
+    for (float &parameter : m_parameters)
+        parameter = distribution(generator);
+
+    m_gradients.clear();
+    m_mask.clear();
+    m_slots.assign(m_n_rows, -1);
+    m_touched.clear();
+    m_row_gradients.clear();
+    m_accumulators.assign(m_optimizer == ADAGRAD ? m_n_rows : 0, 0);
+
+    return m_output;
+}
+
+void NeuralEmbedding::forward(const float *in, float *out, const size_t &batch, const bool &)
+{
+    const size_t n_ids = m_input.size();
+    const size_t size = m_output.size();
+
+    // Check if the IDs are rows of the table
+    for (size_t i = 0; i < batch * n_ids; i++)
+        if (in[i] >= 0 && (in[i] >= m_n_rows || in[i] != std::floor(in[i])))
+            throw std::invalid_argument("The ID " + std::to_string(in[i]) + " must be an integer of [0, " + std::to_string(m_n_rows) + "[ or a negative value");
+
+    // Gather the rows of each sample
+#pragma omp parallel for schedule(static)
+    for (size_t s = 0; s < batch; s++)
+    {
+        const float *ids = in + s * n_ids;
+        float *y = out + s * size;
+        size_t count = 0;
+
+        std::fill(y, y + size, 0);
+        for (size_t f = 0; f < n_ids; f++)
+        {
+            const long row = __row(ids[f]);
+            if (row < 0)
+                continue;
+
+            const float *w = m_parameters.data() + row * m_dim;
+            float *z = m_pooling == CONCAT ? y + f * m_dim : y;
+            count++;
+
+            for (size_t d = 0; d < m_dim; d++)
+                z[d] += w[d];
+        }
+
+        if (m_pooling == MEAN && count > 1)
+            for (size_t d = 0; d < m_dim; d++)
+                y[d] /= count;
+    }
+}
+
+void NeuralEmbedding::backward(const float *in, const float *, float *d_out, float *d_in, const size_t &batch)
+{
+    const size_t n_ids = m_input.size();
+    const size_t size = m_output.size();
+
+    // The IDs have no gradient
+    if (d_in)
+        std::fill(d_in, d_in + batch * n_ids, 0);
+
+    // Give a slot to each row of the batch. Only the rows of the last backward are reset, not the whole table
+    for (const uint32_t &row : m_touched)
+        m_slots[row] = -1;
+    m_touched.clear();
+
+    // Group the IDs of the batch by slot (counting sort), so each slot is accumulated by one thread without lock
+    m_offsets.assign(1, 0);
+    for (size_t i = 0; i < batch * n_ids; i++)
+    {
+        const long row = __row(in[i]);
+        if (row < 0)
+            continue;
+
+        if (m_slots[row] < 0)
+        {
+            m_slots[row] = m_touched.size();
+            m_touched.push_back(row);
+            m_offsets.push_back(0);
+        }
+
+        m_offsets[m_slots[row] + 1]++;
+    }
+
+    const size_t n_touched = m_touched.size();
+    for (size_t slot = 0; slot < n_touched; slot++)
+        m_offsets[slot + 1] += m_offsets[slot];
+
+    m_occurrences.resize(m_offsets[n_touched]);
+    std::vector<size_t> next(m_offsets.begin(), m_offsets.end() - 1);
+    for (size_t i = 0; i < batch * n_ids; i++)
+        if (in[i] >= 0)
+            m_occurrences[next[m_slots[__row(in[i])]]++] = i;
+
+    // The scale of the gradient of each sample: 1 / the number of its IDs for the mean
+    m_scales.assign(batch, 1);
+    if (m_pooling == MEAN)
+    {
+#pragma omp parallel for schedule(static)
+        for (size_t s = 0; s < batch; s++)
+        {
+            const size_t count = std::count_if(in + s * n_ids, in + (s + 1) * n_ids, [](const float &id)
+                                               { return id >= 0; });
+            m_scales[s] = count > 1 ? 1.f / count : 1.f;
+        }
+    }
+
+    m_row_gradients.assign(n_touched * m_dim, 0);
+
+    // Gather the gradients of the samples of each slot. A frequent ID has many occurrences: the slots are scheduled dynamically
+#pragma omp parallel for schedule(dynamic, 64)
+    for (size_t slot = 0; slot < n_touched; slot++)
+    {
+        float *dw = m_row_gradients.data() + slot * m_dim;
+
+        for (size_t k = m_offsets[slot]; k < m_offsets[slot + 1]; k++)
+        {
+            const size_t s = m_occurrences[k] / n_ids, f = m_occurrences[k] % n_ids;
+            const float *g = d_out + s * size;
+            const float *z = m_pooling == CONCAT ? g + f * m_dim : g;
+            const float scale = m_scales[s];
+
+            for (size_t d = 0; d < m_dim; d++)
+                dw[d] += scale * z[d];
+        }
+    }
+}
+
+void NeuralEmbedding::update(const float &learning_rate)
+{
+    const size_t n_touched = m_touched.size();
+
+    // Each touched row is updated by one thread: no lock is needed
+#pragma omp parallel for schedule(static) if (n_touched * m_dim > 4096)
+    for (size_t slot = 0; slot < n_touched; slot++)
+    {
+        const uint32_t row = m_touched[slot];
+        const float *dw = m_row_gradients.data() + slot * m_dim;
+        float *w = m_parameters.data() + row * m_dim;
+        float rate = learning_rate;
+
+        // Row-wise Adagrad: the state of a row is the sum of its mean squared gradients
+        if (m_optimizer == ADAGRAD)
+        {
+            float squares = 0;
+            for (size_t d = 0; d < m_dim; d++)
+                squares += dw[d] * dw[d];
+
+            m_accumulators[row] += squares / m_dim;
+            rate = learning_rate / (std::sqrt(m_accumulators[row]) + 1e-8f);
+        }
+
+        for (size_t d = 0; d < m_dim; d++)
+            w[d] -= rate * dw[d];
+    }
+
+    __parameters_changed();
+}
+
+void NeuralEmbedding::save(std::ostream &stream) const
+{
+    stream << "Embedding " << m_n_rows << " " << m_dim << " " << m_pooling << " " << m_optimizer;
+}
+
+// ==================================================
+// NEURALRECURRENT
+
+/**
+ * @brief The sigmoid of the gates.
+ */
+static inline float sigmoid(const float &x)
+{
+    return 1 / (1 + std::exp(-x));
+}
+
+size_t NeuralRecurrent::__n_gates() const
+{
+    return m_cell == LSTM ? 4 : 3;
+}
+
+void NeuralRecurrent::__step(const size_t &t, float *out)
+{
+    const size_t B = m_batch, H = m_units, F = m_features, T = m_length, W = m_window;
+    const size_t GH = __n_gates() * H;
+    const size_t ld = F + H + (m_cell == GRU ? 2 : 1);
+
+    const float *hp = m_states.data() + (t % (W + 1)) * B * H;
+    float *h = m_states.data() + ((t + 1) % (W + 1)) * B * H;
+    float *gates = m_gates.data() + (t % W) * B * GH;
+    float *recurrent = m_recurrent.data() + (m_cell == GRU ? (t % W) * B * GH : 0);
+    const float *b = m_biases.data();
+
+    // The recurrent projections of all the gates in one product: added to the input projections (LSTM), or kept apart (GRU)
+    if (m_cell == LSTM)
+        __gemm_nt(B, GH, H, hp, H, m_parameters.data() + F, ld, gates, GH, true, true);
+    else
+        __gemm_nt(B, GH, H, hp, H, m_parameters.data() + F, ld, recurrent, GH, false, true);
+
+    // The nonlinearities of the gates and the update of the state, fused. The activated gates replace their projections
+#pragma omp parallel for schedule(static)
+    for (size_t s = 0; s < B; s++)
+    {
+        float *g = gates + s * GH;
+        const float *hps = hp + s * H;
+        float *hs = h + s * H;
+
+        if (m_cell == LSTM)
+        {
+            const float *cp = m_cells.data() + (t % (W + 1)) * B * H + s * H;
+            float *c = m_cells.data() + ((t + 1) % (W + 1)) * B * H + s * H;
+
+#pragma omp simd
+            for (size_t u = 0; u < H; u++)
+            {
+                const float i = sigmoid(g[u] + b[u]);
+                const float f = sigmoid(g[H + u] + b[H + u]);
+                const float z = std::tanh(g[2 * H + u] + b[2 * H + u]);
+                const float o = sigmoid(g[3 * H + u] + b[3 * H + u]);
+
+                g[u] = i;
+                g[H + u] = f;
+                g[2 * H + u] = z;
+                g[3 * H + u] = o;
+                c[u] = f * cp[u] + i * z;
+                hs[u] = o * std::tanh(c[u]);
+            }
+        }
+
+        else
+        {
+            float *q = recurrent + s * GH;
+
+#pragma omp simd
+            for (size_t u = 0; u < H; u++)
+            {
+                const float z = sigmoid(g[u] + b[u] + q[u] + b[GH + u]);
+                const float r = sigmoid(g[H + u] + b[H + u] + q[H + u] + b[GH + H + u]);
+                const float hn = q[2 * H + u] + b[GH + 2 * H + u];
+                const float n = std::tanh(g[2 * H + u] + b[2 * H + u] + r * hn);
+
+                g[u] = z;
+                g[H + u] = r;
+                g[2 * H + u] = n;
+                q[2 * H + u] = hn;
+                hs[u] = (1 - z) * n + z * hps[u];
+            }
+        }
+
+        if (m_sequences)
+            for (size_t u = 0; u < H; u++)
+                out[s * H * T + u * T + t] = hs[u];
+    }
+}
+
+void NeuralRecurrent::__step_backward(const size_t &t, const float *d_out)
+{
+    const size_t B = m_batch, H = m_units, F = m_features, T = m_length, W = m_window;
+    const size_t GH = __n_gates() * H;
+    const size_t ld = F + H + (m_cell == GRU ? 2 : 1);
+
+    const float *hp = m_states.data() + (t % (W + 1)) * B * H;
+    const float *gates = m_gates.data() + (t % W) * B * GH;
+    float *dP = m_deltas.data() + (t % W) * B * GH;
+    float *dR = m_cell == GRU ? m_recurrent_deltas.data() + (t % W) * B * GH : dP;
+
+    // The previous states of the window are gathered for the product of the recurrent weights
+    std::copy(hp, hp + B * H, m_previous.data() + (t % W) * B * H);
+
+#pragma omp parallel for schedule(static)
+    for (size_t s = 0; s < B; s++)
+    {
+        const float *g = gates + s * GH;
+        const float *hps = hp + s * H;
+        float *dp = dP + s * GH;
+        float *dr = dR + s * GH;
+        float *dh_next = m_d_state.data() + s * H;
+
+        for (size_t u = 0; u < H; u++)
+        {
+            // The gradient of the state: from the next step, and from the output
+            float dh = dh_next[u];
+            if (m_sequences)
+                dh += d_out[s * H * T + u * T + t];
+            else if (t == T - 1)
+                dh += d_out[s * H + u];
+
+            if (m_cell == LSTM)
+            {
+                const float i = g[u], f = g[H + u], z = g[2 * H + u], o = g[3 * H + u];
+                const float cp = m_cells[(t % (W + 1)) * B * H + s * H + u];
+                const float tc = std::tanh(m_cells[((t + 1) % (W + 1)) * B * H + s * H + u]);
+                const float dc = m_d_cell[s * H + u] + dh * o * (1 - tc * tc);
+
+                dp[u] = dc * z * i * (1 - i);
+                dp[H + u] = dc * cp * f * (1 - f);
+                dp[2 * H + u] = dc * i * (1 - z * z);
+                dp[3 * H + u] = dh * tc * o * (1 - o);
+                m_d_cell[s * H + u] = dc * f;
+                dh_next[u] = 0;
+            }
+
+            else
+            {
+                const float z = g[u], r = g[H + u], n = g[2 * H + u];
+                const float hn = m_recurrent[(t % W) * B * GH + s * GH + 2 * H + u];
+                const float dn = dh * (1 - z) * (1 - n * n);
+
+                dp[u] = dh * (hps[u] - n) * z * (1 - z);
+                dp[H + u] = dn * hn * r * (1 - r);
+                dp[2 * H + u] = dn;
+                dr[u] = dp[u];
+                dr[H + u] = dp[H + u];
+                dr[2 * H + u] = dn * r;
+                dh_next[u] = dh * z;
+            }
+        }
+    }
+
+    // The gradient of the previous state through the recurrent projections, in one product
+    __gemm_nn(B, H, GH, dR, GH, m_parameters.data() + F, ld, m_d_state.data(), H, true, true);
+}
+
+NeuralRecurrent::NeuralRecurrent(const Cell &cell, const size_t &units, const bool &sequences, const size_t &truncation)
+    : NeuralLayer(LINEAR), m_cell(cell), m_units(units), m_sequences(sequences), m_truncation(truncation)
+{
+    if (units == 0)
+        throw std::invalid_argument("The number of units of a recurrent layer must be positive");
+
+    // The gradients of the outputs before the window would be dropped by the truncated backward
+    if (sequences && truncation)
+        throw std::invalid_argument("The truncation of a recurrent layer must be 0 if the sequence is returned");
+}
+
+NeuralLayer *NeuralRecurrent::clone() const
+{
+    return new NeuralRecurrent(*this);
+}
+
+NeuralLayer::Shape NeuralRecurrent::build(const Shape &input, const int &seed)
+{
+    // Check if the input is a sequence
+    if (input.size() == 0 || input.height != 1)
+        throw std::invalid_argument("The input of a recurrent layer must be a sequence of shape (features, 1, length)");
+
+    m_input = input;
+    m_features = input.channels;
+    m_length = input.width;
+    m_window = m_truncation ? std::min(m_truncation, m_length) : m_length;
+    m_output = m_sequences ? Shape(m_units, 1, m_length) : Shape(m_units);
+    m_batch = 0;
+
+    // Initialize the weights in [-1/sqrt(units), 1/sqrt(units)]
+    const size_t ld = m_features + m_units + (m_cell == GRU ? 2 : 1);
+    const float bound = 1 / std::sqrt((float)m_units);
+    std::mt19937 generator(seed);
+    std::uniform_real_distribution<float> distribution(-bound, bound);
+
+    m_parameters.resize(__n_gates() * m_units * ld);
+    for (float &parameter : m_parameters)
+        parameter = distribution(generator);
+
+    m_gradients.assign(m_parameters.size(), 0);
+    m_mask.clear();
+
+    return m_output;
+}
+
+void NeuralRecurrent::plan(const size_t &batch)
+{
+    const size_t B = batch, H = m_units, F = m_features, W = m_window;
+    const size_t GH = __n_gates() * H;
+    const bool gru = m_cell == GRU;
+
+    m_batch = batch;
+    m_biases.assign(gru ? 2 * GH : GH, 0);
+    m_inputs.assign(W * B * F, 0);
+    m_gates.assign(W * B * GH, 0);
+    m_recurrent.assign(gru ? W * B * GH : 0, 0);
+    m_states.assign((W + 1) * B * H, 0);
+    m_cells.assign(gru ? 0 : (W + 1) * B * H, 0);
+
+    m_deltas.assign(W * B * GH, 0);
+    m_recurrent_deltas.assign(gru ? W * B * GH : 0, 0);
+    m_previous.assign(W * B * H, 0);
+    m_d_state.assign(B * H, 0);
+    m_d_cell.assign(gru ? 0 : B * H, 0);
+    m_d_inputs.assign(W * B * F, 0);
+}
+
+void NeuralRecurrent::forward(const float *in, float *out, const size_t &batch, const bool &)
+{
+    if (batch != m_batch)
+        plan(batch);
+
+    const size_t H = m_units, F = m_features, T = m_length, W = m_window;
+    const size_t GH = __n_gates() * H;
+    const size_t ld = F + H + (m_cell == GRU ? 2 : 1);
+
+    // Gather the biases, so the kernel of the gates reads them contiguously
+    for (size_t k = 0; k < GH; k++)
+    {
+        m_biases[k] = m_parameters[k * ld + F + H];
+        if (m_cell == GRU)
+            m_biases[GH + k] = m_parameters[k * ld + F + H + 1];
+    }
+
+    // The initial state is 0
+    std::fill(m_states.begin(), m_states.begin() + batch * H, 0.f);
+    if (m_cell == LSTM)
+        std::fill(m_cells.begin(), m_cells.begin() + batch * H, 0.f);
+
+    for (size_t t0 = 0; t0 < T; t0 += W)
+    {
+        const size_t length = std::min(W, T - t0);
+
+        // The time steps of the window, one after the other, in the slots 0 to length - 1
+#pragma omp parallel for schedule(static)
+        for (size_t s = 0; s < batch; s++)
+            for (size_t r = 0; r < length; r++)
+                for (size_t f = 0; f < F; f++)
+                    m_inputs[(r * batch + s) * F + f] = in[s * F * T + f * T + t0 + r];
+
+        // The input projections of all the gates of all the time steps of the window in one product
+        __gemm_nt(length * batch, GH, F, m_inputs.data(), F, m_parameters.data(), ld, m_gates.data(), GH, false, true);
+
+        for (size_t t = t0; t < t0 + length; t++)
+            __step(t, out);
+    }
+
+    if (!m_sequences)
+    {
+        const float *h = m_states.data() + (T % (W + 1)) * batch * H;
+        std::copy(h, h + batch * H, out);
+    }
+}
+
+void NeuralRecurrent::backward(const float *, const float *, float *d_out, float *d_in, const size_t &batch)
+{
+    const size_t H = m_units, F = m_features, T = m_length, W = m_window;
+    const size_t GH = __n_gates() * H;
+    const size_t ld = F + H + (m_cell == GRU ? 2 : 1);
+    const float *dR = m_cell == GRU ? m_recurrent_deltas.data() : m_deltas.data();
+
+    // Backpropagation through the time steps of the window, from the last one
+    std::fill(m_d_state.begin(), m_d_state.end(), 0.f);
+    std::fill(m_d_cell.begin(), m_d_cell.end(), 0.f);
+
+    for (size_t t = T; t-- > T - W;)
+        __step_backward(t, d_out);
+
+    // The gradients of the weights, summed over the window in one product each
+    const size_t rows = W * batch;
+    __gemm_tn(GH, F, rows, m_deltas.data(), GH, m_inputs.data(), F, m_gradients.data(), ld, false, true);
+    __gemm_tn(GH, H, rows, dR, GH, m_previous.data(), H, m_gradients.data() + F, ld, false, true);
+
+#pragma omp parallel for schedule(static)
+    for (size_t k = 0; k < GH; k++)
+    {
+        float db = 0, dc = 0;
+        for (size_t i = 0; i < rows; i++)
+        {
+            db += m_deltas[i * GH + k];
+            dc += dR[i * GH + k];
+        }
+
+        m_gradients[k * ld + F + H] = db;
+        if (m_cell == GRU)
+            m_gradients[k * ld + F + H + 1] = dc;
+    }
+
+    if (!d_in)
+        return;
+
+    // The gradient of the input of the window, in one product. The time steps before the window have no gradient
+    __gemm_nn(rows, F, GH, m_deltas.data(), GH, m_parameters.data(), ld, m_d_inputs.data(), F, false, true);
+    std::fill(d_in, d_in + batch * F * T, 0.f);
+
+#pragma omp parallel for schedule(static)
+    for (size_t s = 0; s < batch; s++)
+        for (size_t t = T - W; t < T; t++)
+            for (size_t f = 0; f < F; f++)
+                d_in[s * F * T + f * T + t] = m_d_inputs[((t % W) * batch + s) * F + f];
+}
+
+void NeuralRecurrent::weights_shape(size_t &rows, size_t &columns) const
+{
+    rows = __n_gates() * m_units;
+    columns = m_features + m_units;
+}
+
+void NeuralRecurrent::save(std::ostream &stream) const
+{
+    stream << (m_cell == LSTM ? "LSTM " : "GRU ") << m_units << " " << m_sequences << " " << m_truncation;
+}
+
+NeuralLSTM::NeuralLSTM(const size_t &units, const bool &sequences, const size_t &truncation)
+    : NeuralRecurrent(LSTM, units, sequences, truncation) {}
+
+NeuralLayer *NeuralLSTM::clone() const
+{
+    return new NeuralLSTM(*this);
+}
+
+NeuralGRU::NeuralGRU(const size_t &units, const bool &sequences, const size_t &truncation)
+    : NeuralRecurrent(GRU, units, sequences, truncation) {}
+
+NeuralLayer *NeuralGRU::clone() const
+{
+    return new NeuralGRU(*this);
+}
@@ -12,23 +12,36 @@
 
 // INCLUDES
 #include "../include/NeuralLayers.hpp"
+#include "../include/NeuralTuner.hpp"
+
+#include <cmath>
+#include <fstream>
 
 // ==================================================
 // PRIVATE METHODS
 
-void NeuralLayers::__init_weights(const int &n_features, std::vector<int> &layers_dims, const int &n_output)
+void NeuralLayers::__init_weights(const size_t &n_features, const size_t &n_output)
 {
-    // Check if the layers_dims vector is empty
-    if (layers_dims.size() == 0)
-        throw std::invalid_argument("The layers_dims vector must not be empty");
+    if (!m_custom_graph)
+    {
+        // Check if the layers_dims vector is empty
+        if (m_layers_dims.size() == 0)
+            throw std::invalid_argument("The layers_dims vector must not be empty");
+
+        // The hidden layers, with the bias on the first one, then the output layer
+        m_graph = NeuralGraph();
+        for (size_t i = 0; i < m_layers_dims.size(); i++)
+            m_graph.add(NeuralDense(m_layers_dims[i], NeuralLayer::SIGMOID, i == 0));
 
-    // Insert the number of features and the number of outputs in the layers_dims vector
-    layers_dims.insert(layers_dims.begin(), n_features);
-    layers_dims.push_back(n_output);
+        m_graph.add(NeuralDense(n_output, NeuralLayer::SIGMOID, false));
+    }
 
     // Initialize the weights
-    for (int i = 1; i < layers_dims.size(); i++)
-        m_weights["W" + std::to_string(i)] = cmatrix<float>::randfloat(layers_dims[i], layers_dims[i - 1], -1, 1, i);
+    m_graph.build(n_features);
+
+    // Check if the output of the graph matches y
+    if (m_graph.output_size() != n_output)
+        throw std::invalid_argument("The output of the graph must have " + std::to_string(n_output) + " values");
 }
 
 bool NeuralLayers::__valid_layers_dims(const std::vector<int> &layers_dims) const
@@ -41,86 +54,267 @@ bool NeuralLayers::__valid_layers_dims(const std::vector<int> &layers_dims) cons
     return layers_dims.size() > 1;
 }
 
-cmatrix<float> NeuralLayers::__sigmoid(const cmatrix<float> &Z) const
+NeuralDense &NeuralLayers::__sparse_input_layer()
 {
-    return Z.map([](float x)
-                 { return 1 / (1 + std::exp(-x)); });
+    // Centering would make the input dense
+    if (!m_scaler.is_identity())
+        throw std::invalid_argument("The sparse input cannot be used with a scaler");
+
+    // The sparse-dense product is only implemented by the dense layer
+    NeuralDense *layer = dynamic_cast<NeuralDense *>(&m_graph.layer(0));
+    if (!layer)
+        throw std::invalid_argument("The sparse input requires a dense first layer");
+
+    return *layer;
 }
 
-void NeuralLayers::__forward_propagation(const cmatrix<float> &X)
+std::vector<float> NeuralLayers::__gather_targets(const cmatrix<float> &y, const std::vector<size_t> *indices) const
 {
-    // Initialize the activation for the first layer with the augmented X matrix.
-    // Augmented X is the X matrix with a row of ones for the bias.
-    m_activations["A0"] = cmatrix<float>::merge(X, cmatrix<float>(1, X.width(), 1), 0);
+    const size_t n_samples = indices ? indices->size() : y.width();
+    const size_t n_outputs = y.height();
+    std::vector<float> targets(n_samples * n_outputs);
 
-    // Compute the activation for each layer
-    for (int i = 1; i <= m_weights.size(); i++)
+    for (size_t k = 0; k < n_samples; k++)
     {
-        const std::string &dim_str = std::to_string(i);
+        const size_t j = indices ? (*indices)[k] : k;
 
-        // Get the parameters W and the activation A required for the current layer
-        const cmatrix<float> &W = m_weights.at("W" + dim_str);
-        const cmatrix<float> &A_prev = m_activations.at("A" + std::to_string(i - 1));
+        // Check if the index is in range
+        if (j >= y.width())
+            throw std::invalid_argument("The sample index " + std::to_string(j) + " is out of range");
 
-        // Compute the activation for the current layer
-        const cmatrix<float> &Z = W.matmul(A_prev);
-        const cmatrix<float> &A_current = __sigmoid(Z);
-
-        // Store the activation for the current layer
-        m_activations["A" + dim_str] = A_current;
+        for (size_t r = 0; r < n_outputs; r++)
+            targets[k * n_outputs + r] = y.cell(r, j);
     }
+
+    return targets;
+}
+
+void NeuralLayers::__forward_propagation(const cmatrix<float> &X, const bool &training)
+{
+    // Scale X directly in the input buffer of the graph
+    m_graph.plan(X.width());
+    m_scaler.transform(X, m_graph.activation(0));
+
+    // Compute the activation for each layer
+    m_graph.forward(training);
+}
+
+void NeuralLayers::__forward_propagation(const NeuralSparse &X, const bool &training)
+{
+    // The sparse input is never copied in the graph: the first layer reads it directly
+    NeuralDense &input = __sparse_input_layer();
+    m_graph.plan(X.height(), 1);
+
+    // Compute the activation for the first layer with a sparse-dense product
+    input.forward(X, m_graph.activation(1));
+
+    // Compute the activation for the other layers
+    m_graph.forward(training, 1);
+}
+
+void NeuralLayers::__forward_propagation(const cmatrix<float> &X, const std::vector<size_t> &indices, const bool &training)
+{
+    // Gather and scale the selected samples directly in the input buffer of the graph
+    m_graph.plan(indices.size());
+    m_scaler.transform(X, indices, m_graph.activation(0));
+
+    // Compute the activation for each layer
+    m_graph.forward(training);
+}
+
+void NeuralLayers::__back_propagation(const std::vector<float> &y)
+{
+    m_graph.backward(y);
+}
+
+void NeuralLayers::__gradient_descent(const float &learning_rate)
+{
+    m_graph.update(learning_rate);
+}
+
+cmatrix<float> NeuralLayers::__probabilities()
+{
+    const size_t n_samples = m_graph.batch();
+    const size_t n_outputs = m_graph.output_size();
+    const float *output = m_graph.activation(m_graph.size());
+
+    // The graph stores the samples one after the other
+    cmatrix<float> y_pred(n_outputs, n_samples, 0);
+    for (size_t k = 0; k < n_samples; k++)
+        for (size_t r = 0; r < n_outputs; r++)
+            y_pred.cell(r, k) = output[k * n_outputs + r];
+
+    return y_pred;
+}
+
+cmatrix<cbool> NeuralLayers::__output()
+{
+    return __probabilities() > 0.5;
+}
+
+bool NeuralLayers::__log_accuracy(const int &epoch, const cmatrix<cbool> &y_pred, const cmatrix<cbool> &y_true)
+{
+    const cmatrix<float> &y_correct = cmatrix<float>(y_pred.eq(y_true));
+
+    // Compute the accuracy
+    const float accuracy = y_correct.sum_all() / y_pred.width_t<float>();
+    std::cout << epoch << ". Accuracy: " << accuracy << std::endl;
+
+    // Store the error
+    errors.push_back(1 - accuracy);
+
+    return accuracy == 1;
 }
 
-void NeuralLayers::__back_propagation(const cmatrix<float> &y)
+void NeuralLayers::__fit_async(const size_t &n_samples, const std::function<void(const size_t &, std::vector<std::pair<size_t, float>> &)> &sample, const cmatrix<float> &y, const int &epochs, const float &learning_rate, const int &verbose, NeuralHogwild &hogwild, const std::function<cmatrix<cbool>()> &predict)
 {
-    // Initialize variables
-    const float m = y.width_t<float>();
+    const int n_layers = m_graph.size();
 
-    // Compute the gradient for the last layer
-    const cmatrix<float> &A_last = m_activations.at("A" + std::to_string(m_activations.size() - 1));
-    cmatrix<float> dZ = A_last - y;
+    // The weights of the layer i are stored row by row from offsets[i], as in the graph
+    std::vector<size_t> dims = {m_graph.layer(0).parameters().size() / m_graph.layer(0).output_shape().size()};
+    std::vector<size_t> offsets = {0, 0};
+    std::vector<float> weights = m_graph.parameters();
 
-    // Compute the gradient for each layer
-    for (int i = m_weights.size(); i >= 1; i--)
+    for (int i = 1; i <= n_layers; i++)
     {
-        const std::string &dim_str = std::to_string(i);
-        const std::string &dim_prev_str = std::to_string(i - 1);
+        const NeuralLayer &layer = m_graph.layer(i - 1);
+        dims.push_back(layer.output_shape().size());
+        offsets.push_back(offsets.back() + layer.parameters().size());
+    }
+
+    const size_t bias = dims[0] - 1;
+
+    // Each worker reuses its own buffers
+    struct Buffers
+    {
+        std::vector<std::pair<size_t, float>> x;
+        std::vector<std::vector<float>> A;
+        std::vector<float> dZ;
+        std::vector<float> dZ_prev;
+    };
+
+    std::vector<Buffers> buffers(hogwild.n_threads());
+    for (Buffers &buffer : buffers)
+        for (int i = 0; i <= n_layers; i++)
+            buffer.A.push_back(std::vector<float>(dims[i]));
+
+    const NeuralHogwild::Step &step = [&](const size_t &j, NeuralHogwild::Weights &w, const size_t &worker)
+    {
+        Buffers &buffer = buffers[worker];
+        std::vector<std::vector<float>> &A = buffer.A;
+        sample(j, buffer.x);
+
+        // Forward propagation of the first layer over the non-zero features
+        for (size_t r = 0; r < dims[1]; r++)
+        {
+            const size_t row = offsets[1] + r * dims[0];
+            float z = w.get(row + bias);
 
-        // Get the activation A required for the current layer
-        const cmatrix<float> &A_prev = m_activations.at("A" + dim_prev_str);
+            for (const std::pair<size_t, float> &feature : buffer.x)
+                z += w.get(row + feature.first) * feature.second;
 
-        // Compute the gradient for the current layer
-        const cmatrix<float> &dW = 1 / m * dZ.matmul(A_prev.transpose());
+            A[1][r] = 1 / (1 + std::exp(-z));
+        }
+
+        // Forward propagation of the other layers
+        for (int i = 2; i <= n_layers; i++)
+        {
+            for (size_t r = 0; r < dims[i]; r++)
+            {
+                const size_t row = offsets[i] + r * dims[i - 1];
+                float z = 0;
+
+                for (size_t k = 0; k < dims[i - 1]; k++)
+                    z += w.get(row + k) * A[i - 1][k];
+
+                A[i][r] = 1 / (1 + std::exp(-z));
+            }
+        }
 
-        // Store the gradient for the current layer
-        m_gradients["dW" + dim_str] = dW;
+        // Compute the gradient for the last layer
+        buffer.dZ.resize(dims[n_layers]);
+        for (size_t r = 0; r < dims[n_layers]; r++)
+            buffer.dZ[r] = A[n_layers][r] - y.cell(r, j);
 
-        // Compute the gradient for the previous layer
-        if (i > 1)
+        // Back propagation: the gradient of the previous layer is computed before the update of the current one
+        for (int i = n_layers; i >= 2; i--)
         {
-            const cmatrix<float> &W = m_weights.at('W' + dim_str);
-            dZ = W.transpose().matmul(dZ) * A_prev * (-1) * (A_prev - (float)1);
+            buffer.dZ_prev.assign(dims[i - 1], 0);
+
+            for (size_t r = 0; r < dims[i]; r++)
+            {
+                const size_t row = offsets[i] + r * dims[i - 1];
+
+                for (size_t k = 0; k < dims[i - 1]; k++)
+                {
+                    buffer.dZ_prev[k] += w.get(row + k) * buffer.dZ[r];
+                    w.add(row + k, -learning_rate * buffer.dZ[r] * A[i - 1][k]);
+                }
+            }
+
+            for (size_t k = 0; k < dims[i - 1]; k++)
+                buffer.dZ_prev[k] *= A[i - 1][k] * (1 - A[i - 1][k]);
+
+            std::swap(buffer.dZ, buffer.dZ_prev);
         }
-    }
+
+        // Update the first layer for the non-zero features only
+        for (size_t r = 0; r < dims[1]; r++)
+        {
+            const size_t row = offsets[1] + r * dims[0];
+
+            for (const std::pair<size_t, float> &feature : buffer.x)
+                w.add(row + feature.first, -learning_rate * buffer.dZ[r] * feature.second);
+
+            w.add(row + bias, -learning_rate * buffer.dZ[r]);
+        }
+    };
+
+    // Copy the flat weights back to the layers
+    const std::function<void(const std::vector<float> &)> &unflatten = [&](const std::vector<float> &flat)
+    {
+        m_graph.set_parameters(flat);
+    };
+
+    const cmatrix<cbool> y_true = cmatrix<cbool>(y);
+
+    // Stop the training if the accuracy is 100%
+    const NeuralHogwild::Callback &callback = [&](const int &epoch, const std::vector<float> &flat)
+    {
+        if (verbose == 0 || epoch % verbose != 0)
+            return false;
+
+        unflatten(flat);
+        return __log_accuracy(epoch, predict(), y_true);
+    };
+
+    unflatten(hogwild.run(weights, n_samples, epochs, step, callback));
+    throughput = hogwild.throughput;
 }
 
-void NeuralLayers::__gradient_descent(const float &learning_rate)
+void NeuralLayers::__train(const cmatrix<float> &X, const cmatrix<float> &y, const std::vector<size_t> &indices, const int &first_epoch, const int &epochs, const float &learning_rate, const int &verbose)
 {
-    for (int i = 1; i <= m_weights.size(); i++)
-    {
-        const std::string &dim_str = std::to_string(i);
+    // Gather the selected labels
+    const std::vector<float> &targets = __gather_targets(y, &indices);
 
-        // Get the parameters W required for the current layer
-        cmatrix<float> &W = m_weights.at("W" + dim_str);
+    cmatrix<float> y_indices(y.height(), indices.size());
+    for (size_t j = 0; j < indices.size(); j++)
+        for (size_t r = 0; r < y.height(); r++)
+            y_indices.cell(r, j) = targets[j * y.height() + r];
 
-        // Get the gradients dW required for the current layer
-        const cmatrix<float> &dW = m_gradients.at("dW" + dim_str);
+    const cmatrix<cbool> y_true = cmatrix<cbool>(y_indices);
 
-        // Update the parameters W for the current layer
-        W -= learning_rate * dW;
+    // Train the model, the pruner continuing its schedule from the first epoch
+    for (int i = first_epoch; i < epochs; i++)
+    {
+        __forward_propagation(X, indices, true);
+        __back_propagation(targets);
+        __gradient_descent(learning_rate);
+        m_pruner.step(m_graph, i);
 
-        // Store the updated parameters W for the current layer
-        m_weights["W" + dim_str] = W;
+        // Stop the training if the accuracy is 100%
+        if (verbose != 0 && i % verbose == 0 && __log_accuracy(i, predict(X, indices), y_true))
+            break;
     }
 }
 
@@ -135,45 +329,166 @@ NeuralLayers::NeuralLayers(const std::vector<int> &layers_dims)
     m_layers_dims = layers_dims;
 }
 
+NeuralLayers::NeuralLayers(const std::vector<int> &layers_dims, const NeuralScaler &scaler) : NeuralLayers(layers_dims)
+{
+    m_scaler = scaler;
+}
+
+NeuralLayers::NeuralLayers(const NeuralGraph &graph, const NeuralScaler &scaler)
+    : m_graph(graph), m_custom_graph(true), m_scaler(scaler)
+{
+    // Check if the graph is empty
+    if (graph.size() == 0)
+        throw std::invalid_argument("The graph must contain at least one layer");
+}
+
 NeuralLayers::~NeuralLayers() {}
 
 // ==================================================
 // TRAINING METHODS
 void NeuralLayers::fit(const cmatrix<float> &X, const cmatrix<float> &y, const int &epochs, const float &learning_rate, const int &verbose)
 {
-    // Initialize the weights (+1 for the bias)
-    __init_weights(X.height() + 1, m_layers_dims, y.height());
+    // Fit the scaler and initialize the weights
+    m_scaler.fit(X);
+    __init_weights(m_scaler.n_outputs(), y.height());
+
+    // Tune the products of the model which are not in the cache, on the first fit of its shapes
+    if (NeuralTuner::automatic())
+        NeuralTuner().tune(*this, X);
 
     // TODO: Multiclassification
     const cmatrix<cbool> y_true = cmatrix<cbool>(y);
+    const std::vector<float> &targets = __gather_targets(y, nullptr);
 
     // Train the model
     for (int i = 0; i < epochs; i++)
     {
-        __forward_propagation(X);
-        __back_propagation(y);
+        __forward_propagation(X, true);
+        __back_propagation(targets);
         __gradient_descent(learning_rate);
+        m_pruner.step(m_graph, i);
 
-        if (verbose != 0 && i % verbose == 0)
-        {
-            // Predict
-            const cmatrix<cbool> &y_pred = predict(X);
-            const cmatrix<float> &y_correct = cmatrix<float>(y_pred.eq(y_true));
+        // Stop the training if the accuracy is 100%
+        if (verbose != 0 && i % verbose == 0 && __log_accuracy(i, predict(X), y_true))
+            break;
+    }
+}
 
-            // Compute the accuracy
-            const float accuracy = y_correct.sum_all() / y_pred.width_t<float>();
-            std::cout << i << ". Accuracy: " << accuracy << std::endl;
+void NeuralLayers::fit(const NeuralSparse &X, const cmatrix<float> &y, const int &epochs, const float &learning_rate, const int &verbose)
+{
+    // Initialize the weights
+    __init_weights(X.height(), y.height());
+    NeuralDense &input = __sparse_input_layer();
 
-            // Store the error
-            errors.push_back(1 - accuracy);
+    // The forward reads the samples as rows, the update reads the features as rows
+    const NeuralSparse &X_samples = X.transpose();
 
-            // Stop the training if the accuracy is 100%
-            if (accuracy == 1)
-                break;
-        }
+    const cmatrix<cbool> y_true = cmatrix<cbool>(y);
+    const std::vector<float> &targets = __gather_targets(y, nullptr);
+
+    // Train the model
+    for (int i = 0; i < epochs; i++)
+    {
+        __forward_propagation(X_samples, true);
+
+        // Compute the gradients of the dense layers and the gradient of the output of the first layer
+        float *d_input = m_graph.backward(targets, 1);
+        m_graph.update(learning_rate, 1);
+
+        // Update the weights of the first layer for the non-zero features only
+        input.update(X, m_graph.activation(1), d_input, learning_rate);
+        m_pruner.step(m_graph, i);
+
+        // Stop the training if the accuracy is 100%
+        if (verbose != 0 && i % verbose == 0 && __log_accuracy(i, predict(X), y_true))
+            break;
     }
 }
 
+void NeuralLayers::fit(const cmatrix<float> &X, const cmatrix<float> &y, const std::vector<size_t> &indices, const int &epochs, const float &learning_rate, const int &verbose)
+{
+    // Fit the scaler to the selected samples only and initialize the weights
+    m_scaler.fit(X, indices);
+    __init_weights(m_scaler.n_outputs(), y.height());
+
+    // Train the model on the selected samples
+    __train(X, y, indices, 0, epochs, learning_rate, verbose);
+}
+
+void NeuralLayers::fit_async(const cmatrix<float> &X, const cmatrix<float> &y, const int &epochs, const float &learning_rate, const int &verbose, const size_t &n_threads, const size_t &n_replicas)
+{
+    // The stochastic step is written for the sigmoid dense layers of the dimensions
+    if (m_custom_graph)
+        throw std::invalid_argument("The asynchronous fit only supports a model built from the dimensions of the layers");
+
+    NeuralHogwild hogwild(n_threads, n_replicas);
+
+    // Fit the scaler and initialize the weights
+    m_scaler.fit(X);
+    __init_weights(m_scaler.n_outputs(), y.height());
+
+    // Read the scaled features of a dense sample
+    const std::function<void(const size_t &, std::vector<std::pair<size_t, float>> &)> &sample = [&](const size_t &j, std::vector<std::pair<size_t, float>> &x)
+    {
+        m_scaler.transform(X, j, x);
+    };
+
+    __fit_async(X.width(), sample, y, epochs, learning_rate, verbose, hogwild, [&]()
+                { return predict(X); });
+}
+
+void NeuralLayers::fit_async(const NeuralSparse &X, const cmatrix<float> &y, const int &epochs, const float &learning_rate, const int &verbose, const size_t &n_threads, const size_t &n_replicas)
+{
+    // The stochastic step is written for the sigmoid dense layers of the dimensions
+    if (m_custom_graph)
+        throw std::invalid_argument("The asynchronous fit only supports a model built from the dimensions of the layers");
+
+    NeuralHogwild hogwild(n_threads, n_replicas);
+
+    // Initialize the weights
+    __init_weights(X.height(), y.height());
+    __sparse_input_layer();
+
+    // The samples are the rows of the transposed matrix
+    const NeuralSparse &X_samples = X.transpose();
+    const std::vector<size_t> &row_ptr = X_samples.row_ptr();
+    const std::vector<size_t> &col_idx = X_samples.col_idx();
+    const std::vector<float> &values = X_samples.values();
+
+    // Read the non-zero features of a sparse sample
+    const std::function<void(const size_t &, std::vector<std::pair<size_t, float>> &)> &sample = [&](const size_t &j, std::vector<std::pair<size_t, float>> &x)
+    {
+        x.clear();
+        for (size_t k = row_ptr[j]; k < row_ptr[j + 1]; k++)
+            x.push_back(std::make_pair(col_idx[k], values[k]));
+    };
+
+    __fit_async(X.width(), sample, y, epochs, learning_rate, verbose, hogwild, [&]()
+                { return predict(X); });
+}
+
+// ==================================================
+// PRUNING METHODS
+
+void NeuralLayers::set_pruner(const NeuralPruner &pruner)
+{
+    m_pruner = pruner;
+}
+
+size_t NeuralLayers::compress(const float &min_sparsity)
+{
+    // Check if the model is trained
+    if (!m_graph.is_built())
+        throw std::invalid_argument("The model must be trained before its compression");
+
+    return m_pruner.compress(m_graph, min_sparsity);
+}
+
+const NeuralGraph &NeuralLayers::graph() const
+{
+    return m_graph;
+}
+
 // ==================================================
 // PREDICTION METHODS
 
@@ -181,5 +496,80 @@ cmatrix<cbool> NeuralLayers::predict(const cmatrix<float> &X)
 {
     __forward_propagation(X);
 
-    return m_activations.at("A" + std::to_string(m_activations.size() - 1)) > 0.5;
+    return __output();
+}
+
+cmatrix<cbool> NeuralLayers::predict(const NeuralSparse &X)
+{
+    // The first layer reads the samples from the columns of X, so X is not transposed at each call
+    NeuralDense &input = __sparse_input_layer();
+    m_graph.plan(X.width(), 1);
+    input.forward_columns(X, m_graph.activation(1));
+    m_graph.forward(false, 1);
+
+    return __output();
+}
+
+cmatrix<cbool> NeuralLayers::predict(const cmatrix<float> &X, const std::vector<size_t> &indices)
+{
+    __forward_propagation(X, indices);
+
+    return __output();
+}
+
+cmatrix<float> NeuralLayers::predict_proba(const cmatrix<float> &X)
+{
+    __forward_propagation(X);
+
+    return __probabilities();
+}
+
+// ==================================================
+// SERIALIZATION METHODS
+
+void NeuralLayers::save(const std::string &path) const
+{
+    std::ofstream file(path);
+
+    if (!file)
+        throw std::runtime_error("Unable to write the file " + path);
+
+    // The layers and their weights, then the scaler
+    file << "NeuralLayers\n";
+    m_graph.save(file);
+    m_scaler.save(file);
+
+    if (!file)
+        throw std::runtime_error("Unable to write the file " + path);
+}
+
+void NeuralLayers::load(const std::string &path)
+{
+    std::ifstream file(path);
+    std::string name;
+
+    if (!file || !(file >> name) || name != "NeuralLayers")
+        throw std::runtime_error("The file " + path + " is not a valid model");
+
+    NeuralGraph graph;
+    NeuralScaler scaler;
+
+    try
+    {
+        graph.load(file);
+        scaler.load(file);
+    }
+    catch (const std::runtime_error &)
+    {
+        throw std::runtime_error("The file " + path + " is not a valid model");
+    }
+
+    // The scaler must produce the input of the graph
+    if (scaler.is_fitted() && scaler.n_outputs() != graph.input_shape().size())
+        throw std::runtime_error("The file " + path + " is not a valid model");
+
+    // The loaded layers are kept by the next fit
+    m_graph = graph;
+    m_custom_graph = true;
+    m_scaler = scaler;
 }
@@ -43,8 +43,8 @@ float NeuralLoss::mse(const cmatrix<float> &y_true, const cmatrix<float> &y_pred
     __check_valid_y(y_true, y_pred);
 
     // Compute the mean squared error
-    // MSE: 1/n * sum((y_pred - y_true)^2)
-    return 1 / y_true.height_t<float>() * ((y_pred - y_true) ^ 2).sum_all();
+    // MSE: 1/n * sum((y_pred - y_true)^2), fused in one pass without temporary
+    return (NeuralLazy(y_pred) - NeuralLazy(y_true)).square().sum_all() / y_true.height_t<float>();
 }
 
 float NeuralLoss::mae(const cmatrix<float> &y_true, const cmatrix<float> &y_pred)
@@ -53,8 +53,8 @@ float NeuralLoss::mae(const cmatrix<float> &y_true, const cmatrix<float> &y_pred
     __check_valid_y(y_true, y_pred);
 
     // Compute the mean absolute error
-    // MAE: 1/n * sum(|y_pred - y_true|)
-    return 1 / y_true.height_t<float>() * (y_pred - y_true).abs().sum_all();
+    // MAE: 1/n * sum(|y_pred - y_true|), fused in one pass without temporary
+    return (NeuralLazy(y_pred) - NeuralLazy(y_true)).abs().sum_all() / y_true.height_t<float>();
 }
 
 // ==================================================
@@ -68,7 +68,9 @@ cmatrix<float> NeuralLoss::mse_grad(const cmatrix<float> &X, const cmatrix<float
 
     // Compute the mean squared error gradient
     // Grad (w): 1/(2n) * X^T * (X * w - y) => 1/(2n) * X^T * (y_pred - y_true) considering y_pred = X * w
-    return 1 / (2 * y_true.height_t<float>()) * X.transpose().matmul(y_pred - y_true);
+    // X^T is a view: X is read row by row, without being transposed. The residuals are scaled before the product, which is not copied
+    const cmatrix<float> &residuals = ((NeuralLazy(y_pred) - NeuralLazy(y_true)) / (2 * y_true.height_t<float>())).eval();
+    return NeuralView(X).transpose().matmul(NeuralView(residuals));
 }
 
 cmatrix<float> NeuralLoss::mae_grad(const cmatrix<float> &X, const cmatrix<float> &y_true, const cmatrix<float> &y_pred)
@@ -79,5 +81,6 @@ cmatrix<float> NeuralLoss::mae_grad(const cmatrix<float> &X, const cmatrix<float
 
     // Compute the mean absolute error gradient
     // Grad (w): 2/n * (W * w - y) * X => 2/n * (y_pred - y_true) * X considering y_pred = X * w
-    return 2 / y_true.height_t<float>() * (y_pred - y_true).matmul(X);
+    const cmatrix<float> &residuals = ((NeuralLazy(y_pred) - NeuralLazy(y_true)) * (2 / y_true.height_t<float>())).eval();
+    return residuals.matmul(X);
 }
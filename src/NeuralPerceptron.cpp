@@ -13,18 +13,21 @@
 // INCLUDES
 #include "../include/NeuralPerceptron.hpp"
 
+#include <algorithm>
+
 // ==================================================
 // PRIVATE METHODS
 
-cmatrix<float> NeuralPerceptron::__augment_X(const cmatrix<float> &X) const
+std::vector<float> NeuralPerceptron::__weights() const
 {
-    return cmatrix<float>::merge(X, cmatrix<float>(X.height(), 1, 1), 1);
-}
+    std::vector<float> weights(m_weights.height());
+    for (size_t i = 0; i < weights.size(); i++)
+        weights[i] = m_weights.cell(i, 0);
 
-// ==================================================
-// METHODS
+    return weights;
+}
 
-cmatrix<float> NeuralPerceptron::fit(const cmatrix<float> &X, const cmatrix<float> &y_true, const int &epochs, const float &learning_rate)
+void NeuralPerceptron::__check_valid_fit(const cmatrix<float> &y_true, const int &epochs) const
 {
     // Check if the number of epochs is valid
     if (epochs <= 0)
@@ -34,13 +37,119 @@ cmatrix<float> NeuralPerceptron::fit(const cmatrix<float> &X, const cmatrix<floa
     if (y_true.find([&](float x)
                     { return x != 1 && x != -1; }) != std::pair<int, int>(-1, -1))
         throw std::invalid_argument("The labels must be either 1 or -1");
+}
+
+void NeuralPerceptron::__fit_async(const size_t &n_samples, const size_t &n_features, const std::function<void(const size_t &, std::vector<std::pair<size_t, float>> &)> &sample, const cmatrix<float> &y_true, const int &epochs, const float &learning_rate, NeuralHogwild &hogwild, const std::function<float()> &error)
+{
+    // Initialize weights if not set (+1 for the bias)
+    if (m_weights.is_empty())
+        m_weights = cmatrix<float>::randfloat(n_features + 1, 1, -2, 2);
+
+    std::vector<float> weights = __weights();
+
+    // Each worker reuses its own buffer for the features of its samples
+    std::vector<std::vector<std::pair<size_t, float>>> buffers(hogwild.n_threads());
+
+    const NeuralHogwild::Step &step = [&](const size_t &i, NeuralHogwild::Weights &w, const size_t &worker)
+    {
+        std::vector<std::pair<size_t, float>> &x = buffers[worker];
+        sample(i, x);
+
+        // Compute the score of the sample
+        float score = w.get(n_features);
+        for (const std::pair<size_t, float> &feature : x)
+            score += feature.second * w.get(feature.first);
+
+        // Update the weights of the features of the wrong prediction
+        const float y = y_true.cell(i, 0);
+        if (y * score <= 0)
+        {
+            for (const std::pair<size_t, float> &feature : x)
+                w.add(feature.first, learning_rate * y * feature.second);
+
+            w.add(n_features, learning_rate * y);
+        }
+    };
+
+    // Store the error after each epoch
+    m_errors.clear();
+    const NeuralHogwild::Callback &callback = [&](const int &epoch, const std::vector<float> &weights)
+    {
+        if (verbose)
+        {
+            for (size_t i = 0; i < weights.size(); i++)
+                m_weights.cell(i, 0) = weights[i];
+
+            m_errors.push_back(error());
+            std::cout << "Epoch: " << epoch << " "
+                      << "Error: " << m_errors.back() << std::endl;
+        }
+
+        return false;
+    };
+
+    weights = hogwild.run(weights, n_samples, epochs, step, callback);
+    throughput = hogwild.throughput;
+
+    for (size_t i = 0; i < weights.size(); i++)
+        m_weights.cell(i, 0) = weights[i];
+}
+
+// ==================================================
+// METHODS
+
+cmatrix<float> NeuralPerceptron::fit(const cmatrix<float> &X, const cmatrix<float> &y_true, const int &epochs, const float &learning_rate)
+{
+    return fit(NeuralView(X), y_true, epochs, learning_rate);
+}
+
+cmatrix<float> NeuralPerceptron::fit(const NeuralView &X, const cmatrix<float> &y_true, const int &epochs, const float &learning_rate)
+{
+    // Check if arguments are valid
+    __check_valid_fit(y_true, epochs);
+
+    // Initialize weights if not set (+1 for the bias)
+    if (m_weights.is_empty())
+        m_weights = cmatrix<float>::randfloat(X.width() + 1, 1, -2, 2);
+
+    // Initialize the errors vector
+    m_errors = std::vector<float>(epochs);
+    std::vector<float> scores(X.height());
+
+    // Train the model
+    for (int iter = 0; iter < epochs; iter++)
+    {
+        // Update the weights with the ReLU activation function, the samples are augmented implicitly
+        // W -= learning_rate * dW is fused in place, without temporary
+        const cmatrix<float> &dW = NeuralActivation::dW_relu(X, y_true, m_weights, true);
+        (NeuralLazy(m_weights) - learning_rate * NeuralLazy(dW)).eval_to(m_weights);
+
+        // Print the error
+        if (verbose)
+        {
+            // Compute the error: number of wrong predictions / total number of samples
+            const std::vector<float> &weights = __weights();
+            X.matvec(weights.data(), scores.data(), weights.back());
+            m_errors[iter] = (float)std::count_if(scores.begin(), scores.end(), [](const float &score)
+                                                  { return score <= 0; }) /
+                             X.height();
 
-    // Augment the samples matrix with a column of ones for the bias
-    cmatrix<float> X_augmented = __augment_X(X);
+            std::cout << "Epoch: " << iter << " "
+                      << "Error: " << m_errors[iter] << std::endl;
+        }
+    }
 
-    // Initialize weights if not set
+    return m_weights;
+}
+
+cmatrix<float> NeuralPerceptron::fit(const NeuralSparse &X, const cmatrix<float> &y_true, const int &epochs, const float &learning_rate)
+{
+    // Check if arguments are valid
+    __check_valid_fit(y_true, epochs);
+
+    // Initialize weights if not set (+1 for the bias)
     if (m_weights.is_empty())
-        m_weights = cmatrix<float>::randfloat(X_augmented.width(), 1, -2, 2);
+        m_weights = cmatrix<float>::randfloat(X.width() + 1, 1, -2, 2);
 
     // Initialize the errors vector
     m_errors = std::vector<float>(epochs);
@@ -49,13 +158,14 @@ cmatrix<float> NeuralPerceptron::fit(const cmatrix<float> &X, const cmatrix<floa
     for (int iter = 0; iter < epochs; iter++)
     {
         // Update the weights with the ReLU activation function
-        m_weights -= learning_rate * NeuralActivation::dW_relu(X_augmented, y_true, m_weights);
+        const cmatrix<float> &dW = NeuralActivation::dW_relu(X, y_true, m_weights);
+        (NeuralLazy(m_weights) - learning_rate * NeuralLazy(dW)).eval_to(m_weights);
 
         // Print the error
         if (verbose)
         {
             // Compute the error: number of wrong predictions / total number of samples
-            m_errors[iter] = (X_augmented.matmul(m_weights) <= 0).sum_all() / X_augmented.height();
+            m_errors[iter] = (X.matmul(m_weights, true) <= 0).sum_all() / X.height();
 
             std::cout << "Epoch: " << iter << " "
                       << "Error: " << m_errors[iter] << std::endl;
@@ -65,20 +175,101 @@ cmatrix<float> NeuralPerceptron::fit(const cmatrix<float> &X, const cmatrix<floa
     return m_weights;
 }
 
+cmatrix<float> NeuralPerceptron::fit_async(const cmatrix<float> &X, const cmatrix<float> &y_true, const int &epochs, const float &learning_rate, const size_t &n_threads, const size_t &n_replicas)
+{
+    // Check if arguments are valid
+    __check_valid_fit(y_true, epochs);
+
+    NeuralHogwild hogwild(n_threads, n_replicas);
+
+    // Read the features of a dense sample
+    const size_t n_features = X.width();
+    const std::function<void(const size_t &, std::vector<std::pair<size_t, float>> &)> &sample = [&](const size_t &i, std::vector<std::pair<size_t, float>> &x)
+    {
+        x.resize(n_features);
+        for (size_t k = 0; k < n_features; k++)
+            x[k] = std::make_pair(k, X.cell(i, k));
+    };
+
+    // Compute the error: number of wrong predictions / total number of samples
+    const std::function<float()> &error = [&]()
+    {
+        const cmatrix<float> &y_correct = cmatrix<float>((predict(X) > 0).eq(y_true > 0));
+        return 1 - y_correct.sum_all() / X.height();
+    };
+
+    __fit_async(X.height(), n_features, sample, y_true, epochs, learning_rate, hogwild, error);
+
+    return m_weights;
+}
+
+cmatrix<float> NeuralPerceptron::fit_async(const NeuralSparse &X, const cmatrix<float> &y_true, const int &epochs, const float &learning_rate, const size_t &n_threads, const size_t &n_replicas)
+{
+    // Check if arguments are valid
+    __check_valid_fit(y_true, epochs);
+
+    NeuralHogwild hogwild(n_threads, n_replicas);
+
+    // Read the non-zero features of a sparse sample
+    const std::vector<size_t> &row_ptr = X.row_ptr();
+    const std::vector<size_t> &col_idx = X.col_idx();
+    const std::vector<float> &values = X.values();
+
+    const std::function<void(const size_t &, std::vector<std::pair<size_t, float>> &)> &sample = [&](const size_t &i, std::vector<std::pair<size_t, float>> &x)
+    {
+        x.clear();
+        for (size_t k = row_ptr[i]; k < row_ptr[i + 1]; k++)
+            x.push_back(std::make_pair(col_idx[k], values[k]));
+    };
+
+    // Compute the error: number of wrong predictions / total number of samples
+    const std::function<float()> &error = [&]()
+    {
+        const cmatrix<float> &y_correct = cmatrix<float>((X.matmul(m_weights, true) > 0).eq(y_true > 0));
+        return 1 - y_correct.sum_all() / X.height();
+    };
+
+    __fit_async(X.height(), X.width(), sample, y_true, epochs, learning_rate, hogwild, error);
+
+    return m_weights;
+}
+
 cmatrix<float> NeuralPerceptron::predict(const cmatrix<float> &X) const
+{
+    return predict(NeuralView(X));
+}
+
+cmatrix<float> NeuralPerceptron::predict(const NeuralView &X) const
 {
     // Check if the model is trained
     if (m_weights.is_empty())
         throw std::runtime_error("The model must be trained before making predictions");
 
-    // Check if the number of features should be augmented
-    cmatrix<float> X_ = X;
-    if (X.width() == m_weights.height() + 1)
-        X_ = __augment_X(X);
+    // Check if the number of features is valid, the samples are augmented implicitly if needed
+    const bool bias = X.width() + 1 == m_weights.height();
+    if (!bias && X.width() != m_weights.height())
+        throw std::invalid_argument("The number of features must be equal to the number of weights: " + std::to_string(m_weights.height()));
+
+    const std::vector<float> &weights = __weights();
+    std::vector<float> scores(X.height());
+    X.matvec(weights.data(), scores.data(), bias ? weights.back() : 0);
+
+    cmatrix<float> y_pred(X.height(), 1);
+    for (size_t i = 0; i < scores.size(); i++)
+        y_pred.cell(i, 0) = scores[i] > 0;
+
+    return y_pred;
+}
+
+cmatrix<float> NeuralPerceptron::predict(const NeuralSparse &X) const
+{
+    // Check if the model is trained
+    if (m_weights.is_empty())
+        throw std::runtime_error("The model must be trained before making predictions");
 
     // Check if the number of features is valid
-    if (X.width() != m_weights.height())
-        throw std::invalid_argument("The number of features must be equal to the number of weights: " + std::to_string(m_weights.height()));
+    if (X.width() + 1 != m_weights.height())
+        throw std::invalid_argument("The number of features must be equal to the number of weights without the bias: " + std::to_string(m_weights.height() - 1));
 
-    return X_.matmul(m_weights) > 0;
+    return X.matmul(m_weights, true) > 0;
 }
@@ -0,0 +1,233 @@
+/**
+ * @file NeuralPruner.cpp
+ * @see include/NeuralPruner.hpp for definition.
+ * @brief The NeuralPruner class.
+ *
+ * This file contains the implementation of the NeuralPruner class.
+ *
+ * @author Manitas Bahri <https://github.com/B-Manitas>
+ * @date 2023/11
+ * @license MIT License
+ */
+
+// INCLUDES
+#include "../include/NeuralPruner.hpp"
+#include "../include/NeuralTuner.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+
+// ==================================================
+// PRIVATE METHODS
+
+void NeuralPruner::__prune_magnitude(NeuralGraph &graph, const float &sparsity) const
+{
+    // The score of a block, with its layer and its first weight
+    struct Block
+    {
+        float score;
+        size_t layer;
+        size_t row;
+        size_t column;
+    };
+
+    std::vector<std::vector<Block>> groups(1);
+    std::vector<std::vector<uint8_t>> masks(graph.size());
+
+    for (size_t i = 0; i < graph.size(); i++)
+    {
+        const NeuralLayer &layer = graph.layer(i);
+        size_t rows = 0, columns = 0;
+        layer.weights_shape(rows, columns);
+
+        if (rows * columns == 0)
+            continue;
+
+        // Each layer is a group when the sparsity is reached per layer
+        if (m_scope == LAYER && !groups.back().empty())
+            groups.push_back(std::vector<Block>());
+
+        const NeuralBuffer &W = layer.parameters();
+        const size_t ld = W.size() / rows;
+        masks[i].assign(W.size(), 1);
+
+        for (size_t r = 0; r < rows; r += m_block_height)
+            for (size_t c = 0; c < columns; c += m_block_width)
+            {
+                const size_t height = std::min(m_block_height, rows - r);
+                const size_t width = std::min(m_block_width, columns - c);
+
+                float sum = 0;
+                for (size_t br = 0; br < height; br++)
+                    for (size_t bc = 0; bc < width; bc++)
+                        sum += std::fabs(W[(r + br) * ld + c + bc]);
+
+                groups.back().push_back({sum / (height * width), i, r, c});
+            }
+    }
+
+    // Prune the blocks of the smallest scores of each group
+    for (std::vector<Block> &blocks : groups)
+    {
+        const size_t n_pruned = std::min(blocks.size(), (size_t)(sparsity * blocks.size()));
+        std::nth_element(blocks.begin(), blocks.begin() + n_pruned, blocks.end(), [](const Block &a, const Block &b)
+                         { return a.score < b.score; });
+
+        for (size_t k = 0; k < n_pruned; k++)
+        {
+            const Block &block = blocks[k];
+            size_t rows = 0, columns = 0;
+            graph.layer(block.layer).weights_shape(rows, columns);
+
+            const size_t ld = masks[block.layer].size() / rows;
+            for (size_t r = block.row; r < std::min(rows, block.row + m_block_height); r++)
+                for (size_t c = block.column; c < std::min(columns, block.column + m_block_width); c++)
+                    masks[block.layer][r * ld + c] = 0;
+        }
+    }
+
+    for (size_t i = 0; i < graph.size(); i++)
+        if (!masks[i].empty())
+            graph.layer(i).set_mask(masks[i]);
+}
+
+void NeuralPruner::__prune_structured(NeuralGraph &graph) const
+{
+    for (size_t i = 0; i < graph.size(); i++)
+    {
+        NeuralLayer &layer = graph.layer(i);
+        size_t rows = 0, columns = 0;
+        layer.weights_shape(rows, columns);
+
+        if (rows * columns == 0)
+            continue;
+
+        const NeuralBuffer &W = layer.parameters();
+        const size_t ld = W.size() / rows;
+        std::vector<uint8_t> mask(W.size(), 1);
+        std::vector<std::pair<float, size_t>> group;
+
+        for (size_t r = 0; r < rows; r++)
+            for (size_t c = 0; c < columns; c += m_m)
+            {
+                // Sort the weights of the group by decreasing magnitude
+                group.clear();
+                for (size_t k = c; k < std::min(columns, c + m_m); k++)
+                    group.push_back(std::make_pair(std::fabs(W[r * ld + k]), r * ld + k));
+
+                std::sort(group.begin(), group.end(), [](const std::pair<float, size_t> &a, const std::pair<float, size_t> &b)
+                          { return a.first > b.first; });
+
+                for (size_t k = m_n; k < group.size(); k++)
+                    mask[group[k].second] = 0;
+            }
+
+        layer.set_mask(mask);
+    }
+}
+
+// ==================================================
+// CONSTRUCTORS
+
+NeuralPruner::NeuralPruner(const float &sparsity, const Scope &scope, const int &begin_epoch, const int &end_epoch, const int &frequency, const size_t &block_height, const size_t &block_width)
+    : m_sparsity(sparsity), m_scope(scope), m_begin_epoch(begin_epoch), m_end_epoch(std::max(begin_epoch, end_epoch)), m_frequency(frequency), m_block_height(block_height), m_block_width(block_width)
+{
+    // Check if the parameters are valid
+    if (sparsity < 0 || sparsity >= 1)
+        throw std::invalid_argument("The sparsity must be in [0, 1[");
+
+    if (begin_epoch < 0 || frequency <= 0)
+        throw std::invalid_argument("The first epoch must be positive and the frequency greater than 0");
+
+    if (block_height == 0 || block_width == 0 || block_height > 16 || block_width > 16)
+        throw std::invalid_argument("The size of the blocks must be in [1, 16]");
+}
+
+NeuralPruner NeuralPruner::structured(const size_t &n, const size_t &m, const int &begin_epoch, const int &end_epoch, const int &frequency)
+{
+    // Check if the pattern is valid
+    if (m == 0 || n >= m)
+        throw std::invalid_argument("The N:M pattern must keep less than m weights of each group of m weights");
+
+    NeuralPruner pruner(1 - (float)n / m, GLOBAL, begin_epoch, end_epoch, frequency, 1, m);
+    pruner.m_n = n;
+    pruner.m_m = m;
+
+    return pruner;
+}
+
+// ==================================================
+// METHODS
+
+bool NeuralPruner::is_enabled() const
+{
+    return m_sparsity > 0;
+}
+
+float NeuralPruner::sparsity(const int &epoch) const
+{
+    if (epoch < m_begin_epoch)
+        return 0;
+
+    if (epoch >= m_end_epoch)
+        return m_sparsity;
+
+    const float progress = (float)(epoch - m_begin_epoch) / (m_end_epoch - m_begin_epoch);
+
+    return m_sparsity * (1 - std::pow(1 - progress, 3));
+}
+
+bool NeuralPruner::step(NeuralGraph &graph, const int &epoch) const
+{
+    // Check if the schedule prunes at this epoch
+    if (!is_enabled() || epoch < m_begin_epoch || epoch > m_end_epoch)
+        return false;
+
+    if ((epoch - m_begin_epoch) % m_frequency != 0 && epoch != m_end_epoch)
+        return false;
+
+    prune(graph, sparsity(epoch));
+
+    return true;
+}
+
+void NeuralPruner::prune(NeuralGraph &graph, const float &sparsity) const
+{
+    // Check if the graph is built
+    if (!graph.is_built())
+        throw std::invalid_argument("The graph must be built before its pruning");
+
+    if (m_m > 0)
+        __prune_structured(graph);
+    else
+        __prune_magnitude(graph, sparsity);
+}
+
+size_t NeuralPruner::compress(NeuralGraph &graph, const float &min_sparsity) const
+{
+    size_t n_compressed = 0;
+
+    for (size_t i = 0; i < graph.size(); i++)
+    {
+        NeuralDense *layer = dynamic_cast<NeuralDense *>(&graph.layer(i));
+        if (!layer || layer->parameters().empty())
+            continue;
+
+        // Count the blocks of zeros before the compression
+        const size_t K = layer->input_shape().size();
+        const size_t units = layer->output_shape().size();
+        const NeuralBlockSparse &blocks = NeuralBlockSparse::from_dense(layer->parameters().data(), units, K, K + layer->bias(), m_block_height, m_block_width);
+
+        // The default threshold is the measured sparsity from which the block sparse product is the fastest
+        const float threshold = min_sparsity < 0 ? NeuralTuner::crossover(units, K, m_block_height, m_block_width) : min_sparsity;
+        if (1 - blocks.density() < threshold)
+            continue;
+
+        layer->compress(m_block_height, m_block_width);
+        n_compressed++;
+    }
+
+    return n_compressed;
+}
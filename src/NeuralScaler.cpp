@@ -0,0 +1,433 @@
+/**
+ * @file NeuralScaler.cpp
+ * @see include/NeuralScaler.hpp for definition.
+ * @brief The NeuralScaler class.
+ *
+ * This file contains the implementation of the NeuralScaler class.
+ *
+ * @author Manitas Bahri <https://github.com/B-Manitas>
+ * @date 2023/11
+ * @license MIT License
+ */
+
+// INCLUDES
+#include "../include/NeuralScaler.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <limits>
+#include <string>
+
+// ==================================================
+// PRIVATE METHODS
+
+void NeuralScaler::__fit(const cmatrix<float> &X, const std::vector<size_t> *indices)
+{
+    const size_t n_features = X.height();
+    const size_t n_samples = indices ? indices->size() : X.width();
+
+    // Check if there are samples
+    if (X.is_empty() || n_samples == 0)
+        throw std::invalid_argument("The scaler must be fitted to at least one sample");
+
+    if (indices)
+        __check_valid_indices(X, *indices);
+
+    // Check if the categorical features are in range
+    std::vector<bool> is_categorical(n_features, false);
+    for (const size_t &f : m_categorical)
+    {
+        if (f >= n_features)
+            throw std::invalid_argument("The categorical feature " + std::to_string(f) + " is out of range");
+
+        is_categorical[f] = true;
+    }
+
+    m_n_features = n_features;
+    m_shift.assign(n_features, 0);
+    m_scale.assign(n_features, 1);
+    m_categories.assign(n_features, std::vector<float>());
+
+    // The moments of a block of samples of a feature
+    struct Moments
+    {
+        double count;
+        double mean;
+        double m2;
+        float min;
+        float max;
+    };
+
+    // Each block of samples of each feature is reduced with Welford's algorithm, then the blocks are merged (Chan et al.)
+    const size_t block = 4096;
+    const size_t n_blocks = (n_samples + block - 1) / block;
+    std::vector<Moments> moments(m_method == NONE ? 0 : n_features * n_blocks);
+
+#pragma omp parallel for schedule(dynamic)
+    for (size_t t = 0; t < moments.size(); t++)
+    {
+        const size_t f = t / n_blocks;
+        const size_t begin = (t % n_blocks) * block;
+        const size_t end = std::min(n_samples, begin + block);
+
+        Moments m = {0, 0, 0, std::numeric_limits<float>::max(), std::numeric_limits<float>::lowest()};
+        if (is_categorical[f])
+        {
+            moments[t] = m;
+            continue;
+        }
+
+        for (size_t k = begin; k < end; k++)
+        {
+            const float x = X.cell(f, indices ? (*indices)[k] : k);
+            const double delta = x - m.mean;
+
+            m.count++;
+            m.mean += delta / m.count;
+            m.m2 += delta * (x - m.mean);
+            m.min = std::min(m.min, x);
+            m.max = std::max(m.max, x);
+        }
+
+        moments[t] = m;
+    }
+
+#pragma omp parallel for schedule(dynamic)
+    for (size_t f = 0; f < n_features; f++)
+    {
+        // Collect the sorted categories
+        if (is_categorical[f])
+        {
+            std::vector<float> &categories = m_categories[f];
+            for (size_t k = 0; k < n_samples; k++)
+                categories.push_back(X.cell(f, indices ? (*indices)[k] : k));
+
+            std::sort(categories.begin(), categories.end());
+            categories.erase(std::unique(categories.begin(), categories.end()), categories.end());
+            continue;
+        }
+
+        if (m_method == NONE)
+            continue;
+
+        // Merge the moments of the blocks
+        Moments m = moments[f * n_blocks];
+        for (size_t b = 1; b < n_blocks; b++)
+        {
+            const Moments &other = moments[f * n_blocks + b];
+            const double count = m.count + other.count;
+            const double delta = other.mean - m.mean;
+
+            m.mean += delta * other.count / count;
+            m.m2 += other.m2 + delta * delta * m.count * other.count / count;
+            m.count = count;
+            m.min = std::min(m.min, other.min);
+            m.max = std::max(m.max, other.max);
+        }
+
+        // A constant feature is only shifted
+        if (m_method == STANDARD)
+        {
+            const double sigma = std::sqrt(m.m2 / m.count);
+            m_shift[f] = m.mean;
+            m_scale[f] = sigma > 0 ? 1 / sigma : 1;
+        }
+
+        else
+        {
+            m_shift[f] = m.min;
+            m_scale[f] = m.max > m.min ? 1 / (m.max - m.min) : 1;
+        }
+    }
+
+    __compute_offsets();
+    m_fitted = true;
+}
+
+cmatrix<float> NeuralScaler::__transform(const cmatrix<float> &X, const std::vector<size_t> *indices, const bool &bias) const
+{
+    __check_valid_X(X);
+
+    const size_t n_samples = indices ? indices->size() : X.width();
+
+    if (indices)
+        __check_valid_indices(X, *indices);
+
+    // The output is written once: the bias row and the one-hot rows are initialized here
+    cmatrix<float> out(m_n_outputs + bias, n_samples, 0);
+
+    // Each feature writes its own rows, read and written sequentially
+#pragma omp parallel for schedule(dynamic)
+    for (size_t f = 0; f < m_n_features; f++)
+    {
+        const size_t row = m_offsets[f];
+
+        if (m_categories[f].empty())
+        {
+            const float shift = m_shift[f];
+            const float scale = m_scale[f];
+
+            for (size_t k = 0; k < n_samples; k++)
+                out.cell(row, k) = (X.cell(f, indices ? (*indices)[k] : k) - shift) * scale;
+        }
+
+        else
+        {
+            const size_t n_categories = m_categories[f].size();
+
+            for (size_t k = 0; k < n_samples; k++)
+            {
+                const size_t category = __category(f, X.cell(f, indices ? (*indices)[k] : k));
+                if (category < n_categories)
+                    out.cell(row + category, k) = 1;
+            }
+        }
+    }
+
+    if (bias)
+        for (size_t k = 0; k < n_samples; k++)
+            out.cell(m_n_outputs, k) = 1;
+
+    return out;
+}
+
+void NeuralScaler::__transform(const cmatrix<float> &X, const std::vector<size_t> *indices, float *out) const
+{
+    __check_valid_X(X);
+
+    const size_t n_samples = indices ? indices->size() : X.width();
+    const size_t n_outputs = m_n_outputs;
+
+    if (indices)
+        __check_valid_indices(X, *indices);
+
+    // Each block of samples is written by one thread: the features are read along the samples
+    // and the outputs of the block stay in the cache
+    const size_t block = 64;
+    const size_t n_blocks = (n_samples + block - 1) / block;
+
+#pragma omp parallel for schedule(dynamic)
+    for (size_t b = 0; b < n_blocks; b++)
+    {
+        const size_t begin = b * block;
+        const size_t end = std::min(n_samples, begin + block);
+        std::fill(out + begin * n_outputs, out + end * n_outputs, 0.f);
+
+        for (size_t f = 0; f < m_n_features; f++)
+        {
+            const size_t row = m_offsets[f];
+
+            if (m_categories[f].empty())
+            {
+                const float shift = m_shift[f];
+                const float scale = m_scale[f];
+
+                for (size_t k = begin; k < end; k++)
+                    out[k * n_outputs + row] = (X.cell(f, indices ? (*indices)[k] : k) - shift) * scale;
+            }
+
+            else
+            {
+                const size_t n_categories = m_categories[f].size();
+
+                for (size_t k = begin; k < end; k++)
+                {
+                    const size_t category = __category(f, X.cell(f, indices ? (*indices)[k] : k));
+                    if (category < n_categories)
+                        out[k * n_outputs + row + category] = 1;
+                }
+            }
+        }
+    }
+}
+
+void NeuralScaler::__check_valid_indices(const cmatrix<float> &X, const std::vector<size_t> &indices) const
+{
+    for (const size_t &j : indices)
+        if (j >= X.width())
+            throw std::invalid_argument("The sample index " + std::to_string(j) + " is out of range");
+}
+
+void NeuralScaler::__check_valid_X(const cmatrix<float> &X) const
+{
+    // Check if the scaler is fitted
+    if (!m_fitted)
+        throw std::invalid_argument("The scaler must be fitted before the transform");
+
+    // Check if X has the features of the fit
+    if (X.height() != m_n_features)
+        throw std::invalid_argument("The input matrix must have " + std::to_string(m_n_features) + " features");
+}
+
+size_t NeuralScaler::__category(const size_t &feature, const float &value) const
+{
+    const std::vector<float> &categories = m_categories[feature];
+    const std::vector<float>::const_iterator &it = std::lower_bound(categories.begin(), categories.end(), value);
+
+    return it != categories.end() && *it == value ? it - categories.begin() : categories.size();
+}
+
+void NeuralScaler::__compute_offsets()
+{
+    m_offsets.assign(m_n_features, 0);
+    m_n_outputs = 0;
+
+    for (size_t f = 0; f < m_n_features; f++)
+    {
+        m_offsets[f] = m_n_outputs;
+        m_n_outputs += m_categories[f].empty() ? 1 : m_categories[f].size();
+    }
+}
+
+// ==================================================
+// CONSTRUCTORS
+
+NeuralScaler::NeuralScaler(const Method &method, const std::vector<size_t> &categorical)
+    : m_method(method), m_categorical(categorical) {}
+
+// ==================================================
+// METHODS
+
+NeuralScaler::Method NeuralScaler::method() const
+{
+    return m_method;
+}
+
+bool NeuralScaler::is_identity() const
+{
+    return m_method == NONE && m_categorical.empty();
+}
+
+bool NeuralScaler::is_fitted() const
+{
+    return m_fitted;
+}
+
+size_t NeuralScaler::n_features() const
+{
+    return m_n_features;
+}
+
+size_t NeuralScaler::n_outputs() const
+{
+    return m_n_outputs;
+}
+
+void NeuralScaler::fit(const cmatrix<float> &X)
+{
+    __fit(X, nullptr);
+}
+
+void NeuralScaler::fit(const cmatrix<float> &X, const std::vector<size_t> &indices)
+{
+    __fit(X, &indices);
+}
+
+cmatrix<float> NeuralScaler::transform(const cmatrix<float> &X, const bool &bias) const
+{
+    return __transform(X, nullptr, bias);
+}
+
+cmatrix<float> NeuralScaler::transform(const cmatrix<float> &X, const std::vector<size_t> &indices, const bool &bias) const
+{
+    return __transform(X, &indices, bias);
+}
+
+void NeuralScaler::transform(const cmatrix<float> &X, const size_t &j, std::vector<std::pair<size_t, float>> &x) const
+{
+    x.clear();
+
+    for (size_t f = 0; f < m_n_features; f++)
+    {
+        const float value = X.cell(f, j);
+
+        // A one-hot encoded feature has at most one non-zero row
+        if (m_categories[f].empty())
+            x.push_back(std::make_pair(m_offsets[f], (value - m_shift[f]) * m_scale[f]));
+
+        else
+        {
+            const size_t category = __category(f, value);
+            if (category < m_categories[f].size())
+                x.push_back(std::make_pair(m_offsets[f] + category, 1.f));
+        }
+    }
+}
+
+void NeuralScaler::transform(const cmatrix<float> &X, float *out) const
+{
+    __transform(X, nullptr, out);
+}
+
+void NeuralScaler::transform(const cmatrix<float> &X, const std::vector<size_t> &indices, float *out) const
+{
+    __transform(X, &indices, out);
+}
+
+void NeuralScaler::save(std::ostream &stream) const
+{
+    stream << std::setprecision(std::numeric_limits<float>::max_digits10);
+    stream << "NeuralScaler " << m_method << " " << m_fitted << " " << m_n_features << "\n";
+
+    stream << m_categorical.size();
+    for (const size_t &f : m_categorical)
+        stream << " " << f;
+    stream << "\n";
+
+    // The statistics of each feature: shift, scale and categories
+    for (size_t f = 0; f < m_n_features; f++)
+    {
+        stream << m_shift[f] << " " << m_scale[f] << " " << m_categories[f].size();
+        for (const float &category : m_categories[f])
+            stream << " " << category;
+        stream << "\n";
+    }
+}
+
+void NeuralScaler::load(std::istream &stream)
+{
+    std::string name;
+    NeuralScaler S;
+    int method = 0;
+    size_t n_categorical = 0;
+
+    if (!(stream >> name >> method >> S.m_fitted >> S.m_n_features >> n_categorical) || name != "NeuralScaler" || method < NONE || method > MINMAX)
+        throw std::runtime_error("The stream does not contain a valid scaler");
+
+    S.m_method = (Method)method;
+    S.m_categorical.assign(n_categorical, 0);
+    for (size_t &f : S.m_categorical)
+        stream >> f;
+
+    // Check if the categorical features are in range before reading the features
+    bool valid = (bool)stream;
+    for (size_t i = 0; i < n_categorical && valid; i++)
+        valid = S.m_categorical[i] < S.m_n_features;
+
+    if (!valid)
+        throw std::runtime_error("The stream does not contain a valid scaler");
+
+    S.m_shift.assign(S.m_n_features, 0);
+    S.m_scale.assign(S.m_n_features, 1);
+    S.m_categories.assign(S.m_n_features, std::vector<float>());
+
+    for (size_t f = 0; f < S.m_n_features && stream; f++)
+    {
+        size_t n_categories = 0;
+        stream >> S.m_shift[f] >> S.m_scale[f] >> n_categories;
+
+        if (!stream)
+            break;
+
+        S.m_categories[f].assign(n_categories, 0);
+        for (float &category : S.m_categories[f])
+            stream >> category;
+    }
+
+    if (!stream)
+        throw std::runtime_error("The stream does not contain a valid scaler");
+
+    S.__compute_offsets();
+    *this = S;
+}
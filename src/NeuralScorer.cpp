@@ -0,0 +1,505 @@
+/**
+ * @file NeuralScorer.cpp
+ * @see include/NeuralScorer.hpp for definition.
+ * @brief The NeuralScorer class.
+ *
+ * This file contains the implementation of the NeuralScorer class.
+ *
+ * @author Manitas Bahri <https://github.com/B-Manitas>
+ * @date 2023/11
+ * @license MIT License
+ */
+
+// INCLUDES
+#include "../include/NeuralScorer.hpp"
+#include "../include/NeuralTuner.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/**
+ * @brief The magic of the binary columnar input and of the binary output.
+ */
+static const char COLUMNAR_MAGIC[8] = {'N', 'C', 'P', 'P', 'C', 'O', 'L', '1'};
+static const char SCORES_MAGIC[8] = {'N', 'C', 'P', 'P', 'S', 'C', 'R', '1'};
+static const size_t HEADER_SIZE = sizeof(COLUMNAR_MAGIC) + 2 * sizeof(uint64_t);
+
+/**
+ * @brief Releases the pages of the mapped input which are entirely in [begin, end[.
+ * The pages shared with the neighbouring chunks are kept, since they may not be parsed yet.
+ */
+static void release_pages(const char *begin, const char *end)
+{
+    static const uintptr_t page = sysconf(_SC_PAGESIZE);
+    const uintptr_t first = ((uintptr_t)begin + page - 1) / page * page;
+    const uintptr_t last = (uintptr_t)end / page * page;
+
+    if (first < last)
+        madvise(reinterpret_cast<void *>(first), last - first, MADV_DONTNEED);
+}
+
+// ==================================================
+// PRIVATE METHODS
+
+void NeuralScorer::__parse_csv(Chunk &chunk, const size_t &n_features)
+{
+    chunk.X = cmatrix<float>(n_features, chunk.n_rows);
+    std::string line;
+    const char *p = chunk.begin;
+
+    for (size_t i = 0; i < chunk.n_rows; i++)
+    {
+        const char *eol = static_cast<const char *>(memchr(p, '\n', chunk.end - p));
+        if (!eol)
+            eol = chunk.end;
+
+        // The mapping is not null terminated: copy the line before converting its values
+        line.assign(p, eol > p && eol[-1] == '\r' ? eol - 1 : eol);
+        const char *value = line.c_str();
+        size_t f = 0;
+
+        for (; f < n_features; f++)
+        {
+            char *next = nullptr;
+            const float x = strtof(value, &next);
+
+            // The values are separated by commas and the last one ends the line
+            if (next == value || *next != (f + 1 < n_features ? ',' : '\0'))
+                break;
+
+            chunk.X.cell(f, i) = x;
+            value = next + 1;
+        }
+
+        if (f < n_features)
+            throw std::runtime_error("The row " + std::to_string(chunk.first_row + i + 1) + " must have " + std::to_string(n_features) + " numeric values");
+
+        p = eol + 1;
+    }
+}
+
+void NeuralScorer::__parse_binary(Chunk &chunk, const float *columns, const size_t &n_rows)
+{
+    const size_t n_features = chunk.X.height();
+
+    // Each feature is a contiguous column: its values of the chunk are read in one pass
+    for (size_t f = 0; f < n_features; f++)
+    {
+        const float *column = columns + f * n_rows + chunk.first_row;
+
+        for (size_t i = 0; i < chunk.n_rows; i++)
+            chunk.X.cell(f, i) = column[i];
+    }
+}
+
+void NeuralScorer::__format(Chunk &chunk, const float *output, const size_t &n_outputs, const Format &format)
+{
+    std::string &result = chunk.result;
+    result.clear();
+
+    if (format == BINARY)
+    {
+        result.reserve(chunk.n_rows * n_outputs * (sizeof(float) + 1));
+
+        for (size_t k = 0; k < chunk.n_rows; k++)
+        {
+            const float *y = output + k * n_outputs;
+            result.append(reinterpret_cast<const char *>(y), n_outputs * sizeof(float));
+
+            for (size_t r = 0; r < n_outputs; r++)
+                result.push_back(y[r] > 0.5 ? 1 : 0);
+        }
+
+        return;
+    }
+
+    char value[32];
+    result.reserve(chunk.n_rows * n_outputs * 16);
+
+    for (size_t k = 0; k < chunk.n_rows; k++)
+    {
+        const float *y = output + k * n_outputs;
+
+        for (size_t r = 0; r < n_outputs; r++)
+        {
+            result.append(value, snprintf(value, sizeof(value), "%.7g", y[r]));
+            result.push_back(',');
+        }
+
+        for (size_t r = 0; r < n_outputs; r++)
+        {
+            result.push_back(y[r] > 0.5 ? '1' : '0');
+            result.push_back(r + 1 < n_outputs ? ',' : '\n');
+        }
+    }
+}
+
+// ==================================================
+// CONSTRUCTORS
+
+NeuralScorer::NeuralScorer(const size_t &batch_size, const size_t &n_parsers, const size_t &n_workers, const size_t &queue_size)
+    : m_batch_size(batch_size), m_n_parsers(n_parsers), m_n_workers(n_workers), m_queue_size(queue_size)
+{
+    if (n_workers == 0 || queue_size == 0)
+        throw std::invalid_argument("The number of workers and the size of the queues must be positive");
+
+    if (m_n_parsers == 0)
+        m_n_parsers = std::max(1u, std::thread::hardware_concurrency());
+}
+
+// ==================================================
+// METHODS
+
+const NeuralScorer::Report &NeuralScorer::score(const NeuralLayers &model, const std::string &input, const std::string &output, const Format &input_format, const Format &output_format, const bool &header)
+{
+    typedef std::chrono::steady_clock clock;
+
+    // Check if the model is trained
+    if (!model.m_graph.is_built() || !model.m_scaler.is_fitted())
+        throw std::invalid_argument("The model must be trained before scoring");
+
+    const size_t n_features = model.m_scaler.n_features();
+    const size_t n_outputs = model.m_graph.output_size();
+    const size_t batch_size = m_batch_size ? m_batch_size : NeuralTuner::batch_size(model, 4096);
+
+    // Map the input: the pages are read ahead by the kernel and released once parsed
+    const int fd = open(input.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw std::runtime_error("Unable to open the file " + input);
+
+    struct stat st;
+    fstat(fd, &st);
+    const size_t size = st.st_size;
+    const char *data = nullptr;
+
+    if (size > 0)
+    {
+        void *mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED)
+        {
+            close(fd);
+            throw std::runtime_error("Unable to map the file " + input);
+        }
+
+        madvise(mapping, size, MADV_SEQUENTIAL);
+        data = static_cast<const char *>(mapping);
+    }
+    close(fd);
+
+    const char *const end = data + size;
+    const float *columns = nullptr;
+    size_t n_rows = 0;
+
+    // Check if the header of the columnar file matches the model
+    if (input_format == BINARY)
+    {
+        uint64_t dims[2] = {0, 0};
+        if (size >= HEADER_SIZE)
+            memcpy(dims, data + sizeof(COLUMNAR_MAGIC), sizeof(dims));
+
+        if (size < HEADER_SIZE || memcmp(data, COLUMNAR_MAGIC, sizeof(COLUMNAR_MAGIC)) != 0 || size != HEADER_SIZE + dims[0] * dims[1] * sizeof(float))
+        {
+            if (data)
+                munmap(const_cast<char *>(data), size);
+            throw std::runtime_error("The file " + input + " is not a valid columnar file");
+        }
+
+        if (dims[1] != n_features)
+        {
+            munmap(const_cast<char *>(data), size);
+            throw std::runtime_error("The file " + input + " has " + std::to_string(dims[1]) + " features, the model expects " + std::to_string(n_features));
+        }
+
+        n_rows = dims[0];
+        columns = reinterpret_cast<const float *>(data + HEADER_SIZE);
+    }
+
+    std::ofstream file(output, std::ios::binary);
+    if (!file)
+    {
+        if (data)
+            munmap(const_cast<char *>(data), size);
+        throw std::runtime_error("Unable to open the file " + output);
+    }
+
+    if (output_format == BINARY)
+    {
+        const uint64_t n = n_outputs;
+        file.write(SCORES_MAGIC, sizeof(SCORES_MAGIC));
+        file.write(reinterpret_cast<const char *>(&n), sizeof(n));
+    }
+
+    // The tokens bound the number of chunks in flight: the reader takes one per chunk, the writer gives it back
+    const size_t window = 3 * m_queue_size + m_n_parsers + m_n_workers;
+    Queue<size_t> tokens(window);
+    Queue<Chunk> chunks(m_queue_size), parsed(m_queue_size), results(m_queue_size);
+
+    for (size_t t = 0; t < window; t++)
+        tokens.push(t);
+
+    std::mutex mutex;
+    std::exception_ptr error = nullptr;
+    double busy[4] = {0, 0, 0, 0};
+    std::atomic<size_t> n_parsers(m_n_parsers), n_workers(m_n_workers);
+    size_t n_chunks = 0, n_rows_read = 0, bytes_written = (size_t)file.tellp();
+
+    // The first error stops every stage
+    const std::function<void()> &fail = [&]()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!error)
+                error = std::current_exception();
+        }
+
+        tokens.close();
+        chunks.close();
+        parsed.close();
+        results.close();
+    };
+
+    const std::function<void(const Stage &, const clock::time_point &)> &account = [&](const Stage &stage, const clock::time_point &start)
+    {
+        const double seconds = std::chrono::duration<double>(clock::now() - start).count();
+        std::lock_guard<std::mutex> lock(mutex);
+        busy[stage] += seconds;
+    };
+
+    const clock::time_point start = clock::now();
+    std::vector<std::thread> threads;
+
+    // READ: split the file in chunks of rows
+    threads.emplace_back([&]()
+                         {
+        try
+        {
+            const char *p = data;
+            size_t row = 0, token = 0;
+
+            // Skip the header of a CSV file
+            if (input_format == CSV && header && p < end)
+            {
+                const char *eol = static_cast<const char *>(memchr(p, '\n', end - p));
+                p = eol ? eol + 1 : end;
+            }
+
+            while (input_format == CSV ? p < end : row < n_rows)
+            {
+                if (!tokens.pop(token))
+                    return;
+
+                const clock::time_point begin = clock::now();
+                Chunk chunk;
+                chunk.index = n_chunks++;
+                chunk.first_row = row;
+
+                if (input_format == CSV)
+                {
+                    chunk.begin = p;
+                    while (chunk.n_rows < batch_size && p < end)
+                    {
+                        const char *eol = static_cast<const char *>(memchr(p, '\n', end - p));
+                        p = eol ? eol + 1 : end;
+                        chunk.n_rows++;
+                    }
+                    chunk.end = p;
+                }
+                else
+                    chunk.n_rows = std::min(batch_size, n_rows - row);
+
+                row += chunk.n_rows;
+                n_rows_read = row;
+                account(READ, begin);
+
+                if (!chunks.push(std::move(chunk)))
+                    return;
+            }
+
+            chunks.close();
+        }
+        catch (...)
+        {
+            fail();
+        } });
+
+    // PARSE: convert the chunks in matrices of samples
+    for (size_t t = 0; t < m_n_parsers; t++)
+        threads.emplace_back([&]()
+                             {
+            try
+            {
+                Chunk chunk;
+                while (chunks.pop(chunk))
+                {
+                    const clock::time_point begin = clock::now();
+                    if (input_format == CSV)
+                    {
+                        __parse_csv(chunk, n_features);
+                        release_pages(chunk.begin, chunk.end);
+                    }
+                    else
+                    {
+                        chunk.X = cmatrix<float>(n_features, chunk.n_rows);
+                        __parse_binary(chunk, columns, n_rows);
+
+                        for (size_t f = 0; f < n_features; f++)
+                        {
+                            const float *column = columns + f * n_rows + chunk.first_row;
+                            release_pages(reinterpret_cast<const char *>(column), reinterpret_cast<const char *>(column + chunk.n_rows));
+                        }
+                    }
+                    account(PARSE, begin);
+
+                    if (!parsed.push(std::move(chunk)))
+                        return;
+                }
+
+                if (--n_parsers == 0)
+                    parsed.close();
+            }
+            catch (...)
+            {
+                fail();
+            } });
+
+    // COMPUTE: run the forward passes, each worker with its own buffers, and format the results
+    for (size_t t = 0; t < m_n_workers; t++)
+        threads.emplace_back([&]()
+                             {
+            try
+            {
+#ifdef _OPENMP
+                // The cores are shared between the forward passes of the workers
+                omp_set_num_threads(std::max(1, omp_get_num_procs() / (int)m_n_workers));
+#endif
+                NeuralLayers local = model;
+                Chunk chunk;
+
+                while (parsed.pop(chunk))
+                {
+                    const clock::time_point begin = clock::now();
+                    local.__forward_propagation(chunk.X);
+                    __format(chunk, local.m_graph.activation(local.m_graph.size()), n_outputs, output_format);
+                    chunk.X = cmatrix<float>();
+                    account(COMPUTE, begin);
+
+                    if (!results.push(std::move(chunk)))
+                        return;
+                }
+
+                if (--n_workers == 0)
+                    results.close();
+            }
+            catch (...)
+            {
+                fail();
+            } });
+
+    // WRITE: write the results in the order of the input
+    threads.emplace_back([&]()
+                         {
+        try
+        {
+            std::map<size_t, std::string> pending;
+            size_t next = 0;
+            Chunk chunk;
+
+            while (results.pop(chunk))
+            {
+                const clock::time_point begin = clock::now();
+                pending[chunk.index] = std::move(chunk.result);
+
+                for (std::map<size_t, std::string>::iterator it = pending.begin(); it != pending.end() && it->first == next; it = pending.erase(it), next++)
+                {
+                    file.write(it->second.data(), it->second.size());
+                    bytes_written += it->second.size();
+                    tokens.push(0);
+                }
+
+                if (!file)
+                    throw std::runtime_error("Unable to write the file " + output);
+                account(WRITE, begin);
+            }
+        }
+        catch (...)
+        {
+            fail();
+        } });
+
+    for (std::thread &thread : threads)
+        thread.join();
+
+    file.close();
+    if (data)
+        munmap(const_cast<char *>(data), size);
+
+    if (error)
+        std::rethrow_exception(error);
+
+    // The bottleneck is the stage whose threads are the most busy
+    const double seconds = std::chrono::duration<double>(clock::now() - start).count();
+    const double n_threads[4] = {1, (double)m_n_parsers, (double)m_n_workers, 1};
+
+    m_report = Report();
+    m_report.n_chunks = n_chunks;
+    m_report.n_rows = n_rows_read;
+    m_report.bytes_read = size;
+    m_report.bytes_written = bytes_written;
+    m_report.seconds = seconds;
+    m_report.rows_per_second = seconds > 0 ? n_rows_read / seconds : 0;
+
+    for (int s = 0; s < 4; s++)
+    {
+        m_report.busy_seconds[s] = busy[s];
+        if (busy[s] / n_threads[s] > busy[m_report.bottleneck] / n_threads[m_report.bottleneck])
+            m_report.bottleneck = (Stage)s;
+    }
+
+    return m_report;
+}
+
+const NeuralScorer::Report &NeuralScorer::report() const
+{
+    return m_report;
+}
+
+// ==================================================
+// STATIC METHODS
+
+void NeuralScorer::save_binary(const std::string &path, const cmatrix<float> &X)
+{
+    std::ofstream file(path, std::ios::binary);
+    if (!file)
+        throw std::runtime_error("Unable to open the file " + path);
+
+    const uint64_t dims[2] = {X.width(), X.height()};
+    file.write(COLUMNAR_MAGIC, sizeof(COLUMNAR_MAGIC));
+    file.write(reinterpret_cast<const char *>(dims), sizeof(dims));
+
+    // The rows of X are the features: each one is a column of the file
+    for (size_t f = 0; f < X.height() && X.width() > 0; f++)
+        file.write(reinterpret_cast<const char *>(&X.cell(f, 0)), X.width() * sizeof(float));
+
+    if (!file)
+        throw std::runtime_error("Unable to write the file " + path);
+}
@@ -0,0 +1,273 @@
+/**
+ * @file NeuralSearch.cpp
+ * @see include/NeuralSearch.hpp for definition.
+ * @brief The NeuralSearch class.
+ *
+ * This file contains the implementation of the NeuralSearch class.
+ *
+ * @author Manitas Bahri <https://github.com/B-Manitas>
+ * @date 2023/11
+ * @license MIT License
+ */
+
+// INCLUDES
+#include "../include/NeuralSearch.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <random>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// ==================================================
+// PRIVATE METHODS
+
+std::vector<std::vector<size_t>> NeuralSearch::__split_folds(const size_t &n_samples) const
+{
+    // Check if there are enough samples
+    if (n_samples < (size_t)m_n_folds)
+        throw std::invalid_argument("The number of samples must be greater or equal to the number of folds: " + std::to_string(m_n_folds));
+
+    // Shuffle the indices of the samples
+    std::vector<size_t> indices(n_samples);
+    std::iota(indices.begin(), indices.end(), 0);
+    std::shuffle(indices.begin(), indices.end(), std::mt19937(m_random_state));
+
+    // Distribute the indices over the folds
+    std::vector<std::vector<size_t>> folds(m_n_folds);
+    for (size_t i = 0; i < n_samples; i++)
+        folds[i % m_n_folds].push_back(indices[i]);
+
+    return folds;
+}
+
+std::vector<NeuralSearch::Result> NeuralSearch::__cross_validate(const cmatrix<float> &X, const cmatrix<float> &y, const std::vector<Params> &candidates, const std::vector<int> &first_epochs, const std::vector<int> &epochs, std::vector<std::vector<NeuralLayers>> *models)
+{
+    // Build the validation and training indices of each fold once, shared by all the tasks
+    const std::vector<std::vector<size_t>> &valid_folds = __split_folds(X.width());
+    std::vector<std::vector<size_t>> train_folds(m_n_folds);
+
+    for (int f = 0; f < m_n_folds; f++)
+        for (int g = 0; g < m_n_folds; g++)
+            if (g != f)
+                train_folds[f].insert(train_folds[f].end(), valid_folds[g].begin(), valid_folds[g].end());
+
+    // Each task writes its own score, so no lock is needed
+    std::vector<Result> scores(candidates.size());
+    for (size_t c = 0; c < candidates.size(); c++)
+        scores[c] = {candidates[c], epochs[c], 0, std::vector<float>(m_n_folds, 0)};
+
+    for (size_t c = 0; c < candidates.size(); c++)
+        for (int f = 0; f < m_n_folds; f++)
+            m_pool.submit([&, c, f]
+                          {
+                // Without kept models, the model of the task is dropped once scored
+                NeuralLayers local;
+                NeuralLayers &model = models ? (*models)[c][f] : local;
+                scores[c].fold_scores[f] = __score_fold(X, y, candidates[c], model, first_epochs[c], epochs[c], train_folds[f], valid_folds[f]); });
+
+    m_pool.wait();
+
+    // Compute the mean score of each candidate
+    for (Result &result : scores)
+        result.score = std::accumulate(result.fold_scores.begin(), result.fold_scores.end(), 0.0f) / m_n_folds;
+
+    return scores;
+}
+
+float NeuralSearch::__score_fold(const cmatrix<float> &X, const cmatrix<float> &y, const Params &params, NeuralLayers &model, const int &first_epoch, const int &epochs, const std::vector<size_t> &train, const std::vector<size_t> &valid)
+{
+#ifdef _OPENMP
+    // The pool already uses every core: avoid nested parallel regions
+    omp_set_num_threads(1);
+#endif
+
+    // Train the candidate on the training samples of the fold, or resume the training of its model
+    if (first_epoch == 0)
+    {
+        model = NeuralLayers(params.layers_dims);
+        model.fit(X, y, train, epochs, params.learning_rate, 0);
+    }
+    else
+        model.__train(X, y, train, first_epoch, epochs, params.learning_rate, 0);
+
+    // Compute the accuracy on the validation samples of the fold
+    const cmatrix<cbool> &y_pred = model.predict(X, valid);
+
+    float n_correct = 0;
+    for (size_t j = 0; j < valid.size(); j++)
+        n_correct += (bool)y_pred.cell(0, j) == (y.cell(0, valid[j]) != 0);
+
+    return n_correct / valid.size();
+}
+
+void NeuralSearch::__sort_results(std::vector<Result> &results)
+{
+    std::stable_sort(results.begin(), results.end(), [](const Result &a, const Result &b)
+                     { return a.score > b.score; });
+}
+
+// ==================================================
+// CONSTRUCTORS
+
+NeuralSearch::NeuralSearch(const int &n_folds, const size_t &n_threads, const int &random_state)
+    : m_n_folds(n_folds), m_random_state(random_state), m_pool(n_threads)
+{
+    // Check if the number of folds is valid
+    if (n_folds < 2)
+        throw std::invalid_argument("The number of folds must be greater than 1");
+}
+
+// ==================================================
+// STATIC METHODS
+
+std::vector<NeuralSearch::Params> NeuralSearch::grid(const std::vector<std::vector<int>> &layers_dims, const std::vector<int> &epochs, const std::vector<float> &learning_rates)
+{
+    std::vector<Params> candidates;
+
+    for (const std::vector<int> &dims : layers_dims)
+        for (const int &e : epochs)
+            for (const float &lr : learning_rates)
+                candidates.push_back({dims, e, lr});
+
+    return candidates;
+}
+
+std::vector<NeuralSearch::Params> NeuralSearch::random(const std::vector<std::vector<int>> &layers_dims, const int &min_epochs, const int &max_epochs, const float &min_learning_rate, const float &max_learning_rate, const int &n_candidates, const int &random_state)
+{
+    // Check if the ranges are valid
+    if (layers_dims.empty())
+        throw std::invalid_argument("The layers_dims vector must not be empty");
+
+    if (min_epochs <= 0 || min_epochs > max_epochs)
+        throw std::invalid_argument("The range of epochs must be valid and greater than 0");
+
+    if (min_learning_rate <= 0 || min_learning_rate > max_learning_rate)
+        throw std::invalid_argument("The range of learning rates must be valid and greater than 0");
+
+    // Initialize the random generator
+    std::mt19937 generator(random_state);
+    std::uniform_int_distribution<size_t> dist_dims(0, layers_dims.size() - 1);
+    std::uniform_int_distribution<int> dist_epochs(min_epochs, max_epochs);
+    std::uniform_real_distribution<float> dist_log_lr(std::log(min_learning_rate), std::log(max_learning_rate));
+
+    std::vector<Params> candidates;
+    for (int i = 0; i < n_candidates; i++)
+        candidates.push_back({layers_dims[dist_dims(generator)], dist_epochs(generator), std::exp(dist_log_lr(generator))});
+
+    return candidates;
+}
+
+// ==================================================
+// METHODS
+
+const std::vector<NeuralSearch::Result> &NeuralSearch::fit(const cmatrix<float> &X, const cmatrix<float> &y, const std::vector<Params> &candidates)
+{
+    // Check if there are candidates
+    if (candidates.empty())
+        throw std::invalid_argument("The candidates vector must not be empty");
+
+    // Train each candidate for its own number of epochs
+    std::vector<int> epochs;
+    for (const Params &params : candidates)
+        epochs.push_back(params.epochs);
+
+    results = __cross_validate(X, y, candidates, std::vector<int>(candidates.size(), 0), epochs);
+    __sort_results(results);
+
+    return results;
+}
+
+const std::vector<NeuralSearch::Result> &NeuralSearch::fit_halving(const cmatrix<float> &X, const cmatrix<float> &y, const std::vector<Params> &candidates, const int &min_epochs, const int &eta)
+{
+    // Check if the arguments are valid
+    if (candidates.empty())
+        throw std::invalid_argument("The candidates vector must not be empty");
+
+    if (min_epochs <= 0)
+        throw std::invalid_argument("The minimum number of epochs must be greater than 0");
+
+    if (eta < 2)
+        throw std::invalid_argument("The elimination factor must be greater than 1");
+
+    // The last result and the last round reached by each candidate
+    std::vector<Result> last(candidates.size());
+    std::vector<int> last_round(candidates.size(), 0);
+
+    // The model of each fold of each candidate, kept while the candidate remains
+    std::vector<std::vector<NeuralLayers>> models(candidates.size(), std::vector<NeuralLayers>(m_n_folds));
+
+    std::vector<size_t> alive(candidates.size());
+    std::iota(alive.begin(), alive.end(), 0);
+
+    int budget = min_epochs;
+    for (int round = 0; true; round++)
+    {
+        // Resume the training of the remaining candidates up to the budget of the round
+        std::vector<Params> round_candidates;
+        std::vector<int> round_first_epochs, round_epochs;
+        std::vector<std::vector<NeuralLayers>> round_models(alive.size());
+        bool all_complete = true;
+
+        for (size_t i = 0; i < alive.size(); i++)
+        {
+            const size_t &c = alive[i];
+            round_candidates.push_back(candidates[c]);
+            round_first_epochs.push_back(round == 0 ? 0 : last[c].epochs_trained);
+            round_epochs.push_back(std::min(budget, candidates[c].epochs));
+            round_models[i].swap(models[c]);
+            all_complete = all_complete && budget >= candidates[c].epochs;
+        }
+
+        const std::vector<Result> &round_results = __cross_validate(X, y, round_candidates, round_first_epochs, round_epochs, &round_models);
+
+        for (size_t i = 0; i < alive.size(); i++)
+        {
+            last[alive[i]] = round_results[i];
+            last_round[alive[i]] = round;
+            models[alive[i]].swap(round_models[i]);
+        }
+
+        // Stop when a single candidate remains or when the candidates cannot be trained longer
+        if (alive.size() == 1 || all_complete)
+            break;
+
+        // Keep the best 1/eta candidates
+        std::stable_sort(alive.begin(), alive.end(), [&](const size_t &a, const size_t &b)
+                         { return last[a].score > last[b].score; });
+        for (size_t i = std::max<size_t>(1, alive.size() / eta); i < alive.size(); i++)
+            models[alive[i]].clear();
+        alive.resize(std::max<size_t>(1, alive.size() / eta));
+
+        budget *= eta;
+    }
+
+    // Rank the candidates by the last round reached, then by score
+    std::vector<size_t> order(candidates.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](const size_t &a, const size_t &b)
+                     { return last_round[a] != last_round[b] ? last_round[a] > last_round[b] : last[a].score > last[b].score; });
+
+    results.clear();
+    for (const size_t &c : order)
+        results.push_back(last[c]);
+
+    return results;
+}
+
+std::vector<std::vector<size_t>> NeuralSearch::folds(const size_t &n_samples) const
+{
+    return __split_folds(n_samples);
+}
+
+const NeuralSearch::Result &NeuralSearch::best() const
+{
+    // Check if a search was done
+    if (results.empty())
+        throw std::runtime_error("The search must be done before getting the best result");
+
+    return results.front();
+}
@@ -0,0 +1,340 @@
+/**
+ * @file NeuralSparse.cpp
+ * @see include/NeuralSparse.hpp for definition.
+ * @brief The NeuralSparse class.
+ *
+ * This file contains the implementation of the NeuralSparse class.
+ *
+ * @author Manitas Bahri <https://github.com/B-Manitas>
+ * @date 2023/11
+ * @license MIT License
+ */
+
+// INCLUDES
+#include "../include/NeuralSparse.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+// ==================================================
+// CHECKS
+
+void NeuralSparse::__check_valid_csr() const
+{
+    // Check if the row pointers are of the right size
+    if (m_row_ptr.size() != m_height + 1 || m_row_ptr.front() != 0)
+        throw std::invalid_argument("The row pointers must be of size height + 1 and start with 0");
+
+    // Check if the row pointers are increasing
+    for (size_t i = 0; i < m_height; i++)
+        if (m_row_ptr[i] > m_row_ptr[i + 1])
+            throw std::invalid_argument("The row pointers must be increasing");
+
+    // Check if the column indices and the values are of the right size
+    if (m_col_idx.size() != m_row_ptr.back() || m_values.size() != m_row_ptr.back())
+        throw std::invalid_argument("The column indices and the values must be of size nnz");
+
+    // Check if the column indices are in range
+    for (const size_t &c : m_col_idx)
+        if (c >= m_width)
+            throw std::invalid_argument("The column indices must be lower than the width: " + std::to_string(m_width));
+}
+
+// ==================================================
+// CONSTRUCTORS
+
+NeuralSparse::NeuralSparse() {}
+
+NeuralSparse::NeuralSparse(const size_t &height, const size_t &width)
+    : m_height(height), m_width(width), m_row_ptr(height + 1, 0) {}
+
+NeuralSparse::NeuralSparse(const size_t &height, const size_t &width, const std::vector<size_t> &row_ptr, const std::vector<size_t> &col_idx, const std::vector<float> &values)
+    : m_height(height), m_width(width), m_row_ptr(row_ptr), m_col_idx(col_idx), m_values(values)
+{
+    __check_valid_csr();
+}
+
+// ==================================================
+// STATIC METHODS
+
+NeuralSparse NeuralSparse::from_dense(const cmatrix<float> &M, const float &epsilon)
+{
+    NeuralSparse S(M.height(), M.width());
+
+    // Keep only the values greater than epsilon
+    for (size_t r = 0; r < M.height(); r++)
+    {
+        for (size_t c = 0; c < M.width(); c++)
+        {
+            const float &value = M.cell(r, c);
+
+            if (std::fabs(value) > epsilon)
+            {
+                S.m_col_idx.push_back(c);
+                S.m_values.push_back(value);
+            }
+        }
+
+        S.m_row_ptr[r + 1] = S.m_values.size();
+    }
+
+    return S;
+}
+
+NeuralSparse NeuralSparse::from_triplets(const size_t &height, const size_t &width, const std::vector<size_t> &rows, const std::vector<size_t> &cols, const std::vector<float> &values)
+{
+    // Check if the triplets are valid
+    if (rows.size() != cols.size() || rows.size() != values.size())
+        throw std::invalid_argument("The rows, columns and values vectors must be of the same size");
+
+    for (size_t i = 0; i < rows.size(); i++)
+        if (rows[i] >= height || cols[i] >= width)
+            throw std::invalid_argument("The triplet (" + std::to_string(rows[i]) + ", " + std::to_string(cols[i]) + ") is out of range");
+
+    // Count the number of values in each row
+    NeuralSparse S(height, width);
+    for (const size_t &r : rows)
+        S.m_row_ptr[r + 1]++;
+
+    for (size_t r = 0; r < height; r++)
+        S.m_row_ptr[r + 1] += S.m_row_ptr[r];
+
+    // Scatter the triplets in their rows
+    std::vector<size_t> next(S.m_row_ptr.begin(), S.m_row_ptr.end() - 1);
+    std::vector<size_t> col_idx(rows.size());
+    std::vector<float> vals(rows.size());
+
+    for (size_t i = 0; i < rows.size(); i++)
+    {
+        const size_t k = next[rows[i]]++;
+        col_idx[k] = cols[i];
+        vals[k] = values[i];
+    }
+
+    // Sort each row by column and sum the duplicated entries
+    std::vector<size_t> row_ptr(height + 1, 0);
+    std::vector<size_t> order;
+    for (size_t r = 0; r < height; r++)
+    {
+        const size_t begin = S.m_row_ptr[r];
+        const size_t end = S.m_row_ptr[r + 1];
+
+        order.resize(end - begin);
+        for (size_t k = 0; k < order.size(); k++)
+            order[k] = begin + k;
+
+        std::sort(order.begin(), order.end(), [&](const size_t &a, const size_t &b)
+                  { return col_idx[a] < col_idx[b]; });
+
+        for (const size_t &k : order)
+        {
+            if (S.m_col_idx.size() > row_ptr[r] && S.m_col_idx.back() == col_idx[k])
+                S.m_values.back() += vals[k];
+            else
+            {
+                S.m_col_idx.push_back(col_idx[k]);
+                S.m_values.push_back(vals[k]);
+            }
+        }
+
+        row_ptr[r + 1] = S.m_values.size();
+    }
+
+    S.m_row_ptr = row_ptr;
+
+    return S;
+}
+
+// ==================================================
+// GETTERS
+
+size_t NeuralSparse::height() const
+{
+    return m_height;
+}
+
+size_t NeuralSparse::width() const
+{
+    return m_width;
+}
+
+size_t NeuralSparse::nnz() const
+{
+    return m_values.size();
+}
+
+float NeuralSparse::density() const
+{
+    if (is_empty())
+        return 0;
+
+    return (float)nnz() / ((float)m_height * (float)m_width);
+}
+
+bool NeuralSparse::is_empty() const
+{
+    return m_height == 0 || m_width == 0;
+}
+
+const std::vector<size_t> &NeuralSparse::row_ptr() const
+{
+    return m_row_ptr;
+}
+
+const std::vector<size_t> &NeuralSparse::col_idx() const
+{
+    return m_col_idx;
+}
+
+const std::vector<float> &NeuralSparse::values() const
+{
+    return m_values;
+}
+
+// ==================================================
+// METHODS
+
+cmatrix<float> NeuralSparse::to_dense() const
+{
+    cmatrix<float> M(m_height, m_width, 0);
+
+    for (size_t r = 0; r < m_height; r++)
+        for (size_t k = m_row_ptr[r]; k < m_row_ptr[r + 1]; k++)
+            M.cell(r, m_col_idx[k]) = m_values[k];
+
+    return M;
+}
+
+NeuralSparse NeuralSparse::transpose() const
+{
+    NeuralSparse T(m_width, m_height);
+    T.m_col_idx.resize(nnz());
+    T.m_values.resize(nnz());
+
+    // Count the number of values in each column
+    for (const size_t &c : m_col_idx)
+        T.m_row_ptr[c + 1]++;
+
+    for (size_t c = 0; c < m_width; c++)
+        T.m_row_ptr[c + 1] += T.m_row_ptr[c];
+
+    // Scatter the values: the rows are visited in order, so each new row is sorted
+    std::vector<size_t> next(T.m_row_ptr.begin(), T.m_row_ptr.end() - 1);
+    for (size_t r = 0; r < m_height; r++)
+    {
+        for (size_t k = m_row_ptr[r]; k < m_row_ptr[r + 1]; k++)
+        {
+            const size_t t = next[m_col_idx[k]]++;
+            T.m_col_idx[t] = r;
+            T.m_values[t] = m_values[k];
+        }
+    }
+
+    return T;
+}
+
+// ==================================================
+// PRODUCTS
+
+cmatrix<float> NeuralSparse::matmul(const cmatrix<float> &B, const bool &bias) const
+{
+    // Check if the height of B is valid
+    if (B.height() != m_width + (bias ? 1 : 0))
+        throw std::invalid_argument("The height of the dense matrix must be equal to: " + std::to_string(m_width + (bias ? 1 : 0)));
+
+    const size_t p = B.width();
+    cmatrix<float> out(m_height, p, 0);
+
+    // Each row of the result only reads the non-zero values of the same row
+#pragma omp parallel for schedule(dynamic, 64)
+    for (long r = 0; r < (long)m_height; r++)
+    {
+        for (size_t j = 0; j < p; j++)
+        {
+            float sum = bias ? B.cell(m_width, j) : 0;
+
+            for (size_t k = m_row_ptr[r]; k < m_row_ptr[r + 1]; k++)
+                sum += m_values[k] * B.cell(m_col_idx[k], j);
+
+            out.cell(r, j) = sum;
+        }
+    }
+
+    return out;
+}
+
+cmatrix<float> NeuralSparse::rmatmul(const cmatrix<float> &A, const bool &bias) const
+{
+    // Check if the width of A is valid
+    if (A.width() != m_height + (bias ? 1 : 0))
+        throw std::invalid_argument("The width of the dense matrix must be equal to: " + std::to_string(m_height + (bias ? 1 : 0)));
+
+    const size_t p = A.height();
+    cmatrix<float> out(p, m_width, 0);
+
+    // Each row of the result scatters the rows of S scaled by the row of A
+#pragma omp parallel for schedule(static)
+    for (long i = 0; i < (long)p; i++)
+    {
+        if (bias)
+            for (size_t c = 0; c < m_width; c++)
+                out.cell(i, c) = A.cell(i, m_height);
+
+        for (size_t r = 0; r < m_height; r++)
+        {
+            const float a = A.cell(i, r);
+
+            if (a == 0)
+                continue;
+
+            for (size_t k = m_row_ptr[r]; k < m_row_ptr[r + 1]; k++)
+                out.cell(i, m_col_idx[k]) += a * m_values[k];
+        }
+    }
+
+    return out;
+}
+
+void NeuralSparse::rmatmul_transpose_add(const cmatrix<float> &A, cmatrix<float> &out, const float &alpha, const bool &bias) const
+{
+    // Check if the sizes are valid
+    if (A.width() != m_width)
+        throw std::invalid_argument("The width of the dense matrix must be equal to: " + std::to_string(m_width));
+
+    if (out.height() != A.height() || out.width() != m_height + (bias ? 1 : 0))
+        throw std::invalid_argument("The output matrix must be of size " + std::to_string(A.height()) + "x" + std::to_string(m_height + (bias ? 1 : 0)));
+
+    const size_t p = A.height();
+
+    // Each row of S only updates its own column of the output
+#pragma omp parallel for schedule(dynamic, 64)
+    for (long r = 0; r < (long)m_height; r++)
+    {
+        if (m_row_ptr[r] == m_row_ptr[r + 1])
+            continue;
+
+        for (size_t i = 0; i < p; i++)
+        {
+            float sum = 0;
+
+            for (size_t k = m_row_ptr[r]; k < m_row_ptr[r + 1]; k++)
+                sum += A.cell(i, m_col_idx[k]) * m_values[k];
+
+            out.cell(i, r) += alpha * sum;
+        }
+    }
+
+    // The trailing row of ones adds the sum of each row of A
+    if (bias)
+    {
+        for (size_t i = 0; i < p; i++)
+        {
+            float sum = 0;
+
+            for (size_t c = 0; c < m_width; c++)
+                sum += A.cell(i, c);
+
+            out.cell(i, m_height) += alpha * sum;
+        }
+    }
+}
@@ -0,0 +1,165 @@
+/**
+ * @file NeuralThreadPool.cpp
+ * @see include/NeuralThreadPool.hpp for definition.
+ * @brief The NeuralThreadPool class.
+ *
+ * This file contains the implementation of the NeuralThreadPool class.
+ *
+ * @author Manitas Bahri <https://github.com/B-Manitas>
+ * @date 2023/11
+ * @license MIT License
+ */
+
+// INCLUDES
+#include "../include/NeuralThreadPool.hpp"
+
+#include <algorithm>
+
+// ==================================================
+// PRIVATE METHODS
+
+void NeuralThreadPool::__worker_loop(const size_t &id)
+{
+    std::function<void()> task;
+
+    while (true)
+    {
+        // Wait for a queued task or for the stop signal, then claim it
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cv_task.wait(lock, [&]
+                           { return m_stop || m_queued > 0; });
+
+            if (m_queued == 0)
+                return;
+
+            m_queued--;
+        }
+
+        // A claimed task is always in one of the queues
+        while (!__pop_task(id, task))
+            std::this_thread::yield();
+
+        try
+        {
+            task();
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_error)
+                m_error = std::current_exception();
+        }
+
+        // Notify the waiting threads when the last task is done
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (--m_pending == 0)
+            m_cv_done.notify_all();
+    }
+}
+
+bool NeuralThreadPool::__pop_task(const size_t &id, std::function<void()> &task)
+{
+    // Take the most recent task of the own queue
+    {
+        Queue &own = *m_queues[id];
+        std::lock_guard<std::mutex> lock(own.mutex);
+
+        if (!own.tasks.empty())
+        {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+
+    // Steal the oldest task of another queue
+    for (size_t i = 1; i < m_queues.size(); i++)
+    {
+        Queue &victim = *m_queues[(id + i) % m_queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+
+        if (!victim.tasks.empty())
+        {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// ==================================================
+// CONSTRUCTORS
+
+NeuralThreadPool::NeuralThreadPool(const size_t &n_threads) : m_next_queue(0)
+{
+    size_t n = n_threads;
+    if (n == 0)
+        n = std::max(1u, std::thread::hardware_concurrency());
+
+    for (size_t i = 0; i < n; i++)
+        m_queues.push_back(new Queue());
+
+    for (size_t i = 0; i < n; i++)
+        m_workers.push_back(std::thread(&NeuralThreadPool::__worker_loop, this, i));
+}
+
+NeuralThreadPool::~NeuralThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+
+    m_cv_task.notify_all();
+
+    for (std::thread &worker : m_workers)
+        worker.join();
+
+    for (Queue *queue : m_queues)
+        delete queue;
+}
+
+// ==================================================
+// METHODS
+
+size_t NeuralThreadPool::size() const
+{
+    return m_workers.size();
+}
+
+void NeuralThreadPool::submit(const std::function<void()> &task)
+{
+    // Push the task in the next queue
+    Queue &queue = *m_queues[m_next_queue++ % m_queues.size()];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(task);
+    }
+
+    // Wake up a worker
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queued++;
+        m_pending++;
+    }
+
+    m_cv_task.notify_one();
+}
+
+void NeuralThreadPool::wait()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_cv_done.wait(lock, [&]
+                   { return m_pending == 0; });
+
+    // Forward the first error thrown by a task
+    if (m_error)
+    {
+        std::exception_ptr error = m_error;
+        m_error = nullptr;
+        std::rethrow_exception(error);
+    }
+}
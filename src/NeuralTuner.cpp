@@ -0,0 +1,693 @@
+/**
+ * @file NeuralTuner.cpp
+ * @see include/NeuralTuner.hpp for definition.
+ * @brief The NeuralTuner class.
+ *
+ * This file contains the implementation of the NeuralTuner class.
+ *
+ * @author Manitas Bahri <https://github.com/B-Manitas>
+ * @date 2023/11
+ * @license MIT License
+ */
+
+// INCLUDES
+#include "../include/NeuralTuner.hpp"
+#include "../include/NeuralLayers.hpp"
+#include "../include/NeuralBlockSparse.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/**
+ * @brief The names of the kernels in the cache.
+ */
+static const char *KERNELS[] = {"NN", "NT", "TN"};
+
+/**
+ * @brief The key of a product: the kernel, if it is parallel, and its shape M, N, K.
+ */
+typedef std::tuple<int, int, size_t, size_t, size_t> GemmKey;
+
+/**
+ * @brief The key of a block sparse product: the number of units and of features of the layer, and the size of the blocks.
+ */
+typedef std::tuple<size_t, size_t, size_t, size_t> SparseKey;
+
+/**
+ * @brief The number of samples of the products timed to find the crossover of the block sparse format.
+ */
+static const size_t CROSSOVER_BATCH = 128;
+
+/**
+ * @brief The tuned configurations. A table is never modified once published, so the products read it without lock.
+ */
+struct TunerTable
+{
+    std::map<GemmKey, NeuralTuner::Config> gemm;
+    std::map<std::pair<size_t, uint64_t>, size_t> batch;
+    std::map<SparseKey, float> crossover;
+};
+
+static std::atomic<const TunerTable *> TABLE(nullptr);
+/**
+ * @brief The replaced tables. They stay alive, since a product may still read them.
+ */
+static std::vector<std::unique_ptr<TunerTable>> RETIRED;
+static std::mutex MUTEX;
+static std::once_flag LOADED;
+static std::atomic<int> AUTOMATIC(-1);
+
+/**
+ * @brief The products recorded by a tuning.
+ */
+static std::atomic<bool> RECORDING(false);
+static std::set<GemmKey> RECORDED;
+
+/**
+ * @brief The configuration forced by the tuning for the products of the calling thread, or nullptr.
+ */
+static thread_local const NeuralTuner::Config *FORCED = nullptr;
+
+/**
+ * @brief Publish a copy of the current table with the entries of another table. The caller holds MUTEX.
+ */
+static void publish(const TunerTable &entries)
+{
+    std::unique_ptr<TunerTable> table(new TunerTable());
+    if (const TunerTable *current = TABLE.load())
+        *table = *current;
+
+    for (const auto &entry : entries.gemm)
+        table->gemm[entry.first] = entry.second;
+    for (const auto &entry : entries.batch)
+        table->batch[entry.first] = entry.second;
+    for (const auto &entry : entries.crossover)
+        table->crossover[entry.first] = entry.second;
+
+    TABLE.store(table.get());
+    RETIRED.push_back(std::move(table));
+}
+
+/**
+ * @brief Parse an entry of the cache.
+ *
+ * @param line The entry.
+ * @param table The table where the entry is added.
+ * @param machine The machine of the entry.
+ * @return true if the entry is valid.
+ */
+static bool parse_entry(const std::string &line, TunerTable &table, std::string &machine)
+{
+    std::istringstream stream(line);
+    std::string type;
+    stream >> type;
+
+    if (type == "GEMM")
+    {
+        std::string kernel;
+        int parallel = 0;
+        size_t M = 0, N = 0, K = 0;
+        NeuralTuner::Config config;
+        stream >> kernel >> parallel >> M >> N >> K >> config.block >> config.threads;
+
+        const int k = std::find(KERNELS, KERNELS + 3, kernel) - KERNELS;
+        if (!stream || k == 3)
+            return false;
+
+        table.gemm[GemmKey(k, parallel != 0, M, N, K)] = config;
+    }
+
+    else if (type == "BATCH")
+    {
+        size_t n_features = 0, batch_size = 0;
+        uint64_t signature = 0;
+        stream >> n_features >> signature >> batch_size;
+
+        if (!stream || batch_size == 0)
+            return false;
+
+        table.batch[std::make_pair(n_features, signature)] = batch_size;
+    }
+
+    else if (type == "SPARSE")
+    {
+        size_t units = 0, K = 0, block_height = 0, block_width = 0;
+        float sparsity = -1;
+        stream >> units >> K >> block_height >> block_width >> sparsity;
+
+        if (!stream || sparsity < 0 || sparsity > 1)
+            return false;
+
+        table.crossover[SparseKey(units, K, block_height, block_width)] = sparsity;
+    }
+
+    else
+        return false;
+
+    std::getline(stream >> std::ws, machine);
+    return !machine.empty();
+}
+
+/**
+ * @brief Get the fastest time of a function, in seconds.
+ */
+template <class F>
+static double fastest(const size_t &repeats, const F &function)
+{
+    typedef std::chrono::steady_clock clock;
+    double best = -1;
+
+    // The first run warms up the caches and the threads
+    function();
+    for (size_t r = 0; r < repeats; r++)
+    {
+        const clock::time_point start = clock::now();
+        function();
+        const double seconds = std::chrono::duration<double>(clock::now() - start).count();
+
+        if (best < 0 || seconds < best)
+            best = seconds;
+    }
+
+    return best;
+}
+
+/**
+ * @brief Get the number of threads of the machine: $OMP_NUM_THREADS, or the number of processors.
+ * Unlike omp_get_max_threads(), it does not depend on the calling thread, e.g. a search worker limited to one thread.
+ */
+static size_t machine_threads()
+{
+    const char *env = std::getenv("OMP_NUM_THREADS");
+    if (env && std::atoi(env) > 0)
+        return std::atoi(env);
+
+#ifdef _OPENMP
+    return omp_get_num_procs();
+#else
+    return 1;
+#endif
+}
+
+// ==================================================
+// CONSTRUCTORS
+
+NeuralTuner::NeuralTuner(const std::string &path, const size_t &repeats) : m_path(path), m_repeats(repeats)
+{
+    if (repeats == 0)
+        throw std::invalid_argument("The number of runs of each candidate must be positive");
+}
+
+// ==================================================
+// PRIVATE METHODS
+
+NeuralTuner::Config NeuralTuner::__tune_gemm(const Kernel &kernel, const bool &parallel, const size_t &M, const size_t &N, const size_t &K) const
+{
+    // Random operands of the shape, stored without padding
+    std::mt19937 generator(0);
+    std::uniform_real_distribution<float> distribution(-1, 1);
+    std::vector<float> A(M * K), B(K * N), C(M * N);
+    for (float &a : A)
+        a = distribution(generator);
+    for (float &b : B)
+        b = distribution(generator);
+
+    // The candidate numbers of threads: serial, then a quarter, a half and all the threads of the machine
+    const size_t max_threads = machine_threads();
+    std::vector<size_t> threads = {1};
+    if (parallel)
+        for (const size_t &n : {max_threads / 4, max_threads / 2, max_threads})
+            if (n > threads.back())
+                threads.push_back(n);
+
+    Config best;
+    double best_seconds = -1;
+
+    for (const size_t &block : m_blocks)
+        for (const size_t &n_threads : threads)
+        {
+            Config candidate;
+            candidate.block = block;
+            candidate.threads = n_threads;
+            FORCED = &candidate;
+
+            const double seconds = fastest(m_repeats, [&]()
+                                           {
+                if (kernel == NN)
+                    NeuralLayer::__gemm_nn(M, N, K, A.data(), K, B.data(), N, C.data(), N, false, parallel);
+                else if (kernel == NT)
+                    NeuralLayer::__gemm_nt(M, N, K, A.data(), K, B.data(), K, C.data(), N, false, parallel);
+                else
+                    NeuralLayer::__gemm_tn(M, N, K, A.data(), M, B.data(), N, C.data(), N, false, parallel); });
+
+            FORCED = nullptr;
+            if (best_seconds < 0 || seconds < best_seconds)
+            {
+                best = candidate;
+                best_seconds = seconds;
+            }
+        }
+
+    return best;
+}
+
+size_t NeuralTuner::__tune_batch_size(NeuralLayers &model, const cmatrix<float> &X) const
+{
+    NeuralGraph &graph = model.m_graph;
+    const size_t n_inputs = graph.input_shape().size();
+    const size_t n_samples = X.width();
+
+    // The samples are scaled once, then repeated to fill each batch
+    std::vector<float> samples(n_samples * n_inputs);
+    model.m_scaler.transform(X, samples.data());
+
+    size_t best = 0;
+    double best_rate = 0;
+
+    for (const size_t &batch : m_batch_sizes)
+    {
+        graph.plan(batch);
+        float *input = graph.activation(0);
+        for (size_t s = 0; s < batch; s++)
+            std::copy(samples.begin() + (s % n_samples) * n_inputs, samples.begin() + (s % n_samples + 1) * n_inputs, input + s * n_inputs);
+
+        const double seconds = fastest(m_repeats, [&]()
+                                       { graph.forward(false); });
+        const double rate = batch / std::max(seconds, 1e-9);
+
+        if (rate > best_rate)
+        {
+            best = batch;
+            best_rate = rate;
+        }
+    }
+
+    return best;
+}
+
+float NeuralTuner::__tune_crossover(const size_t &units, const size_t &K, const size_t &block_height, const size_t &block_width) const
+{
+    // Random weights and samples of the shape, stored without padding
+    std::mt19937 generator(0);
+    std::uniform_real_distribution<float> distribution(-1, 1);
+    std::vector<float> W(units * K), X(CROSSOVER_BATCH * K), out(CROSSOVER_BATCH * units);
+    for (float &w : W)
+        w = distribution(generator);
+    for (float &x : X)
+        x = distribution(generator);
+
+    // The dense product of the forward of the layer, with its tuned configuration
+    const double dense = fastest(m_repeats, [&]()
+                                 { NeuralLayer::__gemm_nt(CROSSOVER_BATCH, units, K, X.data(), K, W.data(), K, out.data(), units, false, true); });
+
+    // The blocks are zeroed in a random order, so a sparsity s zeroes the first s * n_blocks blocks of the order
+    const size_t block_rows = (units + block_height - 1) / block_height;
+    const size_t block_cols = (K + block_width - 1) / block_width;
+    std::vector<size_t> order(block_rows * block_cols);
+    for (size_t b = 0; b < order.size(); b++)
+        order[b] = b;
+    std::shuffle(order.begin(), order.end(), generator);
+
+    // The block sparse product gets faster as the sparsity grows: bisect the sparsity where it beats the dense product
+    float low = 0, high = 1;
+    for (int step = 0; step < 6; step++)
+    {
+        const float sparsity = (low + high) / 2;
+        std::vector<float> pruned(W);
+
+        for (size_t b = 0; b < (size_t)(sparsity * order.size()); b++)
+        {
+            const size_t row = order[b] / block_cols * block_height, col = order[b] % block_cols * block_width;
+            for (size_t r = row; r < std::min(row + block_height, units); r++)
+                std::fill(pruned.begin() + r * K + col, pruned.begin() + r * K + std::min(col + block_width, K), 0.f);
+        }
+
+        const NeuralBlockSparse &S = NeuralBlockSparse::from_dense(pruned.data(), units, K, K, block_height, block_width);
+        const double seconds = fastest(m_repeats, [&]()
+                                       { S.matmul_transpose(X.data(), CROSSOVER_BATCH, out.data()); });
+
+        if (seconds <= dense)
+            high = sparsity;
+        else
+            low = sparsity;
+    }
+
+    return high;
+}
+
+uint64_t NeuralTuner::__signature(const NeuralLayers &model)
+{
+    // The input shape and the configuration of each layer, as they are saved
+    const NeuralGraph &graph = model.m_graph;
+    const NeuralLayer::Shape &shape = graph.input_shape();
+    std::ostringstream stream;
+    stream << shape.channels << " " << shape.height << " " << shape.width;
+
+    for (size_t i = 0; i < graph.size(); i++)
+    {
+        stream << ";";
+        graph.layer(i).save(stream);
+    }
+
+    // FNV-1a hash
+    uint64_t hash = 14695981039346656037ULL;
+    for (const char &c : stream.str())
+        hash = (hash ^ (unsigned char)c) * 1099511628211ULL;
+
+    return hash;
+}
+
+void NeuralTuner::__load_default()
+{
+    try
+    {
+        load(default_path());
+    }
+    catch (const std::exception &)
+    {
+        // The cache is only a hint: the products keep their default configuration
+    }
+}
+
+// ==================================================
+// METHODS
+
+NeuralTuner::Report NeuralTuner::tune(NeuralLayers &model, const cmatrix<float> &X, const bool &force)
+{
+    typedef std::chrono::steady_clock clock;
+    const clock::time_point start = clock::now();
+
+    // Check if the model is trained
+    if (!model.m_graph.is_built() || !model.m_scaler.is_fitted())
+        throw std::invalid_argument("The model must be trained before tuning");
+
+    if (X.height() != model.m_scaler.n_features() || X.width() == 0)
+        throw std::invalid_argument("The input must have " + std::to_string(model.m_scaler.n_features()) + " features");
+
+    std::call_once(LOADED, __load_default);
+
+    // Record the products of one forward and backward propagation of X
+    {
+        std::lock_guard<std::mutex> lock(MUTEX);
+        RECORDED.clear();
+    }
+
+    RECORDING = true;
+    try
+    {
+        model.__forward_propagation(X, true);
+        model.__back_propagation(std::vector<float>(X.width() * model.m_graph.output_size(), 0));
+    }
+    catch (...)
+    {
+        RECORDING = false;
+        throw;
+    }
+    RECORDING = false;
+
+    std::set<GemmKey> shapes;
+    {
+        std::lock_guard<std::mutex> lock(MUTEX);
+        shapes.swap(RECORDED);
+    }
+
+    // Tune the shapes which are not in the cache
+    Report report;
+    report.n_shapes = shapes.size();
+    const TunerTable *current = TABLE.load();
+    TunerTable winners;
+
+    for (const GemmKey &key : shapes)
+    {
+        if (!force && current && current->gemm.count(key))
+            continue;
+
+        winners.gemm[key] = __tune_gemm((Kernel)std::get<0>(key), std::get<1>(key), std::get<2>(key), std::get<3>(key), std::get<4>(key));
+        report.n_tuned++;
+    }
+
+    // Tune the crossover of the block sparse format of the dense layers, with the blocks of the pruner of the model
+    for (size_t i = 0; i < model.m_graph.size(); i++)
+    {
+        const NeuralDense *layer = dynamic_cast<const NeuralDense *>(&model.m_graph.layer(i));
+        if (!layer)
+            continue;
+
+        const SparseKey key(layer->output_shape().size(), layer->input_shape().size(), model.m_pruner.m_block_height, model.m_pruner.m_block_width);
+        if (force || !current || !current->crossover.count(key))
+            winners.crossover[key] = __tune_crossover(std::get<0>(key), std::get<1>(key), std::get<2>(key), std::get<3>(key));
+    }
+
+    const std::pair<size_t, uint64_t> batch_key(model.m_scaler.n_features(), __signature(model));
+    if (force || !current || !current->batch.count(batch_key))
+        winners.batch[batch_key] = __tune_batch_size(model, X);
+
+    // Publish and save the winners
+    if (!winners.gemm.empty() || !winners.batch.empty() || !winners.crossover.empty())
+    {
+        {
+            std::lock_guard<std::mutex> lock(MUTEX);
+            publish(winners);
+        }
+        save(m_path);
+    }
+
+    report.batch_size = batch_size(model, 0);
+    report.seconds = std::chrono::duration<double>(clock::now() - start).count();
+
+    return report;
+}
+
+// ==================================================
+// STATIC METHODS
+
+std::string NeuralTuner::machine()
+{
+    static const std::string model = []()
+    {
+        // The model name of the first CPU
+        std::string name = "unknown CPU";
+        std::ifstream cpuinfo("/proc/cpuinfo");
+        std::string line;
+
+        while (std::getline(cpuinfo, line))
+        {
+            const size_t colon = line.find(':');
+            if (line.compare(0, 10, "model name") != 0 || colon == std::string::npos)
+                continue;
+
+            const size_t begin = line.find_first_not_of(" \t", colon + 1);
+            const size_t end = line.find_last_not_of(" \t\r");
+            if (begin != std::string::npos)
+                name = line.substr(begin, end - begin + 1);
+            break;
+        }
+
+        return name;
+    }();
+
+    return model + ", " + std::to_string(machine_threads()) + " threads";
+}
+
+std::string NeuralTuner::default_path()
+{
+    if (const char *path = std::getenv("NEURALCPP_TUNING_CACHE"))
+        return path;
+
+    if (const char *home = std::getenv("HOME"))
+        return std::string(home) + "/.neuralcpp_tuning";
+
+    return ".neuralcpp_tuning";
+}
+
+NeuralTuner::Config NeuralTuner::config(const Kernel &kernel, const bool &parallel, const size_t &M, const size_t &N, const size_t &K)
+{
+    std::call_once(LOADED, __load_default);
+
+    if (FORCED)
+        return *FORCED;
+
+    const GemmKey key(kernel, parallel, M, N, K);
+    if (RECORDING)
+    {
+        std::lock_guard<std::mutex> lock(MUTEX);
+        RECORDED.insert(key);
+    }
+
+    const TunerTable *table = TABLE.load();
+    if (table)
+    {
+        const auto it = table->gemm.find(key);
+        if (it != table->gemm.end())
+            return it->second;
+    }
+
+    return Config();
+}
+
+size_t NeuralTuner::batch_size(const NeuralLayers &model, const size_t &fallback)
+{
+    std::call_once(LOADED, __load_default);
+
+    const TunerTable *table = TABLE.load();
+    if (!table || !model.m_graph.is_built() || !model.m_scaler.is_fitted())
+        return fallback;
+
+    const auto it = table->batch.find(std::make_pair(model.m_scaler.n_features(), __signature(model)));
+    return it == table->batch.end() ? fallback : it->second;
+}
+
+float NeuralTuner::crossover(const size_t &units, const size_t &K, const size_t &block_height, const size_t &block_width)
+{
+    std::call_once(LOADED, __load_default);
+
+    const SparseKey key(units, K, block_height, block_width);
+    const TunerTable *table = TABLE.load();
+    if (table)
+    {
+        const auto it = table->crossover.find(key);
+        if (it != table->crossover.end())
+            return it->second;
+    }
+
+    // Measure the shape once: the next calls read the table
+    TunerTable winners;
+    winners.crossover[key] = NeuralTuner().__tune_crossover(units, K, block_height, block_width);
+
+    std::lock_guard<std::mutex> lock(MUTEX);
+    publish(winners);
+
+    return winners.crossover[key];
+}
+
+bool NeuralTuner::load(const std::string &path)
+{
+    std::ifstream file(path);
+    if (!file)
+        return false;
+
+    // Keep the entries of this machine only
+    TunerTable entries;
+    std::string line;
+    size_t n_line = 0;
+
+    while (std::getline(file, line))
+    {
+        n_line++;
+        if (line.empty() || line[0] == '#')
+            continue;
+
+        TunerTable entry;
+        std::string name;
+        if (!parse_entry(line, entry, name))
+            throw std::runtime_error("Invalid entry at line " + std::to_string(n_line) + " of the tuning cache " + path);
+
+        if (name != machine())
+            continue;
+
+        entries.gemm.insert(entry.gemm.begin(), entry.gemm.end());
+        entries.batch.insert(entry.batch.begin(), entry.batch.end());
+        entries.crossover.insert(entry.crossover.begin(), entry.crossover.end());
+    }
+
+    std::lock_guard<std::mutex> lock(MUTEX);
+    publish(entries);
+
+    return true;
+}
+
+void NeuralTuner::save(const std::string &path)
+{
+    // The valid entries of the other machines are kept
+    std::vector<std::string> others;
+    std::ifstream current(path);
+    std::string line;
+
+    while (std::getline(current, line))
+    {
+        TunerTable entry;
+        std::string name;
+        if (!line.empty() && line[0] != '#' && parse_entry(line, entry, name) && name != machine())
+            others.push_back(line);
+    }
+    current.close();
+
+    // Write a new cache, then replace the old one, so a concurrent load never reads a partial cache
+    const std::string temporary = path + ".tmp";
+    std::ofstream file(temporary);
+    if (!file)
+        throw std::runtime_error("Unable to write the tuning cache " + temporary);
+
+    file << "# NeuralCPP tuning cache\n";
+    for (const std::string &other : others)
+        file << other << "\n";
+
+    const TunerTable *table = TABLE.load();
+    if (table)
+    {
+        for (const auto &entry : table->gemm)
+        {
+            const GemmKey &key = entry.first;
+            file << "GEMM " << KERNELS[std::get<0>(key)] << " " << std::get<1>(key) << " " << std::get<2>(key) << " " << std::get<3>(key) << " " << std::get<4>(key)
+                 << " " << entry.second.block << " " << entry.second.threads << " " << machine() << "\n";
+        }
+
+        for (const auto &entry : table->batch)
+            file << "BATCH " << entry.first.first << " " << entry.first.second << " " << entry.second << " " << machine() << "\n";
+
+        for (const auto &entry : table->crossover)
+        {
+            const SparseKey &key = entry.first;
+            file << "SPARSE " << std::get<0>(key) << " " << std::get<1>(key) << " " << std::get<2>(key) << " " << std::get<3>(key)
+                 << " " << entry.second << " " << machine() << "\n";
+        }
+    }
+
+    file.close();
+    if (!file || std::rename(temporary.c_str(), path.c_str()) != 0)
+    {
+        std::remove(temporary.c_str());
+        throw std::runtime_error("Unable to write the tuning cache " + path);
+    }
+}
+
+void NeuralTuner::clear()
+{
+    // The default cache is not loaded after a clear
+    std::call_once(LOADED, []() {});
+
+    std::lock_guard<std::mutex> lock(MUTEX);
+    TABLE.store(nullptr);
+}
+
+bool NeuralTuner::automatic()
+{
+    const int automatic = AUTOMATIC;
+    if (automatic >= 0)
+        return automatic;
+
+    const char *variable = std::getenv("NEURALCPP_AUTOTUNE");
+    return variable && std::string(variable) == "1";
+}
+
+void NeuralTuner::set_automatic(const bool &automatic)
+{
+    AUTOMATIC = automatic;
+}
@@ -0,0 +1,198 @@
+/**
+ * @file NeuralView.cpp
+ * @see include/NeuralView.hpp for definition.
+ * @brief The NeuralView class.
+ *
+ * This file contains the implementation of the NeuralView class.
+ *
+ * @author Manitas Bahri <https://github.com/B-Manitas>
+ * @date 2023/11
+ * @license MIT License
+ */
+
+// INCLUDES
+#include "../include/NeuralView.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// ==================================================
+// PRIVATE METHODS
+
+NeuralView NeuralView::__block(const size_t &row, const size_t &column, const size_t &height, const size_t &width) const
+{
+    NeuralView V = *this;
+    V.m_row += row;
+    V.m_column += column;
+    V.m_height = height;
+    V.m_width = width;
+
+    return V;
+}
+
+// ==================================================
+// CHECKS
+
+void NeuralView::__check_valid_range(const size_t &begin, const size_t &end, const size_t &size)
+{
+    if (begin >= end || end > size)
+        throw std::invalid_argument("The range [" + std::to_string(begin) + ", " + std::to_string(end) + "[ must be a non-empty range of [0, " + std::to_string(size) + "[");
+}
+
+// ==================================================
+// CONSTRUCTORS
+
+NeuralView::NeuralView() {}
+
+NeuralView::NeuralView(const cmatrix<float> &X)
+    : m_matrix(&X), m_height(X.height()), m_width(X.width()) {}
+
+NeuralView::NeuralView(const float *data, const size_t &height, const size_t &width, const size_t &ld)
+    : m_data(data), m_ld(ld ? ld : width), m_height(height), m_width(width)
+{
+    // Check if the rows do not overlap
+    if (m_ld < width)
+        throw std::invalid_argument("The distance between two rows must be at least the width");
+}
+
+// ==================================================
+// METHODS
+
+NeuralView NeuralView::rows(const size_t &i) const
+{
+    return rows(i, i + 1);
+}
+
+NeuralView NeuralView::rows(const size_t &begin, const size_t &end) const
+{
+    __check_valid_range(begin, end, height());
+
+    return m_transposed ? __block(0, begin, m_height, end - begin) : __block(begin, 0, end - begin, m_width);
+}
+
+NeuralView NeuralView::columns(const size_t &j) const
+{
+    return columns(j, j + 1);
+}
+
+NeuralView NeuralView::columns(const size_t &begin, const size_t &end) const
+{
+    __check_valid_range(begin, end, width());
+
+    return m_transposed ? __block(begin, 0, end - begin, m_width) : __block(0, begin, m_height, end - begin);
+}
+
+NeuralView NeuralView::transpose() const
+{
+    NeuralView V = *this;
+    V.m_transposed = !m_transposed;
+
+    return V;
+}
+
+cmatrix<float> NeuralView::to_cmatrix() const
+{
+    cmatrix<float> M(height(), width());
+
+    for (size_t i = 0; i < height(); i++)
+        for (size_t j = 0; j < width(); j++)
+            M.cell(i, j) = cell(i, j);
+
+    return M;
+}
+
+cmatrix<float> NeuralView::matmul(const NeuralView &B) const
+{
+    // Check if the sizes match
+    if (width() != B.height())
+        throw std::invalid_argument("The width of the left view (" + std::to_string(width()) + ") must be equal to the height of the right view (" + std::to_string(B.height()) + ")");
+
+    const size_t m = height(), n = B.width(), k = width();
+    cmatrix<float> out(m, n);
+
+#pragma omp parallel for schedule(static) if (m * n * k > 65536)
+    for (size_t i = 0; i < m; i++)
+    {
+        std::vector<float> acc(n, 0);
+
+        if (B.m_transposed)
+        {
+            // The columns of B are contiguous: dot products
+            for (size_t j = 0; j < n; j++)
+            {
+                const float *b = B.__row(j);
+                float sum = 0;
+
+                if (m_transposed)
+                    for (size_t p = 0; p < k; p++)
+                        sum += __row(p)[i] * b[p];
+                else
+                {
+                    const float *a = __row(i);
+#pragma omp simd reduction(+ : sum)
+                    for (size_t p = 0; p < k; p++)
+                        sum += a[p] * b[p];
+                }
+
+                acc[j] = sum;
+            }
+        }
+        else
+        {
+            // The rows of B are contiguous: the row i of the product accumulates the rows of B
+            for (size_t p = 0; p < k; p++)
+            {
+                const float a = cell(i, p);
+                if (a == 0)
+                    continue;
+
+                const float *b = B.__row(p);
+#pragma omp simd
+                for (size_t j = 0; j < n; j++)
+                    acc[j] += a * b[j];
+            }
+        }
+
+        for (size_t j = 0; j < n; j++)
+            out.cell(i, j) = acc[j];
+    }
+
+    return out;
+}
+
+void NeuralView::matvec(const float *x, float *out, const float &bias) const
+{
+    const size_t m = height(), n = width();
+
+    if (m_transposed)
+    {
+        // The columns of the view are contiguous: accumulate them
+        std::fill(out, out + m, bias);
+        for (size_t j = 0; j < n; j++)
+        {
+            const float *column = __row(j);
+            const float xj = x[j];
+
+#pragma omp simd
+            for (size_t i = 0; i < m; i++)
+                out[i] += column[i] * xj;
+        }
+
+        return;
+    }
+
+#pragma omp parallel for schedule(static) if (m * n > 65536)
+    for (size_t i = 0; i < m; i++)
+    {
+        const float *row = __row(i);
+        float sum = 0;
+
+#pragma omp simd reduction(+ : sum)
+        for (size_t j = 0; j < n; j++)
+            sum += row[j] * x[j];
+
+        out[i] = sum + bias;
+    }
+}
@@ -0,0 +1,84 @@
+/**
+ * @file NeuralAllocatorTest.cpp
+ * @brief The NeuralMemory class test.
+ *
+ * This file contains unit tests for the NeuralMemory and NeuralAllocator classes.
+ *
+ * @author Manitas Bahri
+ * @date 2023/11
+ * @license MIT License
+ */
+
+// INCLUDES
+#include <gtest/gtest.h>
+#include <cstdint>
+#include "../include/NeuralCPP.hpp"
+
+/** @brief Test the alignment and the statistics of a pool. */
+TEST(NeuralAllocatorTest, pool)
+{
+    NeuralMemory pool("test", NeuralMemory::EXPLICIT, true, 1 << 16);
+
+    // TEST 1: HEAP AND MAPPED BLOCKS ARE ALIGNED
+    void *small = pool.allocate(100);
+    void *large = pool.allocate(3 << 20);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(small) % NeuralMemory::ALIGNMENT, 0);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(large) % NeuralMemory::ALIGNMENT, 0);
+
+    // The explicit huge pages fall back to transparent huge pages if none is reserved
+    NeuralMemory::Stats stats = pool.stats();
+    EXPECT_EQ(stats.n_allocations, 2);
+    EXPECT_EQ(stats.bytes_in_use, 100 + (3 << 20));
+    EXPECT_GE(stats.mapped_bytes, (size_t)3 << 20);
+    EXPECT_LE(stats.huge_page_bytes, stats.mapped_bytes);
+
+    // TEST 2: THE BLOCKS ARE RELEASED
+    static_cast<float *>(large)[(3 << 18) - 1] = 1;
+    pool.deallocate(large, 3 << 20);
+    pool.deallocate(small, 100);
+
+    stats = pool.stats();
+    EXPECT_EQ(stats.n_deallocations, 2);
+    EXPECT_EQ(stats.bytes_in_use, 0);
+    EXPECT_EQ(stats.mapped_bytes, 0);
+    EXPECT_EQ(stats.peak_bytes, 100 + (3 << 20));
+
+    pool.reset_peak();
+    EXPECT_EQ(pool.stats().peak_bytes, 0);
+}
+
+/** @brief Test the buffers of the models allocated in their pools. */
+TEST(NeuralAllocatorTest, buffers)
+{
+    // TEST 1: A BUFFER STAYS IN ITS POOL
+    NeuralMemory pool("buffer");
+    const NeuralAllocator<float> allocator(pool);
+    NeuralBuffer a(1000, 1.f, allocator);
+
+    NeuralBuffer b = a;
+    EXPECT_EQ(&b.get_allocator().pool(), &pool);
+    EXPECT_EQ(pool.stats().bytes_in_use, 2000 * sizeof(float));
+
+    // TEST 2: THE GRAPH ALLOCATES ITS ACTIVATIONS AND ITS PARAMETERS IN THE POOLS
+    const size_t activations = NeuralMemory::activations().stats().bytes_in_use;
+    const size_t parameters = NeuralMemory::parameters().stats().bytes_in_use;
+    {
+        NeuralGraph graph;
+        graph.add(NeuralDense(32)).add(NeuralDense(2, NeuralLayer::SIGMOID, false));
+        graph.build(16);
+        graph.plan(64);
+
+        EXPECT_GE(NeuralMemory::activations().stats().bytes_in_use - activations, 64 * (16 + 32 + 2) * sizeof(float));
+        EXPECT_GE(NeuralMemory::parameters().stats().bytes_in_use - parameters, 2 * (32 * 17 + 2 * 32) * sizeof(float));
+    }
+
+    EXPECT_EQ(NeuralMemory::activations().stats().bytes_in_use, activations);
+    EXPECT_EQ(NeuralMemory::parameters().stats().bytes_in_use, parameters);
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,132 @@
+/**
+ * @file NeuralDistributedTest.cpp
+ * @brief The NeuralDistributed class test.
+ *
+ * This file contains unit tests for the NeuralDistributed class and the NeuralComm classes.
+ *
+ * @author Manitas Bahri
+ * @date 2023/11
+ * @license MIT License
+ */
+
+// INCLUDES
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include "../include/NeuralCPP.hpp"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+/** @brief Listen on a free port given by the system, or on $NEURALCPP_TEST_PORT. Returns the socket and sets the port. */
+int listen_free_port(int &port)
+{
+    const char *env = std::getenv("NEURALCPP_TEST_PORT");
+    const int fd = socket(AF_INET, SOCK_STREAM, 0);
+
+    sockaddr_in address;
+    socklen_t size = sizeof(address);
+    std::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(env ? std::atoi(env) : 0);
+    inet_pton(AF_INET, "127.0.0.1", &address.sin_addr);
+
+    if (bind(fd, (sockaddr *)&address, sizeof(address)) != 0 || listen(fd, 4) != 0 || getsockname(fd, (sockaddr *)&address, &size) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+
+    port = ntohs(address.sin_port);
+    return fd;
+}
+
+/** @brief Test that the workers train the same weights as a full-batch training on one process, with both transports. */
+TEST(NeuralDistributedTest, fit)
+{
+    cmatrix<float> X, y;
+    NeuralCPP::create_dataset(X, y, 301, 4, 2);
+
+    NeuralLayers reference({8});
+    reference.fit(X, y, 30, .5, 0);
+    const std::vector<float> &expected = reference.graph().parameters();
+
+    // TEST 1: SHARED MEMORY, THE SHARDS DO NOT HAVE THE SAME SIZE
+    NeuralLayers shm_model({8});
+    const NeuralDistributed::Report &report = NeuralDistributed(3).fit(shm_model, X, y, 30, .5);
+    EXPECT_EQ(report.n_workers, 3);
+    EXPECT_GT(report.samples_per_second, 0);
+    EXPECT_GE(report.overlap, 0);
+    EXPECT_LE(report.overlap, 1);
+    EXPECT_GT(report.serial_seconds, 0);
+    EXPECT_GT(report.speedup, 0);
+    EXPECT_FLOAT_EQ(report.efficiency, report.speedup / 3);
+
+    const std::vector<float> &shm_weights = shm_model.graph().parameters();
+    ASSERT_EQ(shm_weights.size(), expected.size());
+    for (size_t i = 0; i < expected.size(); i++)
+        EXPECT_NEAR(shm_weights[i], expected[i], 1e-4);
+
+    // TEST 2: TCP, FROM A FREE PORT SO THAT PARALLEL RUNS DO NOT COLLIDE
+    int port = 0;
+    const int fd = listen_free_port(port);
+    ASSERT_GE(fd, 0);
+    close(fd);
+
+    NeuralLayers tcp_model({8});
+    NeuralDistributed(2, NeuralDistributed::TCP, port).fit(tcp_model, X, y, 30, .5);
+
+    const std::vector<float> &tcp_weights = tcp_model.graph().parameters();
+    ASSERT_EQ(tcp_weights.size(), expected.size());
+    for (size_t i = 0; i < expected.size(); i++)
+        EXPECT_NEAR(tcp_weights[i], expected[i], 1e-4);
+}
+
+/** @brief Test the invalid trainings. */
+TEST(NeuralDistributedTest, invalid)
+{
+    cmatrix<float> X, y;
+    NeuralCPP::create_dataset(X, y, 3, 2, 2);
+
+    EXPECT_THROW(NeuralDistributed(0), std::invalid_argument);
+
+    // More workers than samples
+    NeuralLayers model({2});
+    EXPECT_THROW(NeuralDistributed(4).fit(model, X, y, 2, .1), std::invalid_argument);
+
+    // The sparse gradients of an embedding are not reduced
+    NeuralGraph graph;
+    graph.add(NeuralEmbedding(10, 2)).add(NeuralDense(1));
+    NeuralLayers embedding(graph);
+    EXPECT_THROW(NeuralDistributed(2).fit(embedding, X, y, 2, .1), std::invalid_argument);
+    EXPECT_THROW(NeuralDistributed(2).fit(model, X, cmatrix<float>(1, 2, 0), 2, .1), std::invalid_argument);
+}
+
+/** @brief Test that the failure of a worker stops the training, instead of the others waiting for it forever. */
+TEST(NeuralDistributedTest, failure)
+{
+    cmatrix<float> X, y;
+    NeuralCPP::create_dataset(X, y, 60, 2, 2);
+
+    // The port of the worker 1 is taken: it fails, while the workers 0 and 2 wait for it in the ring
+    int port = 0;
+    const int fd = listen_free_port(port);
+    ASSERT_GE(fd, 0);
+
+    NeuralLayers model({4});
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    EXPECT_THROW(NeuralDistributed(3, NeuralDistributed::TCP, port - 1).fit(model, X, y, 1000, .1), std::runtime_error);
+    EXPECT_LT(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(), 10);
+    close(fd);
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,113 @@
+/**
+ * @file NeuralEmbeddingTest.cpp
+ * @brief The NeuralEmbedding class test.
+ *
+ * This file contains unit tests for the NeuralEmbedding class.
+ *
+ * @author Manitas Bahri
+ * @date 2023/11
+ * @license MIT License
+ */
+
+// INCLUDES
+#include <gtest/gtest.h>
+#include <cstdio>
+#include "../include/NeuralCPP.hpp"
+
+/** @brief Test the gather of the rows and the sparse update of the rows of the batch. */
+TEST(NeuralEmbeddingTest, sparse)
+{
+    NeuralEmbedding embedding(1000, 3, NeuralEmbedding::SUM);
+    embedding.build(NeuralLayer::Shape(2), 1);
+    const std::vector<float> table(embedding.parameters().begin(), embedding.parameters().end());
+
+    // The second ID of the first sample is missing
+    const std::vector<float> in = {5, -1, 5, 7};
+    std::vector<float> out(6);
+    embedding.forward(in.data(), out.data(), 2, true);
+
+    for (size_t d = 0; d < 3; d++)
+    {
+        EXPECT_FLOAT_EQ(out[d], table[15 + d]);
+        EXPECT_FLOAT_EQ(out[3 + d], table[15 + d] + table[21 + d]);
+    }
+
+    // TEST 1: ONLY THE ROWS OF THE BATCH ARE UPDATED
+    std::vector<float> d_out = {1, 1, 1, 2, 2, 2};
+    embedding.backward(in.data(), out.data(), d_out.data(), nullptr, 2);
+    embedding.update(.1);
+    EXPECT_EQ(embedding.touched(), std::vector<uint32_t>({5, 7}));
+
+    for (size_t i = 0; i < table.size(); i++)
+    {
+        const float step = i / 3 == 5 ? .3 : i / 3 == 7 ? .2 : 0;
+        EXPECT_NEAR(embedding.parameters()[i], table[i] - step, 1e-6);
+    }
+
+    // TEST 2: CONCATENATION AND INVALID IDS
+    NeuralEmbedding concat(1000, 3);
+    EXPECT_EQ(concat.build(NeuralLayer::Shape(2), 1).size(), 6);
+    concat.forward(in.data(), out.data(), 1, false);
+    EXPECT_FLOAT_EQ(out[1], table[16]);
+    EXPECT_FLOAT_EQ(out[4], 0);
+
+    const std::vector<float> invalid = {1000, 2.5};
+    EXPECT_THROW(concat.forward(invalid.data(), out.data(), 1, false), std::invalid_argument);
+    EXPECT_THROW(NeuralEmbedding(0, 3), std::invalid_argument);
+
+    // TEST 3: MEAN, A ROW SHARED BY ALL THE SAMPLES OF A LARGE BATCH
+    NeuralEmbedding mean(100, 3, NeuralEmbedding::MEAN);
+    mean.build(NeuralLayer::Shape(2), 1);
+    const std::vector<float> rows(mean.parameters().begin(), mean.parameters().end());
+
+    std::vector<float> ids(2000), outputs(3000), ones(3000, 1);
+    for (size_t s = 0; s < 1000; s++)
+    {
+        ids[2 * s] = 3;
+        ids[2 * s + 1] = s % 4 ? 10.f + s % 10 : -1.f;
+    }
+
+    mean.forward(ids.data(), outputs.data(), 1000, true);
+    mean.backward(ids.data(), outputs.data(), ones.data(), nullptr, 1000);
+    mean.update(.001);
+
+    // 250 samples have the row 3 only, the others share their gradient with a second row
+    EXPECT_EQ(mean.touched().size(), 11);
+    EXPECT_NEAR(mean.parameters()[9], rows[9] - .001 * (250 + 750 * .5), 1e-4);
+    EXPECT_NEAR(mean.parameters()[33], rows[33] - .001 * 100 * .5, 1e-4);
+}
+
+/** @brief Test that a model with an embedding of categorical IDs is trained, saved and loaded. */
+TEST(NeuralEmbeddingTest, model)
+{
+    // The label is the parity of the first ID, the second ID is noise
+    cmatrix<float> X(2, 400), y(1, 400);
+    for (size_t j = 0; j < 400; j++)
+    {
+        X.cell(0, j) = (j * 7) % 50;
+        X.cell(1, j) = (j * 13) % 31;
+        y.cell(0, j) = (int)X.cell(0, j) % 2;
+    }
+
+    NeuralGraph graph;
+    graph.add(NeuralEmbedding(50, 4, NeuralEmbedding::CONCAT, NeuralEmbedding::ADAGRAD)).add(NeuralDense(1));
+
+    NeuralLayers model(graph);
+    model.fit(X, y, 300, .5, 0);
+
+    const cmatrix<float> &accuracy = cmatrix<float>(model.predict(X).eq(cmatrix<cbool>(y)));
+    EXPECT_GT(accuracy.sum_all() / X.width(), .95);
+
+    model.save("neural_embedding_test.model");
+    NeuralLayers loaded;
+    loaded.load("neural_embedding_test.model");
+    std::remove("neural_embedding_test.model");
+    EXPECT_EQ(loaded.predict(X), model.predict(X));
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+
+    return RUN_ALL_TESTS();
+}
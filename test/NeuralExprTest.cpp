@@ -0,0 +1,126 @@
+/**
+ * @file NeuralExprTest.cpp
+ * @brief The NeuralExpr expression templates test.
+ *
+ * This file contains unit tests for the NeuralExpr expression templates.
+ *
+ * @author Manitas Bahri
+ * @date 2023/11
+ * @license MIT License
+ */
+
+// INCLUDES
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include "../include/NeuralCPP.hpp"
+
+/**
+ * @brief The number of allocations of the program, counted by the global operator new.
+ */
+static std::atomic<size_t> n_allocations(0);
+
+void *operator new(std::size_t size)
+{
+    n_allocations++;
+    if (void *block = std::malloc(size ? size : 1))
+        return block;
+
+    throw std::bad_alloc();
+}
+
+void operator delete(void *block) noexcept
+{
+    std::free(block);
+}
+
+void operator delete(void *block, std::size_t) noexcept
+{
+    std::free(block);
+}
+
+/** @brief Test that the expressions give the values of the operators of the matrices. */
+TEST(NeuralExprTest, values)
+{
+    const cmatrix<float> &A = cmatrix<float>::randfloat(300, 400, -1, 1, 1);
+    const cmatrix<float> &B = cmatrix<float>::randfloat(300, 400, -1, 1, 2);
+
+    // TEST 1: REDUCTIONS
+    EXPECT_NEAR((NeuralLazy(A) - NeuralLazy(B)).square().sum_all(), ((A - B) ^ 2).sum_all(), 1e-1);
+    EXPECT_NEAR((NeuralLazy(A) - NeuralLazy(B)).abs().sum_all(), (A - B).abs().sum_all(), 1e-1);
+
+    // TEST 2: EVALUATION, IN PLACE
+    const cmatrix<float> &C = (2 * NeuralLazy(A) + NeuralLazy(B) / 4 - 1).eval();
+    cmatrix<float> W = A;
+    (NeuralLazy(W) - .1f * NeuralLazy(B)).eval_to(W);
+    const cmatrix<float> &S = (-NeuralLazy(A)).sign().eval();
+
+    for (size_t i = 0; i < 300; i += 7)
+        for (size_t j = 0; j < 400; j += 11)
+        {
+            EXPECT_FLOAT_EQ(C.cell(i, j), 2 * A.cell(i, j) + B.cell(i, j) / 4 - 1);
+            EXPECT_FLOAT_EQ(W.cell(i, j), A.cell(i, j) - .1f * B.cell(i, j));
+            EXPECT_FLOAT_EQ(S.cell(i, j), A.cell(i, j) > 0 ? -1 : 1);
+        }
+
+    // TEST 3: A ROW MATRIX AND ROWS SPLIT BETWEEN BLOCKS, REDUCED IN DOUBLE
+    const cmatrix<float> &targets = cmatrix<float>::randfloat(1, 300001, 0, 1, 3);
+    const cmatrix<float> &D = cmatrix<float>::randfloat(301, 777, -1, 1, 4);
+    for (const cmatrix<float> *M : {&targets, &D})
+    {
+        double expected = 0;
+        for (size_t i = 0; i < M->height(); i++)
+            for (size_t j = 0; j < M->width(); j++)
+                expected += (double)M->cell(i, j) * M->cell(i, j);
+
+        EXPECT_NEAR(NeuralLazy(*M).square().sum_all(), expected, 1e-6 * expected);
+
+        const cmatrix<float> &E = (NeuralLazy(*M) + 1).eval();
+        for (size_t i = 0; i < M->height(); i++)
+            for (size_t j = 0; j < M->width(); j++)
+                ASSERT_EQ(E.cell(i, j), M->cell(i, j) + 1);
+    }
+
+    EXPECT_THROW(NeuralLazy(A) + NeuralLazy(A.transpose()), std::invalid_argument);
+}
+
+/** @brief Test that a chain of operations allocates at most its output, against a temporary per operation. */
+TEST(NeuralExprTest, allocations)
+{
+    const cmatrix<float> &A = cmatrix<float>::randfloat(100, 50, -1, 1, 1);
+    const cmatrix<float> &B = cmatrix<float>::randfloat(100, 50, -1, 1, 2);
+    cmatrix<float> W = A;
+
+    // The allocations of one matrix of the size of A
+    size_t start = n_allocations;
+    const cmatrix<float> output(100, 50);
+    const size_t n_matrix = n_allocations - start;
+
+    // TEST 1: NO ALLOCATION FOR A REDUCTION OR AN UPDATE IN PLACE
+    start = n_allocations;
+    const float loss = (NeuralLazy(A) - NeuralLazy(B)).square().sum_all();
+    (NeuralLazy(W) - .1f * NeuralLazy(B)).eval_to(W);
+    EXPECT_EQ(n_allocations - start, 0);
+
+    // TEST 2: ONE MATRIX FOR AN EVALUATION
+    start = n_allocations;
+    const cmatrix<float> &C = (2 * NeuralLazy(A) + NeuralLazy(B) / 4 - 1).eval();
+    EXPECT_EQ(n_allocations - start, n_matrix);
+
+    // The same chains with the operators of the matrices allocate a temporary per operation
+    start = n_allocations;
+    const float eager_loss = ((A - B) ^ 2).sum_all();
+    const cmatrix<float> &eager = A * 2 + B / 4 - 1;
+    EXPECT_GE(n_allocations - start, 4 * n_matrix);
+
+    EXPECT_NEAR(loss, eager_loss, 1e-2);
+    EXPECT_FLOAT_EQ(C.cell(3, 4), eager.cell(3, 4));
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,196 @@
+/**
+ * @file NeuralGraphTest.cpp
+ * @brief The NeuralGraph class test.
+ *
+ * This file contains unit tests for the NeuralGraph class and its layers.
+ *
+ * @author Manitas Bahri
+ * @date 2023/11
+ * @license MIT License
+ */
+
+// INCLUDES
+#include <gtest/gtest.h>
+#include <cmath>
+#include <sstream>
+#include "../include/NeuralCPP.hpp"
+
+/** @brief Computes the mean cross-entropy of the sigmoid output of the graph. */
+double loss(NeuralGraph &graph, const std::vector<float> &X, const std::vector<float> &y)
+{
+    std::copy(X.begin(), X.end(), graph.activation(0));
+    const float *output = graph.forward(false);
+
+    double sum = 0;
+    for (size_t i = 0; i < y.size(); i++)
+        sum -= y[i] * std::log(output[i]) + (1 - y[i]) * std::log(1 - output[i]);
+
+    return sum / graph.batch();
+}
+
+/** @brief Compares the gradients of every parameter of the graph with finite differences. */
+void check_gradients(NeuralGraph &graph, const size_t &batch)
+{
+    const size_t n_features = graph.input_shape().size();
+    graph.build(n_features, 1);
+    graph.plan(batch);
+
+    const cmatrix<float> &R = cmatrix<float>::randfloat(batch, n_features + graph.output_size(), -1, 1, 7);
+    std::vector<float> X, y;
+    for (size_t s = 0; s < batch; s++)
+    {
+        for (size_t f = 0; f < n_features; f++)
+            X.push_back(R.cell(s, f));
+
+        for (size_t o = 0; o < graph.output_size(); o++)
+            y.push_back(R.cell(s, n_features + o) > 0);
+    }
+
+    loss(graph, X, y);
+    graph.backward(y);
+
+    const float epsilon = 1e-3;
+    for (size_t i = 0; i < graph.size(); i++)
+    {
+        NeuralBuffer &parameters = graph.layer(i).parameters();
+        const NeuralBuffer gradients = graph.layer(i).gradients();
+
+        for (size_t p = 0; p < parameters.size(); p++)
+        {
+            const float value = parameters[p];
+            parameters[p] = value + epsilon;
+            const double loss_plus = loss(graph, X, y);
+            parameters[p] = value - epsilon;
+            const double loss_minus = loss(graph, X, y);
+            parameters[p] = value;
+
+            EXPECT_NEAR(gradients[p], (loss_plus - loss_minus) / (2 * epsilon), 2e-3) << "layer " << i << ", parameter " << p;
+        }
+    }
+}
+
+/** @brief Test the gradients of each layer. */
+TEST(NeuralGraphTest, gradients)
+{
+    // TEST 1: DENSE
+    NeuralGraph dense;
+    dense.add(NeuralDense(3)).add(NeuralDense(2, NeuralLayer::SIGMOID, false));
+    dense.build(4);
+    check_gradients(dense, 5);
+
+    // TEST 2: CONV1D AND AVERAGE POOLING
+    NeuralGraph conv1d(NeuralLayer::Shape(1, 1, 8));
+    conv1d.add(NeuralConv1D(2, 3, 1, 1, NeuralLayer::SIGMOID)).add(NeuralPool(1, 2, NeuralPool::AVERAGE)).add(NeuralDense(1));
+    check_gradients(conv1d, 3);
+
+    // TEST 3: CONV2D (DIRECT AND IM2COL) AND MAX POOLING
+    NeuralGraph conv2d(NeuralLayer::Shape(1, 6, 6));
+    conv2d.add(NeuralConv2D(2, 2, 2, 1, 0, NeuralLayer::SIGMOID)).add(NeuralConv2D(3, 3, 3, 1, 1, NeuralLayer::SIGMOID));
+    conv2d.add(NeuralPool(2, 2)).add(NeuralDense(1));
+    check_gradients(conv2d, 3);
+
+    // TEST 4: INVALID SHAPE
+    NeuralGraph invalid(NeuralLayer::Shape(1, 2, 2));
+    invalid.add(NeuralConv2D(1, 3, 3));
+    EXPECT_THROW(invalid.build(4), std::invalid_argument);
+    EXPECT_THROW(invalid.build(5), std::invalid_argument);
+}
+
+/** @brief Test the gradients of the recurrent layers, through the time steps, and the truncation of the backpropagation. */
+TEST(NeuralGraphTest, recurrent)
+{
+    // TEST 1: LSTM, ALL THE STATES
+    NeuralGraph lstm(NeuralLayer::Shape(2, 1, 5));
+    lstm.add(NeuralLSTM(3, true)).add(NeuralDense(1));
+    check_gradients(lstm, 3);
+
+    // TEST 2: GRU, THE LAST STATE
+    NeuralGraph gru(NeuralLayer::Shape(2, 1, 5));
+    gru.add(NeuralGRU(3)).add(NeuralDense(1));
+    check_gradients(gru, 3);
+
+    // TEST 3: TRUNCATION
+    const cmatrix<float> &R = cmatrix<float>::randfloat(1, 20, -1, 1, 3);
+    std::vector<float> in(20), out(6, 0), d_out(6, 1), d_full(20), d_truncated(20);
+
+    for (size_t i = 0; i < 20; i++)
+        in[i] = R.cell(0, i);
+
+    NeuralGRU full(3), truncated(3, false, 2);
+    full.build(NeuralLayer::Shape(2, 1, 5), 1);
+    truncated.build(NeuralLayer::Shape(2, 1, 5), 1);
+    full.forward(in.data(), out.data(), 2, true);
+    full.backward(in.data(), out.data(), d_out.data(), d_full.data(), 2);
+    truncated.forward(in.data(), out.data(), 2, true);
+    truncated.backward(in.data(), out.data(), d_out.data(), d_truncated.data(), 2);
+
+    // Only the two last time steps have a gradient, the same as without truncation
+    for (size_t i = 0; i < 20; i++)
+    {
+        EXPECT_NE(d_full[i], 0);
+        EXPECT_NEAR(d_truncated[i], i % 5 < 3 ? 0 : d_full[i], 1e-6);
+    }
+    EXPECT_THROW(full.build(NeuralLayer::Shape(2, 2, 5), 1), std::invalid_argument);
+    EXPECT_THROW(NeuralGRU(3, true, 2), std::invalid_argument);
+}
+
+/** @brief Test the dropout in training and inference mode. */
+TEST(NeuralGraphTest, dropout)
+{
+    NeuralDropout dropout(.25, 3);
+    dropout.build(NeuralLayer::Shape(1000), 0);
+    dropout.plan(2);
+
+    std::vector<float> in(2000, 1), out(2000), d_out(2000, 1), d_in(2000);
+
+    // TEST 1: TRAINING
+    dropout.forward(in.data(), out.data(), 2, true);
+    dropout.backward(in.data(), out.data(), d_out.data(), d_in.data(), 2);
+
+    size_t n_kept = 0;
+    for (size_t i = 0; i < out.size(); i++)
+    {
+        EXPECT_TRUE(out[i] == 0 || std::fabs(out[i] - 1 / .75f) < 1e-6);
+        EXPECT_FLOAT_EQ(d_in[i], out[i]);
+        n_kept += out[i] != 0;
+    }
+
+    EXPECT_NEAR(n_kept / 2000., .75, .05);
+
+    // TEST 2: INFERENCE
+    dropout.forward(in.data(), out.data(), 2, false);
+    EXPECT_EQ(out, in);
+}
+
+/** @brief Test that a model built from a graph is trained, saved and loaded. */
+TEST(NeuralGraphTest, model)
+{
+    cmatrix<float> X, y;
+    NeuralCPP::create_dataset(X, y, 200, 4, 2);
+
+    NeuralGraph graph(NeuralLayer::Shape(1, 2, 2));
+    graph.add(NeuralConv2D(4, 2, 2, 1, 1)).add(NeuralPool(2, 2)).add(NeuralDropout(.1)).add(NeuralDense(8)).add(NeuralDense(1));
+
+    NeuralLayers model(graph, NeuralScaler(NeuralScaler::STANDARD));
+    model.fit(X, y, 200, .5, 0);
+
+    const cmatrix<float> &accuracy = cmatrix<float>(model.predict(X).eq(cmatrix<cbool>(y)));
+    EXPECT_GT(accuracy.sum_all() / X.width(), .8);
+
+    // TEST 1: SAVE AND LOAD
+    model.save("neural_graph_test.model");
+    NeuralLayers loaded;
+    loaded.load("neural_graph_test.model");
+    std::remove("neural_graph_test.model");
+    EXPECT_EQ(loaded.predict(X), model.predict(X));
+
+    // TEST 2: OUTPUT MISMATCH
+    EXPECT_THROW(model.fit(X, cmatrix<float>(2, X.width(), 0), 1, .5, 0), std::invalid_argument);
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,111 @@
+/**
+ * @file NeuralHogwildTest.cpp
+ * @brief The NeuralHogwild class test.
+ *
+ * This file contains unit tests for the NeuralHogwild class and the asynchronous fits.
+ *
+ * @author Manitas Bahri
+ * @date 2023/11
+ * @license MIT License
+ */
+
+// INCLUDES
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include "../include/NeuralCPP.hpp"
+
+/** @brief Computes the accuracy of the predictions of a model. */
+template <class Model, class Input>
+float accuracy(Model &model, const Input &X, const cmatrix<float> &y)
+{
+    const cmatrix<float> &correct = cmatrix<float>(model.predict(X).eq(cmatrix<cbool>(y)));
+    return correct.sum_all() / y.width();
+}
+
+/** @brief Test that the asynchronous fits reach the accuracy of the synchronous fits, dense and sparse. */
+TEST(NeuralHogwildTest, convergence)
+{
+    // TEST 1: DENSE
+    cmatrix<float> X, y;
+    NeuralCPP::create_dataset(X, y, 1000, 4, 2);
+
+    NeuralLayers sync({8}), async({8});
+    sync.fit(X, y, 500, .5, 0);
+    async.fit_async(X, y, 10, .1, 0, 4, 2);
+
+    const float sync_accuracy = accuracy(sync, X, y);
+    EXPECT_GT(sync_accuracy, .8);
+    EXPECT_NEAR(accuracy(async, X, y), sync_accuracy, .05);
+    EXPECT_GT(async.throughput, 0);
+
+    // TEST 2: SPARSE
+    NeuralSparse Xs;
+    cmatrix<float> ys;
+    NeuralCPP::create_dataset(Xs, ys, 2000, 100, .1f, 2, 1);
+
+    NeuralLayers sync_sparse({8}), async_sparse({8});
+    sync_sparse.fit(Xs, ys, 500, .5, 0);
+    async_sparse.fit_async(Xs, ys, 10, .1, 0, 4);
+
+    const float sync_sparse_accuracy = accuracy(sync_sparse, Xs, ys);
+    EXPECT_GT(sync_sparse_accuracy, .8);
+    EXPECT_NEAR(accuracy(async_sparse, Xs, ys), sync_sparse_accuracy, .05);
+    EXPECT_GT(async_sparse.throughput, 0);
+
+    // TEST 3: PERCEPTRON, THE LABELS ARE -1 OR 1
+    cmatrix<float> y_signs(1000, 1);
+    for (size_t j = 0; j < 1000; j++)
+        y_signs.cell(j, 0) = y.cell(0, j) ? 1 : -1;
+
+    NeuralPerceptron perceptron;
+    perceptron.fit_async(X.transpose(), y_signs, 10, .01, 4);
+
+    const cmatrix<float> &correct = cmatrix<float>((perceptron.predict(X.transpose()) > 0).eq(y_signs > 0));
+    EXPECT_GT(correct.sum_all() / 1000, .8);
+    EXPECT_GT(perceptron.throughput, 0);
+}
+
+/** @brief Test the validation of the arguments, and that the replicas are released when a step or the callback throws. */
+TEST(NeuralHogwildTest, invalid)
+{
+    EXPECT_THROW(NeuralHogwild(2, 0), std::invalid_argument);
+    EXPECT_THROW(NeuralHogwild(2, 3), std::invalid_argument);
+    EXPECT_EQ(NeuralHogwild(2, 2).n_threads(), 2);
+
+    NeuralHogwild hogwild(4, 2);
+    const std::vector<float> weights(1000, 1);
+    const NeuralHogwild::Step step = [](const size_t &sample, NeuralHogwild::Weights &w, const size_t &)
+    { w.add(sample, 1); };
+    EXPECT_THROW(hogwild.run(weights, 10, 0, step), std::invalid_argument);
+
+    // The replicas are released by every exit
+    const size_t bytes_in_use = NeuralMemory::parameters().stats().bytes_in_use;
+    EXPECT_THROW(hogwild.run(weights, 10, 2, [](const size_t &sample, NeuralHogwild::Weights &, const size_t &)
+                             { if (sample == 7) throw std::runtime_error("step"); }),
+                 std::runtime_error);
+    EXPECT_THROW(hogwild.run(weights, 10, 2, step, [](const int &, const std::vector<float> &) -> bool
+                             { throw std::runtime_error("callback"); }),
+                 std::runtime_error);
+    EXPECT_EQ(NeuralMemory::parameters().stats().bytes_in_use, bytes_in_use);
+
+    // Each sample is added once per epoch to each replica, then the replicas are averaged
+    const std::vector<float> &result = hogwild.run(weights, 10, 3, step);
+    EXPECT_FLOAT_EQ(result[0], 1 + 3 * .5);
+    EXPECT_FLOAT_EQ(result[10], 1);
+
+    // The asynchronous fits of the models
+    cmatrix<float> X, y;
+    NeuralCPP::create_dataset(X, y, 50, 3, 2);
+    NeuralGraph graph;
+    graph.add(NeuralDense(1));
+    NeuralLayers custom(graph);
+    EXPECT_THROW(custom.fit_async(X, y, 2, .1, 0, 2), std::invalid_argument);
+    EXPECT_THROW(NeuralPerceptron().fit_async(X.transpose(), y.transpose(), 2, .1, 2), std::invalid_argument);
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,141 @@
+/**
+ * @file NeuralPrunerTest.cpp
+ * @brief The NeuralPruner class test.
+ *
+ * This file contains unit tests for the NeuralPruner and NeuralBlockSparse classes.
+ *
+ * @author Manitas Bahri
+ * @date 2023/11
+ * @license MIT License
+ */
+
+// INCLUDES
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include "../include/NeuralCPP.hpp"
+
+/** @brief Test the magnitude pruning and its schedule. */
+TEST(NeuralPrunerTest, magnitude)
+{
+    NeuralGraph graph;
+    graph.add(NeuralDense(8)).add(NeuralDense(4, NeuralLayer::SIGMOID, false));
+    graph.build(10);
+
+    // TEST 1: SCHEDULE
+    NeuralPruner pruner(.8, NeuralPruner::GLOBAL, 10, 20, 5);
+    EXPECT_FLOAT_EQ(pruner.sparsity(5), 0);
+    EXPECT_FLOAT_EQ(pruner.sparsity(15), .8 * (1 - .125));
+    EXPECT_FLOAT_EQ(pruner.sparsity(30), .8);
+    EXPECT_FALSE(pruner.step(graph, 12));
+    EXPECT_TRUE(pruner.step(graph, 20));
+
+    // TEST 2: GLOBAL SPARSITY, THE BIAS IS KEPT
+    const size_t n_zeros = graph.layer(0).sparsity() * 80 + graph.layer(1).sparsity() * 32;
+    EXPECT_EQ(n_zeros, (size_t)(.8f * 112));
+    for (size_t u = 0; u < 8; u++)
+        EXPECT_NE(graph.layer(0).parameters()[u * 11 + 10], 0);
+
+    // TEST 3: THE PRUNED WEIGHTS STAY 0
+    const float sparsity = graph.layer(0).sparsity();
+    std::fill(graph.layer(0).gradients().begin(), graph.layer(0).gradients().end(), 1.f);
+    graph.layer(0).update(.1);
+    EXPECT_FLOAT_EQ(graph.layer(0).sparsity(), sparsity);
+
+    // TEST 4: SPARSITY PER LAYER
+    graph.build(10);
+    NeuralPruner(.5, NeuralPruner::LAYER).prune(graph, .5);
+    EXPECT_FLOAT_EQ(graph.layer(0).sparsity(), .5);
+    EXPECT_FLOAT_EQ(graph.layer(1).sparsity(), .5);
+}
+
+/** @brief Test the N:M structured pruning. */
+TEST(NeuralPrunerTest, structured)
+{
+    NeuralGraph graph;
+    graph.add(NeuralDense(3, NeuralLayer::SIGMOID, false));
+    graph.build(8);
+
+    NeuralPruner::structured(2, 4).prune(graph, 0);
+
+    // Each group of 4 weights keeps its 2 largest weights
+    const NeuralBuffer &W = graph.layer(0).parameters();
+    for (size_t g = 0; g < 6; g++)
+    {
+        std::vector<float> group(W.begin() + g * 4, W.begin() + g * 4 + 4);
+        std::vector<float> magnitudes;
+        for (const float &w : group)
+            magnitudes.push_back(std::fabs(w));
+
+        std::sort(magnitudes.begin(), magnitudes.end());
+        EXPECT_EQ(std::count(group.begin(), group.end(), 0.f), 2);
+
+        for (const float &w : group)
+            EXPECT_TRUE(w == 0 || std::fabs(w) >= magnitudes[2]);
+    }
+
+    EXPECT_THROW(NeuralPruner::structured(4, 4), std::invalid_argument);
+}
+
+/** @brief Test the block sparse product and the compressed model. */
+TEST(NeuralPrunerTest, compress)
+{
+    // TEST 1: PRODUCT
+    const cmatrix<float> &R = cmatrix<float>::randfloat(7, 10, -1, 1, 3);
+    std::vector<float> W(70), X(30), expected(21, 0), out(21);
+    for (size_t r = 0; r < 7; r++)
+        for (size_t c = 0; c < 10; c++)
+            W[r * 10 + c] = (r / 2 + c / 4) % 2 ? R.cell(r, c) : 0;
+
+    for (size_t i = 0; i < X.size(); i++)
+        X[i] = i % 7 - 3.f;
+
+    for (size_t s = 0; s < 3; s++)
+        for (size_t r = 0; r < 7; r++)
+            for (size_t c = 0; c < 10; c++)
+                expected[s * 7 + r] += W[r * 10 + c] * X[s * 10 + c];
+
+    const NeuralBlockSparse &S = NeuralBlockSparse::from_dense(W.data(), 7, 10, 10, 2, 4);
+    EXPECT_EQ(S.n_blocks(), 6);
+    S.matmul_transpose(X.data(), 3, out.data());
+    for (size_t i = 0; i < out.size(); i++)
+        EXPECT_NEAR(out[i], expected[i], 1e-5);
+
+    std::vector<float> dense(70);
+    S.to_dense(dense.data(), 10);
+    EXPECT_EQ(dense, W);
+
+    // TEST 2: COMPRESSED MODEL
+    cmatrix<float> X_train, y;
+    NeuralCPP::create_dataset(X_train, y, 300, 16, 2);
+
+    NeuralLayers model({64, 16});
+    model.set_pruner(NeuralPruner(.9, NeuralPruner::GLOBAL, 50, 150, 10, 1, 4));
+    model.fit(X_train, y, 300, .5, 0);
+    model.save("neural_pruner_dense.model");
+
+    const cmatrix<cbool> &y_pred = model.predict(X_train);
+    // A fixed threshold, since the default one is measured on the machine
+    EXPECT_GE(model.compress(.5), 1);
+    EXPECT_EQ(model.predict(X_train), y_pred);
+
+    // TEST 3: THE FILE STORES THE BLOCKS
+    model.save("neural_pruner_sparse.model");
+    NeuralLayers loaded;
+    loaded.load("neural_pruner_sparse.model");
+    EXPECT_EQ(loaded.predict(X_train), y_pred);
+
+    std::ifstream dense_file("neural_pruner_dense.model", std::ios::ate), sparse_file("neural_pruner_sparse.model", std::ios::ate);
+    EXPECT_LT(sparse_file.tellg(), dense_file.tellg());
+
+    std::remove("neural_pruner_dense.model");
+    std::remove("neural_pruner_sparse.model");
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,103 @@
+/**
+ * @file NeuralScalerTest.cpp
+ * @brief The NeuralScaler class test.
+ *
+ * This file contains unit tests for the NeuralScaler class.
+ *
+ * @author Manitas Bahri
+ * @date 2023/11
+ * @license MIT License
+ */
+
+// INCLUDES
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <sstream>
+#include "../include/NeuralCPP.hpp"
+
+/** @brief Test the standardization and the min-max scaling. */
+TEST(NeuralScalerTest, scaling)
+{
+    cmatrix<float> X = {{1, 2, 3, 4}, {5, 5, 5, 5}};
+
+    // TEST 1: STANDARD
+    NeuralScaler standard(NeuralScaler::STANDARD);
+    standard.fit(X);
+    cmatrix<float> T = standard.transform(X);
+    EXPECT_EQ(standard.n_outputs(), 2);
+    EXPECT_NEAR(T.cell(0, 0), -1.5 / std::sqrt(1.25), 1e-5);
+    EXPECT_NEAR(T.cell(0, 3), 1.5 / std::sqrt(1.25), 1e-5);
+    EXPECT_FLOAT_EQ(T.cell(1, 2), 0);
+
+    // TEST 2: MINMAX WITH BIAS
+    NeuralScaler minmax(NeuralScaler::MINMAX);
+    minmax.fit(X);
+    T = minmax.transform(X, true);
+    EXPECT_EQ(T.height(), 3);
+    EXPECT_FLOAT_EQ(T.cell(0, 0), 0);
+    EXPECT_FLOAT_EQ(T.cell(0, 3), 1);
+    EXPECT_FLOAT_EQ(T.cell(2, 1), 1);
+
+    // TEST 3: INVALID ARGUMENT
+    EXPECT_THROW(NeuralScaler().transform(X), std::invalid_argument);
+    EXPECT_THROW(minmax.transform(X.transpose()), std::invalid_argument);
+    EXPECT_THROW(NeuralScaler(NeuralScaler::NONE, {2}).fit(X), std::invalid_argument);
+}
+
+/** @brief Test the one-hot encoding. */
+TEST(NeuralScalerTest, one_hot)
+{
+    cmatrix<float> X = {{2, 0, 2, 1}, {3, 4, 5, 6}};
+    NeuralScaler scaler(NeuralScaler::NONE, {0});
+    scaler.fit(X);
+    EXPECT_EQ(scaler.n_outputs(), 4);
+
+    // TEST 1: DENSE TRANSFORM
+    cmatrix<float> T = scaler.transform(X, {1, 3});
+    cmatrix<float> expected = {{1, 0}, {0, 1}, {0, 0}, {4, 6}};
+    EXPECT_EQ(T, expected);
+
+    // TEST 2: UNKNOWN CATEGORY
+    cmatrix<float> Y = {{7}, {1}};
+    std::vector<std::pair<size_t, float>> x;
+    scaler.transform(Y, 0, x);
+    ASSERT_EQ(x.size(), 1);
+    EXPECT_EQ(x[0].first, 3);
+}
+
+/** @brief Test that a saved model predicts the same output with its scaler. */
+TEST(NeuralScalerTest, save_load)
+{
+    cmatrix<float> X, y;
+    NeuralCPP::create_dataset(X, y, 200, 3, 2);
+    X = X * 100;
+
+    NeuralLayers model({4}, NeuralScaler(NeuralScaler::STANDARD));
+    model.fit(X, y, 20, .5, 0);
+    model.save("neural_scaler_test.model");
+
+    NeuralLayers loaded;
+    loaded.load("neural_scaler_test.model");
+    std::remove("neural_scaler_test.model");
+
+    EXPECT_EQ(loaded.predict(X), model.predict(X));
+    EXPECT_THROW(loaded.load("neural_scaler_test.model"), std::runtime_error);
+
+    // A categorical feature out of range or a truncated stream leaves the scaler unchanged
+    NeuralScaler scaler(NeuralScaler::MINMAX, {1});
+    scaler.fit(cmatrix<float>({{1, 2}, {0, 1}}));
+
+    std::stringstream out_of_range("NeuralScaler 1 1 2 1 2 0 1 0 0 1 0");
+    EXPECT_THROW(scaler.load(out_of_range), std::runtime_error);
+    std::stringstream truncated("NeuralScaler 1 1 2 1 0 0 1 0 0 1");
+    EXPECT_THROW(scaler.load(truncated), std::runtime_error);
+    EXPECT_EQ(scaler.n_features(), 2);
+    EXPECT_EQ(scaler.n_outputs(), 3);
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,116 @@
+/**
+ * @file NeuralScorerTest.cpp
+ * @brief The NeuralScorer class test.
+ *
+ * This file contains unit tests for the NeuralScorer class.
+ *
+ * @author Manitas Bahri
+ * @date 2023/11
+ * @license MIT License
+ */
+
+// INCLUDES
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include "../include/NeuralCPP.hpp"
+
+/** @brief Test the scoring of a CSV file, in the order of its rows. */
+TEST(NeuralScorerTest, csv)
+{
+    cmatrix<float> X, y;
+    NeuralCPP::create_dataset(X, y, 100, 3, 2);
+    NeuralLayers model({4, 1});
+    model.fit(X, y, 200, .5, 0);
+
+    // One sample per line, after a header
+    std::ofstream samples("neural_scorer_test.csv");
+    samples.precision(9);
+    samples << "a,b,c\n";
+    for (size_t j = 0; j < X.width(); j++)
+        samples << X.cell(0, j) << "," << X.cell(1, j) << "," << X.cell(2, j) << "\n";
+    samples.close();
+
+    // TEST 1: SMALL CHUNKS ON SEVERAL THREADS GIVE THE ROWS IN ORDER
+    NeuralScorer scorer(7, 3, 2, 2);
+    const NeuralScorer::Report &report = scorer.score(model, "neural_scorer_test.csv", "neural_scorer_test.out", NeuralScorer::CSV, NeuralScorer::CSV, true);
+    EXPECT_EQ(report.n_rows, 100);
+    EXPECT_EQ(report.n_chunks, 15);
+
+    const cmatrix<float> &y_proba = model.predict_proba(X);
+    const cmatrix<cbool> &y_pred = model.predict(X);
+    std::ifstream scores("neural_scorer_test.out");
+    std::string line;
+
+    for (size_t j = 0; j < X.width(); j++)
+    {
+        ASSERT_TRUE(std::getline(scores, line));
+        float p = 0;
+        int label = 0;
+        ASSERT_EQ(sscanf(line.c_str(), "%f,%d", &p, &label), 2);
+        EXPECT_NEAR(p, y_proba.cell(0, j), 1e-5);
+        EXPECT_EQ(label, (int)y_pred.cell(0, j));
+    }
+    EXPECT_FALSE(std::getline(scores, line));
+
+    // TEST 2: INVALID ROWS AND MODELS
+    std::ofstream invalid("neural_scorer_test.csv");
+    invalid << "1,2,3\n4,5\n";
+    invalid.close();
+
+    EXPECT_THROW(scorer.score(model, "neural_scorer_test.csv", "neural_scorer_test.out"), std::runtime_error);
+    EXPECT_THROW(scorer.score(model, "neural_scorer_missing.csv", "neural_scorer_test.out"), std::runtime_error);
+    EXPECT_THROW(scorer.score(NeuralLayers(), "neural_scorer_test.csv", "neural_scorer_test.out"), std::invalid_argument);
+
+    std::remove("neural_scorer_test.csv");
+    std::remove("neural_scorer_test.out");
+}
+
+/** @brief Test the scoring of a binary columnar file, written in binary. */
+TEST(NeuralScorerTest, binary)
+{
+    cmatrix<float> X, y;
+    NeuralCPP::create_dataset(X, y, 50, 4, 3);
+    NeuralLayers model({3, 1});
+    model.fit(X, y, 200, .5, 0);
+    NeuralScorer::save_binary("neural_scorer_test.col", X);
+
+    const NeuralScorer::Report &report = NeuralScorer(16).score(model, "neural_scorer_test.col", "neural_scorer_test.bin", NeuralScorer::BINARY, NeuralScorer::BINARY);
+    EXPECT_EQ(report.n_rows, 50);
+    EXPECT_EQ(report.bytes_written, 16 + 50 * (sizeof(float) + 1));
+
+    // The header, then the probability and the label of each sample
+    std::ifstream file("neural_scorer_test.bin", std::ios::binary);
+    char magic[8];
+    uint64_t n_outputs = 0;
+    file.read(magic, 8);
+    file.read(reinterpret_cast<char *>(&n_outputs), sizeof(n_outputs));
+    EXPECT_EQ(std::string(magic, 8), "NCPPSCR1");
+    EXPECT_EQ(n_outputs, 1);
+
+    const cmatrix<float> &y_proba = model.predict_proba(X);
+    for (size_t j = 0; j < X.width(); j++)
+    {
+        float p = 0;
+        char label = 0;
+        file.read(reinterpret_cast<char *>(&p), sizeof(p));
+        file.read(&label, 1);
+        EXPECT_FLOAT_EQ(p, y_proba.cell(0, j));
+        EXPECT_EQ(label, y_proba.cell(0, j) > .5);
+    }
+
+    // The number of features of the file must match the model
+    NeuralScorer::save_binary("neural_scorer_test.col", cmatrix<float>(3, 10, 0));
+    EXPECT_THROW(NeuralScorer().score(model, "neural_scorer_test.col", "neural_scorer_test.bin", NeuralScorer::BINARY), std::runtime_error);
+
+    std::remove("neural_scorer_test.col");
+    std::remove("neural_scorer_test.bin");
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+
+    return RUN_ALL_TESTS();
+}
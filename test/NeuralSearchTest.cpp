@@ -0,0 +1,152 @@
+/**
+ * @file NeuralSearchTest.cpp
+ * @brief The NeuralSearch and NeuralThreadPool classes test.
+ *
+ * This file contains unit tests for the NeuralSearch and NeuralThreadPool classes.
+ *
+ * @author Manitas Bahri
+ * @date 2023/11
+ * @license MIT License
+ */
+
+// INCLUDES
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <stdexcept>
+#include <thread>
+#include "../include/NeuralCPP.hpp"
+#include "../include/NeuralThreadPool.hpp"
+
+/** @brief Test the folds and the candidates of the grid and random searches. */
+TEST(NeuralSearchTest, candidates)
+{
+    // TEST 1: THE FOLDS ARE A PARTITION OF THE SAMPLES
+    const NeuralSearch search(4, 2, 1);
+    const std::vector<std::vector<size_t>> &folds = search.folds(103);
+    ASSERT_EQ(folds.size(), 4);
+
+    std::vector<int> n_valid(103, 0);
+    for (const std::vector<size_t> &fold : folds)
+    {
+        EXPECT_GE(fold.size(), 25);
+        EXPECT_LE(fold.size(), 26);
+        for (const size_t &i : fold)
+            n_valid[i]++;
+    }
+
+    // Each sample is validated by one fold, and trained on by the others only
+    for (const int &n : n_valid)
+        EXPECT_EQ(n, 1);
+    EXPECT_THROW(search.folds(3), std::invalid_argument);
+
+    // TEST 2: GRID
+    const std::vector<NeuralSearch::Params> &grid = NeuralSearch::grid({{2}, {4, 2}}, {10, 20, 30}, {.1, .5});
+    ASSERT_EQ(grid.size(), 12);
+    EXPECT_EQ(grid[0].layers_dims, std::vector<int>({2}));
+    EXPECT_EQ(grid[11].layers_dims, std::vector<int>({4, 2}));
+    EXPECT_EQ(grid[11].epochs, 30);
+    EXPECT_FLOAT_EQ(grid[11].learning_rate, .5);
+
+    // TEST 3: RANDOM, IN THE RANGES AND REPRODUCIBLE
+    const std::vector<NeuralSearch::Params> &random = NeuralSearch::random({{2}, {4}}, 5, 50, .001, .1, 40, 3);
+    ASSERT_EQ(random.size(), 40);
+    for (const NeuralSearch::Params &params : random)
+    {
+        EXPECT_GE(params.epochs, 5);
+        EXPECT_LE(params.epochs, 50);
+        EXPECT_GE(params.learning_rate, .001f * .999f);
+        EXPECT_LE(params.learning_rate, .1f * 1.001f);
+    }
+    EXPECT_EQ(NeuralSearch::random({{2}, {4}}, 5, 50, .001, .1, 40, 3)[7].epochs, random[7].epochs);
+    EXPECT_THROW(NeuralSearch::random({{2}}, 10, 5, .1, .2, 3), std::invalid_argument);
+    EXPECT_THROW(NeuralSearch::random({{2}}, 5, 10, 0, .2, 3), std::invalid_argument);
+}
+
+/** @brief Test that successive halving keeps 1/eta of the candidates and multiplies their epochs by eta at each round. */
+TEST(NeuralSearchTest, halving)
+{
+    cmatrix<float> X, y;
+    NeuralCPP::create_dataset(X, y, 60, 2, 2);
+
+    const std::vector<NeuralSearch::Params> &candidates = NeuralSearch::grid({{2}, {3}, {4}}, {18}, {.1, .3, .5});
+    NeuralSearch search(3, 4);
+    const std::vector<NeuralSearch::Result> &results = search.fit_halving(X, y, candidates, 2, 3);
+    ASSERT_EQ(results.size(), 9);
+
+    // 9 candidates for 2 epochs, the best 3 for 6 epochs, then the best one for 18 epochs
+    std::map<int, int> n_trained;
+    for (const NeuralSearch::Result &result : results)
+    {
+        n_trained[result.epochs_trained]++;
+        EXPECT_EQ(result.fold_scores.size(), 3);
+    }
+    EXPECT_EQ(n_trained[2], 6);
+    EXPECT_EQ(n_trained[6], 2);
+    EXPECT_EQ(n_trained[18], 1);
+    EXPECT_EQ(search.best().epochs_trained, 18);
+
+    // The best candidate resumed its models from 2 then 6 epochs: they match models trained for 18 epochs at once
+    const NeuralSearch::Result best = search.best();
+    NeuralSearch direct_search(3, 4);
+    const NeuralSearch::Result &direct = direct_search.fit(X, y, {best.params}).front();
+    for (size_t f = 0; f < 3; f++)
+        EXPECT_FLOAT_EQ(best.fold_scores[f], direct.fold_scores[f]);
+
+    EXPECT_THROW(search.fit_halving(X, y, candidates, 2, 1), std::invalid_argument);
+    EXPECT_THROW(search.fit_halving(X, y, {}, 2, 3), std::invalid_argument);
+}
+
+/** @brief Test that the pool runs each task once, steals the tasks of a busy worker and forwards the errors. */
+TEST(NeuralSearchTest, pool)
+{
+    NeuralThreadPool pool(2);
+
+    // TEST 1: EACH TASK RUNS ONCE
+    std::vector<std::atomic<int>> runs(1000);
+    for (std::atomic<int> &run : runs)
+        run = 0;
+    for (size_t i = 0; i < runs.size(); i++)
+        pool.submit([&, i]
+                    { runs[i]++; });
+    pool.wait();
+
+    for (const std::atomic<int> &run : runs)
+        EXPECT_EQ(run, 1);
+
+    // TEST 2: THE TASKS QUEUED BEHIND A BLOCKED WORKER ARE STOLEN
+    std::atomic<bool> started(false);
+    std::atomic<int> n_done(0);
+    bool stolen = false;
+    pool.submit([&]
+                {
+        started = true;
+        // Blocked until the other worker ran all the tasks, including the ones of this worker's queue
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (n_done < 20 && std::chrono::steady_clock::now() < deadline)
+            std::this_thread::yield();
+        stolen = n_done == 20; });
+
+    while (!started)
+        std::this_thread::yield();
+    for (int i = 0; i < 20; i++)
+        pool.submit([&]
+                    { n_done++; });
+    pool.wait();
+    EXPECT_TRUE(stolen);
+
+    // TEST 3: THE FIRST ERROR IS FORWARDED BY WAIT
+    pool.submit([]
+                { throw std::runtime_error("task"); });
+    pool.submit([] {});
+    EXPECT_THROW(pool.wait(), std::runtime_error);
+    EXPECT_NO_THROW(pool.wait());
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+
+    return RUN_ALL_TESTS();
+}
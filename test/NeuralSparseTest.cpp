@@ -0,0 +1,125 @@
+/**
+ * @file NeuralSparseTest.cpp
+ * @brief The NeuralSparse class test.
+ *
+ * This file contains unit tests for the NeuralSparse class.
+ *
+ * @author Manitas Bahri
+ * @date 2023/11
+ * @license MIT License
+ */
+
+// INCLUDES
+#include <gtest/gtest.h>
+#include "../include/NeuralCPP.hpp"
+
+/** @brief Test the conversion from and to a dense matrix. */
+TEST(NeuralSparseTest, from_dense)
+{
+    // TEST 1
+    cmatrix<float> M = {{0, 1, 0}, {0, 0, 0}, {2, 0, 3}};
+    NeuralSparse S = NeuralSparse::from_dense(M);
+    EXPECT_EQ(S.height(), 3);
+    EXPECT_EQ(S.width(), 3);
+    EXPECT_EQ(S.nnz(), 3);
+    EXPECT_EQ(S.row_ptr(), std::vector<size_t>({0, 1, 1, 3}));
+    EXPECT_EQ(S.col_idx(), std::vector<size_t>({1, 0, 2}));
+    EXPECT_EQ(S.to_dense(), M);
+
+    // TEST 2: TRANSPOSE
+    EXPECT_EQ(S.transpose().to_dense(), M.transpose());
+
+    // TEST 3: INVALID ARGUMENT
+    EXPECT_THROW(NeuralSparse(2, 2, {0, 1}, {0}, {1}), std::invalid_argument);
+    EXPECT_THROW(NeuralSparse(2, 2, {0, 1, 1}, {2}, {1}), std::invalid_argument);
+}
+
+/** @brief Test the from_triplets function. */
+TEST(NeuralSparseTest, from_triplets)
+{
+    // TEST 1: DUPLICATED ENTRIES ARE SUMMED
+    NeuralSparse S = NeuralSparse::from_triplets(2, 3, {1, 0, 1}, {2, 1, 2}, {1, 4, 2});
+    cmatrix<float> M = {{0, 4, 0}, {0, 0, 3}};
+    EXPECT_EQ(S.nnz(), 2);
+    EXPECT_EQ(S.to_dense(), M);
+
+    // TEST 2: INVALID ARGUMENT
+    EXPECT_THROW(NeuralSparse::from_triplets(2, 3, {2}, {0}, {1}), std::invalid_argument);
+    EXPECT_THROW(NeuralSparse::from_triplets(2, 3, {0, 1}, {0}, {1}), std::invalid_argument);
+}
+
+/** @brief Test the sparse-dense products. */
+TEST(NeuralSparseTest, products)
+{
+    cmatrix<float> M = {{0, 1, 0}, {2, 0, 3}};
+    NeuralSparse S = NeuralSparse::from_dense(M);
+
+    // TEST 1: S * B
+    cmatrix<float> B = {{1, 2}, {3, 4}, {5, 6}};
+    EXPECT_EQ(S.matmul(B), M.matmul(B));
+
+    // TEST 2: [S, 1] * B
+    cmatrix<float> B_bias = {{1, 2}, {3, 4}, {5, 6}, {1, -1}};
+    cmatrix<float> expected = {{4, 3}, {18, 21}};
+    EXPECT_EQ(S.matmul(B_bias, true), expected);
+
+    // TEST 3: A * [S; 1]
+    cmatrix<float> A = {{1, 2, 1}, {0, 1, -1}};
+    expected = {{5, 2, 7}, {1, -1, 2}};
+    EXPECT_EQ(S.rmatmul(A, true), expected);
+
+    // TEST 4: out += alpha * A * [S; 1]^T
+    A = {{1, 2, 3}};
+    cmatrix<float> out = {{1, 1, 1}};
+    expected = {{5, 23, 13}};
+    S.rmatmul_transpose_add(A, out, 2, true);
+    EXPECT_EQ(out, expected);
+
+    // TEST 5: INVALID ARGUMENT
+    EXPECT_THROW(S.matmul(B_bias), std::invalid_argument);
+    EXPECT_THROW(S.rmatmul(A), std::invalid_argument);
+}
+
+/** @brief Test that the models trained on the sparse samples match the models trained on the same dense samples. */
+TEST(NeuralSparseTest, dense_equivalence)
+{
+    NeuralSparse X;
+    cmatrix<float> y;
+    NeuralCPP::create_dataset(X, y, 200, 20, .2);
+    const cmatrix<float> &X_dense = X.to_dense();
+
+    // TEST 1: NEURAL LAYERS, WITHOUT SCALING
+    NeuralLayers sparse_model({8}), dense_model({8});
+    sparse_model.fit(X, y, 20, .5, 0);
+    dense_model.fit(X_dense, y, 20, .5, 0);
+
+    const std::vector<float> &sparse_weights = sparse_model.graph().parameters();
+    const std::vector<float> &dense_weights = dense_model.graph().parameters();
+    ASSERT_EQ(sparse_weights.size(), dense_weights.size());
+    for (size_t i = 0; i < dense_weights.size(); i++)
+        EXPECT_NEAR(sparse_weights[i], dense_weights[i], 1e-4);
+
+    EXPECT_EQ(sparse_model.predict(X), dense_model.predict(X_dense));
+
+    // TEST 2: PERCEPTRON, FROM THE SAME INITIAL WEIGHTS
+    const NeuralSparse &samples = X.transpose();
+    cmatrix<float> y_true(200, 1);
+    for (size_t i = 0; i < 200; i++)
+        y_true.cell(i, 0) = y.cell(0, i) > 0 ? 1 : -1;
+
+    NeuralPerceptron sparse_perceptron, dense_perceptron;
+    sparse_perceptron.m_weights = dense_perceptron.m_weights = cmatrix<float>::randfloat(21, 1, -2, 2, 0);
+    const cmatrix<float> &sparse_w = sparse_perceptron.fit(samples, y_true, 20, .1);
+    const cmatrix<float> &dense_w = dense_perceptron.fit(X_dense.transpose(), y_true, 20, .1);
+
+    for (size_t i = 0; i < 21; i++)
+        EXPECT_NEAR(sparse_w.cell(i, 0), dense_w.cell(i, 0), 1e-4);
+    EXPECT_EQ(sparse_perceptron.predict(samples), dense_perceptron.predict(X_dense.transpose()));
+}
+
+GTEST_API_ int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+
+    return RUN_ALL_TESTS();
+}
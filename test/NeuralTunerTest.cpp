@@ -0,0 +1,186 @@
+/**
+ * @file NeuralTunerTest.cpp
+ * @brief The NeuralTuner class test.
+ *
+ * This file contains unit tests for the NeuralTuner class.
+ *
+ * @author Manitas Bahri
+ * @date 2023/11
+ * @license MIT License
+ */
+
+// INCLUDES
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include "../include/NeuralCPP.hpp"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/** @brief Test the tuning of a model, then the loading of its cache by a later run. */
+TEST(NeuralTunerTest, cache)
+{
+    cmatrix<float> X, y;
+    NeuralCPP::create_dataset(X, y, 300, 4, 2);
+    NeuralLayers model({8, 4});
+    model.fit(X, y, 50, .5, 0);
+    const cmatrix<float> &y_proba = model.predict_proba(X);
+
+    // The entries of another machine are kept
+    std::ofstream cache("neural_tuner_test.cache");
+    cache << "GEMM NT 1 300 8 5 16 2 Another CPU, 2 threads\n";
+    cache.close();
+
+    // TEST 1: THE SHAPES OF A TRAINING EPOCH ARE TUNED ONCE
+    NeuralTuner::clear();
+    NeuralTuner tuner("neural_tuner_test.cache", 1);
+    const NeuralTuner::Report &report = tuner.tune(model, X);
+    EXPECT_GE(report.n_shapes, 6);
+    EXPECT_EQ(report.n_tuned, report.n_shapes);
+    EXPECT_GT(report.batch_size, 0);
+    EXPECT_EQ(tuner.tune(model, X).n_tuned, 0);
+
+    // The products give the same values with any configuration
+    const cmatrix<float> &y_tuned = model.predict_proba(X);
+    for (size_t j = 0; j < X.width(); j++)
+        EXPECT_FLOAT_EQ(y_tuned.cell(0, j), y_proba.cell(0, j));
+
+    // TEST 2: A LATER RUN LOADS THE ENTRIES OF ITS MACHINE
+    std::ifstream file("neural_tuner_test.cache");
+    std::string line;
+    size_t n_entries = 0, n_others = 0;
+    while (std::getline(file, line))
+    {
+        n_entries += line.find(NeuralTuner::machine()) != std::string::npos;
+        n_others += line.find("Another CPU") != std::string::npos;
+    }
+    // A GEMM entry per shape, the batch size, and the crossover of each dense layer
+    size_t n_dense = 0;
+    for (size_t i = 0; i < model.graph().size(); i++)
+        n_dense += dynamic_cast<const NeuralDense *>(&model.graph().layer(i)) != nullptr;
+    EXPECT_EQ(n_entries, report.n_shapes + 1 + n_dense);
+    EXPECT_EQ(n_others, 1);
+
+    NeuralTuner::clear();
+    EXPECT_EQ(NeuralTuner::batch_size(model, 7), 7);
+    EXPECT_TRUE(NeuralTuner::load("neural_tuner_test.cache"));
+    EXPECT_EQ(NeuralTuner::batch_size(model, 7), report.batch_size);
+    EXPECT_EQ(NeuralTuner("neural_tuner_test.cache", 1).tune(model, X).n_tuned, 0);
+
+    std::remove("neural_tuner_test.cache");
+    NeuralTuner::clear();
+}
+
+/** @brief Exposes the number of threads of the products. */
+struct NeuralProbe : NeuralDense
+{
+    static int threads(const NeuralTuner::Kernel &kernel, const size_t &M, const size_t &N, const size_t &K)
+    {
+        return __gemm_threads(NeuralTuner::config(kernel, true, M, N, K));
+    }
+};
+
+/** @brief Test that a tuned product respects the number of threads set by the caller. */
+TEST(NeuralTunerTest, threads)
+{
+    std::ofstream cache("neural_tuner_test.cache");
+    cache << "GEMM NN 1 300 8 5 16 64 " << NeuralTuner::machine() << "\n";
+    cache.close();
+
+    NeuralTuner::clear();
+    EXPECT_TRUE(NeuralTuner::load("neural_tuner_test.cache"));
+    std::remove("neural_tuner_test.cache");
+
+#ifdef _OPENMP
+    const int max_threads = omp_get_max_threads();
+    EXPECT_EQ(NeuralProbe::threads(NeuralTuner::NN, 300, 8, 5), std::min(64, max_threads));
+
+    // The cap of the caller wins over the tuned number, as in a search worker or a forked worker
+    const std::string machine = NeuralTuner::machine();
+    omp_set_num_threads(1);
+    EXPECT_EQ(NeuralTuner::machine(), machine);
+    EXPECT_EQ(NeuralProbe::threads(NeuralTuner::NN, 300, 8, 5), 1);
+    EXPECT_EQ(NeuralProbe::threads(NeuralTuner::NT, 300, 8, 5), 1);
+    omp_set_num_threads(max_threads);
+#else
+    EXPECT_EQ(NeuralProbe::threads(NeuralTuner::NN, 300, 8, 5), 1);
+#endif
+    NeuralTuner::clear();
+}
+
+/** @brief Test the measured crossover of the block sparse format, and its entry in the cache. */
+TEST(NeuralTunerTest, crossover)
+{
+    // TEST 1: THE CROSSOVER IS MEASURED ONCE, THEN KEPT
+    NeuralTuner::clear();
+    const float crossover = NeuralTuner::crossover(64, 16, 1, 4);
+    EXPECT_GT(crossover, 0);
+    EXPECT_LE(crossover, 1);
+    EXPECT_EQ(NeuralTuner::crossover(64, 16, 1, 4), crossover);
+
+    // TEST 2: THE CROSSOVER IS SAVED AND LOADED
+    NeuralTuner::save("neural_tuner_test.cache");
+    NeuralTuner::clear();
+    std::ofstream cache("neural_tuner_test.cache", std::ios::app);
+    cache << "SPARSE 32 8 2 2 0.25 " << NeuralTuner::machine() << "\n";
+    cache.close();
+
+    EXPECT_TRUE(NeuralTuner::load("neural_tuner_test.cache"));
+    EXPECT_FLOAT_EQ(NeuralTuner::crossover(64, 16, 1, 4), crossover);
+    EXPECT_FLOAT_EQ(NeuralTuner::crossover(32, 8, 2, 2), .25);
+    std::remove("neural_tuner_test.cache");
+
+    // TEST 3: THE DEFAULT COMPRESSION OF A MODEL USES THE CROSSOVER OF EACH LAYER
+    cmatrix<float> X, y;
+    NeuralCPP::create_dataset(X, y, 100, 16, 2);
+    NeuralLayers model({64});
+    model.set_pruner(NeuralPruner(.9, NeuralPruner::GLOBAL, 0, 0, 1, 1, 4));
+    model.fit(X, y, 2, .5, 0);
+    model.compress();
+
+    for (size_t i = 0; i < model.graph().size(); i++)
+    {
+        const NeuralDense *layer = dynamic_cast<const NeuralDense *>(&model.graph().layer(i));
+        if (!layer)
+            continue;
+
+        const size_t units = layer->output_shape().size(), K = layer->input_shape().size();
+        const float sparsity = 1 - NeuralBlockSparse::from_dense(layer->parameters().data(), units, K, K + layer->bias(), 1, 4).density();
+        if (!layer->is_compressed())
+            EXPECT_LT(sparsity, NeuralTuner::crossover(units, K, 1, 4));
+        else
+            EXPECT_GE(1 - layer->compressed().density(), NeuralTuner::crossover(units, K, 1, 4));
+    }
+
+    EXPECT_THROW(NeuralTuner::crossover(8, 8, 17, 1), std::invalid_argument);
+    NeuralTuner::clear();
+}
+
+/** @brief Test the invalid caches and models. */
+TEST(NeuralTunerTest, invalid)
+{
+    std::ofstream cache("neural_tuner_test.cache");
+    cache << "GEMM XY 1 2 3 4 5 6 CPU\n";
+    cache.close();
+
+    EXPECT_FALSE(NeuralTuner::load("neural_tuner_missing.cache"));
+    EXPECT_THROW(NeuralTuner::load("neural_tuner_test.cache"), std::runtime_error);
+    std::remove("neural_tuner_test.cache");
+
+    cmatrix<float> X, y;
+    NeuralCPP::create_dataset(X, y, 20, 3, 2);
+    NeuralLayers model;
+    EXPECT_THROW(NeuralTuner("neural_tuner_test.cache").tune(model, X), std::invalid_argument);
+    EXPECT_THROW(NeuralTuner("neural_tuner_test.cache", 0), std::invalid_argument);
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,105 @@
+/**
+ * @file NeuralViewTest.cpp
+ * @brief The NeuralView class test.
+ *
+ * This file contains unit tests for the NeuralView class.
+ *
+ * @author Manitas Bahri
+ * @date 2023/11
+ * @license MIT License
+ */
+
+// INCLUDES
+#include <gtest/gtest.h>
+#include "../include/NeuralCPP.hpp"
+
+/** @brief Test the rows, the columns and the transpose of a view. */
+TEST(NeuralViewTest, slices)
+{
+    const cmatrix<float> &X = cmatrix<float>::randfloat(6, 4, -1, 1, 1);
+    const NeuralView V(X);
+
+    // TEST 1: ROWS AND COLUMNS
+    EXPECT_EQ(V.rows(2).to_cmatrix(), X.rows(2));
+    EXPECT_EQ(V.columns(3).to_cmatrix(), X.columns(3));
+    EXPECT_EQ(V.transpose().to_cmatrix(), X.transpose());
+    const cmatrix<float> expected = {{X.cell(1, 2), X.cell(2, 2), X.cell(3, 2)}};
+    EXPECT_EQ(V.rows(1, 4).columns(1, 3).transpose().rows(1).to_cmatrix(), expected);
+
+    // TEST 2: BUFFER WITH A ROW STRIDE
+    std::vector<float> buffer(6 * 5);
+    for (size_t i = 0; i < buffer.size(); i++)
+        buffer[i] = i;
+
+    const NeuralView B(buffer.data(), 6, 4, 5);
+    EXPECT_FLOAT_EQ(B.cell(2, 3), 13);
+    EXPECT_FLOAT_EQ(B.transpose().columns(1, 3).cell(0, 1), 10);
+
+    // TEST 3: INVALID RANGES
+    EXPECT_THROW(V.rows(6), std::invalid_argument);
+    EXPECT_THROW(V.columns(2, 2), std::invalid_argument);
+    EXPECT_THROW(NeuralView(buffer.data(), 6, 4, 3), std::invalid_argument);
+}
+
+/** @brief Test the products of the views in every storage order. */
+TEST(NeuralViewTest, products)
+{
+    const cmatrix<float> &A = cmatrix<float>::randfloat(5, 3, -1, 1, 2);
+    const cmatrix<float> &B = cmatrix<float>::randfloat(3, 4, -1, 1, 3);
+    const cmatrix<float> &A_t = A.transpose(), &B_t = B.transpose();
+    const cmatrix<float> &expected = A.matmul(B);
+
+    const std::vector<cmatrix<float>> products = {
+        NeuralView(A).matmul(NeuralView(B)),
+        NeuralView(A).matmul(NeuralView(B_t).transpose()),
+        NeuralView(A_t).transpose().matmul(NeuralView(B)),
+        NeuralView(A_t).transpose().matmul(NeuralView(B_t).transpose())};
+
+    for (const cmatrix<float> &product : products)
+        for (size_t i = 0; i < 5; i++)
+            for (size_t j = 0; j < 4; j++)
+                EXPECT_NEAR(product.cell(i, j), expected.cell(i, j), 1e-5);
+
+    // The product with a vector, with a bias
+    const std::vector<float> x = {1, -2, .5};
+    std::vector<float> out(5), out_t(5);
+    NeuralView(A).matvec(x.data(), out.data(), 1);
+    NeuralView(A_t).transpose().matvec(x.data(), out_t.data(), 1);
+
+    for (size_t i = 0; i < 5; i++)
+    {
+        EXPECT_NEAR(out[i], A.cell(i, 0) - 2 * A.cell(i, 1) + .5 * A.cell(i, 2) + 1, 1e-5);
+        EXPECT_NEAR(out_t[i], out[i], 1e-5);
+    }
+
+    EXPECT_THROW(NeuralView(A).matmul(NeuralView(A)), std::invalid_argument);
+}
+
+/** @brief Test the perceptron on views of the samples. */
+TEST(NeuralViewTest, perceptron)
+{
+    // The samples of the dataset are its columns: the perceptron reads their transposed view
+    cmatrix<float> X, y;
+    NeuralCPP::create_dataset(X, y, 100, 5, 2);
+    const NeuralView &samples = NeuralView(X).transpose();
+
+    cmatrix<float> y_true(100, 1);
+    for (size_t i = 0; i < 100; i++)
+        y_true.cell(i, 0) = y.cell(0, i) > 0 ? 1 : -1;
+
+    NeuralPerceptron model;
+    model.fit(samples, y_true, 20);
+
+    // The view and the copied samples give the same predictions
+    const cmatrix<float> &y_pred = model.predict(samples);
+    EXPECT_EQ(model.predict(X.transpose()), y_pred);
+    EXPECT_EQ(model.predict(samples.rows(10, 20)).cell(3, 0), y_pred.cell(13, 0));
+    EXPECT_THROW(model.predict(samples.columns(0, 3)), std::invalid_argument);
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+
+    return RUN_ALL_TESTS();
+}